@@ -45,6 +45,12 @@ namespace tnac::ir
     //
     function& declare_function(entity_id id, function& owner, name_t name, size_type paramCount) noexcept;
 
+    //
+    // Declares a built-in function
+    // Built-ins have no owner, and are not listed among modules
+    //
+    function& declare_intrinsic(entity_id id, name_t name, size_type paramCount, eval::intrinsic which) noexcept;
+
     //
     // Returns a pointer to the module or function corresponding to the given id
     //
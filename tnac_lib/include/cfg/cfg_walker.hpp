@@ -127,11 +127,18 @@ namespace tnac::ir
 
     //
     // Walks basic blocks
+    // A block is visited after its last predecessor. Loop headers would wait for
+    // their back edges forever, so, once nothing else is left, the earliest
+    // block reached so far is visited regardless
     //
     void walk_blocks(dest<basic_block> start) noexcept
     {
-      std::queue<decltype(start)> blocks;
+      using block_ptr = decltype(start);
+      std::queue<block_ptr> blocks;
+      std::vector<block_ptr> reached;
+      std::unordered_set<block_ptr> visited;
       blocks.push(start);
+      visited.emplace(start);
 
       while (!blocks.empty())
       {
@@ -142,8 +149,23 @@ namespace tnac::ir
         for (auto conn : cur->outs())
         {
           auto&& out = conn->outgoing();
-          if (out.is_last_pred(*conn))
+          if (out.is_last_pred(*conn) && visited.emplace(&out).second)
             blocks.push(&out);
+          else
+            reached.push_back(&out);
+        }
+
+        if (!blocks.empty())
+          continue;
+
+        auto next = std::ranges::find_if(reached, [&visited](block_ptr bb) noexcept
+          {
+            return !visited.contains(bb);
+          });
+        if (next != reached.end())
+        {
+          visited.emplace(*next);
+          blocks.push(*next);
         }
       }
     }
@@ -60,6 +60,17 @@ namespace tnac::ir
     //
     operand value() const noexcept;
 
+    //
+    // Replaces the attached value
+    //
+    void replace_value(operand val) noexcept;
+
+    //
+    // Removes the edge from the preds and outs of its blocks
+    // After this, the edge is loose
+    //
+    void disconnect() noexcept;
+
   private:
     basic_block* m_in{};
     basic_block* m_out{};
@@ -120,6 +131,12 @@ namespace tnac::ir
     //
     void clear_instructions() noexcept;
 
+    //
+    // Deletes the given instruction
+    // The instruction must belong to this block
+    //
+    void erase(instruction& in) noexcept;
+
     //
     // Returns an iterator to the first instruction
     //
@@ -196,6 +213,16 @@ namespace tnac::ir
     //
     void add_out(edge* e) noexcept;
 
+    //
+    // Removes an incoming edge
+    //
+    void remove_pred(const edge* e) noexcept;
+
+    //
+    // Removes an outgoing edge
+    //
+    void remove_out(const edge* e) noexcept;
+
   private:
     function* m_owner{};
     string_t m_name;
@@ -26,6 +26,7 @@ namespace tnac::ir
     using rec_list         = record::list_type;
     using size_type        = instruction::size_type;
     using arr_store        = std::unordered_map<entity_id, constant*>;
+    using const_pool       = std::unordered_multimap<constant::hash_type, constant*>;
 
   private:
     struct loose_module final :
@@ -71,6 +72,11 @@ namespace tnac::ir
     //
     function& make_loose(entity_id id, fname_t name) noexcept;
 
+    //
+    // Creates a built-in function
+    //
+    function& make_intrinsic(entity_id id, fname_t name, par_size_t paramCount, eval::intrinsic which) noexcept;
+
     //
     // Appends an instruction to the specified basic block before the given iterator
     //
@@ -97,6 +103,12 @@ namespace tnac::ir
     //
     instruction& add_array(basic_block& owner, instruction_list::iterator pos) noexcept;
 
+    //
+    // Adds a phi node to the start of the specified block
+    // Preallocs space for operands according to the count parameter
+    //
+    instruction& add_phi(basic_block& owner, size_type count) noexcept;
+
     //
     // Creates a new named virtual register
     //
@@ -135,9 +147,17 @@ namespace tnac::ir
 
     //
     // Interns a global array
+    // Callers are expected to check for an existing one with find_same first
     //
     constant& intern(vreg& reg, eval::array_type val) noexcept;
 
+    //
+    // Returns an interned constant with the same content as the given array
+    // Lookups go by the content hash, so literals from different functions
+    // and modules end up sharing one constant
+    //
+    constant* find_same(const eval::array_type& val) noexcept;
+
     //
     // Declares a record
     //
@@ -192,6 +212,7 @@ namespace tnac::ir
     rec_list m_recs;
     register_store m_regs;
     arr_store m_arrays;
+    const_pool m_constPool;
 
     loose_store m_looseModules;
   };
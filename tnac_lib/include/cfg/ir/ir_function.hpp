@@ -14,6 +14,12 @@ namespace tnac
 namespace tnac::ir
 {
   class record;
+  class vreg;
+}
+
+namespace tnac::eval
+{
+  enum class intrinsic : std::uint8_t;
 }
 
 namespace tnac::ir
@@ -29,6 +35,7 @@ namespace tnac::ir
     using child_list    = std::vector<function*>;
     using block_list    = block_container;
     using child_sym_tab = std::unordered_map<string_t, function*>;
+    using slot_type     = std::uint32_t;
 
     friend tnac::compiler;
     friend class builder;
@@ -84,6 +91,17 @@ namespace tnac::ir
     //
     bool is_loose() const noexcept;
 
+    //
+    // Checks whether the function is built-in
+    // Such functions have no blocks, and are computed by evaluators natively
+    //
+    bool is_intrinsic() const noexcept;
+
+    //
+    // Returns the id of a built-in function
+    //
+    eval::intrinsic intrinsic_id() const noexcept;
+
     //
     // Returns the number of function's parameters
     //
@@ -150,7 +168,7 @@ namespace tnac::ir
 
     //
     // Deletes a tree of basic blocks starting with the given one
-    // Walks the outs to reach subsequent blocks
+    // Walks the outs to reach subsequent blocks which are left without predecessors
     //
     void delete_block_tree(basic_block& root) noexcept;
 
@@ -164,6 +182,29 @@ namespace tnac::ir
     //
     string_t raw_name() const noexcept;
 
+    //
+    // Checks whether stack frame slots have been assigned
+    //
+    bool has_slots() const noexcept;
+
+    //
+    // Assigns stack frame slots to the function's local registers
+    // Parameters occupy the first slots in their declaration order,
+    // all other registers get dense indices after them
+    //
+    void assign_slots() noexcept;
+
+    //
+    // Returns the slot of a register assigning a new one if needed
+    // A new slot is never placed below the given lower bound
+    //
+    slot_type slot_of(vreg& reg, slot_type lowerBound = {}) noexcept;
+
+    //
+    // Returns the number of stack frame slots required by the function
+    //
+    slot_type slot_count() const noexcept;
+
   private:
     //
     // Adds a nested function
@@ -175,11 +216,21 @@ namespace tnac::ir
     //
     void add_child_name(string_t name, function& child) noexcept;
 
+    //
+    // Removes phi operands coming from a deleted block
+    //
+    static void drop_phi_inputs(basic_block& block, const basic_block& from) noexcept;
+
     //
     // Usable by ir builder
     //
     void make_loose() noexcept;
 
+    //
+    // Usable by ir builder
+    //
+    void make_intrinsic(eval::intrinsic id) noexcept;
+
   private:
     name_t m_name;
     function* m_owner{};
@@ -189,7 +240,10 @@ namespace tnac::ir
     entity_id m_id;
     record* m_rec{};
     child_sym_tab m_childSt;
+    slot_type m_slotCount{};
     size_type m_paramCount{};
+    eval::intrinsic m_intrinsic{};
     bool m_loose{};
+    bool m_slotsReady{};
   };
 }
\ No newline at end of file
@@ -28,8 +28,11 @@ namespace tnac::ir
   class vreg final : public node
   {
   public:
-    using idx_type = std::uint64_t;
-    using id_type  = std::variant<string_t, idx_type>;
+    using idx_type  = std::uint64_t;
+    using id_type   = std::variant<string_t, idx_type>;
+    using slot_type = std::uint32_t;
+
+    static constexpr auto noSlot = ~slot_type{};
 
     enum class reg_scope : std::uint8_t
     {
@@ -39,6 +42,7 @@ namespace tnac::ir
     using enum reg_scope;
 
     friend class instruction;
+    friend class function;
 
   public:
     CLASS_SPECIALS_NONE(vreg);
@@ -95,14 +99,28 @@ namespace tnac::ir
     //
     instruction& source() noexcept;
 
+    //
+    // Checks whether the register has been assigned a stack frame slot
+    //
+    bool has_slot() const noexcept;
+
+    //
+    // Returns the register's slot in its function's stack frame
+    // Must check has_slot before using
+    //
+    slot_type slot() const noexcept;
+
   protected:
     void make_result_of(instruction& src) noexcept;
 
     void drop_source_if(const instruction* instr) noexcept;
 
+    void assign_slot(slot_type slot) noexcept;
+
   private:
     id_type m_id;
     instruction* m_source{};
+    slot_type m_slot{ noSlot };
     reg_scope m_scope;
   };
 }
@@ -321,6 +339,7 @@ namespace tnac::ir
     Alloc,
     StructAlloc,
     Arr,
+    Range,
     Append,
     StoreElem,
 
@@ -403,6 +422,26 @@ namespace tnac::ir
     //
     instruction& add(operand op) noexcept;
 
+    //
+    // Replaces the operand at the specified index
+    // The result register stays attached to the instruction
+    // DOES NOT check the boundaries
+    //
+    void replace(size_type idx, operand op) noexcept;
+
+    //
+    // Removes the operand at the specified index
+    // Operands after it are shifted to the left
+    // DOES NOT check the boundaries
+    //
+    void remove(size_type idx) noexcept;
+
+    //
+    // Detaches the result register from this instruction
+    // Allows a copy of the instruction to become the register's source
+    //
+    void release_result() noexcept;
+
     //
     // Returns the number of operands
     //
@@ -22,6 +22,7 @@ namespace tnac::ir
   {
   public:
     using value_type = eval::value;
+    using hash_type  = std::size_t;
 
   public:
     CLASS_SPECIALS_NONE(constant);
@@ -30,6 +31,19 @@ namespace tnac::ir
 
     constant(vreg& reg, value_type val) noexcept;
 
+  public:
+    //
+    // Hashes a value by its content
+    // Arrays are hashed element by element, functions by identity
+    //
+    static hash_type content_hash(const value_type& val) noexcept;
+
+    //
+    // Checks whether two values have the same content
+    // Values of different types never match, and floats are compared bitwise
+    //
+    static bool same_content(const value_type& l, const value_type& r) noexcept;
+
   public:
     //
     // Returns a reference to the global register
@@ -48,9 +62,21 @@ namespace tnac::ir
     //
     const value_type& value() const noexcept;
 
+    //
+    // Returns the content hash of the interned value
+    //
+    hash_type hash() const noexcept;
+
+    //
+    // Checks whether the interned value has the same content as the given one
+    // Values of different types never match, and floats are compared bitwise
+    //
+    bool holds(const value_type& val) const noexcept;
+
   private:
     vreg* m_reg{};
     value_type m_value;
+    hash_type m_hash{};
   };
 }
 
@@ -0,0 +1,115 @@
+//
+// Dead code elimination and CFG simplification
+//
+
+#pragma once
+#include "cfg/ir/ir_builder.hpp"
+
+namespace tnac::ir
+{
+  //
+  // Cleans up a function after other passes
+  //
+  // Pure instructions whose results are never read are deleted. This is repeated
+  // for their operands, so whole chains of unused computations go away.
+  //
+  // Blocks which contain nothing but a jump are bypassed: their predecessors
+  // jump straight to the target. A block with a single predecessor which jumps
+  // only to it is merged into that predecessor.
+  //
+  // Edges are kept in sync with jumps, and phis are updated to take values
+  // along the new edges
+  //
+  class cleanup final
+  {
+  public:
+    using size_type = std::size_t;
+
+    //
+    // Changes made to a function
+    //
+    struct result
+    {
+      size_type m_erased{};
+      size_type m_merged{};
+    };
+
+  private:
+    using count_map  = std::unordered_map<const vreg*, size_type>;
+    using instr_list = std::vector<instruction*>;
+    using instr_set  = std::unordered_set<const instruction*>;
+    using block_list = std::vector<basic_block*>;
+    using block_set  = std::unordered_set<const basic_block*>;
+
+  public:
+    CLASS_SPECIALS_NONE(cleanup);
+
+    ~cleanup() noexcept;
+
+    explicit cleanup(builder& bld) noexcept;
+
+  public:
+    //
+    // Cleans up the given function
+    //
+    result operator()(function& fn) noexcept;
+
+  private:
+    //
+    // Deletes unused pure instructions
+    // Returns the number of deleted instructions
+    //
+    size_type erase_dead(function& fn) noexcept;
+
+    //
+    // Counts reads of registers in a function and its nested functions
+    //
+    void count_uses(const function& fn) noexcept;
+
+    //
+    // Bypasses a block which only forwards to another one
+    //
+    bool thread(basic_block& block) noexcept;
+
+    //
+    // Merges the single successor of a block into it
+    //
+    bool merge(basic_block& block) noexcept;
+
+    //
+    // Gives phis of a block the value they take from the old edge along the new one
+    // Loose edges of synthetic phis are recreated with the same value
+    //
+    void add_incoming(basic_block& block, const basic_block& from, const edge& old, edge& cur) noexcept;
+
+    //
+    // Removes phi operands coming from the given block
+    //
+    void drop_incoming(basic_block& block, const basic_block& from) noexcept;
+
+    //
+    // Replaces reads of a register with the given operand
+    //
+    void replace_uses(function& fn, const vreg& reg, const operand& val) noexcept;
+
+    //
+    // Disconnects a block from its successors and deletes it
+    //
+    void drop_block(basic_block& block) noexcept;
+
+    //
+    // Returns the only target of an unconditional jump ending the block
+    //
+    static basic_block* jump_target(basic_block& block) noexcept;
+
+    //
+    // Finds an edge connecting two blocks
+    //
+    static edge* find_edge(basic_block& from, const basic_block& to) noexcept;
+
+  private:
+    builder* m_builder{};
+    count_map m_uses;
+    block_set m_deleted;
+  };
+}
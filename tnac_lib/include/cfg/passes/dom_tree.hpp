@@ -0,0 +1,107 @@
+//
+// Dominator tree
+//
+
+#pragma once
+#include "cfg/ir/ir.hpp"
+
+namespace tnac::ir
+{
+  //
+  // Orders the blocks of a function and computes their dominators
+  //
+  // Self tail calls jump back to the loop header, so the graph can have cycles.
+  // Dominators are refined in reverse post order until they stop changing.
+  // Blocks which can't be reached from the entry are left out
+  //
+  class dom_tree final
+  {
+  public:
+    using block_list = std::vector<basic_block*>;
+    using size_type  = block_list::size_type;
+
+  private:
+    struct node
+    {
+      block_list m_preds;
+      block_list m_children;
+      basic_block* m_idom{};
+      size_type m_index{};
+    };
+
+    using node_map = std::unordered_map<const basic_block*, node>;
+
+  public:
+    CLASS_SPECIALS_NONE(dom_tree);
+
+    ~dom_tree() noexcept;
+
+    explicit dom_tree(function& fn) noexcept;
+
+  public:
+    //
+    // Returns the blocks a block can jump to
+    //
+    static block_list successors(basic_block& block) noexcept;
+
+  public:
+    //
+    // Returns reachable blocks in reverse post order
+    // The entry goes first
+    //
+    const block_list& order() const noexcept;
+
+    //
+    // Checks whether the block can be reached from the entry
+    //
+    bool is_reachable(const basic_block& block) const noexcept;
+
+    //
+    // Returns reachable predecessors of a block
+    // Each one is listed once, even if it has several jumps to the block
+    //
+    const block_list& preds(const basic_block& block) const noexcept;
+
+    //
+    // Returns the immediate dominator of a block
+    // The entry and unreachable blocks have none
+    //
+    basic_block* idom(const basic_block& block) const noexcept;
+
+    //
+    // Returns the blocks immediately dominated by the given one
+    //
+    const block_list& children(const basic_block& block) const noexcept;
+
+    //
+    // Checks whether the first block dominates the second one
+    // Every block dominates itself
+    //
+    bool dominates(const basic_block& dom, const basic_block& block) const noexcept;
+
+  private:
+    //
+    // Collects reachable blocks in reverse post order
+    //
+    void build_order(function& fn) noexcept;
+
+    //
+    // Computes immediate dominators
+    //
+    void build_tree() noexcept;
+
+    //
+    // Finds the closest common dominator of two blocks
+    //
+    basic_block* intersect(basic_block* l, basic_block* r) const noexcept;
+
+    //
+    // Returns the node of a reachable block
+    //
+    const node& node_of(const basic_block& block) const noexcept;
+
+  private:
+    node_map m_nodes;
+    block_list m_order;
+  };
+}
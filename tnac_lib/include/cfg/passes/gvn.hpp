@@ -0,0 +1,81 @@
+//
+// Global value numbering
+//
+
+#pragma once
+#include "cfg/passes/dom_tree.hpp"
+
+namespace tnac::ir
+{
+  //
+  // Removes pure instructions which repeat an earlier one
+  //
+  // Blocks are walked down the dominator tree. Every pure instruction is looked up
+  // among the ones in its dominators, and if there is one with the same opcode and
+  // operands, the duplicate is deleted and its uses are redirected to the earlier result.
+  //
+  // Pure instructions are unary and binary operations, type tests, and selects.
+  // Operands must be constants or registers
+  //
+  class gvn final
+  {
+  public:
+    using size_type = std::size_t;
+    using hash_type = constant::hash_type;
+    using hash_opt  = std::optional<hash_type>;
+
+  private:
+    using avail_map  = std::unordered_multimap<hash_type, instruction*>;
+    using scope_item = std::pair<hash_type, instruction*>;
+    using scope_list = std::vector<scope_item>;
+    using reg_map    = std::unordered_map<const vreg*, vreg*>;
+    using instr_list = std::vector<instruction*>;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(gvn);
+
+    ~gvn() noexcept;
+
+    gvn() noexcept;
+
+  public:
+    //
+    // Deduplicates instructions of the given function
+    // Returns the number of deleted instructions
+    //
+    size_type operator()(function& fn) noexcept;
+
+  private:
+    //
+    // Numbers instructions of a block and the blocks it dominates
+    //
+    void number(basic_block& block, const dom_tree& tree) noexcept;
+
+    //
+    // Hashes a pure instruction
+    // Returns an empty result if the instruction can't be deduplicated
+    //
+    hash_opt hash(const instruction& instr) const noexcept;
+
+    //
+    // Finds an available instruction computing the same value
+    //
+    instruction* find(hash_type h, const instruction& instr) const noexcept;
+
+    //
+    // Points operands of an instruction to the results which replaced them
+    //
+    void redirect(instruction& instr) const noexcept;
+
+    //
+    // Returns the replacement for a register, if it was the result of a deleted instruction
+    //
+    operand resolve(const operand& op) const noexcept;
+
+  private:
+    avail_map m_avail;
+    scope_list m_scope;
+    reg_map m_replaced;
+    instr_list m_dead;
+  };
+}
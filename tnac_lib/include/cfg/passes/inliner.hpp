@@ -0,0 +1,132 @@
+//
+// Function inlining
+//
+
+#pragma once
+#include "cfg/ir/ir_builder.hpp"
+
+namespace tnac::ir
+{
+  //
+  // Replaces calls to small functions with copies of their code
+  //
+  // A call is inlined if its callee is known at compile time, and the callee
+  // is small and simple enough. The caller's block is split after the call,
+  // blocks of the callee are copied in between, and its returns become jumps
+  // to the rest of the caller's block. Parameters are replaced by the arguments.
+  //
+  // Callees are optimised before their callers, so their calls have already been
+  // inlined where possible. The copied code isn't looked at again, and the depth
+  // limit stops chains of inlined functions from growing too long
+  //
+  class inliner final
+  {
+  public:
+    using size_type = std::size_t;
+
+    //
+    // Produces a unique name for a block from a prefix and a postfix
+    //
+    using block_namer = std::function<string_t(string_t, string_t)>;
+
+    //
+    // Inlining limits
+    //
+    struct settings
+    {
+      size_type m_maxSize{ 24 };
+      size_type m_maxDepth{ 4 };
+      bool m_enabled{ true };
+    };
+
+  private:
+    using reg_map    = std::unordered_map<const vreg*, operand>;
+    using block_map  = std::unordered_map<const basic_block*, basic_block*>;
+    using edge_map   = std::unordered_map<const edge*, edge*>;
+    using depth_map  = std::unordered_map<const function*, size_type>;
+    using instr_list = std::vector<instruction*>;
+    using edge_list  = std::vector<edge*>;
+    using instr_iter = basic_block::instruction_iter;
+
+  public:
+    CLASS_SPECIALS_NONE(inliner);
+
+    ~inliner() noexcept;
+
+    inliner(builder& bld, block_namer names) noexcept;
+
+  public:
+    //
+    // Returns the current settings
+    //
+    const settings& config() const noexcept;
+
+    //
+    // Replaces the current settings
+    //
+    void configure(const settings& cfg) noexcept;
+
+    //
+    // Inlines calls made by the given function
+    // Returns the number of inlined calls
+    //
+    size_type operator()(function& fn) noexcept;
+
+  private:
+    //
+    // Returns the callee of a call, if it can be inlined into the given function
+    //
+    const function* inlinable(const function& caller, const instruction& call) const noexcept;
+
+    //
+    // Checks whether the code of a function can be copied elsewhere
+    //
+    bool can_copy(const function& callee, const function& caller) const noexcept;
+
+    //
+    // Replaces a call with the callee's code
+    //
+    void inline_call(instruction& call, const function& callee) noexcept;
+
+    //
+    // Moves instructions following the call and outgoing edges to a new block
+    //
+    basic_block& split(instruction& call) noexcept;
+
+    //
+    // Creates new registers for the callee's results,
+    // and maps its parameters to the arguments
+    //
+    void map_registers(const function& callee, const instruction& call) noexcept;
+
+    //
+    // Creates copies of the callee's blocks and edges
+    //
+    void copy_graph(const function& callee, function& caller) noexcept;
+
+    //
+    // Copies instructions of a callee's block before the given position
+    // Returns are turned into jumps to the continuation block
+    //
+    void copy_block(const basic_block& src, basic_block& cont, instr_iter pos, edge_list& rets) noexcept;
+
+    //
+    // Returns the operand which replaces the given one in copied code
+    //
+    operand map(const operand& op) noexcept;
+
+    //
+    // Returns the inlining depth of a function
+    //
+    size_type depth_of(const function& fn) const noexcept;
+
+  private:
+    builder* m_builder{};
+    block_namer m_names;
+    settings m_settings;
+    depth_map m_depth;
+    reg_map m_regs;
+    block_map m_blocks;
+    edge_map m_edges;
+  };
+}
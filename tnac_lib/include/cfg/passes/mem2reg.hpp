@@ -0,0 +1,124 @@
+//
+// Promotion of variables to registers
+//
+
+#pragma once
+#include "cfg/ir/ir_builder.hpp"
+#include "cfg/passes/dom_tree.hpp"
+
+namespace tnac::ir
+{
+  //
+  // Rewrites variables of a function into SSA registers
+  //
+  // The compiler gives every variable an Alloc slot, which is written by stores
+  // and read by loads. A variable is promoted if nothing but its own stores and loads
+  // refers to it. Its loads are replaced by the values which reach them,
+  // and values coming from different predecessors are merged by phi nodes.
+  // After that, the variable's allocation, stores, and loads are deleted.
+  //
+  // The only cycles in the CFG of a function are self tail calls jumping back to
+  // the loop header. Variables are allocated there, and each allocation starts
+  // a variable over, so no variable values flow along the back edges.
+  // This makes a single walk in reverse post order enough
+  //
+  class mem2reg final
+  {
+  public:
+    using size_type  = std::size_t;
+    using block_list = dom_tree::block_list;
+    using instr_list = std::vector<instruction*>;
+    using var_set    = std::unordered_set<const vreg*>;
+    using value_map  = std::unordered_map<const vreg*, operand>;
+
+  private:
+    //
+    // Per-block state
+    //
+    struct block_info
+    {
+      var_set m_liveIn;
+      value_map m_out;
+    };
+
+    using info_map = std::unordered_map<const basic_block*, block_info>;
+    using var_map  = std::unordered_map<const vreg*, instruction*>;
+
+  public:
+    CLASS_SPECIALS_NONE(mem2reg);
+
+    ~mem2reg() noexcept;
+
+    explicit mem2reg(builder& bld) noexcept;
+
+  public:
+    //
+    // Promotes variables of the given function
+    // Returns the number of promoted variables
+    //
+    size_type operator()(function& fn) noexcept;
+
+  private:
+    //
+    // Collects the variables which can be promoted
+    //
+    void collect(function& fn) noexcept;
+
+    //
+    // Drops variables referenced from nested functions
+    //
+    void drop_escaping(const function& fn) noexcept;
+
+    //
+    // Orders blocks for the walk
+    // Unreachable blocks go last
+    //
+    void order(function& fn) noexcept;
+
+    //
+    // Finds variables which are read in or after each block before being written
+    //
+    void compute_liveness() noexcept;
+
+    //
+    // Replaces loads of promoted variables in a block
+    //
+    void rename(basic_block& block) noexcept;
+
+    //
+    // Replaces results of deleted loads in values phis take along their edges
+    // Loads feeding a back edge are renamed after the phis which read them
+    //
+    void resolve_phis() noexcept;
+
+    //
+    // Computes values of promoted variables at the start of a block
+    // Inserts phi nodes where predecessors disagree
+    //
+    value_map incoming(basic_block& block, const block_info& info) noexcept;
+
+    //
+    // Returns the value of a promoted variable at the end of a block
+    //
+    operand value_at_end(const basic_block& block, const vreg& var) const noexcept;
+
+    //
+    // Returns the replacement for a register, if it was the result of a deleted load
+    //
+    operand resolve(const operand& op) const noexcept;
+
+    //
+    // Checks whether the register is a promoted variable
+    //
+    bool is_promoted(const operand& op) const noexcept;
+
+  private:
+    builder* m_builder{};
+    const dom_tree* m_tree{};
+    var_map m_vars;
+    value_map m_replaced;
+    block_list m_order;
+    info_map m_blocks;
+    instr_list m_dead;
+  };
+}
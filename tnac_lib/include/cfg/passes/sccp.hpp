@@ -0,0 +1,173 @@
+//
+// Sparse conditional constant propagation
+//
+
+#pragma once
+#include "cfg/ir/ir.hpp"
+
+namespace tnac::ir
+{
+  //
+  // Propagates constants through the function's registers and branches
+  //
+  // Every register starts as unknown and can only go up to a constant,
+  // and then to varying. Blocks start as unreached, and become reached once
+  // a jump which can actually be taken leads to them. Phis only merge values
+  // coming along such jumps, so a branch which is never taken doesn't spoil
+  // the result.
+  //
+  // After that, registers holding constants are replaced by their values,
+  // conditional jumps with known conditions become unconditional,
+  // and blocks which were never reached are deleted.
+  //
+  // Only scalar values are propagated, arrays and functions are left alone
+  //
+  class sccp final
+  {
+  public:
+    using size_type = std::size_t;
+
+    //
+    // Changes made to a function
+    //
+    struct result
+    {
+      size_type m_folded{};
+      size_type m_pruned{};
+    };
+
+  private:
+    enum class state : std::uint8_t
+    {
+      Unknown,
+      Const,
+      Varying
+    };
+
+    struct lattice
+    {
+      state m_state{};
+      eval::value m_value;
+    };
+
+    using lattice_map = std::unordered_map<const vreg*, lattice>;
+    using instr_list  = std::vector<instruction*>;
+    using user_map    = std::unordered_map<const vreg*, instr_list>;
+    using reg_set     = std::unordered_set<const vreg*>;
+    using block_set   = std::unordered_set<const basic_block*>;
+    using flow_map    = std::unordered_map<const basic_block*, block_set>;
+    using flow_item   = std::pair<basic_block*, basic_block*>;
+    using flow_list   = std::vector<flow_item>;
+    using bool_opt    = std::optional<bool>;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(sccp);
+
+    ~sccp() noexcept;
+
+    sccp() noexcept;
+
+  public:
+    //
+    // Propagates constants in the given function
+    //
+    result operator()(function& fn) noexcept;
+
+  private:
+    //
+    // Collects the registers which can hold constants and their users
+    //
+    void collect(function& fn) noexcept;
+
+    //
+    // Drops registers referenced from nested functions
+    //
+    void drop_escaping(const function& fn) noexcept;
+
+    //
+    // Runs the analysis until nothing changes
+    //
+    void solve(function& fn) noexcept;
+
+    //
+    // Checks whether every reached conditional jump got a condition
+    // Otherwise, the analysis can't tell which blocks are dead
+    //
+    bool is_settled(function& fn) const noexcept;
+
+    //
+    // Queues a jump from one block to another
+    //
+    void reach(basic_block& from, basic_block& to) noexcept;
+
+    //
+    // Checks whether a jump from one block to another can be taken
+    //
+    bool is_flowing(const basic_block& from, const basic_block& to) const noexcept;
+
+    //
+    // Evaluates an instruction of a reached block
+    //
+    void visit(instruction& instr) noexcept;
+
+    //
+    // Queues the targets of a jump which can be taken
+    //
+    void visit_jump(instruction& instr) noexcept;
+
+    //
+    // Merges values of a phi coming from the jumps which can be taken
+    //
+    lattice eval_phi(const instruction& instr) const noexcept;
+
+    //
+    // Computes the result of a foldable instruction
+    //
+    lattice eval_pure(const instruction& instr) const noexcept;
+
+    //
+    // Raises the state of an instruction's result and queues its users
+    //
+    void update(const instruction& instr, lattice val) noexcept;
+
+    //
+    // Returns the lattice of an operand
+    //
+    lattice value_of(const operand& op) const noexcept;
+
+    //
+    // Replaces registers with known values and deletes their instructions
+    //
+    size_type fold(function& fn) noexcept;
+
+    //
+    // Turns conditional jumps with known conditions into unconditional ones
+    // and drops phi inputs which are never taken
+    //
+    size_type fold_jumps(function& fn) noexcept;
+
+    //
+    // Deletes blocks which were never reached
+    //
+    size_type prune(function& fn) noexcept;
+
+  private:
+    //
+    // Combines two lattice values
+    //
+    static lattice meet(const lattice& l, const lattice& r) noexcept;
+
+    //
+    // Returns the value of a condition, if it is a known bool
+    //
+    static bool_opt as_bool(const lattice& val) noexcept;
+
+  private:
+    lattice_map m_values;
+    user_map m_users;
+    block_set m_reached;
+    flow_map m_flows;
+    flow_list m_flowWork;
+    instr_list m_instrWork;
+  };
+}
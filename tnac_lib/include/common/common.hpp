@@ -19,6 +19,14 @@ namespace tnac
 #else
 #endif
 
+#if defined(__linux__) && defined(__x86_64__)
+#define TNAC_LINUX_X64 1
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TNAC_X64 1
+#endif
+
 namespace tnac::rt
 {
   using in_stream  = utils::istream;
@@ -159,6 +167,14 @@ namespace tnac
       return static_cast<bool>(m_refs);
     }
 
+    //
+    // Returns the number of live references
+    //
+    counter_type refs() const noexcept
+    {
+      return m_refs;
+    }
+
   private:
     counter_type m_refs{};
   };
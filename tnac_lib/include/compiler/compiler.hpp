@@ -7,6 +7,7 @@
 #include "compiler/detail/context.hpp"
 #include "compiler/detail/name_repo.hpp"
 #include "compiler/detail/compiler_stack.hpp"
+#include "cfg/passes/inliner.hpp"
 
 namespace tnac
 {
@@ -53,6 +54,23 @@ namespace tnac
     using size_opt  = std::optional<size_type>;
 
     using val_opt = std::optional<eval::value>;
+    using counter = std::size_t;
+
+    using inline_settings = ir::inliner::settings;
+
+    //
+    // Cumulative counters of optimisation passes
+    //
+    struct opt_stats
+    {
+      counter m_promoted{};
+      counter m_folded{};
+      counter m_pruned{};
+      counter m_deduplicated{};
+      counter m_erased{};
+      counter m_merged{};
+      counter m_inlined{};
+    };
 
   public:
     CLASS_SPECIALS_NONE(compiler);
@@ -92,6 +110,33 @@ namespace tnac
     //
     const ir::vreg* peek_reg() const noexcept;
 
+    //
+    // Returns the counters of optimisation passes
+    //
+    const opt_stats& opt_counters() const noexcept;
+
+    //
+    // Returns the current inlining settings
+    //
+    const inline_settings& inlining() const noexcept;
+
+    //
+    // Sets limits for inlining, or turns it off
+    // Affects functions compiled afterwards
+    //
+    void configure_inlining(const inline_settings& cfg) noexcept;
+
+    //
+    // Checks whether optimisation passes run on compiled functions
+    //
+    bool is_optimising() const noexcept;
+
+    //
+    // Turns optimisation passes on or off
+    // Affects functions compiled afterwards
+    //
+    void set_optimising(bool enable) noexcept;
+
     //
     // Compiles an existing module attached to the CFG after initial compilation
     // Also, stays in the newly attached module and maintains its context
@@ -306,6 +351,11 @@ namespace tnac
     //
     void emit_inst(ir::op_code oc, size_type opCount, size_type factCount) noexcept;
 
+    //
+    // Creates a range instruction, or a range value if all arguments are known
+    //
+    void emit_range(size_type argSz) noexcept;
+
     //
     // Creates a series of append instructions to fill an array
     //
@@ -321,6 +371,20 @@ namespace tnac
     //
     void emit_call(ir::operand callable, size_type argCount) noexcept;
 
+    //
+    // Replaces a call to the current function in tail position
+    // with a jump back to the loop header
+    // Arguments are passed along the new edge into the parameter phis
+    //
+    void emit_tail_call(size_type argCount) noexcept;
+
+    //
+    // Creates the block self tail calls jump back to and enters it
+    // Parameters are redefined there by phis which start with their initial values
+    // Only emitted for functions which have a self tail call in their body
+    //
+    void emit_loop_header(params_t& params) noexcept;
+
     //
     // Creates a bind instruction
     //
@@ -363,18 +427,46 @@ namespace tnac
     //
     bool delete_block_tree(ir::basic_block& root) noexcept;
 
+    //
+    // Runs optimisation passes over a function whose code is complete
+    // Modules are skipped, since the REPL keeps appending code to them
+    //
+    void optimise(ir::function& fn) noexcept;
+
     //
     // Checks whether the current block has a connection to the return block
+    // or to the loop header, which only self tail calls jump back to
     // Needed to properly handle early returns
     //
     bool has_ret_jump() noexcept;
 
     //
     // Checks whether the given block has a connection to the return block
+    // or to the loop header, which only self tail calls jump back to
     // Needed to properly handle early returns
     //
     bool has_ret_jump(ir::basic_block& block) noexcept;
 
+
+    //
+    // Marks the expression which produces the value of the given node as being in tail position
+    // Calls are only marked inside branches, since at the top level
+    // they'd share the block with the function's return
+    //
+    void mark_tail(ast::node& node, bool inBranch) noexcept;
+
+    //
+    // Returns the expression which produces the value of the given node
+    // Returns nullptr if it can't be in tail position
+    //
+    ast::node* tail_target(ast::node& node, bool inBranch) noexcept;
+
+    //
+    // Checks whether the given node reaches a call to the current function in tail position
+    // Follows conditional branches the same way they are marked during compilation
+    //
+    bool has_self_tail_call(ast::node& node, bool inBranch) noexcept;
+
     //
     // Checks whether the previous instruction has been a jump, and we're in the same block
     //
@@ -514,18 +606,20 @@ namespace tnac
     //
     // Interns an array
     // This is needed in order to store compile-time arrays in a special data section
+    // The operand is replaced with the interned array if one with the same content exists
     //
-    void intern_array(const ir::operand& op) noexcept;
+    void intern_array(ir::operand& op) noexcept;
 
     //
     // Interns arrays in all operands of an instruction
     //
-    void intern_array(const ir::instruction& instr) noexcept;
+    void intern_array(ir::instruction& instr) noexcept;
 
     //
     // Recursively interns all subarrays of an array
+    // Returns the interned array, which can be an existing one with the same content
     //
-    void intern_array(eval::value val) noexcept;
+    eval::value intern_array(eval::value val) noexcept;
 
     //
     // Reports a generic error
@@ -555,5 +649,8 @@ namespace tnac
     detail::context m_context;
     detail::name_repo m_names;
     detail::compiler_stack m_stack;
+    opt_stats m_optStats;
+    ir::inliner m_inliner;
+    bool m_optimise{ true };
   };
 }
\ No newline at end of file
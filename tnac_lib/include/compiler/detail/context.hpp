@@ -11,6 +11,7 @@ namespace tnac
     class module_def;
     class func_decl;
     class ret_expr;
+    class node;
     class scope;
     class expr;
   }
@@ -47,11 +48,13 @@ namespace tnac::detail
     using instr_iter   = utils::ilist<ir::instruction>::iterator;
     using symbol       = semantics::symbol;
     using reg_idx      = std::uint64_t;
+    using param_list   = std::vector<ir::vreg*>;
 
   private:
     struct var_data;
     using var_store       = std::unordered_map<symbol*, var_data>;
     using known_var_names = std::unordered_set<string_t>;
+    using tail_set        = std::unordered_set<const ast::node*>;
 
     struct closure;
     using closure_store   = std::unordered_map<ir::function*, closure>;
@@ -92,6 +95,16 @@ namespace tnac::detail
     //
     ir::vreg* locate_prev(symbol& sym) noexcept;
 
+    //
+    // Appends a register holding the next parameter of the current function
+    //
+    void add_param(ir::vreg& reg) noexcept;
+
+    //
+    // Returns registers holding parameters of the current function
+    //
+    const param_list& params() noexcept;
+
     //
     // Discards the collected data
     //
@@ -156,9 +169,35 @@ namespace tnac::detail
     //
     ir::basic_block* return_block() noexcept;
 
+    //
+    // Sets the block which self tail calls jump back to
+    //
+    void set_loop_header(ir::basic_block& header) noexcept;
+
+    //
+    // Returns a pointer to the block which self tail calls jump back to
+    //
+    ir::basic_block* loop_header() noexcept;
+
+    //
+    // Returns the block where the function's body starts
+    // This is the loop header if the function has one, otherwise, the entry
+    // Only functions with a self tail call have a header
+    //
+    ir::basic_block& body_block() noexcept;
+
+    //
+    // Gets the position of the first instruction of the function's body
+    // Allocations are placed here, so that they are redone by self tail calls
+    // Without a header, this is the start of the function. With one, this is
+    // the first instruction after the parameter phis, or, while the header
+    // is still empty, the end of the entry, which must end by jumping to it
+    //
+    instr_iter body_start() noexcept;
+
     //
     // Returns a reference to the terminal block if available
-    // Otherwise, returns a reference to the entry
+    // Otherwise, returns a reference to the block where the body starts
     //
     ir::basic_block& terminal_or_entry() noexcept;
 
@@ -236,6 +275,16 @@ namespace tnac::detail
     //
     bool is_in_func_scope() const noexcept;
 
+    //
+    // Marks a node as being in tail position of the current function
+    //
+    void mark_tail(const ast::node& node) noexcept;
+
+    //
+    // Checks whether the node is in tail position of the current function
+    //
+    bool is_tail(const ast::node& node) const noexcept;
+
     //
     // Creates an uninited closure
     //
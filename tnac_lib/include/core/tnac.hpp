@@ -62,6 +62,8 @@ namespace tnac
 
     //
     // Compiles code from an AST node
+    // Code the evaluator has lowered so far is dropped, since the compiled
+    // functions can get new instructions
     //
     void compile(ast::node& node) noexcept;
 
@@ -105,6 +107,11 @@ namespace tnac
     //
     compiler& get_compiler() noexcept;
 
+    //
+    // Returns the value store
+    //
+    eval::store& get_store() noexcept;
+
   public:
     //
     // Declares a command
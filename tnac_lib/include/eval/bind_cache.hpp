@@ -0,0 +1,74 @@
+//
+// Bind cache
+//
+
+#pragma once
+
+namespace tnac::ir
+{
+  class function;
+}
+
+namespace tnac::eval
+{
+  //
+  // Inline cache for dynamic member binds
+  // Remembers receivers seen at a bind site along with the members they resolved to.
+  // Holds one receiver (monomorphic) up to its capacity (polymorphic),
+  // after that it stops caching new receivers and falls back to name lookups
+  //
+  class bind_cache final
+  {
+  public:
+    using size_type = std::uint8_t;
+    using counter   = std::size_t;
+
+    static constexpr auto capacity = size_type{ 4 };
+
+    //
+    // Cumulative hit and miss counters
+    //
+    struct stats
+    {
+      counter m_hits{};
+      counter m_misses{};
+    };
+
+  private:
+    struct entry
+    {
+      const ir::function* m_receiver{};
+      ir::function* m_member{};
+    };
+
+    using entry_list = std::array<entry, capacity>;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(bind_cache);
+
+    ~bind_cache() noexcept;
+
+    bind_cache() noexcept;
+
+  public:
+    //
+    // Resolves a member of the given receiver by name
+    // Consults the cached entries first and updates the provided counters
+    //
+    ir::function* lookup(ir::function& receiver, string_t name, stats& st) noexcept;
+
+    //
+    // Returns the number of cached receivers
+    //
+    size_type size() const noexcept;
+
+    //
+    // Checks whether the cache has run out of space for new receivers
+    //
+    bool is_megamorphic() const noexcept;
+
+  private:
+    entry_list m_entries{};
+    size_type m_size{};
+  };
+}
@@ -0,0 +1,221 @@
+//
+// Flat pre-decoded code
+//
+
+#pragma once
+#include "cfg/ir/ir.hpp"
+#include "eval/bind_cache.hpp"
+
+namespace tnac
+{
+  class ir_eval;
+}
+
+namespace tnac::eval
+{
+  //
+  // Specifies where the value of a flat operand resides
+  //
+  enum class flat_src : std::uint8_t
+  {
+    None,
+    Slot,
+    Const
+  };
+
+  //
+  // Operand of a flat instruction
+  // Refers either to a stack frame slot or to a constant pool entry
+  //
+  struct flat_operand
+  {
+    std::uint32_t m_idx{};
+    flat_src m_src{ flat_src::None };
+  };
+
+  //
+  // Incoming value of a phi node
+  //
+  struct flat_incoming
+  {
+    const ir::basic_block* m_from{};
+    flat_operand m_val{};
+  };
+
+  //
+  // Trailing operand of a fused chain of binary operations
+  //
+  struct flat_link
+  {
+    flat_operand m_val{};
+    val_ops m_op{};
+  };
+
+  //
+  // Fixed-width pre-decoded instruction
+  // Operands and jump targets are resolved at lowering time, and the handler
+  // is stored directly in the instruction so that the evaluator doesn't need to
+  // look it up while running
+  // Chains of binary operations, where each result is only used as the left
+  // operand of the next one, are fused into their last instruction
+  //
+  struct flat_instr
+  {
+    using handler = void (ir_eval::*)(const flat_instr&) noexcept;
+    static constexpr auto maxOps = 3u;
+
+    handler m_handler{};
+    const ir::instruction* m_src{};
+    const flat_instr* m_target{};
+    const flat_instr* m_altTarget{};
+    const flat_incoming* m_incoming{};
+    const flat_link* m_links{};
+    bind_cache* m_bindCache{};
+    std::array<flat_operand, maxOps> m_ops{};
+    std::uint32_t m_res{};
+    std::uint32_t m_incomingCount{};
+    std::uint32_t m_linkCount{};
+    val_ops m_valOp{};
+  };
+
+
+  //
+  // Contiguous flat code of a single function
+  // The entry block always comes first
+  //
+  class flat_code final
+  {
+  public:
+    using instr_list    = std::vector<flat_instr>;
+    using incoming_list = std::vector<flat_incoming>;
+    using link_list     = std::vector<flat_link>;
+    using cache_list    = std::forward_list<bind_cache>;
+    using size_type     = instr_list::size_type;
+
+    friend class code_store;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(flat_code);
+
+    ~flat_code() noexcept;
+
+    flat_code() noexcept;
+
+  public:
+    //
+    // Returns a pointer to the first instruction
+    //
+    const flat_instr* entry() const noexcept;
+
+    //
+    // Returns the number of instructions
+    //
+    size_type size() const noexcept;
+
+  private:
+    instr_list m_instrs;
+    incoming_list m_incoming;
+    link_list m_links;
+    cache_list m_bindCaches;
+  };
+
+
+  //
+  // Lowers IR functions into flat code and owns the result
+  // along with the shared constant pool
+  //
+  class code_store final
+  {
+  public:
+    using code_map   = std::unordered_map<const ir::function*, flat_code>;
+    using const_pool = std::vector<value>;
+    using const_idx  = std::uint32_t;
+    using instr_ptr  = const ir::instruction*;
+    using chain_map  = std::unordered_map<instr_ptr, instr_ptr>;
+
+    //
+    // Fills in the handler and the op for the given instruction
+    // Returns false if the instruction needs no runtime representation
+    //
+    using decorator = bool (*)(const ir::instruction&, flat_instr&) noexcept;
+
+    using counter = std::size_t;
+
+    //
+    // Cumulative lowering counters
+    // They survive clearing the store, so lowering the same function again counts again
+    //
+    struct stats
+    {
+      counter m_functions{};
+      counter m_chains{};
+      counter m_fused{};
+    };
+
+  public:
+    CLASS_SPECIALS_NONE(code_store);
+
+    ~code_store() noexcept;
+
+    explicit code_store(decorator dec) noexcept;
+
+  public:
+    //
+    // Returns the flat code for the given function
+    // Lowers it on the first request
+    // The code is cached by function, the store has to be cleared if one changes
+    // The function's registers must have their slots assigned by this point
+    //
+    const flat_code& code_for(const ir::function& fn) noexcept;
+
+    //
+    // Returns a constant pool entry
+    //
+    const value& constant(const_idx idx) const noexcept;
+
+    //
+    // Drops all lowered code along with the constant pool
+    //
+    void clear() noexcept;
+
+    //
+    // Returns the counters of lowered functions, fused chains,
+    // and the instructions folded into them
+    //
+    const stats& counters() const noexcept;
+
+  private:
+    //
+    // Lowers a function
+    //
+    void lower(const ir::function& fn, flat_code& code) noexcept;
+
+    //
+    // Lowers a single instruction
+    //
+    void lower(const ir::instruction& instr, flat_code& code) noexcept;
+
+    //
+    // Lowers a chain of binary operations into one instruction
+    // The chain is given by its first instruction and the links to the next ones
+    //
+    void lower_chain(const ir::instruction& first, const chain_map& chains, flat_code& code) noexcept;
+
+    //
+    // Finds chains of binary operations which can be fused
+    // Maps each instruction in a chain to the next one
+    //
+    static chain_map find_chains(const ir::function& fn) noexcept;
+
+    //
+    // Resolves an IR operand
+    //
+    flat_operand to_flat(const ir::operand& op) noexcept;
+
+  private:
+    code_map m_code;
+    const_pool m_consts;
+    decorator m_decorator{};
+    stats m_stats;
+  };
+}
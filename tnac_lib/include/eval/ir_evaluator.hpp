@@ -5,6 +5,11 @@
 #pragma once
 #include "eval/stack/call_stack.hpp"
 #include "eval/environment.hpp"
+#include "eval/flat_code.hpp"
+#include "eval/memo_cache.hpp"
+#include "eval/jit/native_jit.hpp"
+#include "eval/par/par_calls.hpp"
+#include "eval/par/par_elems.hpp"
 #include "eval/value/value.hpp"
 #include "eval/value/value_store.hpp"
 #include "cfg/cfg.hpp"
@@ -35,12 +40,36 @@ namespace tnac
       entity_id m_callRes{};
     };
 
+    //
+    // State of a reduction whose folding function is being called
+    //
+    struct reduction
+    {
+      eval::value m_arr;
+      eval::value m_fn;
+      std::size_t m_idx{};
+    };
+
+    struct memo_call
+    {
+      const eval::stack_frame* m_frame{};
+      eval::memo_cache::key m_key;
+      std::size_t m_effects{};
+    };
+
     using branch_stack = utils::stack<branch>;
+    using memo_stack   = utils::stack<memo_call>;
     using arr_map      = std::unordered_map<eval::array_wrapper*, arr_call>;
+    using red_map      = std::unordered_map<const eval::stack_frame*, reduction>;
+    using bind_map     = std::unordered_map<const ir::instruction*, eval::bind_cache>;
+    using val_list     = std::vector<eval::value>;
 
   public:
     using val_opt  = std::optional<eval::value>;
     using op_count = ir::instruction::size_type;
+    using bind_stats = eval::bind_cache::stats;
+    using flat_stats = eval::code_store::stats;
+    using memo_key   = std::optional<eval::memo_cache::key>;
 
   public:
     CLASS_SPECIALS_NONE(ir_eval);
@@ -66,6 +95,12 @@ namespace tnac
     //
     void clear_env() noexcept;
 
+    //
+    // Drops the flat code lowered from functions
+    // Must be called when the CFG changes, since the code is cached by function
+    //
+    void drop_code() noexcept;
+
     //
     // Creates a stack frame for the given function and enters it
     //
@@ -88,6 +123,7 @@ namespace tnac
 
     //
     // Evaluates an entire function
+    // Freshly entered functions are run from their flat code
     //
     void evaluate_current() noexcept;
 
@@ -102,6 +138,56 @@ namespace tnac
     //
     void add_arg(eval::value arg) noexcept;
 
+    //
+    // Returns hit and miss counters of dynamic bind caches
+    //
+    const bind_stats& dyn_bind_stats() const noexcept;
+
+    //
+    // Returns the counters of flat code lowering
+    //
+    const flat_stats& flat_code_stats() const noexcept;
+
+    //
+    // Returns the cache of memoised function results
+    //
+    const eval::memo_cache& memo() const noexcept;
+
+    //
+    // Returns the cache of memoised function results
+    //
+    eval::memo_cache& memo() noexcept;
+
+    //
+    // Returns the native backend
+    //
+    const eval::native_jit& jit() const noexcept;
+
+    //
+    // Returns the native backend
+    //
+    eval::native_jit& jit() noexcept;
+
+    //
+    // Returns the parallel array call runner
+    //
+    const eval::par_calls& par() const noexcept;
+
+    //
+    // Returns the parallel array call runner
+    //
+    eval::par_calls& par() noexcept;
+
+    //
+    // Returns the runner for parallel elementwise operations
+    //
+    const eval::par_elems& par_elems() const noexcept;
+
+    //
+    // Returns the runner for parallel elementwise operations
+    //
+    eval::par_elems& par_elems() noexcept;
+
   private:
     //
     // Returns a reference to the current instruction
@@ -118,6 +204,26 @@ namespace tnac
     //
     val_opt get_value(const eval::stack_frame& frame, const ir::operand& op) const noexcept;
 
+    //
+    // Returns a reference to the value of the given operand without copying it
+    // Refers to an invalid value if the operand holds none
+    // The reference is invalidated by the next store to the current frame
+    //
+    const eval::value& borrow_value(const ir::operand& op) const noexcept;
+
+    //
+    // Returns a reference to the value of the given operand without copying it
+    // Refers to an invalid value if the operand holds none
+    // The reference is invalidated by the next store to the frame
+    //
+    const eval::value& borrow_value(const eval::stack_frame& frame, const ir::operand& op) const noexcept;
+
+    //
+    // Extracts the value of an operand of a frame which is about to be left
+    // Register values are moved out of their slots instead of being copied
+    //
+    eval::value take_value(eval::stack_frame& frame, const ir::operand& op) noexcept;
+
     //
     // Attempts to extract the callee's owner to be used as a 'this' register in calls
     //
@@ -191,6 +297,11 @@ namespace tnac
     //
     void alloc_array() noexcept;
 
+    //
+    // Creates a lazy range
+    //
+    void alloc_range() noexcept;
+
     //
     // Allocates a record with the given parameters
     //
@@ -233,6 +344,7 @@ namespace tnac
 
     //
     // Handles phi nodes
+    // All phis at the start of a block read their values before any of them is written
     //
     void phi() noexcept;
 
@@ -241,6 +353,11 @@ namespace tnac
     //
     void dyn_bind() noexcept;
 
+    //
+    // Handles dynamic binds using the given bind site cache
+    //
+    void dyn_bind(eval::bind_cache& cache) noexcept;
+
     //
     // Handles static binds
     //
@@ -275,7 +392,7 @@ namespace tnac
     // Calls the target function
     // Returns true on success
     //
-    bool call(entity_id regId, eval::value f, const ir::instruction& instr) noexcept;
+    bool call(entity_id regId, const eval::value& f, const ir::instruction& instr) noexcept;
 
     //
     // Performs an array call
@@ -288,6 +405,50 @@ namespace tnac
     //
     void call() noexcept;
 
+    //
+    // Runs an array call on the worker pool
+    // Returns an empty result if the call is to be evaluated sequentially
+    //
+    val_opt call_par(eval::array_wrapper& arr, const ir::instruction& instr) noexcept;
+
+    //
+    // Runs the call from native code if the callee has been compiled
+    // Returns an empty result if the call is to be interpreted
+    //
+    val_opt call_native(const eval::value& f, const ir::instruction& instr) noexcept;
+
+    //
+    // Computes a call to a built-in function
+    // Returns an empty result if the callee is not built-in, or is a reduction
+    //
+    val_opt call_intrinsic(const eval::value& f, const ir::instruction& instr) noexcept;
+
+    //
+    // Handles calls to the built-in reduce
+    // The folding function is called once per element, and each return
+    // comes back to the call instruction to pick the next one
+    // Returns false if the callee is something else
+    //
+    bool reduce(entity_id regId, const eval::value& f, const ir::instruction& instr) noexcept;
+
+    //
+    // Creates a memo key for a call if the callee is to be memoised
+    // Calls through binds are skipped since they carry a 'this' value
+    //
+    memo_key make_memo_key(const eval::value& f, const ir::instruction& instr) noexcept;
+
+    //
+    // Remembers the call which has just entered the current frame
+    // so that its result can be cached on return
+    //
+    void memo_enter(eval::memo_cache::key k) noexcept;
+
+    //
+    // Caches the result of the current frame's call if it is being memoised
+    // Calls which have caused side effects get their callee excluded instead
+    //
+    void memo_leave(const eval::value& res) noexcept;
+
     //
     // Handles bind instructions
     //
@@ -308,16 +469,123 @@ namespace tnac
     //
     void ret() noexcept;
 
+    //
+    // Pops the current stack frame
+    //
+    void pop_frame() noexcept;
+
+  private:
+    //
+    // Sets the flat handler and op for an instruction
+    // Returns false for instructions which need no runtime representation
+    //
+    static bool decorate(const ir::instruction& instr, eval::flat_instr& fi) noexcept;
+
+    //
+    // Runs the current function from its flat code until it returns
+    // Does nothing if the function is not at its entry point
+    //
+    void run_flat() noexcept;
+
+    //
+    // Returns a reference to the value of a flat operand
+    // The reference is invalidated by the next store to the current frame
+    //
+    const eval::value& flat_value(const eval::flat_operand& op) const noexcept;
+
+    //
+    // Extracts the value of a flat operand of a frame which is about to be left
+    // Slot values are moved out instead of being copied
+    //
+    eval::value flat_take(const eval::flat_operand& op) noexcept;
+
+    //
+    // Moves to a flat jump target and updates the current branch
+    //
+    void flat_jump_to(const eval::flat_instr& target) noexcept;
+
+    //
+    // Flat handler for jumps
+    //
+    void flat_jump(const eval::flat_instr& fi) noexcept;
+
+    //
+    // Flat handler for calls
+    //
+    void flat_call(const eval::flat_instr& fi) noexcept;
+
+    //
+    // Flat handler for returns
+    //
+    void flat_ret(const eval::flat_instr& fi) noexcept;
+
+    //
+    // Flat handler for phi nodes
+    // Handles the whole run of phis starting with the given one
+    //
+    void flat_phi(const eval::flat_instr& fi) noexcept;
+
+    //
+    // Flat handler for selects
+    //
+    void flat_select(const eval::flat_instr& fi) noexcept;
+
+    //
+    // Flat handler for stores and loads of plain values
+    //
+    void flat_copy(const eval::flat_instr& fi) noexcept;
+
+    //
+    // Flat handler for unary operations
+    //
+    void flat_unary(const eval::flat_instr& fi) noexcept;
+
+    //
+    // Flat handler for binary operations
+    //
+    void flat_binary(const eval::flat_instr& fi) noexcept;
+
+    //
+    // Evaluates a fused chain of binary operations
+    //
+    eval::value flat_chain(const eval::flat_instr& fi, const eval::value& lhs, const eval::value& rhs) const noexcept;
+
+    //
+    // Flat handler for dynamic binds
+    //
+    void flat_dyn_bind(const eval::flat_instr& fi) noexcept;
+
+    //
+    // Flat handler for everything else
+    // Forwards to the regular dispatch
+    //
+    void flat_generic(const eval::flat_instr& fi) noexcept;
+
   private:
     ir::cfg* m_cfg{};
     eval::store* m_valStore{};
     eval::env m_env;
     eval::value m_result{};
+    const eval::stack_frame* m_resFrame{};
+    entity_id m_resReg{};
     eval::call_stack m_stack;
     eval::stack_frame* m_curFrame{};
     branch_stack m_branching;
     arr_map m_arrCalls;
+    red_map m_reductions;
+    bind_map m_bindCaches;
+    bind_stats m_bindStats;
+    eval::memo_cache m_memo;
+    memo_stack m_memoCalls;
+    std::size_t m_effects{};
+    eval::native_jit m_jit;
+    eval::par_calls m_par;
+    eval::par_elems m_parElems;
+    val_list m_phiVals;
     const ir::instruction* m_instrPtr{};
+    eval::code_store m_code;
+    const eval::flat_instr* m_pc{};
+    const eval::stack_frame* m_flatRoot{};
     feedback* m_feedback{};
     eval::console m_io;
   };
@@ -0,0 +1,64 @@
+//
+// Executable memory
+//
+
+#pragma once
+
+namespace tnac::eval
+{
+  //
+  // Owns a block of pages containing machine code
+  // The pages are writable only while the code is being copied in,
+  // and are executable afterwards
+  //
+  class exec_memory final
+  {
+  public:
+    using byte      = std::uint8_t;
+    using size_type = std::size_t;
+    using code_view = std::span<const byte>;
+
+  public:
+    CLASS_SPECIALS_NONE(exec_memory);
+
+    ~exec_memory() noexcept;
+
+    exec_memory() noexcept;
+
+    explicit operator bool() const noexcept;
+
+  public:
+    //
+    // Checks whether machine code can be executed on the current platform
+    //
+    static constexpr bool is_supported() noexcept
+    {
+#if TNAC_LINUX_X64
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    //
+    // Maps new pages and copies the code into them
+    // Previously held pages are released
+    // Returns false if the platform is unsupported or the mapping fails
+    //
+    bool assign(code_view code) noexcept;
+
+    //
+    // Unmaps the pages
+    //
+    void release() noexcept;
+
+    //
+    // Returns the address of the first byte of code
+    //
+    const void* entry() const noexcept;
+
+  private:
+    void* m_data{};
+    size_type m_size{};
+  };
+}
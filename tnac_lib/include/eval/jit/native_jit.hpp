@@ -0,0 +1,148 @@
+//
+// Native JIT
+//
+
+#pragma once
+#include "eval/jit/x64_translator.hpp"
+#include "eval/jit/exec_memory.hpp"
+
+namespace tnac::eval
+{
+  //
+  // Tiered native backend
+  // Counts entries into functions and translates the hot ones into machine code
+  // Calls are dispatched to native code only when all arguments are ints.
+  // Functions which can't be translated stay interpreted
+  //
+  class native_jit final
+  {
+  public:
+    using counter    = std::size_t;
+    using depth_type = std::uint64_t;
+    using arg_list   = std::span<const int_type>;
+    using result     = std::optional<value>;
+
+    static constexpr auto maxParams        = x64_translator::maxParams;
+    static constexpr auto defaultThreshold = counter{ 100 };
+
+    //
+    // Native code runs on the machine stack, so recursion depth is limited
+    // Deeper calls fall back to the interpreter
+    //
+    static constexpr auto maxDepth = depth_type{ 4096 };
+
+    //
+    // Number of fallbacks after which a function is returned to the interpreter
+    //
+    static constexpr auto maxFallbacks = counter{ 16 };
+
+    //
+    // Cumulative counters
+    //
+    struct stats
+    {
+      counter m_compiled{};
+      counter m_rejected{};
+      counter m_calls{};
+      counter m_fallbacks{};
+    };
+
+  private:
+    using entry_point = bool (*)(const int_type*, int_type*, depth_type);
+
+    enum class tier : std::uint8_t
+    {
+      Counting,
+      Native,
+      Interpreted
+    };
+
+    struct fn_state
+    {
+      exec_memory m_code;
+      counter m_entries{};
+      counter m_fallbacks{};
+      tier m_tier{ tier::Counting };
+      native_type m_ret{};
+    };
+
+    using state_map = std::unordered_map<const ir::function*, fn_state>;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(native_jit);
+
+    ~native_jit() noexcept;
+
+    native_jit() noexcept;
+
+  public:
+    //
+    // Checks whether native code can be run on the current platform
+    //
+    static constexpr bool is_supported() noexcept
+    {
+      return exec_memory::is_supported();
+    }
+
+    //
+    // Turns the backend on or off
+    // Has no effect on unsupported platforms
+    //
+    void enable(bool on) noexcept;
+
+    //
+    // Checks whether the backend is on
+    //
+    bool is_enabled() const noexcept;
+
+    //
+    // Sets the number of entries after which a function gets compiled
+    //
+    void set_threshold(counter threshold) noexcept;
+
+    //
+    // Returns the number of entries after which a function gets compiled
+    //
+    counter threshold() const noexcept;
+
+    //
+    // Registers an entry into a function
+    // Compiles it once it gets hot
+    //
+    void on_enter(const ir::function& fn) noexcept;
+
+    //
+    // Checks whether the function has native code
+    //
+    bool is_native(const ir::function& fn) const noexcept;
+
+    //
+    // Runs native code of the given function
+    // Returns an empty result if the code bails out,
+    // in which case the call is to be made by the interpreter
+    //
+    result call(const ir::function& fn, arg_list args) noexcept;
+
+    //
+    // Drops all native code and counters
+    //
+    void clear() noexcept;
+
+    //
+    // Returns the counters
+    //
+    const stats& counters() const noexcept;
+
+  private:
+    //
+    // Translates a function and updates its tier
+    //
+    void compile(const ir::function& fn, fn_state& state) noexcept;
+
+  private:
+    state_map m_states;
+    stats m_stats;
+    counter m_threshold{ defaultThreshold };
+    bool m_enabled{};
+  };
+}
@@ -0,0 +1,235 @@
+//
+// x86-64 emitter
+//
+
+#pragma once
+
+namespace tnac::eval
+{
+  //
+  // General purpose x86-64 registers
+  //
+  enum class x64_reg : std::uint8_t
+  {
+    Rax, Rcx, Rdx, Rbx, Rsp, Rbp, Rsi, Rdi,
+    R8, R9, R10, R11, R12, R13, R14, R15
+  };
+
+  //
+  // Condition codes used by conditional jumps, sets, and moves
+  //
+  enum class x64_cond : std::uint8_t
+  {
+    E  = 0x4,
+    NE = 0x5,
+    L  = 0xC,
+    GE = 0xD,
+    LE = 0xE,
+    G  = 0xF
+  };
+
+  //
+  // Encodes a small subset of x86-64 instructions into a byte buffer
+  // All operations are 64-bit, and memory operands are of the [base + disp32] form
+  // Jumps and calls refer to labels which are resolved by finalise
+  //
+  class x64_emitter final
+  {
+  public:
+    using byte      = std::uint8_t;
+    using buffer    = std::vector<byte>;
+    using size_type = buffer::size_type;
+    using disp_type = std::int32_t;
+    using imm_type  = std::int64_t;
+    using label     = std::uint32_t;
+
+  private:
+    struct fixup
+    {
+      size_type m_at{};
+      label m_to{};
+    };
+
+    using label_list = std::vector<size_type>;
+    using fixup_list = std::vector<fixup>;
+
+    static constexpr auto unbound = ~size_type{};
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(x64_emitter);
+
+    ~x64_emitter() noexcept;
+
+    x64_emitter() noexcept;
+
+  public:
+    //
+    // Creates a new unbound label
+    //
+    label make_label() noexcept;
+
+    //
+    // Binds a label to the current position
+    //
+    void bind(label l) noexcept;
+
+    //
+    // Patches all jumps and calls with their labels' positions
+    // Returns false if any of the used labels is unbound
+    //
+    bool finalise() noexcept;
+
+    //
+    // Returns the encoded code
+    //
+    const buffer& code() const noexcept;
+
+    //
+    // Drops the code and all labels
+    //
+    void clear() noexcept;
+
+  public:
+    //
+    // push reg
+    //
+    void push(x64_reg reg) noexcept;
+
+    //
+    // pop reg
+    //
+    void pop(x64_reg reg) noexcept;
+
+    //
+    // ret
+    //
+    void ret() noexcept;
+
+    //
+    // mov dst, src
+    //
+    void mov(x64_reg dst, x64_reg src) noexcept;
+
+    //
+    // mov dst, imm
+    //
+    void mov(x64_reg dst, imm_type imm) noexcept;
+
+    //
+    // mov dst, [base + disp]
+    //
+    void load(x64_reg dst, x64_reg base, disp_type disp) noexcept;
+
+    //
+    // mov [base + disp], src
+    //
+    void store(x64_reg base, disp_type disp, x64_reg src) noexcept;
+
+    //
+    // lea dst, [base + disp]
+    //
+    void lea(x64_reg dst, x64_reg base, disp_type disp) noexcept;
+
+    //
+    // add dst, src
+    //
+    void add(x64_reg dst, x64_reg src) noexcept;
+
+    //
+    // sub dst, src
+    //
+    void sub(x64_reg dst, x64_reg src) noexcept;
+
+    //
+    // sub dst, imm
+    //
+    void sub(x64_reg dst, disp_type imm) noexcept;
+
+    //
+    // imul dst, src
+    //
+    void imul(x64_reg dst, x64_reg src) noexcept;
+
+    //
+    // neg reg
+    //
+    void neg(x64_reg reg) noexcept;
+
+    //
+    // cmp lhs, rhs
+    //
+    void cmp(x64_reg lhs, x64_reg rhs) noexcept;
+
+    //
+    // test lhs, rhs
+    //
+    void test(x64_reg lhs, x64_reg rhs) noexcept;
+
+    //
+    // setcc dst8
+    // movzx dst, dst8
+    //
+    void setcc(x64_cond cc, x64_reg dst) noexcept;
+
+    //
+    // cmovcc dst, src
+    //
+    void cmov(x64_cond cc, x64_reg dst, x64_reg src) noexcept;
+
+    //
+    // jmp l
+    //
+    void jmp(label l) noexcept;
+
+    //
+    // jcc l
+    //
+    void jcc(x64_cond cc, label l) noexcept;
+
+    //
+    // call l
+    //
+    void call(label l) noexcept;
+
+  private:
+    //
+    // Appends a byte
+    //
+    void emit(byte b) noexcept;
+
+    //
+    // Appends a 32-bit little-endian value
+    //
+    void emit32(std::uint32_t val) noexcept;
+
+    //
+    // Appends a REX prefix if any of its bits are needed
+    //
+    void rex(bool wide, x64_reg reg, x64_reg rm, bool force = false) noexcept;
+
+    //
+    // Appends a register-direct ModRM byte
+    //
+    void modrm(x64_reg reg, x64_reg rm) noexcept;
+
+    //
+    // Appends a ModRM byte for the [base + disp32] operand
+    //
+    void modrm(x64_reg reg, x64_reg base, disp_type disp) noexcept;
+
+    //
+    // Appends a two-register 64-bit instruction of the op r/m, reg form
+    //
+    void reg_op(byte opcode, x64_reg rm, x64_reg reg) noexcept;
+
+    //
+    // Appends a rel32 reference to a label
+    //
+    void rel32(label l) noexcept;
+
+  private:
+    buffer m_code;
+    label_list m_labels;
+    fixup_list m_fixups;
+  };
+}
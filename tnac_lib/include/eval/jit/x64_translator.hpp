@@ -0,0 +1,177 @@
+//
+// x86-64 translator
+//
+
+#pragma once
+#include "cfg/ir/ir.hpp"
+#include "eval/jit/x64_emitter.hpp"
+
+namespace tnac::eval
+{
+  //
+  // Static type of a value in native code
+  // Bools are represented as 0 and 1
+  //
+  enum class native_type : std::uint8_t
+  {
+    Unknown,
+    Int,
+    Bool
+  };
+
+  //
+  // Translates IR functions into x86-64 machine code
+  //
+  // Only functions operating on ints and bools are supported. Parameters are
+  // assumed to be ints, and all other types are inferred from them.
+  // The only calls allowed are the ones to the function itself, so arrays,
+  // closures, binds, io, and calls to other functions make the translation fail
+  //
+  // Generated code follows the System V calling convention:
+  //   bool entry(const int_type* args, int_type* result, std::uint64_t depth)
+  // Each nested call decrements depth, and once it reaches zero, the whole call
+  // chain fails and returns false leaving it up to the interpreter to redo the call
+  //
+  class x64_translator final
+  {
+  public:
+    using code_view = std::span<const std::uint8_t>;
+    using size_type = std::size_t;
+    using slot_type = ir::vreg::slot_type;
+
+    static constexpr auto maxParams = size_type{ 8 };
+
+  private:
+    using label      = x64_emitter::label;
+    using disp_type  = x64_emitter::disp_type;
+    using type_map   = std::unordered_map<const ir::vreg*, native_type>;
+    using label_map  = std::unordered_map<const ir::basic_block*, label>;
+    using block_list = std::vector<const ir::basic_block*>;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(x64_translator);
+
+    ~x64_translator() noexcept;
+
+    x64_translator() noexcept;
+
+  public:
+    //
+    // Translates the given function
+    // The function must have its slots assigned
+    // Returns false if the function can't be translated
+    //
+    bool translate(const ir::function& fn) noexcept;
+
+    //
+    // Returns the generated code
+    //
+    code_view code() const noexcept;
+
+    //
+    // Returns the type of the value returned by the generated code
+    //
+    native_type ret_type() const noexcept;
+
+  private:
+    //
+    // Infers types of all registers assuming the given return type
+    // Returns false if a type conflict or an unsupported instruction is found
+    //
+    bool infer(native_type retType) noexcept;
+
+    //
+    // Infers the type of the instruction's result
+    // Sets the flag if a new type has been assigned
+    //
+    bool infer(const ir::instruction& instr, bool& changed) noexcept;
+
+    //
+    // Checks operands once all types are known
+    //
+    bool validate(const ir::instruction& instr) const noexcept;
+
+    //
+    // Returns the static type of an operand
+    //
+    native_type type_of(const ir::operand& op) const noexcept;
+
+    //
+    // Assigns a type to a register
+    // Returns false if the register already has a different type
+    //
+    bool assign(const ir::operand& op, native_type type, bool& changed) noexcept;
+
+    //
+    // Checks whether a call instruction calls the function being translated
+    //
+    bool is_self_call(const ir::instruction& instr) const noexcept;
+
+    //
+    // Returns the label of a basic block
+    //
+    label label_of(const ir::basic_block& block) const noexcept;
+
+    //
+    // Returns the offset of a slot relative to the frame base
+    //
+    disp_type slot_disp(slot_type slot) const noexcept;
+
+  private:
+    //
+    // Generates code for the entire function
+    //
+    bool emit() noexcept;
+
+    //
+    // Generates code for an instruction
+    //
+    void emit(const ir::instruction& instr) noexcept;
+
+    //
+    // Sets up the native frame and copies arguments into their slots
+    //
+    void emit_prologue(size_type frameSize) noexcept;
+
+    //
+    // Restores the caller's frame and returns
+    //
+    void emit_epilogue() noexcept;
+
+    //
+    // Generates code for a jump
+    //
+    void emit_jump(const ir::instruction& instr) noexcept;
+
+    //
+    // Resolves phi nodes of the target block for the given incoming block
+    //
+    void emit_edge(const ir::basic_block& from, const ir::basic_block& to) noexcept;
+
+    //
+    // Generates code for a self call
+    //
+    void emit_call(const ir::instruction& instr) noexcept;
+
+    //
+    // Loads an operand into a hardware register
+    //
+    void load(x64_reg dst, const ir::operand& op) noexcept;
+
+    //
+    // Stores a hardware register into a virtual register's slot
+    //
+    void store(const ir::operand& op, x64_reg src) noexcept;
+
+  private:
+    const ir::function* m_func{};
+    x64_emitter m_emitter;
+    type_map m_types;
+    label_map m_labels;
+    block_list m_order;
+    native_type m_ret{};
+    label m_start{};
+    label m_fail{};
+    label m_exit{};
+  };
+}
@@ -0,0 +1,183 @@
+//
+// Memo cache
+//
+
+#pragma once
+#include "eval/value/value.hpp"
+
+namespace tnac::ir
+{
+  class function;
+}
+
+namespace tnac::eval
+{
+  //
+  // Specifies which functions get their results memoised
+  //
+  enum class memo_mode : std::uint8_t
+  {
+    Off,
+    Marked,
+    All
+  };
+
+  //
+  // Bounded cache of function call results
+  // Only pure functions are considered. A function is pure if it doesn't
+  // perform stream io, doesn't bind closures, and isn't a closure itself.
+  // Arguments and results are limited to scalar values
+  // When full, the oldest entry is evicted first
+  //
+  class memo_cache final
+  {
+  public:
+    using size_type = std::size_t;
+    using counter   = std::size_t;
+    using arg_list  = std::vector<value>;
+    using hash_type = std::size_t;
+
+    static constexpr auto defaultCapacity = size_type{ 4096 };
+
+    //
+    // Identifies a call by its callee and argument values
+    //
+    struct key
+    {
+      const ir::function* m_func{};
+      arg_list m_args;
+      hash_type m_hash{};
+    };
+
+    //
+    // Cumulative cache counters
+    //
+    struct stats
+    {
+      counter m_hits{};
+      counter m_misses{};
+      counter m_evictions{};
+    };
+
+  private:
+    struct key_hash
+    {
+      hash_type operator()(const key& k) const noexcept;
+    };
+
+    struct key_eq
+    {
+      bool operator()(const key& l, const key& r) const noexcept;
+    };
+
+    enum class purity : std::uint8_t
+    {
+      Pure,
+      Impure
+    };
+
+    using entry_map  = std::unordered_map<key, value, key_hash, key_eq>;
+    using entry_ring = std::vector<const key*>;
+    using fn_set     = std::unordered_set<const ir::function*>;
+    using purity_map = std::unordered_map<const ir::function*, purity>;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(memo_cache);
+
+    ~memo_cache() noexcept;
+
+    memo_cache() noexcept;
+
+  public:
+    //
+    // Sets the memoisation mode
+    //
+    void set_mode(memo_mode mode) noexcept;
+
+    //
+    // Returns the current memoisation mode
+    //
+    memo_mode mode() const noexcept;
+
+    //
+    // Marks a function for memoisation in the Marked mode
+    //
+    void mark(const ir::function& fn) noexcept;
+
+    //
+    // Permanently excludes a function from memoisation
+    // Used when a side effect is observed during its call
+    //
+    void forbid(const ir::function& fn) noexcept;
+
+    //
+    // Checks whether calls to the given function are to be memoised
+    //
+    bool wants(const ir::function& fn) noexcept;
+
+    //
+    // Creates a key for a call
+    // Fails if any of the arguments is not a scalar value
+    //
+    static std::optional<key> make_key(const ir::function& fn, arg_list args) noexcept;
+
+    //
+    // Looks up a cached result and updates the counters
+    //
+    const value* find(const key& k) noexcept;
+
+    //
+    // Caches a call result
+    // Non-scalar results are ignored
+    //
+    void insert(key k, value res) noexcept;
+
+    //
+    // Drops all cached results
+    // Marks and counters are retained
+    //
+    void clear() noexcept;
+
+    //
+    // Sets the maximum number of cached results
+    // Evicts the extra ones if needed
+    //
+    void set_capacity(size_type cap) noexcept;
+
+    //
+    // Returns the maximum number of cached results
+    //
+    size_type capacity() const noexcept;
+
+    //
+    // Returns the number of cached results
+    //
+    size_type size() const noexcept;
+
+    //
+    // Returns the cache counters
+    //
+    const stats& counters() const noexcept;
+
+  private:
+    //
+    // Scans the function body for side effects
+    //
+    static purity classify(const ir::function& fn) noexcept;
+
+    //
+    // Removes the oldest entry
+    //
+    void evict() noexcept;
+
+  private:
+    entry_map m_entries;
+    entry_ring m_ring;
+    fn_set m_marked;
+    purity_map m_purity;
+    stats m_stats;
+    size_type m_capacity{ defaultCapacity };
+    size_type m_oldest{};
+    memo_mode m_mode{ memo_mode::Off };
+  };
+}
@@ -0,0 +1,158 @@
+//
+// Parallel array calls
+//
+
+#pragma once
+#include "eval/par/worker_pool.hpp"
+#include "eval/value/value.hpp"
+
+namespace tnac
+{
+  class ir_eval;
+}
+
+namespace tnac::ir
+{
+  class cfg;
+  class function;
+}
+
+namespace tnac::eval
+{
+  class store;
+  class array_wrapper;
+
+  //
+  // Spreads the elements of an array call across a worker pool
+  // Every worker runs its own evaluator with its own value store over the shared CFG.
+  //
+  // Only calls to pure functions are run in parallel. A function is pure
+  // if neither it nor anything it can call performs stream io, binds or
+  // accesses closures, or refers to interned arrays.
+  // Arguments and results are limited to scalar values and plain functions,
+  // since those carry no references into a value store
+  //
+  class par_calls final
+  {
+  public:
+    using size_type = std::size_t;
+    using counter   = std::size_t;
+    using arg_list  = std::span<const value>;
+    using result    = std::optional<value>;
+
+    //
+    // Array calls with fewer callees are not worth the synchronisation
+    //
+    static constexpr auto minTasks = size_type{ 2 };
+
+    //
+    // Cumulative counters
+    //
+    struct stats
+    {
+      counter m_batches{};
+      counter m_tasks{};
+      counter m_fallbacks{};
+    };
+
+  private:
+    //
+    // Array call layout
+    // Each element is either a call or a nested array
+    //
+    struct plan_item
+    {
+      std::vector<plan_item> m_nested;
+      size_type m_task{};
+      bool m_isCall{};
+    };
+
+    struct worker
+    {
+      std::unique_ptr<store> m_store;
+      std::unique_ptr<ir_eval> m_eval;
+    };
+
+    using plan         = std::vector<plan_item>;
+    using task_list    = std::vector<ir::function*>;
+    using result_list  = std::vector<value>;
+    using worker_list  = std::vector<worker>;
+    using purity_map   = std::unordered_map<const ir::function*, bool>;
+    using fn_set       = std::unordered_set<const ir::function*>;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(par_calls);
+
+    ~par_calls() noexcept;
+
+    par_calls() noexcept;
+
+  public:
+    //
+    // Enables or disables parallel calls
+    //
+    void enable(bool on) noexcept;
+
+    //
+    // Checks whether parallel calls are enabled
+    //
+    bool is_enabled() const noexcept;
+
+    //
+    // Runs an array call on the workers
+    // Returns the result array allocated in the given store,
+    // or an empty result if the call must be evaluated sequentially
+    //
+    result call(ir::cfg& cfg, store& vals, array_wrapper& arr, arg_list args) noexcept;
+
+    //
+    // Forgets the purity of functions
+    // Must be called when the CFG changes
+    //
+    void clear() noexcept;
+
+    //
+    // Returns the counters
+    //
+    const stats& counters() const noexcept;
+
+  private:
+    //
+    // Lays out the array call and collects the callees
+    // Fails if any of the callees is not pure
+    //
+    bool make_plan(array_wrapper& arr, size_type argCount, plan& p, task_list& tasks) noexcept;
+
+    //
+    // Checks whether a value can be passed to a worker
+    //
+    bool is_transferable(const value& val) noexcept;
+
+    //
+    // Checks whether the given function and everything it can call is pure
+    //
+    bool is_pure(ir::function& fn) noexcept;
+
+    //
+    // Scans a function and its callees for side effects
+    //
+    bool scan(ir::function& fn, fn_set& visited) noexcept;
+
+    //
+    // Starts the workers on the first use
+    //
+    void init_workers(ir::cfg& cfg) noexcept;
+
+    //
+    // Builds the result array following the plan
+    //
+    static value assemble(store& vals, const plan& p, result_list& results) noexcept;
+
+  private:
+    std::unique_ptr<worker_pool> m_pool;
+    worker_list m_workers;
+    purity_map m_purity;
+    stats m_stats;
+    bool m_enabled{};
+  };
+}
@@ -0,0 +1,94 @@
+//
+// Parallel elementwise operations
+//
+
+#pragma once
+#include "eval/par/worker_pool.hpp"
+
+namespace tnac::eval
+{
+  //
+  // Splits elementwise array operations across a worker pool
+  // The element range is cut into contiguous chunks of the grain size,
+  // and each task writes its own chunk of the result, so the element order
+  // doesn't depend on scheduling.
+  //
+  // Tasks only compute scalars. Anything which touches a value store
+  // stays on the calling thread
+  //
+  class par_elems final
+  {
+  public:
+    using size_type = std::size_t;
+    using counter   = std::size_t;
+
+    //
+    // Computes elements in [from, to)
+    //
+    using range_job = std::move_only_function<void(size_type from, size_type to) noexcept>;
+
+    static constexpr auto defaultGrain   = size_type{ 1 } << 14;
+    static constexpr auto defaultMinSize = size_type{ 1 } << 16;
+
+    //
+    // Settings
+    // Zero threads disable parallel evaluation
+    //
+    struct config
+    {
+      size_type m_threads{};
+      size_type m_grain{ defaultGrain };
+      size_type m_minSize{ defaultMinSize };
+    };
+
+    //
+    // Cumulative counters
+    //
+    struct stats
+    {
+      counter m_batches{};
+      counter m_tasks{};
+    };
+
+  public:
+    CLASS_SPECIALS_NONE(par_elems);
+
+    ~par_elems() noexcept;
+
+    par_elems() noexcept;
+
+  public:
+    //
+    // Applies new settings
+    // The workers are restarted if the thread count changes
+    //
+    void configure(const config& cfg) noexcept;
+
+    //
+    // Returns the current settings
+    //
+    const config& settings() const noexcept;
+
+    //
+    // Checks whether an operation over the given number of elements
+    // should be run in parallel
+    //
+    bool wants(size_type count) const noexcept;
+
+    //
+    // Runs the job over [0, count) split into chunks
+    // Blocks until all chunks are done
+    //
+    void run(size_type count, range_job job) noexcept;
+
+    //
+    // Returns the counters
+    //
+    const stats& counters() const noexcept;
+
+  private:
+    std::unique_ptr<worker_pool> m_pool;
+    config m_cfg;
+    stats m_stats;
+  };
+}
@@ -0,0 +1,66 @@
+//
+// Worker pool
+//
+
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace tnac::eval
+{
+  //
+  // Fixed set of threads running fork-join batches
+  // A batch is a number of tasks which are picked up by the workers
+  // in index order. The caller blocks until the entire batch is done
+  //
+  class worker_pool final
+  {
+  public:
+    using size_type = std::size_t;
+
+    //
+    // Runs a task with the given index on the worker with the given index
+    // Each worker only runs one task at a time
+    //
+    using job = std::move_only_function<void(size_type worker, size_type task) noexcept>;
+
+  private:
+    using thread_list = std::vector<std::jthread>;
+
+  public:
+    CLASS_SPECIALS_NONE(worker_pool);
+
+    ~worker_pool() noexcept;
+
+    explicit worker_pool(size_type workerCount) noexcept;
+
+  public:
+    //
+    // Returns the number of workers
+    //
+    size_type size() const noexcept;
+
+    //
+    // Runs a batch of tasks and waits for them to finish
+    //
+    void run(size_type taskCount, job j) noexcept;
+
+  private:
+    //
+    // Worker thread body
+    //
+    void work(size_type worker) noexcept;
+
+  private:
+    thread_list m_threads;
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    job m_job;
+    size_type m_next{};
+    size_type m_taskCount{};
+    size_type m_pending{};
+    bool m_stop{};
+  };
+}
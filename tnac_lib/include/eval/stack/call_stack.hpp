@@ -9,12 +9,42 @@ namespace tnac::eval
 {
   //
   // Manages stack frames for functions
+  // Frame objects are pooled and reused across calls. Register slots are
+  // bump-allocated from contiguous segments, so that pushing a frame takes
+  // exactly as many slots as the callee has registers, and popping it just
+  // moves the top back
   //
   class call_stack final
   {
   public:
-    using data_type   = stack_frame::list_type;
-    using param_count = stack_frame::param_count;
+    using slot_count = stack_frame::slot_count;
+    using size_type  = std::size_t;
+
+    static constexpr auto segmentSize = size_type{ 4096 };
+
+  private:
+    using frame_slot = std::optional<stack_frame>;
+    using frame_pool = std::vector<std::unique_ptr<frame_slot>>;
+
+    //
+    // Contiguous region of value slots
+    //
+    struct segment
+    {
+      std::unique_ptr<value[]> m_data;
+      size_type m_size{};
+    };
+    using segment_list = std::vector<segment>;
+
+    //
+    // Position of the first free slot
+    //
+    struct arena_mark
+    {
+      size_type m_segment{};
+      size_type m_offset{};
+    };
+    using mark_list = std::vector<arena_mark>;
 
   public:
     CLASS_SPECIALS_NONE_CUSTOM(call_stack);
@@ -27,14 +57,30 @@ namespace tnac::eval
     //
     // Creates a new stack frame and returns a reference to it
     //
-    stack_frame& make_frame(eval::function_type func, param_count argSz, entity_id jmp) noexcept;
+    stack_frame& make_frame(eval::function_type func, slot_count slotSz, entity_id jmp) noexcept;
 
     //
     // Removes the most recent stack frame and returns a pointer to a previous one
     //
     stack_frame* pop_frame() noexcept;
 
+    //
+    // Returns the number of frames on the stack
+    //
+    size_type depth() const noexcept;
+
+  private:
+    //
+    // Reserves a contiguous region for the given number of slots
+    // Moves on to the next segment if the current one doesn't have enough room
+    //
+    stack_frame::slot_span reserve(slot_count count) noexcept;
+
   private:
-    data_type m_frames;
+    frame_pool m_frames;
+    mark_list m_marks;
+    segment_list m_segments;
+    arena_mark m_top{};
+    size_type m_depth{};
   };
-}
\ No newline at end of file
+}
@@ -9,13 +9,17 @@ namespace tnac::eval
 {
   //
   // Holds execution state for a function
+  // Register slots live in a region owned by the call stack,
+  // anything allocated past them goes to a frame-local spill area
   //
-  class stack_frame final :
-    public utils::ilist_node<stack_frame>
+  class stack_frame final
   {
   public:
     using param_count = std::uint16_t;
+    using slot_count  = std::uint32_t;
     using memory      = std::vector<value>;
+    using slot_span   = std::span<value>;
+    using size_type   = memory::size_type;
     using name_type   = string_t;
 
   public:
@@ -23,9 +27,14 @@ namespace tnac::eval
 
     ~stack_frame() noexcept;
 
-    stack_frame(eval::function_type func, param_count argSz, entity_id jmpBack) noexcept;
+    stack_frame(eval::function_type func, slot_span slots, stack_frame* prev, entity_id jmpBack) noexcept;
 
   public:
+    //
+    // Returns the calling frame
+    //
+    stack_frame* prev() const noexcept;
+
     //
     // Returns the name
     //
@@ -37,25 +46,44 @@ namespace tnac::eval
     eval::function_type function() const noexcept;
 
     //
-    // Appends a function argument and returns its id
+    // Writes the next function argument into its slot and returns its id
     //
     entity_id add_arg(value argVal) noexcept;
 
     //
     // Stores a value into the specified register
+    // Grows the frame if the register is out of its bounds
     //
     void store(entity_id id, value val) noexcept;
 
     //
-    // Allocates a variable and returns its id
+    // Allocates a temporary in the spill area and returns its id
     //
     entity_id allocate() noexcept;
 
+    //
+    // Returns the current number of values in the frame
+    //
+    size_type size() const noexcept;
+
     //
     // Returns the value assigned to a specific id
     //
     value value_for(entity_id id) const noexcept;
 
+    //
+    // Returns a reference to the value assigned to a specific id
+    // If there is none, refers to an invalid value
+    // The reference is invalidated when the frame grows
+    //
+    const value& value_ref(entity_id id) const noexcept;
+
+    //
+    // Moves the value assigned to a specific id out of the frame
+    // The slot is left invalid
+    //
+    value take(entity_id id) noexcept;
+
     //
     // Returns the 'this' register value
     // If not set, an invalid value is returned
@@ -83,16 +111,32 @@ namespace tnac::eval
     entity_id ret_val() const noexcept;
 
     //
-    // Sets the 'this' register and stores its id
+    // Sets the 'this' register
     // The value stored in the nearest enclosing owner function instance
     //
     void init_this_reg(value val) noexcept;
 
   private:
-    memory m_mem;
+    //
+    // Returns a pointer to the value with the specified id
+    // If the id is out of bounds, returns nullptr
+    //
+    const value* try_get(entity_id id) const noexcept;
+
+    //
+    // Returns a pointer to the value with the specified id
+    // If the id is out of bounds, returns nullptr
+    //
+    value* try_get(entity_id id) noexcept;
+
+  private:
+    slot_span m_slots;
+    memory m_spill;
+    stack_frame* m_prev{};
     eval::function_type m_func;
+    value m_this{};
     entity_id m_jmp{};
     entity_id m_retId{};
-    entity_id m_this{};
+    param_count m_argCount{};
   };
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+//
+// Built-in functions
+//
+
+#pragma once
+#include "eval/value/value.hpp"
+
+namespace tnac::eval
+{
+  //
+  // Ids of built-in functions
+  //
+  enum class intrinsic : std::uint8_t
+  {
+    None,
+    Sum,
+    Product,
+    Min,
+    Max,
+    Sort,
+    Reverse,
+    Slice,
+    Dot,
+    PrefixSum,
+    Reduce
+  };
+
+  //
+  // Describes a built-in function
+  //
+  struct intrinsic_info
+  {
+    intrinsic m_id{};
+    string_t m_name;
+    std::span<const string_t> m_params;
+  };
+
+  //
+  // Returns descriptions of all built-in functions
+  //
+  std::span<const intrinsic_info> intrinsics() noexcept;
+
+  //
+  // Returns the id of a built-in function by its name
+  // Unknown names yield None
+  //
+  intrinsic find_intrinsic(string_t name) noexcept;
+
+  //
+  // Computes a built-in function
+  // Non-arrays act as single element arrays, same as in regular array operations
+  //
+  // Reduce calls back into user code, so evaluators handle it themselves,
+  // and it yields an invalid value here
+  //
+  value call_intrinsic(store& vs, intrinsic id, std::span<const value> args) noexcept;
+}
@@ -0,0 +1,257 @@
+//
+// Compact value encoding
+//
+
+#pragma once
+#include "eval/value/types.hpp"
+
+namespace tnac::eval
+{
+  //
+  // 8-byte value encoding used instead of std::variant when TNAC_NAN_BOXING is on
+  //
+  // Floats are stored as is, NaNs are canonicalised to a positive quiet NaN.
+  // Everything else lives in the negative quiet NaN space:
+  // bits 48-50 hold a tag, and the lower 48 bits hold the payload.
+  // Bools, ints which fit into 48 bits, functions without closures,
+  // and arrays are stored in place.
+  // Complex numbers, fractions, wider ints, and closures are spilled
+  // to reference counted cells shared between copies
+  //
+  class nan_box final
+  {
+  public:
+    using bits_type = std::uint64_t;
+
+    //
+    // Heap cell for values which don't fit into the payload
+    //
+    struct cell;
+
+  private:
+    enum class tag : std::uint8_t
+    {
+      Invalid,
+      Bool,
+      Int,
+      Function,
+      Array,
+      Spill
+    };
+
+    static constexpr auto tagShift     = 48;
+    static constexpr auto boxMask      = bits_type{ 0xFFF8'0000'0000'0000 };
+    static constexpr auto tagMask      = bits_type{ 0x7 } << tagShift;
+    static constexpr auto payloadMask  = (bits_type{ 1 } << tagShift) - 1;
+    static constexpr auto canonicalNan = bits_type{ 0x7FF8'0000'0000'0000 };
+    static constexpr auto invalidBits  = boxMask;
+    static constexpr auto minInline    = -(int_type{ 1 } << (tagShift - 1));
+    static constexpr auto maxInline    =  (int_type{ 1 } << (tagShift - 1)) - 1;
+
+    static_assert(sizeof(float_type) == sizeof(bits_type));
+    static_assert(sizeof(void*) == sizeof(bits_type), "NaN boxing needs 64-bit pointers");
+
+  public:
+    ~nan_box() noexcept
+    {
+      unref();
+    }
+
+    nan_box() noexcept = default;
+
+    nan_box(const nan_box& other) noexcept :
+      m_bits{ other.m_bits }
+    {
+      ref();
+    }
+
+    nan_box& operator=(const nan_box& other) noexcept
+    {
+      if (this == &other)
+        return *this;
+
+      other.ref();
+      unref();
+      m_bits = other.m_bits;
+      return *this;
+    }
+
+    nan_box(nan_box&& other) noexcept :
+      m_bits{ std::exchange(other.m_bits, invalidBits) }
+    {
+    }
+
+    nan_box& operator=(nan_box&& other) noexcept
+    {
+      if (this == &other)
+        return *this;
+
+      unref();
+      m_bits = std::exchange(other.m_bits, invalidBits);
+      return *this;
+    }
+
+    explicit nan_box(invalid_val_t) noexcept
+    {
+    }
+
+    explicit nan_box(bool_type val) noexcept :
+      m_bits{ box(tag::Bool, static_cast<bits_type>(val)) }
+    {
+    }
+
+    explicit nan_box(int_type val) noexcept
+    {
+      if (val < minInline || val > maxInline)
+      {
+        m_bits = spill(val);
+        return;
+      }
+
+      m_bits = box(tag::Int, static_cast<bits_type>(val) & payloadMask);
+    }
+
+    explicit nan_box(float_type val) noexcept :
+      m_bits{ val != val ? canonicalNan : std::bit_cast<bits_type>(val) }
+    {
+    }
+
+    explicit nan_box(complex_type val) noexcept;
+
+    explicit nan_box(fraction_type val) noexcept;
+
+    explicit nan_box(function_type val) noexcept;
+
+    explicit nan_box(array_type val) noexcept;
+
+    nan_box& operator=(expr_result auto raw) noexcept
+    {
+      return *this = nan_box{ std::move(raw) };
+    }
+
+  public:
+    //
+    // Returns the type id of the stored value
+    //
+    type_id id() const noexcept
+    {
+      if (!is_boxed())
+        return type_id::Float;
+
+      switch (get_tag())
+      {
+      case tag::Bool:     return type_id::Bool;
+      case tag::Int:      return type_id::Int;
+      case tag::Function: return type_id::Function;
+      case tag::Array:    return type_id::Array;
+      case tag::Spill:    return spilled_id();
+      default:            return type_id::Invalid;
+      }
+    }
+
+    //
+    // Extracts the stored value as the specified type
+    // The caller must ensure that the type is correct
+    //
+    template <expr_result T>
+    T get() const noexcept
+    {
+      UTILS_ASSERT(id() == utils::type_to_id_v<T>);
+      if constexpr (std::same_as<T, invalid_val_t>)
+        return {};
+      else if constexpr (std::same_as<T, bool_type>)
+        return static_cast<bool_type>(payload());
+      else if constexpr (std::same_as<T, int_type>)
+        return get_tag() == tag::Int ? inline_int() : spilled_int();
+      else if constexpr (std::same_as<T, float_type>)
+        return std::bit_cast<float_type>(m_bits);
+      else if constexpr (std::same_as<T, complex_type>)
+        return get_complex();
+      else if constexpr (std::same_as<T, fraction_type>)
+        return get_fraction();
+      else if constexpr (std::same_as<T, function_type>)
+        return get_function();
+      else
+        return get_array();
+    }
+
+    //
+    // Attempts to extract the stored value as the specified type
+    // Returns an empty optional on failure
+    //
+    template <expr_result T>
+    std::optional<T> get_if() const noexcept
+    {
+      if (id() != utils::type_to_id_v<T>)
+        return {};
+
+      return get<T>();
+    }
+
+  private:
+    static constexpr bits_type box(tag t, bits_type payload) noexcept
+    {
+      return boxMask | (static_cast<bits_type>(t) << tagShift) | payload;
+    }
+
+    static bits_type spill(int_type val) noexcept;
+
+    bool is_boxed() const noexcept
+    {
+      return (m_bits & boxMask) == boxMask;
+    }
+
+    tag get_tag() const noexcept
+    {
+      return static_cast<tag>((m_bits & tagMask) >> tagShift);
+    }
+
+    bits_type payload() const noexcept
+    {
+      return m_bits & payloadMask;
+    }
+
+    int_type inline_int() const noexcept
+    {
+      // Sign-extend the 48-bit payload
+      constexpr auto extShift = std::numeric_limits<bits_type>::digits - tagShift;
+      return static_cast<int_type>(payload() << extShift) >> extShift;
+    }
+
+    bool is_counted() const noexcept
+    {
+      return is_boxed() && utils::eq_any(get_tag(), tag::Array, tag::Spill);
+    }
+
+    void ref() const noexcept
+    {
+      if (is_counted())
+        ref_slow();
+    }
+
+    void unref() noexcept
+    {
+      if (is_counted())
+        unref_slow();
+    }
+
+    void ref_slow() const noexcept;
+
+    void unref_slow() noexcept;
+
+    type_id spilled_id() const noexcept;
+
+    int_type spilled_int() const noexcept;
+
+    complex_type get_complex() const noexcept;
+
+    fraction_type get_fraction() const noexcept;
+
+    function_type get_function() const noexcept;
+
+    array_type get_array() const noexcept;
+
+  private:
+    bits_type m_bits{ invalidBits };
+  };
+}
@@ -0,0 +1,119 @@
+//
+// Vectorised kernels for packed arrays
+//
+
+#pragma once
+#include "eval/value/types.hpp"
+
+namespace tnac::eval
+{
+  enum class val_ops : std::uint8_t;
+}
+
+namespace tnac::eval::simd
+{
+  //
+  // Instruction sets the kernels can run on
+  // The best one supported by the cpu is picked on first use
+  //
+  enum class isa : std::uint8_t
+  {
+    Scalar,
+    Sse2,
+    Avx2
+  };
+
+  using size_type = std::size_t;
+
+  template <typename T> using in_buf  = std::span<const T>;
+  template <typename T> using out_buf = std::span<T>;
+
+  //
+  // Returns the instruction set used by the kernels
+  //
+  isa active() noexcept;
+
+  //
+  // Checks whether the binary operation has a kernel for the given element type
+  //
+  bool has_binary(val_ops op, type_id ti) noexcept;
+
+  //
+  // Checks whether the unary operation has a kernel for the given element type
+  //
+  bool has_unary(val_ops op, type_id ti) noexcept;
+
+  //
+  // Computes one row of an array operation: out[i] = lhs op rhs[i]
+  // Callers must check has_binary first
+  //
+  void binary_row(val_ops op, int_type lhs, in_buf<int_type> rhs, out_buf<int_type> out) noexcept;
+  void binary_row(val_ops op, float_type lhs, in_buf<float_type> rhs, out_buf<float_type> out) noexcept;
+  void binary_row(val_ops op, complex_type lhs, in_buf<complex_type> rhs, out_buf<complex_type> out) noexcept;
+
+  //
+  // Applies a unary operation to each element: out[i] = op src[i]
+  // Callers must check has_unary first
+  //
+  void unary(val_ops op, in_buf<int_type> src, out_buf<int_type> out) noexcept;
+  void unary(val_ops op, in_buf<float_type> src, out_buf<float_type> out) noexcept;
+  void unary(val_ops op, in_buf<complex_type> src, out_buf<complex_type> out) noexcept;
+
+  //
+  // Returns the index of the first element which differs between the buffers
+  // If there is none, returns the size of the shorter one
+  //
+  // Relational operators compare arrays as a whole rather than elementwise,
+  // so this is the only comparison kernel. Floats are compared with a tolerance
+  // and are checked one by one instead
+  //
+  size_type mismatch(in_buf<int_type> lhs, in_buf<int_type> rhs) noexcept;
+
+  //
+  // Converts ints to floats
+  //
+  void widen(in_buf<int_type> src, out_buf<float_type> out) noexcept;
+
+  //
+  // Adds up all elements
+  // Floats are accumulated in lanes, so rounding can differ from a left to right sum
+  //
+  int_type sum(in_buf<int_type> src) noexcept;
+  float_type sum(in_buf<float_type> src) noexcept;
+  complex_type sum(in_buf<complex_type> src) noexcept;
+
+  //
+  // Multiplies all elements
+  //
+  int_type product(in_buf<int_type> src) noexcept;
+  float_type product(in_buf<float_type> src) noexcept;
+  complex_type product(in_buf<complex_type> src) noexcept;
+
+  //
+  // Returns the smallest element
+  // The buffer must not be empty
+  //
+  int_type min(in_buf<int_type> src) noexcept;
+  float_type min(in_buf<float_type> src) noexcept;
+
+  //
+  // Returns the largest element
+  // The buffer must not be empty
+  //
+  int_type max(in_buf<int_type> src) noexcept;
+  float_type max(in_buf<float_type> src) noexcept;
+
+  //
+  // Returns the sum of products of elements at the same positions
+  // The buffers must be of the same size
+  //
+  int_type dot(in_buf<int_type> lhs, in_buf<int_type> rhs) noexcept;
+  float_type dot(in_buf<float_type> lhs, in_buf<float_type> rhs) noexcept;
+
+  //
+  // Computes running sums: out[i] = src[0] + ... + src[i]
+  //
+  void prefix_sum(in_buf<int_type> src, out_buf<int_type> out) noexcept;
+  void prefix_sum(in_buf<float_type> src, out_buf<float_type> out) noexcept;
+  void prefix_sum(in_buf<complex_type> src, out_buf<complex_type> out) noexcept;
+}
@@ -443,6 +443,18 @@ namespace tnac::eval
   }
   value tail(const array_type& arr) noexcept;
 
+  //
+  // Returns a view of count elements of the array starting from the given one,
+  // and taking every step-th after it. Negative steps go backwards
+  // Returns an invalid value if the view doesn't fit into the array
+  //
+  value slice(const array_type& arr, int_type from, int_type count, int_type step) noexcept;
+
+  //
+  // Returns a view of the array in reverse order
+  //
+  value reverse(const array_type& arr) noexcept;
+
   template <typename T> auto inv(const T&) noexcept;
   inline auto inv(const has_invert auto& val) noexcept
   {
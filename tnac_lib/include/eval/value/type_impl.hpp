@@ -5,17 +5,39 @@
 #pragma once
 
 #include "eval/value/value.hpp"
+#include "eval/value/value_store.hpp"
 
 namespace tnac::eval
 {
-  class store;
-}
+  //
+  // Element types which arrays can store unboxed
+  //
+  template <typename T>
+  concept packable = utils::same_noquals<T, int_type>
+                  || utils::same_noquals<T, float_type>
+                  || utils::same_noquals<T, complex_type>;
+
+  //
+  // Element types of lazy ranges
+  //
+  template <typename T>
+  concept rangeable = utils::same_noquals<T, int_type>
+                   || utils::same_noquals<T, float_type>;
+
+  class strided_iter;
 
-namespace tnac::eval
-{
   //
   // Array underlying data
   //
+  // Arrays consisting entirely of ints, floats, or complex numbers are stored
+  // as packed buffers of the corresponding primitive type.
+  // Adding an element of a different type, or asking for mutable elements,
+  // switches it to boxed storage for good. Reading and iterating keep it packed
+  //
+  // Ranges are arithmetic sequences which store only the first element,
+  // the step, and the count. Elements are generated when read.
+  // Modifying a range turns it into a packed buffer
+  //
   class array_data final :
     public ref_counted<array_data>,
     public utils::ilist_node<array_data>
@@ -24,6 +46,38 @@ namespace tnac::eval
     using data_type = std::vector<value>;
     using size_type = data_type::size_type;
     using eraser_t = std::move_only_function<bool(const value&) noexcept>;
+    using reverse_iterator = std::reverse_iterator<strided_iter>;
+
+    template <packable T>
+    using packed_buf = std::vector<T>;
+
+    using packed_type = std::variant<std::monostate,
+                                     packed_buf<int_type>,
+                                     packed_buf<float_type>,
+                                     packed_buf<complex_type>>;
+
+    //
+    // Lazy arithmetic sequence
+    //
+    template <rangeable T>
+    struct range_desc
+    {
+      T m_start{};
+      T m_step{};
+      size_type m_count{};
+
+      //
+      // Generates the element at the given index
+      //
+      T at(size_type idx) const noexcept
+      {
+        return m_start + m_step * static_cast<T>(idx);
+      }
+    };
+
+    using range_type = std::variant<std::monostate,
+                                    range_desc<int_type>,
+                                    range_desc<float_type>>;
 
   public:
     CLASS_SPECIALS_NONE(array_data);
@@ -70,66 +124,302 @@ namespace tnac::eval
     //
     value read_at(size_type idx) const noexcept;
 
+    //
+    // Checks whether elements are stored as values
+    //
+    bool is_boxed() const noexcept;
+
+    //
+    // Returns the packed elements if all of them are of the given type
+    // Otherwise, returns an empty buffer
+    //
+    template <packable T>
+    std::span<const T> packed() const noexcept
+    {
+      auto buf = std::get_if<packed_buf<T>>(&m_packed);
+      return buf ? std::span<const T>{ *buf } : std::span<const T>{};
+    }
+
+    //
+    // Resizes an empty array to the given number of packed elements
+    // Returns the buffer to fill them in
+    //
+    template <packable T>
+    std::span<T> make_packed(size_type count) noexcept
+    {
+      UTILS_ASSERT(!size() && !m_boxed);
+      auto buf = m_store->take_buffer<T>(count);
+      buf.resize(count);
+      return m_packed.emplace<packed_buf<T>>(std::move(buf));
+    }
+
+    //
+    // Turns an empty array into a range
+    //
+    template <rangeable T>
+    void make_range(T start, T step, size_type count) noexcept
+    {
+      UTILS_ASSERT(!size() && !m_boxed);
+      m_range.emplace<range_desc<T>>(start, step, count);
+    }
+
+    //
+    // Returns the range description if the array is a range of the given type
+    // Otherwise, returns nullptr
+    //
+    template <rangeable T>
+    const range_desc<T>* range() const noexcept
+    {
+      return std::get_if<range_desc<T>>(&m_range);
+    }
+
+    //
+    // Checks whether the array is a range
+    //
+    bool is_range() const noexcept;
+
+    //
+    // Drops all elements and returns the storage to the value store
+    //
+    void clear() noexcept;
+
+    //
+    // Moves the elements into boxed storage and returns them for modification
+    // References stay valid until the array is cleared or grows
+    //
+    data_type& elements() noexcept;
+
   public:
-    auto begin() const noexcept
+    strided_iter begin() const noexcept;
+    strided_iter cbegin() const noexcept;
+    reverse_iterator rbegin() const noexcept;
+    reverse_iterator crbegin() const noexcept;
+
+    strided_iter end() const noexcept;
+    strided_iter cend() const noexcept;
+    reverse_iterator rend() const noexcept;
+    reverse_iterator crend() const noexcept;
+
+  private:
+    //
+    // Moves packed elements into boxed storage
+    //
+    data_type& boxed() const noexcept;
+
+    //
+    // Attempts to append an element to the packed buffer
+    //
+    bool try_pack(const value& item) noexcept;
+
+    //
+    // Generates all elements of a range into a packed buffer
+    //
+    void unroll() const noexcept;
+
+  private:
+    mutable data_type m_data;
+    mutable packed_type m_packed;
+    mutable range_type m_range;
+    store* m_store{};
+    size_type m_prealloc{};
+    mutable bool m_boxed{};
+  };
+
+
+  //
+  // Iterator over array elements taken with a fixed step
+  // Elements are read by value, so packed arrays and ranges are never boxed
+  // Only positions inside the array are ever read,
+  // so the one past the end can be anywhere, including before the first element
+  //
+  class strided_iter final
+  {
+  public:
+    using iterator_concept  = std::random_access_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = value;
+    using reference         = value;
+
+    //
+    // Holds a copy of an element for member access
+    //
+    class pointer final
+    {
+    public:
+      explicit pointer(value val) noexcept :
+        m_val{ std::move(val) }
+      {}
+
+      const value* operator->() const noexcept
+      {
+        return &m_val;
+      }
+
+    private:
+      value m_val;
+    };
+
+  public:
+    strided_iter() noexcept = default;
+
+    strided_iter(const value* base, difference_type pos, difference_type stride) noexcept :
+      m_vals{ base },
+      m_pos{ pos },
+      m_stride{ stride }
+    {
+      UTILS_ASSERT(stride);
+    }
+
+    strided_iter(const array_data& arr, difference_type pos, difference_type stride) noexcept :
+      m_arr{ &arr },
+      m_pos{ pos },
+      m_stride{ stride }
+    {
+      UTILS_ASSERT(stride);
+    }
+
+    bool operator==(const strided_iter& other) const noexcept
+    {
+      return m_pos == other.m_pos;
+    }
+
+    std::strong_ordering operator<=>(const strided_iter& other) const noexcept
+    {
+      return (*this - other) <=> difference_type{};
+    }
+
+    reference operator*() const noexcept
+    {
+      return read(m_pos);
+    }
+
+    pointer operator->() const noexcept
+    {
+      return pointer{ operator*() };
+    }
+
+    reference operator[](difference_type n) const noexcept
     {
-      return m_data.begin();
+      return read(m_pos + n * m_stride);
     }
-    auto begin() noexcept
+
+    strided_iter& operator+=(difference_type n) noexcept
     {
-      return m_data.begin();
+      m_pos += n * m_stride;
+      return *this;
     }
-    auto cbegin() const noexcept
+
+    strided_iter& operator-=(difference_type n) noexcept
     {
-      return m_data.cbegin();
+      return *this += -n;
     }
-    auto rbegin() const noexcept
+
+    strided_iter& operator++() noexcept
     {
-      return m_data.rbegin();
+      return *this += 1;
     }
-    auto rbegin() noexcept
+
+    strided_iter operator++(int) noexcept
     {
-      return m_data.rbegin();
+      auto copy = *this;
+      ++*this;
+      return copy;
     }
-    auto crbegin() const noexcept
+
+    strided_iter& operator--() noexcept
     {
-      return m_data.crbegin();
+      return *this -= 1;
     }
 
-    auto end() const noexcept
+    strided_iter operator--(int) noexcept
     {
-      return m_data.end();
+      auto copy = *this;
+      --*this;
+      return copy;
     }
-    auto end() noexcept
+
+    friend strided_iter operator+(strided_iter it, difference_type n) noexcept
     {
-      return m_data.end();
+      return it += n;
     }
-    auto cend() const noexcept
+
+    friend strided_iter operator+(difference_type n, strided_iter it) noexcept
     {
-      return m_data.cend();
+      return it += n;
     }
-    auto rend() const noexcept
+
+    friend strided_iter operator-(strided_iter it, difference_type n) noexcept
     {
-      return m_data.rend();
+      return it -= n;
     }
-    auto rend() noexcept
+
+    friend difference_type operator-(const strided_iter& l, const strided_iter& r) noexcept
     {
-      return m_data.rend();
+      return (l.m_pos - r.m_pos) / l.m_stride;
     }
-    auto crend() const noexcept
+
+  private:
+    //
+    // Reads the element at the given position of the underlying data
+    //
+    value read(difference_type pos) const noexcept
     {
-      return m_data.crend();
+      if (m_arr)
+        return m_arr->read_at(static_cast<array_data::size_type>(pos));
+
+      return m_vals[pos];
     }
 
   private:
-    data_type m_data;
-    store* m_store{};
+    const value* m_vals{};
+    const array_data* m_arr{};
+    difference_type m_pos{};
+    difference_type m_stride{ 1 };
   };
 
+  inline strided_iter array_data::begin() const noexcept
+  {
+    return strided_iter{ *this, 0, 1 };
+  }
+  inline strided_iter array_data::cbegin() const noexcept
+  {
+    return begin();
+  }
+  inline array_data::reverse_iterator array_data::rbegin() const noexcept
+  {
+    return reverse_iterator{ end() };
+  }
+  inline array_data::reverse_iterator array_data::crbegin() const noexcept
+  {
+    return rbegin();
+  }
+
+  inline strided_iter array_data::end() const noexcept
+  {
+    return strided_iter{ *this, static_cast<strided_iter::difference_type>(size()), 1 };
+  }
+  inline strided_iter array_data::cend() const noexcept
+  {
+    return end();
+  }
+  inline array_data::reverse_iterator array_data::rend() const noexcept
+  {
+    return reverse_iterator{ begin() };
+  }
+  inline array_data::reverse_iterator array_data::crend() const noexcept
+  {
+    return rend();
+  }
+
 
   //
   // Array wrapper
-  // Holds an array data pointer, an offset, and item count
+  // Holds an array data pointer, an offset, item count, and a stride
+  //
+  // The stride is the distance between neighbouring elements in the underlying data.
+  // Negative strides go backwards, in which case the offset is the position
+  // of the first visible element, which is the last one of the underlying range
   //
   class array_wrapper final :
     public ref_counted<array_wrapper>,
@@ -138,13 +428,18 @@ namespace tnac::eval
   {
   public:
     using size_type    = array_data::size_type;
+    using stride_type  = strided_iter::difference_type;
     using wrapper_base = rc_wrapper<array_data>;
+    using iterator     = strided_iter;
+    using reverse_iterator = std::reverse_iterator<iterator>;
 
   public:
     CLASS_SPECIALS_NONE(array_wrapper);
 
     ~array_wrapper() noexcept;
 
+    array_wrapper(array_data& arr, size_type offset, size_type count, stride_type stride) noexcept;
+
     array_wrapper(array_data& arr, size_type offset, size_type count) noexcept;
 
     array_wrapper(array_data& arr, size_type offset) noexcept;
@@ -158,6 +453,11 @@ namespace tnac::eval
     //
     wrapper_base::reference data() noexcept;
 
+    //
+    // Returns the underlying data
+    //
+    wrapper_base::const_reference data() const noexcept;
+
     //
     // Returns the offset
     //
@@ -168,6 +468,21 @@ namespace tnac::eval
     //
     size_type size() const noexcept;
 
+    //
+    // Returns the distance between neighbouring elements in the underlying data
+    //
+    stride_type stride() const noexcept;
+
+    //
+    // Returns the position of the element with the given index in the underlying data
+    //
+    size_type index_of(size_type idx) const noexcept;
+
+    //
+    // Checks whether the visible elements are adjacent and go forward
+    //
+    bool is_contiguous() const noexcept;
+
     //
     // Returns an id, which is basically the underlying array address
     //
@@ -183,51 +498,97 @@ namespace tnac::eval
     //
     void remove() noexcept;
 
+    //
+    // Returns the packed elements visible through the wrapper
+    // The result is empty if the underlying array is not packed with the given type,
+    // or the view is not contiguous
+    //
+    template <packable T>
+    std::span<const T> packed() const noexcept
+    {
+      auto all = data().packed<T>();
+      if (!is_contiguous() || all.size() < m_offset + m_count)
+        return {};
+
+      return all.subspan(m_offset, m_count);
+    }
+
+    //
+    // Same as above, but strided views are gathered into the provided buffer
+    //
+    template <packable T>
+    std::span<const T> packed(std::vector<T>& tmp) const noexcept
+    {
+      if (is_contiguous())
+        return packed<T>();
+
+      auto all = data().packed<T>();
+      if (all.empty())
+        return {};
+
+      tmp.resize(m_count);
+      for (auto idx = size_type{}; idx < m_count; ++idx)
+        tmp[idx] = all[index_of(idx)];
+
+      return tmp;
+    }
+
+    //
+    // Returns the part of the underlying range visible through the wrapper
+    // The result is empty if the underlying array is not a range of the given type
+    //
+    template <rangeable T>
+    std::optional<array_data::range_desc<T>> range() const noexcept
+    {
+      // Scaling a float step would round elements differently
+      auto all = data().range<T>();
+      if (!all || (!is_contiguous() && !std::same_as<T, int_type>))
+        return {};
+
+      return array_data::range_desc<T>{ all->at(m_offset), all->m_step * static_cast<T>(m_stride), m_count };
+    }
+
   public:
-    auto begin() const noexcept
+    iterator begin() const noexcept
     {
-      return std::next(data().begin(), calc_begin());
+      return make_iter(0);
     }
-    auto cbegin() const noexcept
+    iterator cbegin() const noexcept
     {
-      return std::next(data().cbegin(), calc_begin());
+      return begin();
     }
-    auto rbegin() const noexcept
+    reverse_iterator rbegin() const noexcept
     {
-      return std::next(data().rbegin(), calc_rbegin());
+      return reverse_iterator{ end() };
     }
-    auto crbegin() const noexcept
+    reverse_iterator crbegin() const noexcept
     {
-      return std::next(data().crbegin(), calc_rbegin());
+      return rbegin();
     }
 
-    auto end() const noexcept
+    iterator end() const noexcept
     {
-      return std::next(data().begin(), calc_end());
+      return make_iter(m_count);
     }
-    auto cend() const noexcept
+    iterator cend() const noexcept
     {
-      return std::next(data().cbegin(), calc_end());
+      return end();
     }
-    auto rend() const noexcept
+    reverse_iterator rend() const noexcept
     {
-      return std::next(data().rbegin(), calc_rend());
+      return reverse_iterator{ begin() };
     }
-    auto crend() const noexcept
+    reverse_iterator crend() const noexcept
     {
-      return std::next(data().crbegin(), calc_rend());
+      return rend();
     }
 
   private:
-    wrapper_base::const_reference data() const noexcept;
-
-    size_type calc_begin() const noexcept;
-    size_type calc_end() const noexcept;
-    size_type calc_rbegin() const noexcept;
-    size_type calc_rend() const noexcept;
+    iterator make_iter(size_type idx) const noexcept;
 
   private:
     size_type m_offset{};
     size_type m_count{};
+    stride_type m_stride{ 1 };
   };
 }
\ No newline at end of file
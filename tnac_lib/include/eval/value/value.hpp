@@ -5,11 +5,25 @@
 #pragma once
 #include "eval/value/types.hpp"
 
+#if TNAC_NAN_BOXING
+#include "eval/value/nan_box.hpp"
+#endif
+
 namespace tnac::eval
 {
   enum class val_ops : std::uint8_t;
   class array_wrapper;
   class store;
+  class value;
+
+  //
+  // Trailing operand of a chain of binary operations
+  //
+  struct chain_link
+  {
+    const value* m_val{};
+    val_ops m_op{};
+  };
 
   //
   // Stores a value
@@ -18,8 +32,13 @@ namespace tnac::eval
   {
   public:
     using enum type_id;
+#if TNAC_NAN_BOXING
+    using underlying_val = nan_box;
+#else
     using underlying_val = std::variant<TNAC_TYPES>;
+#endif
     using size_type      = decltype(sizeof(0));
+    using chain_links    = std::span<const chain_link>;
 
   public:
     CLASS_SPECIALS_ALL_CUSTOM(value);
@@ -70,11 +89,16 @@ namespace tnac::eval
     //
     // Extracts the underlying value as the specified type
     // Use with care. Will break if the underlying value is of a wrong type
+    // With NaN boxing, returns a copy
     //
     template <expr_result T>
     decltype(auto) get() const noexcept
     {
+#if TNAC_NAN_BOXING
+      return m_raw.template get<T>();
+#else
       return std::get<T>(m_raw);
+#endif
     }
 
     //
@@ -90,11 +114,16 @@ namespace tnac::eval
     //
     // Attempts to extract the underlying value as the specified type
     // Returns a nullptr on failure
+    // With NaN boxing, returns an optional copy, which is empty on failure
     //
     template <expr_result T>
-    auto try_get() const noexcept -> decltype(&get<T>())
+    auto try_get() const noexcept
     {
+#if TNAC_NAN_BOXING
+      return m_raw.template get_if<T>();
+#else
       return std::get_if<T>(&m_raw);
+#endif
     }
 
     //
@@ -144,6 +173,12 @@ namespace tnac::eval
     //
     static value false_val() noexcept;
 
+    //
+    // Returns a reference to a shared invalid value
+    // Used by lookups which return values by reference and have nothing to return
+    //
+    static const value& invalid() noexcept;
+
     //
     // Returns a value for a function
     //
@@ -154,6 +189,14 @@ namespace tnac::eval
     //
     static value array(array_wrapper& aw) noexcept;
 
+    //
+    // Returns a lazy array of count elements: start, start + step, ...
+    // The elements are ints if both start and step are ints, and floats otherwise
+    // Returns an invalid value if the count is not a non-negative int,
+    // or the bounds are not numbers
+    //
+    static value range(store& vs, const value& count, const value& start, const value& step) noexcept;
+
     //
     // Applies a unary operation to the current value and returns a new resulting one
     //
@@ -165,6 +208,25 @@ namespace tnac::eval
     //
     value binary(val_ops op, const value& rhs) const noexcept;
 
+    //
+    // Applies a unary operation without looking up a specialised kernel
+    // Works for every type, used as a fallback by unary
+    //
+    value unary_generic(val_ops op) const noexcept;
+
+    //
+    // Applies a binary operation without looking up a specialised kernel
+    // Works for every type pair, used as a fallback by binary
+    //
+    value binary_generic(val_ops op, const value& rhs) const noexcept;
+
+    //
+    // Applies a chain of binary operations: ((this op rhs) op1 val1) op2 val2...
+    // If arrays are involved, the result is computed in one pass
+    // without materialising intermediate arrays
+    //
+    value binary_chain(val_ops op, const value& rhs, chain_links links) const noexcept;
+
   private:
     bool is_array() const noexcept;
 
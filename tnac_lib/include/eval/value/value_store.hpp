@@ -3,24 +3,125 @@
 //
 
 #pragma once
+#include "eval/value/value.hpp"
 
 namespace tnac::eval
 {
   class array_data;
   class array_wrapper;
+  class par_elems;
 }
 
 namespace tnac::eval
 {
+  //
+  // Free lists of array buffers grouped by size class
+  // Class N holds buffers with capacity in [2^N, 2^(N+1))
+  //
+  template <typename T>
+  class buffer_pool final
+  {
+  public:
+    using buffer    = std::vector<T>;
+    using size_type = std::size_t;
+
+    static constexpr auto classCount  = size_type{ std::numeric_limits<size_type>::digits };
+    static constexpr auto maxPerClass = size_type{ 64 };
+
+  private:
+    using free_list  = std::vector<buffer>;
+    using class_list = std::array<free_list, classCount>;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(buffer_pool);
+
+    ~buffer_pool() noexcept = default;
+
+    buffer_pool() noexcept = default;
+
+  public:
+    //
+    // Returns an empty buffer with at least the given capacity
+    //
+    buffer take(size_type minCap) noexcept
+    {
+      if (!minCap)
+        return {};
+
+      // The smallest class where every buffer is large enough
+      const auto cls = static_cast<size_type>(std::bit_width(minCap - 1));
+      if (cls < classCount)
+      {
+        if (auto&& fl = m_classes[cls]; !fl.empty())
+        {
+          auto res = std::move(fl.back());
+          fl.pop_back();
+          return res;
+        }
+      }
+
+      buffer res;
+      res.reserve(cls < classCount ? size_type{ 1 } << cls : minCap);
+      return res;
+    }
+
+    //
+    // Returns a buffer to the pool
+    // Its contents are destroyed
+    //
+    void put(buffer buf) noexcept
+    {
+      buf.clear();
+      const auto cap = buf.capacity();
+      if (!cap)
+        return;
+
+      auto&& fl = m_classes[std::bit_width(cap) - 1];
+      if (fl.size() < maxPerClass)
+        fl.emplace_back(std::move(buf));
+    }
+
+  private:
+    class_list m_classes{};
+  };
+
   //
   // Stores instances of various supported types
   //
+  // Arrays and wrappers are removed as soon as nothing references them.
+  // Buffers of removed arrays are recycled for new ones.
+  // Arrays which are never referenced, or which are only reachable through
+  // cycles via closures, are reclaimed by collect. It must only be called
+  // when no array is under construction, e.g. between top-level evaluations
+  //
   class store final
   {
   public:
     using array_list  = utils::ilist<array_data>;
     using array_wraps = utils::ilist<array_wrapper>;
     using size_type   = std::size_t;
+    using counter     = std::size_t;
+
+    //
+    // Number of allocations between automatic collections
+    //
+    static constexpr auto collectThreshold = counter{ 1024 };
+
+    //
+    // Cumulative counters
+    //
+    struct stats
+    {
+      counter m_collections{};
+      counter m_reclaimed{};
+      counter m_recycled{};
+    };
+
+  private:
+    using pools = std::tuple<buffer_pool<value>,
+                             buffer_pool<int_type>,
+                             buffer_pool<float_type>,
+                             buffer_pool<complex_type>>;
 
   public:
     CLASS_SPECIALS_NONE_CUSTOM(store);
@@ -60,8 +161,73 @@ namespace tnac::eval
     //
     array_wrapper& wrap(array_wrapper& aw, size_type offset, size_type size) noexcept;
 
+    //
+    // Creates a view of count elements of an existing wrapper,
+    // starting from the given element and advancing by step
+    // Negative steps go backwards. The view must fit into the wrapper
+    //
+    array_wrapper& view(array_wrapper& aw, size_type from, size_type count, std::ptrdiff_t step) noexcept;
+
+    //
+    // Takes a buffer from the free lists
+    //
+    template <typename T>
+    std::vector<T> take_buffer(size_type minCap) noexcept
+    {
+      return std::get<buffer_pool<T>>(m_pools).take(minCap);
+    }
+
+    //
+    // Returns a buffer to the free lists
+    //
+    template <typename T>
+    void recycle(std::vector<T> buf) noexcept
+    {
+      if (!buf.capacity())
+        return;
+
+      ++m_stats.m_recycled;
+      std::get<buffer_pool<T>>(m_pools).put(std::move(buf));
+    }
+
+    //
+    // Removes arrays and wrappers which are not reachable from outside the store
+    //
+    void collect() noexcept;
+
+    //
+    // Runs collect if enough allocations happened since the last one
+    //
+    void maybe_collect() noexcept;
+
+    //
+    // Attaches the runner for parallel elementwise operations
+    // Stores without one evaluate everything on the calling thread
+    //
+    void attach_par(par_elems* pe) noexcept;
+
+    //
+    // Returns the runner for parallel elementwise operations
+    //
+    par_elems* par() const noexcept;
+
+    //
+    // Returns the number of live arrays
+    //
+    size_type array_count() const noexcept;
+
+    //
+    // Returns the counters
+    //
+    const stats& counters() const noexcept;
+
   private:
+    // Arrays recycle their buffers on removal, so lists go last
+    pools m_pools;
+    stats m_stats;
+    counter m_allocs{};
+    par_elems* m_par{};
     array_list  m_arrData{};
     array_wraps m_arrWrappers{};
   };
-}
\ No newline at end of file
+}
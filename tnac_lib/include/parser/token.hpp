@@ -83,6 +83,7 @@ namespace tnac
     KwFloat,
     KwBool,
     KwArray,
+    KwRange,
     KwUndef,
     KwRet,
     KwTrue,
@@ -94,7 +95,8 @@ namespace tnac
     KwImport,
     KwAs,
     KwIO,
-    KwThis
+    KwThis,
+    KwLib
   };
 
   //
@@ -175,6 +177,7 @@ namespace tnac
                     KwFloat,
                     KwBool,
                     KwArray,
+                    KwRange,
                     KwUndef,
                     KwRet,
                     KwTrue,
@@ -186,7 +189,8 @@ namespace tnac
                     KwImport,
                     KwAs,
                     KwIO,
-                    KwThis);
+                    KwThis,
+                    KwLib);
     }
 
     auto is_literal() const noexcept
@@ -197,7 +201,7 @@ namespace tnac
 
     auto is_identifier() const noexcept
     {
-      return is_any(Identifier, KwThis);
+      return is_any(Identifier, KwThis, KwLib);
     }
 
   private:
@@ -154,6 +154,17 @@ namespace tnac
     //
     string_t contrive_func_name() noexcept;
 
+    //
+    // Returns the module which holds built-in functions
+    // It is created on first use
+    //
+    semantics::module_sym& intrinsics() noexcept;
+
+    //
+    // Checks whether the symbol is the built-in module or one of its functions
+    //
+    bool is_intrinsic(const semantics::symbol& sym) const noexcept;
+
     //
     // Returns an iterable collection of all declared variables
     //
@@ -199,5 +210,6 @@ namespace tnac
     semantics::sym_table m_symTab;
     utils::prefixed_pool m_generatedNames;
     semantics::scope* m_curScope{};
+    semantics::module_sym* m_intrinsics{};
   };
 }
\ No newline at end of file
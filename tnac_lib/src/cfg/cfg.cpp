@@ -30,6 +30,11 @@ namespace tnac::ir
     return m_builder->make_function(id, owner, name, conv_param_count(paramCount));
   }
 
+  function& cfg::declare_intrinsic(entity_id id, name_t name, size_type paramCount, eval::intrinsic which) noexcept
+  {
+    return m_builder->make_intrinsic(id, name, conv_param_count(paramCount), which);
+  }
+
   function* cfg::find_entity(entity_id id) noexcept
   {
     return m_builder->find_function(id);
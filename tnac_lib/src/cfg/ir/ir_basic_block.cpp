@@ -45,6 +45,17 @@ namespace tnac::ir // edge
   {
     return m_value;
   }
+
+  void edge::replace_value(operand val) noexcept
+  {
+    m_value = std::move(val);
+  }
+
+  void edge::disconnect() noexcept
+  {
+    m_in->remove_out(this);
+    m_out->remove_pred(this);
+  }
 }
 
 
@@ -114,6 +125,31 @@ namespace tnac::ir // basic block
     m_last = {};
   }
 
+  void basic_block::erase(instruction& in) noexcept
+  {
+    UTILS_ASSERT(&in.owner_block() == this);
+    auto instrIt = in.to_iterator();
+    if (instrIt == m_first && instrIt == m_last)
+    {
+      m_first = {};
+      m_last = {};
+    }
+    else if (instrIt == m_first)
+    {
+      m_first = std::next(instrIt);
+    }
+    else if (instrIt == m_last)
+    {
+      auto prev = m_first;
+      while (std::next(prev) != instrIt)
+        ++prev;
+      m_last = prev;
+    }
+
+    auto&& list = in.list();
+    list.remove(instrIt);
+  }
+
   basic_block::instruction_iter basic_block::begin() noexcept
   {
     return m_first;
@@ -155,14 +191,22 @@ namespace tnac::ir // basic block
 
   bool basic_block::is_connected_to(const basic_block& other) const noexcept
   {
-    for (auto e : m_out)
+    // Loops lead back to blocks which have already been checked
+    std::vector<const basic_block*> work{ this };
+    std::unordered_set<const basic_block*> visited{ this };
+    while (!work.empty())
     {
-      auto&& outConn = e->outgoing();
-      if (&outConn == &other)
-        return true;
-
-      if (outConn.is_connected_to(other))
-        return true;
+      auto cur = work.back();
+      work.pop_back();
+      for (auto e : cur->m_out)
+      {
+        auto&& outConn = e->outgoing();
+        if (&outConn == &other)
+          return true;
+
+        if (visited.emplace(&outConn).second)
+          work.push_back(&outConn);
+      }
     }
     return false;
   }
@@ -196,4 +240,13 @@ namespace tnac::ir // basic block
   {
     m_out.push_back(e);
   }
+
+  void basic_block::remove_pred(const edge* e) noexcept
+  {
+    std::erase(m_in, e);
+  }
+  void basic_block::remove_out(const edge* e) noexcept
+  {
+    std::erase(m_out, e);
+  }
 }
\ No newline at end of file
@@ -48,6 +48,13 @@ namespace tnac::ir
     return newFunc.m_module;
   }
 
+  function& builder::make_intrinsic(entity_id id, fname_t name, par_size_t paramCount, eval::intrinsic which) noexcept
+  {
+    auto&& newFunc = make_function(id, nullptr, name, paramCount);
+    newFunc.make_intrinsic(which);
+    return newFunc;
+  }
+
   instruction& builder::add_instruction(basic_block& owner, op_code op, size_type count, instruction_list::iterator pos) noexcept
   {
     auto&& newInstr = m_instructions.emplace_before(pos, owner, op, count);
@@ -77,6 +84,13 @@ namespace tnac::ir
     return add_alloc(owner, op_code::Arr, pos);
   }
 
+  instruction& builder::add_phi(basic_block& owner, size_type count) noexcept
+  {
+    auto&& phi = m_instructions.emplace_before(owner.begin(), owner, op_code::Phi, count);
+    owner.add_instruction_front(phi);
+    return phi;
+  }
+
   vreg& builder::make_register(string_t name) noexcept
   {
     return m_regs.emplace_front(name, vreg::Local);
@@ -112,13 +126,31 @@ namespace tnac::ir
 
   constant& builder::intern(vreg& reg, eval::array_type val) noexcept
   {
-    const auto id = val->id();
+    // Views share the underlying data, so the wrapper identifies the array
+    const auto id = entity_id{ &val.wrapper() };
     auto&& res = m_consts.emplace_back(reg, const_val{ std::move(val) });
     [[maybe_unused]] const auto emplaceOk = m_arrays.try_emplace(id, &res).second;
     UTILS_ASSERT(emplaceOk);
+    m_constPool.emplace(res.hash(), &res);
     return res;
   }
 
+  constant* builder::find_same(const eval::array_type& val) noexcept
+  {
+    if (auto item = m_arrays.find(entity_id{ &val.wrapper() }); item != m_arrays.end())
+      return item->second;
+
+    const auto key = const_val{ val };
+    auto [first, last] = m_constPool.equal_range(constant::content_hash(key));
+    for (auto it = first; it != last; ++it)
+    {
+      if (it->second->holds(key))
+        return it->second;
+    }
+
+    return {};
+  }
+
   record& builder::declare_rec(vreg& reg, record::size_type size) noexcept
   {
     auto&& res = m_recs.emplace_back(reg, size);
@@ -147,7 +179,7 @@ namespace tnac::ir
 
   constant* builder::interned(const eval::array_type& val) noexcept
   {
-    auto item = m_arrays.find(val->id());
+    auto item = m_arrays.find(entity_id{ &val.wrapper() });
     if (item == m_arrays.end())
     {
       UTILS_ASSERT(false);
@@ -175,10 +207,13 @@ namespace tnac::ir
 
   instruction& builder::add_alloc(basic_block& owner, op_code oc, instruction_list::iterator pos) noexcept
   {
+    auto ownerEnd = owner.end();
     auto&& alloc = m_instructions.emplace_before(pos, owner, oc);
     auto ownerBeg = owner.begin();
     if (pos == ownerBeg || !ownerBeg)
       owner.add_instruction_front(alloc);
+    else if (pos == ownerEnd)
+      owner.add_instruction(alloc);
 
     return alloc;
   }
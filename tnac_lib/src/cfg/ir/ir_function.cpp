@@ -1,5 +1,6 @@
 #include "cfg/ir/ir_function.hpp"
 #include "cfg/ir/ir_instructions.hpp"
+#include "eval/value/intrinsics.hpp"
 
 namespace tnac::ir
 {
@@ -65,6 +66,16 @@ namespace tnac::ir
     return m_loose;
   }
 
+  bool function::is_intrinsic() const noexcept
+  {
+    return m_intrinsic != eval::intrinsic::None;
+  }
+
+  eval::intrinsic function::intrinsic_id() const noexcept
+  {
+    return m_intrinsic;
+  }
+
   function::size_type function::param_count() const noexcept
   {
     return m_paramCount;
@@ -128,14 +139,35 @@ namespace tnac::ir
 
   void function::delete_block_tree(basic_block& root) noexcept
   {
-    root.clear_instructions();
-    for (auto out : root.outs())
+    // Successors go along once nothing else jumps to them
+    // Edges are disconnected first, so that loops don't bring us back
+    std::vector<basic_block*> work{ &root };
+    while (!work.empty())
     {
-      auto&& target = out->outgoing();
-      if(target.is_last_connection(root))
-        delete_block_tree(target);
+      auto&& block = *work.back();
+      work.pop_back();
+
+      auto preds = block.preds();
+      for (auto in : std::vector<edge*>(preds.begin(), preds.end()))
+        in->disconnect();
+
+      auto succs = block.outs();
+      for (auto out : std::vector<edge*>(succs.begin(), succs.end()))
+      {
+        auto&& target = out->outgoing();
+        out->disconnect();
+        if (&target == &block)
+          continue;
+
+        if (target.preds().empty())
+          work.push_back(&target);
+        else
+          drop_phi_inputs(target, block);
+      }
+
+      block.clear_instructions();
+      m_blocks.remove(block.name());
     }
-    m_blocks.remove(root.name());
   }
 
   void function::add_child_name(function& child) noexcept
@@ -149,6 +181,63 @@ namespace tnac::ir
     return *parts.begin();
   }
 
+  bool function::has_slots() const noexcept
+  {
+    return m_slotsReady;
+  }
+
+  void function::assign_slots() noexcept
+  {
+    m_slotsReady = true;
+    m_slotCount = std::max(m_slotCount, slot_type{ m_paramCount });
+
+    // Parameters go first, so that arguments land into their slots directly
+    for (auto&& block : m_blocks)
+    {
+      for (auto&& instr : block)
+      {
+        if (instr.opcode() != op_code::Load || !instr[1].is_param())
+          continue;
+
+        auto&& reg = instr[0].get_reg();
+        reg.assign_slot(*instr[1].get_param());
+      }
+    }
+
+    for (auto&& block : m_blocks)
+    {
+      for (auto&& instr : block)
+      {
+        for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+        {
+          auto&& op = instr[idx];
+          if (!op.is_register())
+            continue;
+
+          auto&& reg = op.get_reg();
+          if (!reg.is_global())
+            slot_of(reg);
+        }
+      }
+    }
+  }
+
+  function::slot_type function::slot_of(vreg& reg, slot_type lowerBound) noexcept
+  {
+    if (reg.has_slot())
+      return reg.slot();
+
+    const auto slot = std::max(m_slotCount, lowerBound);
+    m_slotCount = slot + 1;
+    reg.assign_slot(slot);
+    return slot;
+  }
+
+  function::slot_type function::slot_count() const noexcept
+  {
+    return m_slotCount;
+  }
+
 
   // Private members
 
@@ -163,8 +252,28 @@ namespace tnac::ir
     m_childSt.try_emplace(name, &child);
   }
 
+  void function::drop_phi_inputs(basic_block& block, const basic_block& from) noexcept
+  {
+    for (auto&& instr : block)
+    {
+      if (instr.opcode() != op_code::Phi)
+        continue;
+
+      for (auto idx = instr.operand_count(); idx > 1; --idx)
+      {
+        if (auto&& op = instr[idx - 1]; op.is_edge() && &op.get_edge().incoming() == &from)
+          instr.remove(idx - 1);
+      }
+    }
+  }
+
   void function::make_loose() noexcept
   {
     m_loose = true;
   }
+
+  void function::make_intrinsic(eval::intrinsic id) noexcept
+  {
+    m_intrinsic = id;
+  }
 }
\ No newline at end of file
@@ -60,6 +60,17 @@ namespace tnac::ir // virtual register
     return FROM_CONST(source);
   }
 
+  bool vreg::has_slot() const noexcept
+  {
+    return m_slot != noSlot;
+  }
+
+  vreg::slot_type vreg::slot() const noexcept
+  {
+    UTILS_ASSERT(has_slot());
+    return m_slot;
+  }
+
 
   // Protected members
 
@@ -74,6 +85,11 @@ namespace tnac::ir // virtual register
     if (m_source == instr)
       m_source = {};
   }
+
+  void vreg::assign_slot(slot_type slot) noexcept
+  {
+    m_slot = slot;
+  }
 }
 
 
@@ -268,6 +284,7 @@ namespace tnac::ir // instruction
     case Alloc:       return "alloc"sv;
     case StructAlloc: return "salloc"sv;
     case Arr:         return "arr"sv;
+    case Range:       return "range"sv;
     case Store:       return "store"sv;
     case Load:        return "load"sv;
     case Append:      return "append"sv;
@@ -323,6 +340,28 @@ namespace tnac::ir // instruction
     return *this;
   }
 
+  void instruction::replace(size_type idx, operand op) noexcept
+  {
+    UTILS_ASSERT(idx < m_operands.size());
+    m_operands[idx] = std::move(op);
+  }
+
+  void instruction::remove(size_type idx) noexcept
+  {
+    UTILS_ASSERT(idx < m_operands.size());
+    m_operands.erase(std::next(m_operands.begin(), idx));
+  }
+
+  void instruction::release_result() noexcept
+  {
+    if (!needs_result(opcode()) || m_operands.empty())
+      return;
+
+    auto&& op0 = m_operands.front();
+    if (op0.is_register())
+      op0.get_reg().drop_source_if(this);
+  }
+
   string_t instruction::opcode_str() const noexcept
   {
     return opcode_str(m_opCode);
@@ -370,6 +409,7 @@ namespace tnac::ir // instruction
     case Alloc:       count = 1; break;
     case StructAlloc: count = 3; break;
     case Arr:         count = 2; break;
+    case Range:       count = 4; break;
     case Append:      count = 2; break;
     case StoreElem:   count = 2; break;
 
@@ -1,4 +1,143 @@
 #include "cfg/ir/ir_stored.hpp"
+#include "eval/value/type_impl.hpp"
+
+namespace tnac::ir::detail
+{
+  namespace
+  {
+    using hash_type = constant::hash_type;
+    using size_type = eval::array_wrapper::size_type;
+
+    constexpr auto combine(hash_type seed, hash_type h) noexcept
+    {
+      return seed ^ (h + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+    }
+
+    template <typename T>
+    auto hash_of(const T& val) noexcept
+    {
+      return std::hash<T>{}(val);
+    }
+
+    auto float_bits(eval::float_type f) noexcept
+    {
+      return std::bit_cast<std::uint64_t>(f);
+    }
+
+    auto elem_at(const eval::array_wrapper& aw, size_type idx) noexcept
+    {
+      return aw.data().read_at(aw.index_of(idx));
+    }
+
+    hash_type content_hash(const eval::value& val) noexcept
+    {
+      using enum eval::type_id;
+      auto res = static_cast<hash_type>(val.id());
+      switch (val.id())
+      {
+      case Bool: return combine(res, hash_of(val.get<Bool>()));
+      case Int:  return combine(res, hash_of(val.get<Int>()));
+
+      // Bitwise, since 0.0 and -0.0 are different constants
+      case Float: return combine(res, hash_of(float_bits(val.get<Float>())));
+
+      case Complex:
+      {
+        const auto c = val.get<Complex>();
+        res = combine(res, hash_of(float_bits(c.real())));
+        return combine(res, hash_of(float_bits(c.imag())));
+      }
+
+      case Fraction:
+      {
+        const auto f = val.get<Fraction>();
+        res = combine(res, hash_of(f.num()));
+        res = combine(res, hash_of(f.denom()));
+        return combine(res, hash_of(f.sign()));
+      }
+
+      case Function:
+      {
+        const auto f = val.get<Function>();
+        res = combine(res, hash_of(&(*f)));
+        return f.is_closure() ? combine(res, hash_of(&f.closure_data())) : res;
+      }
+
+      case Array:
+      {
+        auto&& aw = val.get<Array>().wrapper();
+        res = combine(res, hash_of(aw.size()));
+        for (auto idx = size_type{}; idx < aw.size(); ++idx)
+          res = combine(res, content_hash(elem_at(aw, idx)));
+
+        return res;
+      }
+
+      default: return res;
+      }
+    }
+
+    bool same_content(const eval::value& l, const eval::value& r) noexcept
+    {
+      using enum eval::type_id;
+      if (l.id() != r.id())
+        return false;
+
+      switch (l.id())
+      {
+      case Bool:  return l.get<Bool>() == r.get<Bool>();
+      case Int:   return l.get<Int>() == r.get<Int>();
+      case Float: return float_bits(l.get<Float>()) == float_bits(r.get<Float>());
+
+      case Complex:
+      {
+        const auto lc = l.get<Complex>();
+        const auto rc = r.get<Complex>();
+        return float_bits(lc.real()) == float_bits(rc.real()) &&
+               float_bits(lc.imag()) == float_bits(rc.imag());
+      }
+
+      case Fraction:
+      {
+        const auto lf = l.get<Fraction>();
+        const auto rf = r.get<Fraction>();
+        return lf.num() == rf.num() && lf.denom() == rf.denom() && lf.sign() == rf.sign();
+      }
+
+      case Function:
+      {
+        const auto lf = l.get<Function>();
+        const auto rf = r.get<Function>();
+        if (&(*lf) != &(*rf) || lf.is_closure() != rf.is_closure())
+          return false;
+
+        return !lf.is_closure() || &lf.closure_data() == &rf.closure_data();
+      }
+
+      case Array:
+      {
+        auto&& la = l.get<Array>().wrapper();
+        auto&& ra = r.get<Array>().wrapper();
+        if (&la == &ra)
+          return true;
+
+        if (la.size() != ra.size())
+          return false;
+
+        for (auto idx = size_type{}; idx < la.size(); ++idx)
+        {
+          if (!same_content(elem_at(la, idx), elem_at(ra, idx)))
+            return false;
+        }
+
+        return true;
+      }
+
+      default: return true;
+      }
+    }
+  }
+}
 
 namespace tnac::ir // constant
 {
@@ -9,12 +148,23 @@ namespace tnac::ir // constant
   constant::constant(vreg& reg, value_type val) noexcept :
     node{ kind::Constant },
     m_reg{ &reg },
-    m_value{ std::move(val) }
+    m_value{ std::move(val) },
+    m_hash{ content_hash(m_value) }
   {}
 
 
   // Public members
 
+  constant::hash_type constant::content_hash(const value_type& val) noexcept
+  {
+    return detail::content_hash(val);
+  }
+
+  bool constant::same_content(const value_type& l, const value_type& r) noexcept
+  {
+    return detail::same_content(l, r);
+  }
+
   const vreg& constant::target_reg() const noexcept
   {
     return *m_reg;
@@ -28,6 +178,16 @@ namespace tnac::ir // constant
   {
     return m_value;
   }
+
+  constant::hash_type constant::hash() const noexcept
+  {
+    return m_hash;
+  }
+
+  bool constant::holds(const value_type& val) const noexcept
+  {
+    return detail::same_content(m_value, val);
+  }
 }
 
 
@@ -0,0 +1,374 @@
+#include "cfg/passes/cleanup.hpp"
+
+namespace tnac::ir::detail
+{
+  namespace
+  {
+    //
+    // Checks whether the first operand of an instruction is its result
+    //
+    bool has_result(op_code oc) noexcept
+    {
+      using enum op_code;
+      return utils::eq_none(oc, Store, Append, Jump, Ret, StoreElem);
+    }
+
+    //
+    // Checks whether the instruction can be deleted once its result is unused
+    //
+    bool is_removable(op_code oc) noexcept
+    {
+      using enum op_code;
+      return utils::eq_any(oc,
+        Add, Sub, Mul, Div, Mod, Pow, Root, And, Or, Xor,
+        CmpE, CmpL, CmpLE, CmpNE, CmpG, CmpGE,
+        Abs, Plus, Head, Tail, Neg, BNeg, CmpNot, CmpIs,
+        Test, Select, Phi);
+    }
+
+    //
+    // Returns the operand an instruction reads
+    // Phis read values attached to their edges
+    //
+    operand read_value(const operand& op) noexcept
+    {
+      return op.is_edge() ? op.get_edge().value() : op;
+    }
+  }
+}
+
+namespace tnac::ir
+{
+  // Special members
+
+  cleanup::~cleanup() noexcept = default;
+
+  cleanup::cleanup(builder& bld) noexcept :
+    m_builder{ &bld }
+  {}
+
+
+  // Public members
+
+  cleanup::result cleanup::operator()(function& fn) noexcept
+  {
+    result res;
+    if (fn.is_intrinsic())
+      return res;
+
+    res.m_erased = erase_dead(fn);
+
+    // Merging and threading can make more blocks trivial, so this goes on until nothing changes
+    for (auto changed = true; changed; )
+    {
+      changed = false;
+      block_list blocks;
+      for (auto&& block : fn.blocks())
+        blocks.push_back(&block);
+
+      for (auto block : blocks)
+      {
+        if (m_deleted.contains(block))
+          continue;
+
+        if (thread(*block) || merge(*block))
+        {
+          ++res.m_merged;
+          changed = true;
+        }
+      }
+    }
+
+    m_uses.clear();
+    m_deleted.clear();
+    return res;
+  }
+
+
+  // Private members
+
+  cleanup::size_type cleanup::erase_dead(function& fn) noexcept
+  {
+    count_uses(fn);
+    auto isDead = [&](const instruction& instr) noexcept
+      {
+        if (!detail::is_removable(instr.opcode()) || &instr.owner_block().func() != &fn)
+          return false;
+
+        auto&& res = instr[0];
+        if (!res.is_register() || res.get_reg().is_global())
+          return false;
+
+        auto found = m_uses.find(&res.get_reg());
+        return found == m_uses.end() || !found->second;
+      };
+
+    instr_list work;
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        if (isDead(instr))
+          work.push_back(&instr);
+      }
+    }
+
+    instr_set erased;
+    while (!work.empty())
+    {
+      auto instr = work.back();
+      work.pop_back();
+      if (!erased.emplace(instr).second)
+        continue;
+
+      for (auto idx = instruction::size_type{ 1 }; idx < instr->operand_count(); ++idx)
+      {
+        auto op = detail::read_value((*instr)[idx]);
+        if (!op.is_register())
+          continue;
+
+        auto&& reg = op.get_reg();
+        auto&& count = m_uses[&reg];
+        if (count)
+          --count;
+
+        if (!count && reg.has_src() && isDead(reg.source()))
+          work.push_back(&reg.source());
+      }
+
+      instr->owner_block().erase(*instr);
+    }
+
+    return erased.size();
+  }
+
+  void cleanup::count_uses(const function& fn) noexcept
+  {
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        const auto first = detail::has_result(instr.opcode()) ? 1u : 0u;
+        for (auto idx = instruction::size_type{ first }; idx < instr.operand_count(); ++idx)
+        {
+          if (auto op = detail::read_value(instr[idx]); op.is_register())
+            ++m_uses[&op.get_reg()];
+        }
+      }
+    }
+
+    // Registers read by nested functions stay alive
+    for (auto child : fn.children())
+      count_uses(*child);
+  }
+
+  bool cleanup::thread(basic_block& block) noexcept
+  {
+    auto&& fn = block.func();
+    auto target = jump_target(block);
+    if (!target || target == &block || &block == &fn.entry() || block.begin() != block.last())
+      return false;
+
+    auto out = find_edge(block, *target);
+    auto incoming = block.preds();
+    auto preds = std::vector<edge*>(incoming.begin(), incoming.end());
+    if (!out || preds.empty())
+      return false;
+
+    block_set sources;
+    for (auto in : preds)
+    {
+      // A block already jumping to the target would give its phis two values
+      auto&& from = in->incoming();
+      auto last = from.last();
+      if (!sources.emplace(&from).second || find_edge(from, *target) || !last || last->opcode() != op_code::Jump)
+        return false;
+    }
+
+    for (auto in : preds)
+    {
+      auto&& from = in->incoming();
+      auto&& jump = *from.last();
+      for (auto idx = instruction::size_type{}; idx < jump.operand_count(); ++idx)
+      {
+        if (auto&& op = jump[idx]; op.is_block() && &op.get_block() == &block)
+          jump.replace(idx, target);
+      }
+
+      auto&& bypass = m_builder->make_edge(from, *target, out->value());
+      add_incoming(*target, block, *out, bypass);
+      in->disconnect();
+    }
+
+    drop_incoming(*target, block);
+    drop_block(block);
+    return true;
+  }
+
+  bool cleanup::merge(basic_block& block) noexcept
+  {
+    auto&& fn = block.func();
+    auto next = jump_target(block);
+    if (!next || next == &block)
+      return false;
+
+    auto preds = next->preds();
+    if (preds.size() != 1 || &preds.front()->incoming() != &block)
+      return false;
+
+    block_set targets;
+    auto succs = next->outs();
+    auto outs = std::vector<edge*>(succs.begin(), succs.end());
+    for (auto out : outs)
+    {
+      if (!targets.emplace(&out->outgoing()).second)
+        return false;
+    }
+
+    // With a single predecessor, phis simply pass its value along
+    auto link = preds.front();
+    for (auto&& instr : *next)
+    {
+      if (instr.opcode() != op_code::Phi)
+        continue;
+
+      operand val{ eval::value{} };
+      for (auto idx = instruction::size_type{ 1 }; idx < instr.operand_count(); ++idx)
+      {
+        if (auto&& e = instr[idx].get_edge(); &e.incoming() == &block)
+        {
+          val = e.value();
+          break;
+        }
+      }
+
+      replace_uses(fn, instr[0].get_reg(), val);
+    }
+
+    // Copies go right after the jump, which is then deleted
+    auto jump = block.last();
+    const auto pos = block.end();
+    for (auto&& instr : *next)
+    {
+      if (instr.opcode() == op_code::Phi)
+        continue;
+
+      instr.release_result();
+      auto&& copy = m_builder->add_instruction(block, instr.opcode(), instr.operand_count(), pos);
+      for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+        copy.add(instr[idx]);
+    }
+    block.erase(*jump);
+    link->disconnect();
+
+    for (auto out : outs)
+    {
+      auto&& to = out->outgoing();
+      auto&& moved = m_builder->make_edge(block, to, out->value());
+      add_incoming(to, *next, *out, moved);
+      drop_incoming(to, *next);
+      out->disconnect();
+    }
+
+    drop_block(*next);
+    return true;
+  }
+
+  void cleanup::add_incoming(basic_block& block, const basic_block& from, const edge& old, edge& cur) noexcept
+  {
+    for (auto&& instr : block)
+    {
+      if (instr.opcode() != op_code::Phi)
+        continue;
+
+      for (auto idx = instruction::size_type{ 1 }; idx < instr.operand_count(); ++idx)
+      {
+        auto&& e = instr[idx].get_edge();
+        if (&e.incoming() != &from)
+          continue;
+
+        if (&e == &old)
+          instr.add(&cur);
+        else
+          instr.add(&m_builder->make_loose(cur.incoming(), block, e.value()));
+
+        break;
+      }
+    }
+  }
+
+  void cleanup::drop_incoming(basic_block& block, const basic_block& from) noexcept
+  {
+    for (auto&& instr : block)
+    {
+      if (instr.opcode() != op_code::Phi)
+        continue;
+
+      for (auto idx = instr.operand_count(); idx > 1; --idx)
+      {
+        if (&instr[idx - 1].get_edge().incoming() == &from)
+          instr.remove(idx - 1);
+      }
+    }
+  }
+
+  void cleanup::replace_uses(function& fn, const vreg& reg, const operand& val) noexcept
+  {
+    auto isReg = [&reg](const operand& op) noexcept
+      {
+        return op.is_register() && &op.get_reg() == &reg;
+      };
+
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        const auto first = detail::has_result(instr.opcode()) ? 1u : 0u;
+        for (auto idx = instruction::size_type{ first }; idx < instr.operand_count(); ++idx)
+        {
+          auto&& op = instr[idx];
+          if (op.is_edge() && isReg(op.get_edge().value()))
+            op.get_edge().replace_value(val);
+          else if (isReg(op))
+            instr.replace(idx, val);
+        }
+      }
+
+      for (auto out : block.outs())
+      {
+        if (isReg(out->value()))
+          out->replace_value(val);
+      }
+    }
+  }
+
+  void cleanup::drop_block(basic_block& block) noexcept
+  {
+    auto succs = block.outs();
+    for (auto out : std::vector<edge*>(succs.begin(), succs.end()))
+      out->disconnect();
+
+    m_deleted.emplace(&block);
+    block.func().delete_block_tree(block);
+  }
+
+  basic_block* cleanup::jump_target(basic_block& block) noexcept
+  {
+    auto last = block.last();
+    if (!last || last->opcode() != op_code::Jump || last->operand_count() != 1 || !(*last)[0].is_block())
+      return nullptr;
+
+    return &(*last)[0].get_block();
+  }
+
+  edge* cleanup::find_edge(basic_block& from, const basic_block& to) noexcept
+  {
+    for (auto out : from.outs())
+    {
+      if (&out->outgoing() == &to)
+        return out;
+    }
+
+    return nullptr;
+  }
+}
@@ -0,0 +1,197 @@
+#include "cfg/passes/dom_tree.hpp"
+
+namespace tnac::ir
+{
+  // Special members
+
+  dom_tree::~dom_tree() noexcept = default;
+
+  dom_tree::dom_tree(function& fn) noexcept
+  {
+    build_order(fn);
+    build_tree();
+  }
+
+
+  // Public members
+
+  dom_tree::block_list dom_tree::successors(basic_block& block) noexcept
+  {
+    block_list res;
+    auto last = block.last();
+    if (!last || last->opcode() != op_code::Jump)
+      return res;
+
+    for (auto idx = instruction::size_type{}; idx < last->operand_count(); ++idx)
+    {
+      auto&& op = (*last)[idx];
+      if (!op.is_block())
+        continue;
+
+      auto target = &op.get_block();
+      if (std::ranges::find(res, target) == res.end())
+        res.push_back(target);
+    }
+
+    return res;
+  }
+
+  const dom_tree::block_list& dom_tree::order() const noexcept
+  {
+    return m_order;
+  }
+
+  bool dom_tree::is_reachable(const basic_block& block) const noexcept
+  {
+    return m_nodes.contains(&block);
+  }
+
+  const dom_tree::block_list& dom_tree::preds(const basic_block& block) const noexcept
+  {
+    return node_of(block).m_preds;
+  }
+
+  basic_block* dom_tree::idom(const basic_block& block) const noexcept
+  {
+    auto found = m_nodes.find(&block);
+    return found != m_nodes.end() ? found->second.m_idom : nullptr;
+  }
+
+  const dom_tree::block_list& dom_tree::children(const basic_block& block) const noexcept
+  {
+    return node_of(block).m_children;
+  }
+
+  bool dom_tree::dominates(const basic_block& dom, const basic_block& block) const noexcept
+  {
+    if (!is_reachable(dom) || !is_reachable(block))
+      return false;
+
+    const auto domIdx = node_of(dom).m_index;
+    for (auto cur = &block; cur; cur = idom(*cur))
+    {
+      if (cur == &dom)
+        return true;
+
+      // Dominators come earlier in the order
+      if (node_of(*cur).m_index < domIdx)
+        return false;
+    }
+
+    return false;
+  }
+
+
+  // Private members
+
+  void dom_tree::build_order(function& fn) noexcept
+  {
+    struct dfs_item
+    {
+      basic_block* m_block{};
+      block_list m_succs;
+      size_type m_next{};
+    };
+
+    std::vector<dfs_item> stack;
+    auto visit = [&](basic_block& block) noexcept
+      {
+        if (!m_nodes.try_emplace(&block).second)
+          return;
+
+        auto&& item = stack.emplace_back();
+        item.m_block = &block;
+        item.m_succs = successors(block);
+      };
+
+    visit(fn.entry());
+    while (!stack.empty())
+    {
+      auto&& top = stack.back();
+      if (top.m_next == top.m_succs.size())
+      {
+        m_order.push_back(top.m_block);
+        stack.pop_back();
+        continue;
+      }
+
+      auto succ = top.m_succs[top.m_next++];
+      visit(*succ);
+    }
+
+    std::ranges::reverse(m_order);
+    for (auto idx = size_type{}; idx < m_order.size(); ++idx)
+    {
+      auto block = m_order[idx];
+      m_nodes[block].m_index = idx;
+      for (auto succ : successors(*block))
+        m_nodes[succ].m_preds.push_back(block);
+    }
+  }
+
+  void dom_tree::build_tree() noexcept
+  {
+    if (m_order.empty())
+      return;
+
+    // Back edges come from blocks later in the order, whose dominators
+    // aren't known on the first pass. Those are skipped until they are,
+    // and passes are repeated until nothing changes
+    // The entry temporarily dominates itself to stop the intersection
+    auto entry = m_order.front();
+    m_nodes[entry].m_idom = entry;
+    for (auto changed = true; changed; )
+    {
+      changed = false;
+      for (auto block : m_order)
+      {
+        if (block == entry)
+          continue;
+
+        basic_block* dom{};
+        for (auto pred : m_nodes[block].m_preds)
+        {
+          if (!m_nodes[pred].m_idom)
+            continue;
+
+          dom = dom ? intersect(dom, pred) : pred;
+        }
+
+        auto&& blockNode = m_nodes[block];
+        if (blockNode.m_idom != dom)
+        {
+          blockNode.m_idom = dom;
+          changed = true;
+        }
+      }
+    }
+
+    m_nodes[entry].m_idom = {};
+    for (auto block : m_order)
+    {
+      if (auto dom = m_nodes[block].m_idom)
+        m_nodes[dom].m_children.push_back(block);
+    }
+  }
+
+  basic_block* dom_tree::intersect(basic_block* l, basic_block* r) const noexcept
+  {
+    while (l != r)
+    {
+      while (node_of(*l).m_index > node_of(*r).m_index)
+        l = node_of(*l).m_idom;
+
+      while (node_of(*r).m_index > node_of(*l).m_index)
+        r = node_of(*r).m_idom;
+    }
+
+    return l;
+  }
+
+  const dom_tree::node& dom_tree::node_of(const basic_block& block) const noexcept
+  {
+    auto found = m_nodes.find(&block);
+    UTILS_ASSERT(found != m_nodes.end());
+    return found->second;
+  }
+}
@@ -0,0 +1,204 @@
+#include "cfg/passes/gvn.hpp"
+
+namespace tnac::ir::detail
+{
+  namespace
+  {
+    using hash_type = gvn::hash_type;
+
+    constexpr auto combine(hash_type seed, hash_type h) noexcept
+    {
+      return seed ^ (h + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+    }
+
+    //
+    // Checks whether the instruction computes its result from operands alone
+    //
+    bool is_pure(op_code oc) noexcept
+    {
+      using enum op_code;
+      return utils::eq_any(oc,
+        Add, Sub, Mul, Div, Mod, Pow, Root, And, Or, Xor,
+        CmpE, CmpL, CmpLE, CmpNE, CmpG, CmpGE,
+        Abs, Plus, Head, Tail, Neg, BNeg, CmpNot, CmpIs,
+        Test, Select);
+    }
+
+    //
+    // Checks whether two operands refer to the same value
+    //
+    bool same(const operand& l, const operand& r) noexcept
+    {
+      if (l.is_register() && r.is_register())
+        return &l.get_reg() == &r.get_reg();
+
+      if (l.is_value() && r.is_value())
+        return constant::same_content(l.get_value(), r.get_value());
+
+      if (l.is_typeid() && r.is_typeid())
+        return l.get_typeid() == r.get_typeid();
+
+      return false;
+    }
+  }
+}
+
+namespace tnac::ir
+{
+  // Special members
+
+  gvn::~gvn() noexcept = default;
+
+  gvn::gvn() noexcept = default;
+
+
+  // Public members
+
+  gvn::size_type gvn::operator()(function& fn) noexcept
+  {
+    if (fn.is_intrinsic())
+      return {};
+
+    dom_tree tree{ fn };
+    if (!tree.order().empty())
+      number(*tree.order().front(), tree);
+
+    for (auto instr : m_dead)
+      instr->owner_block().erase(*instr);
+
+    // Phis can take values from blocks which were numbered after them
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+        redirect(instr);
+
+      for (auto out : block.outs())
+        out->replace_value(resolve(out->value()));
+    }
+
+    const auto res = m_dead.size();
+    m_avail.clear();
+    m_scope.clear();
+    m_replaced.clear();
+    m_dead.clear();
+    return res;
+  }
+
+
+  // Private members
+
+  void gvn::number(basic_block& block, const dom_tree& tree) noexcept
+  {
+    const auto scopeStart = m_scope.size();
+    for (auto&& instr : block)
+    {
+      redirect(instr);
+      auto h = hash(instr);
+      if (!h)
+        continue;
+
+      if (auto prev = find(*h, instr))
+      {
+        m_replaced.insert_or_assign(&instr[0].get_reg(), &(*prev)[0].get_reg());
+        m_dead.push_back(&instr);
+        continue;
+      }
+
+      m_avail.emplace(*h, &instr);
+      m_scope.emplace_back(*h, &instr);
+    }
+
+    for (auto child : tree.children(block))
+      number(*child, tree);
+
+    // Instructions of this block don't dominate anything outside of its subtree
+    while (m_scope.size() > scopeStart)
+    {
+      auto [h, instr] = m_scope.back();
+      m_scope.pop_back();
+      auto [first, last] = m_avail.equal_range(h);
+      for (auto it = first; it != last; ++it)
+      {
+        if (it->second != instr)
+          continue;
+
+        m_avail.erase(it);
+        break;
+      }
+    }
+  }
+
+  gvn::hash_opt gvn::hash(const instruction& instr) const noexcept
+  {
+    const auto oc = instr.opcode();
+    if (!detail::is_pure(oc) || !instr.operand_count())
+      return {};
+
+    auto&& res = instr[0];
+    if (!res.is_register() || res.get_reg().is_global())
+      return {};
+
+    auto h = std::hash<op_code>{}(oc);
+    for (auto idx = instruction::size_type{ 1 }; idx < instr.operand_count(); ++idx)
+    {
+      auto&& op = instr[idx];
+      if (op.is_register())
+        h = detail::combine(h, std::hash<const vreg*>{}(&op.get_reg()));
+      else if (op.is_value())
+        h = detail::combine(h, constant::content_hash(op.get_value()));
+      else if (op.is_typeid())
+        h = detail::combine(h, std::hash<eval::type_id>{}(op.get_typeid()));
+      else
+        return {};
+    }
+
+    return h;
+  }
+
+  instruction* gvn::find(hash_type h, const instruction& instr) const noexcept
+  {
+    auto [first, last] = m_avail.equal_range(h);
+    for (auto it = first; it != last; ++it)
+    {
+      auto&& cand = *it->second;
+      if (cand.opcode() != instr.opcode() || cand.operand_count() != instr.operand_count())
+        continue;
+
+      auto match = true;
+      for (auto idx = instruction::size_type{ 1 }; match && idx < instr.operand_count(); ++idx)
+        match = detail::same(cand[idx], instr[idx]);
+
+      if (match)
+        return &cand;
+    }
+
+    return {};
+  }
+
+  void gvn::redirect(instruction& instr) const noexcept
+  {
+    if (m_replaced.empty())
+      return;
+
+    for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+    {
+      auto&& op = instr[idx];
+      if (op.is_edge())
+      {
+        auto&& e = op.get_edge();
+        e.replace_value(resolve(e.value()));
+      }
+      else if (op.is_register() && m_replaced.contains(&op.get_reg()))
+        instr.replace(idx, resolve(op));
+    }
+  }
+
+  operand gvn::resolve(const operand& op) const noexcept
+  {
+    if (!op.is_register())
+      return op;
+
+    auto found = m_replaced.find(&op.get_reg());
+    return found != m_replaced.end() ? operand{ found->second } : op;
+  }
+}
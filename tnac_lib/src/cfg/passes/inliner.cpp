@@ -0,0 +1,347 @@
+#include "cfg/passes/inliner.hpp"
+#include "eval/value/type_impl.hpp"
+
+namespace tnac::ir::detail
+{
+  namespace
+  {
+    //
+    // Checks whether the first operand of an instruction is its result
+    //
+    bool has_result(op_code oc) noexcept
+    {
+      using enum op_code;
+      return utils::eq_none(oc, Store, Append, Jump, Ret, StoreElem);
+    }
+
+    //
+    // Checks whether the instruction loads a parameter
+    //
+    bool is_param_load(const instruction& instr) noexcept
+    {
+      return instr.opcode() == op_code::Load && instr[1].is_param();
+    }
+
+    //
+    // Returns the function an operand refers to statically
+    //
+    const function* static_func(const operand& op) noexcept
+    {
+      if (!op.is_value())
+        return nullptr;
+
+      auto ft = op.get_value().try_get<eval::function_type>();
+      return ft ? &(**ft) : nullptr;
+    }
+  }
+}
+
+namespace tnac::ir
+{
+  // Special members
+
+  inliner::~inliner() noexcept = default;
+
+  inliner::inliner(builder& bld, block_namer names) noexcept :
+    m_builder{ &bld },
+    m_names{ std::move(names) }
+  {}
+
+
+  // Public members
+
+  const inliner::settings& inliner::config() const noexcept
+  {
+    return m_settings;
+  }
+
+  void inliner::configure(const settings& cfg) noexcept
+  {
+    m_settings = cfg;
+  }
+
+  inliner::size_type inliner::operator()(function& fn) noexcept
+  {
+    if (!m_settings.m_enabled || fn.is_intrinsic())
+      return {};
+
+    std::vector<std::pair<instruction*, const function*>> sites;
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        if (auto callee = inlinable(fn, instr))
+          sites.emplace_back(&instr, callee);
+      }
+    }
+
+    // Splitting a block moves instructions following the call,
+    // so calls are inlined starting with the last one
+    for (auto [call, callee] : sites | std::views::reverse)
+    {
+      inline_call(*call, *callee);
+      auto&& depth = m_depth[&fn];
+      depth = std::max(depth, depth_of(*callee) + 1);
+    }
+
+    m_regs.clear();
+    m_blocks.clear();
+    m_edges.clear();
+    return sites.size();
+  }
+
+
+  // Private members
+
+  const function* inliner::inlinable(const function& caller, const instruction& call) const noexcept
+  {
+    if (call.opcode() != op_code::Call || call.operand_count() < 2)
+      return nullptr;
+
+    auto callee = detail::static_func(call[1]);
+    if (!callee || call[1].get_value().try_get<eval::function_type>()->is_closure())
+      return nullptr;
+
+    if (callee->param_count() + 2u != call.operand_count())
+      return nullptr;
+
+    if (depth_of(*callee) >= m_settings.m_maxDepth)
+      return nullptr;
+
+    return can_copy(*callee, caller) ? callee : nullptr;
+  }
+
+  bool inliner::can_copy(const function& callee, const function& caller) const noexcept
+  {
+    if (&callee == &caller || callee.is_intrinsic() || callee.is_loose() || callee.is_closure())
+      return false;
+
+    // Modules keep growing, and nested functions refer to registers of their owners
+    if (!callee.owner_func() || !callee.children().empty())
+      return false;
+
+    // Owners of the caller aren't fully compiled yet
+    for (auto owner = caller.owner_func(); owner; owner = owner->owner_func())
+    {
+      if (owner == &callee)
+        return false;
+    }
+
+    using enum op_code;
+    auto size = size_type{};
+    auto rets = size_type{};
+    for (auto&& block : callee.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        if (++size > m_settings.m_maxSize)
+          return false;
+
+        // Variables and records live in the callee's frame
+        const auto oc = instr.opcode();
+        if (utils::eq_any(oc, Alloc, StructAlloc, Store))
+          return false;
+
+        if (oc == Ret)
+          ++rets;
+
+        for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+        {
+          if (auto fn = detail::static_func(instr[idx]); fn == &callee || fn == &caller)
+            return false;
+        }
+      }
+    }
+
+    return rets > 0;
+  }
+
+  void inliner::inline_call(instruction& call, const function& callee) noexcept
+  {
+    auto&& block = call.owner_block();
+    auto&& caller = block.func();
+    map_registers(callee, call);
+    auto&& cont = split(call);
+    copy_graph(callee, caller);
+
+    edge_list rets;
+    const auto pos = cont.end();
+    for (auto&& src : callee.blocks())
+      copy_block(src, cont, pos, rets);
+
+    auto&& entry = *m_blocks[&callee.entry()];
+    auto&& jump = m_builder->add_instruction(block, op_code::Jump, block.end());
+    jump.add(&entry);
+    m_builder->make_edge(block, entry, eval::value{});
+
+    // The call's result now comes from the returns
+    call.release_result();
+    auto&& phi = m_builder->add_phi(cont, rets.size() + 1);
+    phi.add(call[0]);
+    for (auto ret : rets)
+      phi.add(ret);
+
+    block.erase(call);
+  }
+
+  basic_block& inliner::split(instruction& call) noexcept
+  {
+    auto&& block = call.owner_block();
+    auto&& cont = block.func().create_block(m_names("inline"sv, "cont"sv));
+
+    instr_list moved;
+    auto after = false;
+    for (auto&& instr : block)
+    {
+      if (after)
+        moved.push_back(&instr);
+      else
+        after = &instr == &call;
+    }
+
+    const auto pos = block.end();
+    for (auto instr : moved)
+    {
+      instr->release_result();
+      auto&& copy = m_builder->add_instruction(cont, instr->opcode(), instr->operand_count(), pos);
+      for (auto idx = instruction::size_type{}; idx < instr->operand_count(); ++idx)
+        copy.add((*instr)[idx]);
+    }
+
+    for (auto instr : moved)
+      block.erase(*instr);
+
+    // Successors now get their values from the new block
+    auto succs = block.outs();
+    auto outs = edge_list(succs.begin(), succs.end());
+    for (auto out : outs)
+    {
+      auto&& to = out->outgoing();
+      auto&& from = m_builder->make_edge(cont, to, out->value());
+      for (auto&& instr : to)
+      {
+        if (instr.opcode() != op_code::Phi)
+          continue;
+
+        for (auto idx = instruction::size_type{ 1 }; idx < instr.operand_count(); ++idx)
+        {
+          auto&& e = instr[idx].get_edge();
+          if (&e == out)
+            instr.replace(idx, &from);
+          else if (&e.incoming() == &block && std::ranges::find(outs, &e) == outs.end())
+            instr.replace(idx, &m_builder->make_loose(cont, to, e.value()));
+        }
+      }
+
+      out->disconnect();
+    }
+
+    return cont;
+  }
+
+  void inliner::map_registers(const function& callee, const instruction& call) noexcept
+  {
+    m_regs.clear();
+    for (auto&& block : callee.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        if (detail::is_param_load(instr))
+        {
+          const auto paramIdx = *instr[1].get_param();
+          m_regs.insert_or_assign(&instr[0].get_reg(), call[paramIdx + 2u]);
+          continue;
+        }
+
+        if (!instr.operand_count() || !detail::has_result(instr.opcode()))
+          continue;
+
+        auto&& res = instr[0];
+        if (!res.is_register() || res.get_reg().is_global())
+          continue;
+
+        auto&& reg = res.get_reg();
+        auto&& copy = reg.is_named() ?
+          m_builder->make_register(reg.name()) :
+          m_builder->make_register(reg.index());
+        m_regs.insert_or_assign(&reg, &copy);
+      }
+    }
+  }
+
+  void inliner::copy_graph(const function& callee, function& caller) noexcept
+  {
+    m_blocks.clear();
+    m_edges.clear();
+    for (auto&& src : callee.blocks())
+    {
+      auto&& copy = caller.create_block(m_names("inline"sv, callee.raw_name()));
+      m_blocks.emplace(&src, &copy);
+    }
+
+    for (auto&& src : callee.blocks())
+    {
+      for (auto out : src.outs())
+      {
+        auto&& copy = m_builder->make_edge(*m_blocks[&src], *m_blocks[&out->outgoing()], map(out->value()));
+        m_edges.emplace(out, &copy);
+      }
+    }
+  }
+
+  void inliner::copy_block(const basic_block& src, basic_block& cont, instr_iter pos, edge_list& rets) noexcept
+  {
+    auto&& dest = *m_blocks[&src];
+    for (auto&& instr : src)
+    {
+      if (detail::is_param_load(instr))
+        continue;
+
+      const auto oc = instr.opcode();
+      if (oc == op_code::Ret)
+      {
+        auto&& jump = m_builder->add_instruction(dest, op_code::Jump, pos);
+        jump.add(&cont);
+        rets.push_back(&m_builder->make_edge(dest, cont, map(instr[0])));
+        continue;
+      }
+
+      auto&& copy = m_builder->add_instruction(dest, oc, instr.operand_count(), pos);
+      for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+        copy.add(map(instr[idx]));
+    }
+  }
+
+  operand inliner::map(const operand& op) noexcept
+  {
+    if (op.is_register())
+    {
+      auto found = m_regs.find(&op.get_reg());
+      return found != m_regs.end() ? found->second : op;
+    }
+
+    if (op.is_block())
+    {
+      auto found = m_blocks.find(&op.get_block());
+      return found != m_blocks.end() ? operand{ found->second } : op;
+    }
+
+    if (!op.is_edge())
+      return op;
+
+    // Synthetic phis use loose edges, which have no copies yet
+    auto&& e = op.get_edge();
+    if (auto found = m_edges.find(&e); found != m_edges.end())
+      return found->second;
+
+    auto&& from = *m_blocks[&e.incoming()];
+    auto&& to = *m_blocks[&e.outgoing()];
+    return &m_builder->make_loose(from, to, map(e.value()));
+  }
+
+  inliner::size_type inliner::depth_of(const function& fn) const noexcept
+  {
+    auto found = m_depth.find(&fn);
+    return found != m_depth.end() ? found->second : size_type{};
+  }
+}
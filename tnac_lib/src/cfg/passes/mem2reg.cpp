@@ -0,0 +1,327 @@
+#include "cfg/passes/mem2reg.hpp"
+
+namespace tnac::ir::detail
+{
+  namespace
+  {
+    //
+    // Checks whether two operands are known to hold the same value
+    //
+    bool same(const operand& l, const operand& r) noexcept
+    {
+      if (l.is_register() && r.is_register())
+        return &l.get_reg() == &r.get_reg();
+
+      return l.is_undef() && r.is_undef();
+    }
+  }
+}
+
+namespace tnac::ir
+{
+  // Special members
+
+  mem2reg::~mem2reg() noexcept = default;
+
+  mem2reg::mem2reg(builder& bld) noexcept :
+    m_builder{ &bld }
+  {}
+
+
+  // Public members
+
+  mem2reg::size_type mem2reg::operator()(function& fn) noexcept
+  {
+    if (fn.is_intrinsic())
+      return {};
+
+    collect(fn);
+    if (m_vars.empty())
+      return {};
+
+    dom_tree tree{ fn };
+    m_tree = &tree;
+    order(fn);
+    compute_liveness();
+    for (auto block : m_order)
+      rename(*block);
+
+    resolve_phis();
+    for (auto instr : m_dead)
+      instr->owner_block().erase(*instr);
+
+    const auto res = m_vars.size();
+    m_vars.clear();
+    m_replaced.clear();
+    m_order.clear();
+    m_blocks.clear();
+    m_dead.clear();
+    m_tree = {};
+    return res;
+  }
+
+
+  // Private members
+
+  void mem2reg::collect(function& fn) noexcept
+  {
+    using enum op_code;
+    var_set targets;
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        const auto oc = instr.opcode();
+        if (oc == Alloc && instr[0].is_register() && !instr[0].get_reg().is_global())
+          m_vars.emplace(&instr[0].get_reg(), &instr);
+        else if (oc == Store && instr[1].is_register())
+          targets.emplace(&instr[1].get_reg());
+      }
+    }
+
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        const auto oc = instr.opcode();
+        for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+        {
+          auto&& op = instr[idx];
+          if (!is_promoted(op))
+            continue;
+
+          const auto isAccess = (idx == 0 && oc == Alloc) || (idx == 1 && utils::eq_any(oc, Store, Load));
+          if (!isAccess)
+            m_vars.erase(&op.get_reg());
+        }
+
+        if (oc != Store || !is_promoted(instr[1]))
+          continue;
+
+        // Loads will read the stored operand directly,
+        // so it must not change between the store and the loads
+        auto&& val = instr[0];
+        const auto isStable = val.is_value() || (val.is_register() && !targets.contains(&val.get_reg()));
+        if (!isStable)
+          m_vars.erase(&instr[1].get_reg());
+      }
+
+      for (auto out : block.outs())
+      {
+        if (auto val = out->value(); is_promoted(val))
+          m_vars.erase(&val.get_reg());
+      }
+    }
+
+    drop_escaping(fn);
+  }
+
+  void mem2reg::drop_escaping(const function& fn) noexcept
+  {
+    for (auto child : fn.children())
+    {
+      for (auto&& block : child->blocks())
+      {
+        for (auto&& instr : block)
+        {
+          for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+          {
+            if (auto&& op = instr[idx]; is_promoted(op))
+              m_vars.erase(&op.get_reg());
+          }
+        }
+      }
+
+      drop_escaping(*child);
+    }
+  }
+
+  void mem2reg::order(function& fn) noexcept
+  {
+    m_order = m_tree->order();
+    for (auto block : m_order)
+      m_blocks.try_emplace(block);
+
+    // Unreachable blocks see no values at all
+    for (auto&& block : fn.blocks())
+    {
+      if (m_blocks.try_emplace(&block).second)
+        m_order.push_back(&block);
+    }
+  }
+
+  void mem2reg::compute_liveness() noexcept
+  {
+    using enum op_code;
+
+    // Successors come first in post order
+    // Back edges lead to blocks which haven't been processed yet,
+    // so this is repeated until the sets stop growing
+    for (auto changed = true; changed; )
+    {
+      changed = false;
+      for (auto blockIt = m_order.rbegin(); blockIt != m_order.rend(); ++blockIt)
+      {
+        auto&& block = **blockIt;
+        var_set defs;
+        var_set live;
+        for (auto&& instr : block)
+        {
+          const auto oc = instr.opcode();
+          if (oc == Alloc && is_promoted(instr[0]))
+          {
+            defs.emplace(&instr[0].get_reg());
+            continue;
+          }
+
+          if (!utils::eq_any(oc, Store, Load) || !is_promoted(instr[1]))
+            continue;
+
+          auto var = &instr[1].get_reg();
+          if (oc == Store)
+            defs.emplace(var);
+          else if (!defs.contains(var))
+            live.emplace(var);
+        }
+
+        for (auto succ : dom_tree::successors(block))
+        {
+          for (auto var : m_blocks[succ].m_liveIn)
+          {
+            if (!defs.contains(var))
+              live.emplace(var);
+          }
+        }
+
+        auto&& liveIn = m_blocks[&block].m_liveIn;
+        if (live.size() != liveIn.size())
+        {
+          liveIn = std::move(live);
+          changed = true;
+        }
+      }
+    }
+  }
+
+  void mem2reg::rename(basic_block& block) noexcept
+  {
+    using enum op_code;
+    auto&& info = m_blocks[&block];
+    auto cur = incoming(block, info);
+    for (auto&& instr : block)
+    {
+      for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+      {
+        auto&& op = instr[idx];
+        if (op.is_register() && m_replaced.contains(&op.get_reg()))
+          instr.replace(idx, resolve(op));
+      }
+
+      const auto oc = instr.opcode();
+      if (oc == Alloc && is_promoted(instr[0]))
+      {
+        // Each allocation starts the variable over
+        cur.insert_or_assign(&instr[0].get_reg(), operand{ eval::value{} });
+        m_dead.push_back(&instr);
+      }
+      else if (oc == Store && is_promoted(instr[1]))
+      {
+        cur.insert_or_assign(&instr[1].get_reg(), instr[0]);
+        m_dead.push_back(&instr);
+      }
+      else if (oc == Load && is_promoted(instr[1]))
+      {
+        auto val = cur.find(&instr[1].get_reg());
+        m_replaced.insert_or_assign(&instr[0].get_reg(), val != cur.end() ? val->second : operand{ eval::value{} });
+        m_dead.push_back(&instr);
+      }
+    }
+
+    for (auto out : block.outs())
+      out->replace_value(resolve(out->value()));
+
+    info.m_out = std::move(cur);
+  }
+
+  void mem2reg::resolve_phis() noexcept
+  {
+    for (auto block : m_order)
+    {
+      for (auto&& instr : *block)
+      {
+        if (instr.opcode() != op_code::Phi)
+          continue;
+
+        for (auto idx = instruction::size_type{ 1 }; idx < instr.operand_count(); ++idx)
+        {
+          auto&& e = instr[idx].get_edge();
+          e.replace_value(resolve(e.value()));
+        }
+      }
+    }
+  }
+
+  mem2reg::value_map mem2reg::incoming(basic_block& block, const block_info& info) noexcept
+  {
+    if (!m_tree->is_reachable(block))
+      return {};
+
+    auto&& preds = m_tree->preds(block);
+    if (preds.empty())
+      return {};
+
+    if (preds.size() == 1)
+      return m_blocks[preds.front()].m_out;
+
+    value_map res;
+    for (auto var : info.m_liveIn)
+    {
+      auto first = value_at_end(*preds.front(), *var);
+      auto agreed = true;
+      for (auto pred : preds)
+        agreed = agreed && detail::same(first, value_at_end(*pred, *var));
+
+      if (agreed)
+      {
+        res.insert_or_assign(var, std::move(first));
+        continue;
+      }
+
+      auto&& phi = m_builder->add_phi(block, preds.size() + 1);
+      auto&& reg = var->is_named() ?
+        m_builder->make_register(var->name()) :
+        m_builder->make_register(var->index());
+
+      phi.add(&reg);
+      for (auto pred : preds)
+        phi.add(&m_builder->make_loose(*pred, block, value_at_end(*pred, *var)));
+
+      res.insert_or_assign(var, operand{ &reg });
+    }
+
+    return res;
+  }
+
+  operand mem2reg::value_at_end(const basic_block& block, const vreg& var) const noexcept
+  {
+    auto info = m_blocks.find(&block);
+    UTILS_ASSERT(info != m_blocks.end());
+    auto&& vals = info->second.m_out;
+    auto val = vals.find(&var);
+    return val != vals.end() ? val->second : operand{ eval::value{} };
+  }
+
+  operand mem2reg::resolve(const operand& op) const noexcept
+  {
+    if (!op.is_register())
+      return op;
+
+    auto found = m_replaced.find(&op.get_reg());
+    return found != m_replaced.end() ? found->second : op;
+  }
+
+  bool mem2reg::is_promoted(const operand& op) const noexcept
+  {
+    return op.is_register() && m_vars.contains(&op.get_reg());
+  }
+}
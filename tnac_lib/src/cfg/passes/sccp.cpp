@@ -0,0 +1,520 @@
+#include "cfg/passes/sccp.hpp"
+#include "eval/value/traits.hpp"
+
+namespace tnac::ir::detail
+{
+  namespace
+  {
+    constexpr auto is_unary(op_code oc) noexcept
+    {
+      using enum op_code;
+      return utils::eq_any(oc, Abs, CmpNot, CmpIs, Plus, Neg, BNeg, Head, Tail);
+    }
+    constexpr auto to_unary_op(op_code oc) noexcept
+    {
+      using enum op_code;
+      using eval::val_ops;
+      switch (oc)
+      {
+      case Abs:    return val_ops::AbsoluteValue;
+      case CmpNot: return val_ops::LogicalNot;
+      case CmpIs:  return val_ops::LogicalIs;
+      case Plus:   return val_ops::UnaryPlus;
+      case Neg:    return val_ops::UnaryNegation;
+      case BNeg:   return val_ops::UnaryBitwiseNot;
+      case Head:   return val_ops::UnaryHead;
+      case Tail:   return val_ops::PostTail;
+      }
+
+      return val_ops::InvalidOp;
+    }
+
+    constexpr auto is_binary(op_code oc) noexcept
+    {
+      using enum op_code;
+      return utils::eq_any(oc, Add, Sub, Mul, Div, Mod, Pow, Root, And, Or, Xor,
+                               CmpE, CmpL, CmpLE, CmpNE, CmpG, CmpGE);
+    }
+    constexpr auto to_binary_op(op_code oc) noexcept
+    {
+      using enum op_code;
+      using eval::val_ops;
+      switch (oc)
+      {
+      case Add:    return val_ops::Addition;
+      case Sub:    return val_ops::Subtraction;
+      case Mul:    return val_ops::Multiplication;
+      case Div:    return val_ops::Division;
+      case Mod:    return val_ops::Modulo;
+      case Pow:    return val_ops::BinaryPow;
+      case Root:   return val_ops::BinaryRoot;
+      case And:    return val_ops::BitwiseAnd;
+      case Or:     return val_ops::BitwiseOr;
+      case Xor:    return val_ops::BitwiseXor;
+      case CmpE:   return val_ops::Equal;
+      case CmpL:   return val_ops::RelLess;
+      case CmpLE:  return val_ops::RelLessEq;
+      case CmpNE:  return val_ops::NEqual;
+      case CmpG:   return val_ops::RelGr;
+      case CmpGE:  return val_ops::RelGrEq;
+      }
+
+      return val_ops::InvalidOp;
+    }
+
+    //
+    // Checks whether the instruction's result can be computed from constant operands
+    //
+    constexpr auto is_foldable(op_code oc) noexcept
+    {
+      using enum op_code;
+      return is_unary(oc) || is_binary(oc) || utils::eq_any(oc, Test, Select, Phi);
+    }
+
+    //
+    // Checks whether the value can be propagated
+    // Arrays need interning, and functions are better left to the callers
+    //
+    bool is_scalar(const eval::value& val) noexcept
+    {
+      using enum eval::type_id;
+      return utils::eq_any(val.id(), Bool, Int, Float, Complex, Fraction);
+    }
+
+    //
+    // Checks whether the instruction is a conditional jump
+    //
+    bool is_cond_jump(const instruction& instr) noexcept
+    {
+      return instr.opcode() == op_code::Jump && instr.operand_count() == 3;
+    }
+  }
+}
+
+namespace tnac::ir
+{
+  // Special members
+
+  sccp::~sccp() noexcept = default;
+
+  sccp::sccp() noexcept = default;
+
+
+  // Public members
+
+  sccp::result sccp::operator()(function& fn) noexcept
+  {
+    result res;
+    if (fn.is_intrinsic())
+      return res;
+
+    collect(fn);
+    solve(fn);
+    if (is_settled(fn))
+    {
+      res.m_folded = fold(fn);
+      res.m_folded += fold_jumps(fn);
+      res.m_pruned = prune(fn);
+    }
+
+    m_values.clear();
+    m_users.clear();
+    m_reached.clear();
+    m_flows.clear();
+    m_flowWork.clear();
+    m_instrWork.clear();
+    return res;
+  }
+
+
+  // Private members
+
+  void sccp::collect(function& fn) noexcept
+  {
+    reg_set mutableRegs;
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        if (instr.opcode() == op_code::Store && instr[1].is_register())
+          mutableRegs.emplace(&instr[1].get_reg());
+
+        if (detail::is_foldable(instr.opcode()) && instr[0].is_register())
+          m_values.try_emplace(&instr[0].get_reg());
+
+        for (auto idx = instruction::size_type{ 1 }; idx < instr.operand_count(); ++idx)
+        {
+          auto&& op = instr[idx];
+          auto val = op.is_edge() ? op.get_edge().value() : op;
+          if (val.is_register())
+            m_users[&val.get_reg()].push_back(&instr);
+        }
+
+        if (!instr.operand_count())
+          continue;
+
+        // Jumps have no result, their first operand is the condition
+        if (auto&& op = instr[0]; instr.opcode() == op_code::Jump && op.is_register())
+          m_users[&op.get_reg()].push_back(&instr);
+      }
+    }
+
+    std::erase_if(m_values, [&](auto&& item) noexcept
+      {
+        auto reg = item.first;
+        return reg->is_global() || mutableRegs.contains(reg);
+      });
+
+    drop_escaping(fn);
+  }
+
+  void sccp::drop_escaping(const function& fn) noexcept
+  {
+    for (auto child : fn.children())
+    {
+      for (auto&& block : child->blocks())
+      {
+        for (auto&& instr : block)
+        {
+          for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+          {
+            if (auto&& op = instr[idx]; op.is_register())
+              m_values.erase(&op.get_reg());
+          }
+        }
+      }
+
+      drop_escaping(*child);
+    }
+  }
+
+  void sccp::solve(function& fn) noexcept
+  {
+    auto&& entry = fn.entry();
+    m_reached.emplace(&entry);
+    for (auto&& instr : entry)
+      visit(instr);
+
+    while (!m_flowWork.empty() || !m_instrWork.empty())
+    {
+      while (!m_flowWork.empty())
+      {
+        auto [from, to] = m_flowWork.back();
+        m_flowWork.pop_back();
+        if (!m_flows[to].emplace(from).second)
+          continue;
+
+        // The first visit evaluates the whole block,
+        // later ones only need to merge the new value into phis
+        const auto firstVisit = m_reached.emplace(to).second;
+        for (auto&& instr : *to)
+        {
+          if (firstVisit || instr.opcode() == op_code::Phi)
+            visit(instr);
+        }
+      }
+
+      while (!m_instrWork.empty())
+      {
+        auto instr = m_instrWork.back();
+        m_instrWork.pop_back();
+        if (m_reached.contains(&instr->owner_block()))
+          visit(*instr);
+      }
+    }
+  }
+
+  bool sccp::is_settled(function& fn) const noexcept
+  {
+    for (auto&& block : fn.blocks())
+    {
+      if (!m_reached.contains(&block))
+        continue;
+
+      auto last = block.last();
+      if (last && detail::is_cond_jump(*last) && value_of((*last)[0]).m_state == state::Unknown)
+        return false;
+    }
+
+    return true;
+  }
+
+  void sccp::reach(basic_block& from, basic_block& to) noexcept
+  {
+    m_flowWork.emplace_back(&from, &to);
+  }
+
+  bool sccp::is_flowing(const basic_block& from, const basic_block& to) const noexcept
+  {
+    auto found = m_flows.find(&to);
+    return found != m_flows.end() && found->second.contains(&from);
+  }
+
+  void sccp::visit(instruction& instr) noexcept
+  {
+    const auto oc = instr.opcode();
+    if (oc == op_code::Jump)
+      visit_jump(instr);
+    else if (oc == op_code::Phi)
+      update(instr, eval_phi(instr));
+    else if (detail::is_foldable(oc))
+      update(instr, eval_pure(instr));
+  }
+
+  void sccp::visit_jump(instruction& instr) noexcept
+  {
+    auto&& block = instr.owner_block();
+    if (!detail::is_cond_jump(instr))
+    {
+      reach(block, instr[0].get_block());
+      return;
+    }
+
+    auto cond = value_of(instr[0]);
+    if (cond.m_state == state::Unknown)
+      return;
+
+    if (auto known = as_bool(cond))
+    {
+      reach(block, instr[*known ? 1 : 2].get_block());
+      return;
+    }
+
+    reach(block, instr[1].get_block());
+    reach(block, instr[2].get_block());
+  }
+
+  sccp::lattice sccp::eval_phi(const instruction& instr) const noexcept
+  {
+    lattice res;
+    auto&& block = instr.owner_block();
+    for (auto idx = instruction::size_type{ 1 }; idx < instr.operand_count(); ++idx)
+    {
+      auto&& op = instr[idx];
+      if (!op.is_edge())
+        continue;
+
+      auto&& e = op.get_edge();
+      if (is_flowing(e.incoming(), block))
+        res = meet(res, value_of(e.value()));
+    }
+
+    return res;
+  }
+
+  sccp::lattice sccp::eval_pure(const instruction& instr) const noexcept
+  {
+    using enum op_code;
+    const auto oc = instr.opcode();
+    if (oc == Select)
+    {
+      auto cond = value_of(instr[1]);
+      if (cond.m_state == state::Unknown)
+        return {};
+
+      if (auto known = as_bool(cond))
+        return value_of(instr[*known ? 2 : 3]);
+
+      return meet(value_of(instr[2]), value_of(instr[3]));
+    }
+
+    auto arg = value_of(instr[oc == Test ? 2 : 1]);
+    auto other = detail::is_binary(oc) ? value_of(instr[2]) : arg;
+    if (arg.m_state == state::Varying || other.m_state == state::Varying)
+      return { state::Varying };
+
+    if (arg.m_state == state::Unknown || other.m_state == state::Unknown)
+      return {};
+
+    eval::value res;
+    if (oc == Test)
+      res = eval::value{ arg.m_value.id() == instr[1].get_typeid() };
+    else if (detail::is_binary(oc))
+      res = arg.m_value.binary(detail::to_binary_op(oc), other.m_value);
+    else
+      res = arg.m_value.unary(detail::to_unary_op(oc));
+
+    if (!detail::is_scalar(res))
+      return { state::Varying };
+
+    return { state::Const, std::move(res) };
+  }
+
+  void sccp::update(const instruction& instr, lattice val) noexcept
+  {
+    auto&& res = instr[0];
+    if (!res.is_register() || val.m_state == state::Unknown)
+      return;
+
+    auto found = m_values.find(&res.get_reg());
+    if (found == m_values.end())
+      return;
+
+    auto&& cur = found->second;
+    auto next = meet(cur, val);
+    if (next.m_state == cur.m_state)
+      return;
+
+    cur = std::move(next);
+    auto users = m_users.find(found->first);
+    if (users == m_users.end())
+      return;
+
+    for (auto user : users->second)
+      m_instrWork.push_back(user);
+  }
+
+  sccp::lattice sccp::value_of(const operand& op) const noexcept
+  {
+    if (op.is_value())
+    {
+      auto&& val = op.get_value();
+      if (!detail::is_scalar(val))
+        return { state::Varying };
+
+      return { state::Const, val };
+    }
+
+    if (!op.is_register())
+      return { state::Varying };
+
+    auto found = m_values.find(&op.get_reg());
+    return found != m_values.end() ? found->second : lattice{ state::Varying };
+  }
+
+  sccp::size_type sccp::fold(function& fn) noexcept
+  {
+    instr_list dead;
+    for (auto&& block : fn.blocks())
+    {
+      if (!m_reached.contains(&block))
+        continue;
+
+      for (auto&& instr : block)
+      {
+        if (detail::is_foldable(instr.opcode()) && value_of(instr[0]).m_state == state::Const)
+          dead.push_back(&instr);
+      }
+    }
+
+    for (auto instr : dead)
+      instr->owner_block().erase(*instr);
+
+    auto resolve = [this](const operand& op) noexcept
+      {
+        auto val = value_of(op);
+        return op.is_register() && val.m_state == state::Const ? operand{ val.m_value } : op;
+      };
+
+    for (auto&& block : fn.blocks())
+    {
+      if (!m_reached.contains(&block))
+        continue;
+
+      for (auto&& instr : block)
+      {
+        for (auto idx = instruction::size_type{}; idx < instr.operand_count(); ++idx)
+        {
+          auto&& op = instr[idx];
+          if (op.is_edge())
+          {
+            auto&& e = op.get_edge();
+            e.replace_value(resolve(e.value()));
+          }
+          else if (op.is_register())
+            instr.replace(idx, resolve(op));
+        }
+      }
+
+      for (auto out : block.outs())
+        out->replace_value(resolve(out->value()));
+    }
+
+    return dead.size();
+  }
+
+  sccp::size_type sccp::fold_jumps(function& fn) noexcept
+  {
+    auto res = size_type{};
+    for (auto&& block : fn.blocks())
+    {
+      if (!m_reached.contains(&block))
+        continue;
+
+      for (auto&& instr : block)
+      {
+        if (instr.opcode() == op_code::Phi)
+        {
+          for (auto idx = instr.operand_count(); idx > 1; --idx)
+          {
+            auto&& op = instr[idx - 1];
+            if (op.is_edge() && !is_flowing(op.get_edge().incoming(), block))
+              instr.remove(idx - 1);
+          }
+          continue;
+        }
+
+        if (!detail::is_cond_jump(instr))
+          continue;
+
+        auto known = as_bool(value_of(instr[0]));
+        if (!known)
+          continue;
+
+        // Leaving only the target, the jump becomes unconditional
+        instr.remove(*known ? 2 : 1);
+        instr.remove(0);
+        ++res;
+      }
+    }
+
+    return res;
+  }
+
+  sccp::size_type sccp::prune(function& fn) noexcept
+  {
+    std::vector<basic_block*> unreached;
+    for (auto&& block : fn.blocks())
+    {
+      auto outs = block.outs();
+      for (auto out : std::vector<edge*>(outs.begin(), outs.end()))
+      {
+        if (!is_flowing(out->incoming(), out->outgoing()))
+          out->disconnect();
+      }
+
+      if (!m_reached.contains(&block))
+        unreached.push_back(&block);
+    }
+
+    // Dead blocks are cut off from everything, so each one is its own tree
+    for (auto block : unreached)
+      fn.delete_block_tree(*block);
+
+    return unreached.size();
+  }
+
+  sccp::lattice sccp::meet(const lattice& l, const lattice& r) noexcept
+  {
+    if (l.m_state == state::Unknown)
+      return r;
+    if (r.m_state == state::Unknown)
+      return l;
+
+    if (l.m_state == state::Varying || r.m_state == state::Varying)
+      return { state::Varying };
+
+    if (!constant::same_content(l.m_value, r.m_value))
+      return { state::Varying };
+
+    return l;
+  }
+
+  sccp::bool_opt sccp::as_bool(const lattice& val) noexcept
+  {
+    if (val.m_state != state::Const || val.m_value.id() != eval::type_id::Bool)
+      return {};
+
+    return eval::to_bool(val.m_value);
+  }
+}
@@ -3,6 +3,10 @@
 #include "common/diag.hpp"
 #include "sema/sema.hpp"
 #include "cfg/cfg.hpp"
+#include "cfg/passes/mem2reg.hpp"
+#include "cfg/passes/sccp.hpp"
+#include "cfg/passes/gvn.hpp"
+#include "cfg/passes/cleanup.hpp"
 #include "eval/value/value_store.hpp"
 #include "eval/value/type_impl.hpp"
 
@@ -158,6 +162,7 @@ namespace tnac::detail
     case KwInt:      return expected_args<eval::int_type>();
     case KwFloat:    return expected_args<eval::float_type>();
     case KwBool:     return expected_args<eval::bool_type>();
+    case KwRange:    return { 1, 3 }; // count, start, step
 
     default: UTILS_ASSERT(false); break;
     }
@@ -175,6 +180,7 @@ namespace tnac::detail
     case KwFloat:    return eval::type_id::Float;
     case KwBool:     return eval::type_id::Bool;
     case KwArray:    return eval::type_id::Array;
+    case KwRange:    return eval::type_id::Array;
     case KwFunction: return eval::type_id::Function;
     case KwUndef:    return eval::type_id::Invalid;
 
@@ -203,7 +209,7 @@ namespace tnac::detail
   constexpr auto needs_named_reg(ir::op_code oc) noexcept
   {
     using enum ir::op_code;
-    return utils::eq_none(oc, Load, Phi, Bool, Int, Float, Frac, Cplx, StreamRead, StreamWrite, GetElem);
+    return utils::eq_none(oc, Load, Phi, Bool, Int, Float, Frac, Cplx, Range, StreamRead, StreamWrite, GetElem);
   }
 
   constexpr auto needs_forced_bool(ir::op_code oc) noexcept
@@ -301,7 +307,11 @@ namespace tnac
     m_sema{ &sema },
     m_feedback{ fb },
     m_cfg{ &gr },
-    m_vals{ &valStore }
+    m_vals{ &valStore },
+    m_inliner{ gr.get_builder(), [this](string_t prefix, string_t postfix) noexcept
+      {
+        return m_names.make_block_name(prefix, postfix);
+      } }
   {}
 
 
@@ -344,6 +354,31 @@ namespace tnac
     return op.is_register() ? &op.get_reg() : nullptr;
   }
 
+  const compiler::opt_stats& compiler::opt_counters() const noexcept
+  {
+    return m_optStats;
+  }
+
+  const compiler::inline_settings& compiler::inlining() const noexcept
+  {
+    return m_inliner.config();
+  }
+
+  void compiler::configure_inlining(const inline_settings& cfg) noexcept
+  {
+    m_inliner.configure(cfg);
+  }
+
+  bool compiler::is_optimising() const noexcept
+  {
+    return m_optimise;
+  }
+
+  void compiler::set_optimising(bool enable) noexcept
+  {
+    m_optimise = enable;
+  }
+
   void compiler::attach_module(ir::function& mod, ast::module_def& def) noexcept
   {
     m_context.enter_function(mod, def);
@@ -433,7 +468,21 @@ namespace tnac
     if(!sym)
       return;
 
-    if (auto func = m_cfg->find_entity(sym))
+    // The built-in module is only a prefix for its functions
+    if (sym->is(semantics::sym_kind::Module) && m_sema->is_intrinsic(*sym))
+    {
+      m_stack.push_undef();
+      return;
+    }
+
+    auto func = m_cfg->find_entity(sym);
+    if (!func && m_sema->is_intrinsic(*sym))
+    {
+      auto&& fnSym = utils::cast<semantics::sym_kind::Function>(*sym);
+      func = &m_cfg->declare_intrinsic(sym, fnSym.name(), fnSym.param_count(), eval::find_intrinsic(fnSym.name()));
+    }
+
+    if (func)
     {
       auto op = ir::operand{ eval::value::function(*func) };
       auto reg = init_closure(op);
@@ -528,6 +577,12 @@ namespace tnac
       return;
     }
 
+    if (typed.type_name().is(tok_kind::KwRange))
+    {
+      emit_range(argSz);
+      return;
+    }
+
     const auto typeId = detail::to_type_id(typed.type_name());
     if (m_stack.has_values(argSz))
     {
@@ -659,6 +714,7 @@ namespace tnac
 
     compile(fd.params(), fd.body().children());
     m_context.exit_function();
+    optimise(func);
     if(!lastVal.is_undef())
       m_stack.push(lastVal);
     return false;
@@ -847,12 +903,16 @@ namespace tnac
     auto&& endBlock = m_context.create_block(m_names.make_block_name(namePref, "end"sv));
 
     auto&& onTrue  = m_context.create_block(m_names.make_block_name(namePref, "true"sv));
+    const auto isTail = m_context.is_tail(cond);
     m_context.enter_block(onTrue);
     m_context.terminate_at(onTrue);
     if (!cond.has_true())
       m_stack.push(checkedVal);
     else
+    {
+      if (isTail) mark_tail(cond.on_true(), true);
       compile(cond.on_true());
+    }
     auto trueRes = extract();
     emit_jump(trueRes, endBlock);
 
@@ -862,7 +922,10 @@ namespace tnac
     if (!cond.has_false())
       m_stack.push_undef();
     else
+    {
+      if (isTail) mark_tail(cond.on_false(), true);
       compile(cond.on_false());
+    }
     auto falseRes = extract();
     emit_jump(falseRes, endBlock);
 
@@ -897,6 +960,12 @@ namespace tnac
     constexpr auto namePref = "cond"sv;
     auto&& endBlock = m_context.create_block(m_names.make_block_name(namePref, "exit"sv));
     auto&& patterns = cond.patterns().children();
+    if (m_context.is_tail(cond))
+    {
+      for (auto pattern : patterns)
+        m_context.mark_tail(*pattern);
+    }
+
     ast::pattern* defaultPat{};
     for (auto counter = patterns.size(); auto child : patterns)
     {
@@ -976,6 +1045,16 @@ namespace tnac
         m_stack.push_undef();
         return false;
       }
+
+      auto&& curFn = m_context.current_function();
+      if (&sym == &curFn && m_context.loop_header() && m_context.is_tail(call))
+      {
+        for (auto arg : args)
+          compile(*arg);
+
+        emit_tail_call(argSz);
+        return false;
+      }
     }
 
     for (auto arg : args)
@@ -1141,10 +1220,8 @@ namespace tnac
 
   ir::vreg& compiler::emit_alloc(string_t varName) noexcept
   {
-    auto&& curFn = m_context.current_function();
-    auto&& entry = curFn.entry();
     auto&& builder = m_cfg->get_builder();
-    auto&& var = builder.add_var(entry, m_context.funct_start());
+    auto&& var = builder.add_var(m_context.body_block(), m_context.body_start());
     auto&& reg = make_variable_register(varName);
     var.add(&reg);
     return reg;
@@ -1152,10 +1229,8 @@ namespace tnac
 
   ir::vreg& compiler::emit_salloc(ir::record& rec, ir::operand owner) noexcept
   {
-    auto&& curFn = m_context.current_function();
-    auto&& entry = curFn.entry();
     auto&& builder = m_cfg->get_builder();
-    auto&& var = builder.add_struct(entry, m_context.funct_start());
+    auto&& var = builder.add_struct(m_context.body_block(), m_context.body_start());
     auto&& reg = builder.make_register(m_context.register_index());
     var.add(&reg).add(&rec).add(std::move(owner));
     return reg;
@@ -1163,10 +1238,8 @@ namespace tnac
 
   ir::vreg& compiler::emit_arr(ir::operand::idx_type size) noexcept
   {
-    auto&& curFn = m_context.current_function();
-    auto&& entry = curFn.entry();
     auto&& builder = m_cfg->get_builder();
-    auto&& arr = builder.add_array(entry, m_context.funct_start());
+    auto&& arr = builder.add_array(m_context.body_block(), m_context.body_start());
     auto varName = m_names.op_name(ir::op_code::Arr);
     auto&& reg = builder.make_register(varName);
     arr.add(&reg);
@@ -1331,6 +1404,33 @@ namespace tnac
     m_stack.push(res);
   }
 
+  void compiler::emit_range(size_type argSz) noexcept
+  {
+    // Missing start and step default to 0 and 1
+    constexpr auto maxArgs = size_type{ 3 };
+    const eval::value defaults[]{ eval::value{ eval::int_type{} }, eval::value{ eval::int_type{ 1 } } };
+
+    if (m_stack.has_values(argSz))
+    {
+      std::vector<ir::operand> args;
+      args.reserve(maxArgs);
+      m_stack.fill(args, argSz);
+      for (auto idx = argSz; idx < maxArgs; ++idx)
+        args.emplace_back(defaults[idx - 1]);
+
+      m_stack.push(eval::value::range(*m_vals, args[0].get_value(), args[1].get_value(), args[2].get_value()));
+      return;
+    }
+
+    auto&& instr = make(ir::op_code::Range);
+    auto res = extract();
+    m_stack.fill(instr, argSz);
+    for (auto idx = argSz; idx < maxArgs; ++idx)
+      instr.add(defaults[idx - 1]);
+
+    m_stack.push(res);
+  }
+
   void compiler::emit_append(ir::vreg& arr, size_type size) noexcept
   {
     clear_store();
@@ -1419,6 +1519,66 @@ namespace tnac
     m_stack.push(std::move(res));
   }
 
+  void compiler::emit_tail_call(size_type argCount) noexcept
+  {
+    auto&& params = m_context.params();
+    auto header = m_context.loop_header();
+    UTILS_ASSERT(header);
+    UTILS_ASSERT(params.size() == argCount);
+    UTILS_ASSERT(m_stack.has_at_least(argCount));
+
+    std::vector<ir::operand> args;
+    args.reserve(argCount);
+    for (auto idx = argCount; idx > size_type{}; --idx)
+      args.push_back(extract());
+    std::ranges::reverse(args);
+
+    clear_store();
+    auto&& builder = m_cfg->get_builder();
+    auto&& block = m_context.current_block();
+    auto&& instr = builder.add_instruction(block, ir::op_code::Jump, m_context.func_end());
+    instr.add(header);
+    m_cfg->connect(block, *header, eval::value{});
+    update_func_start(instr);
+
+    // Arguments become the next values of the parameter phis
+    for (auto idx = size_type{}; idx < argCount; ++idx)
+    {
+      auto&& arg = args[idx];
+      intern_array(arg);
+      auto&& phi = params[idx]->source();
+      phi.add(&builder.make_loose(block, *header, std::move(arg)));
+    }
+
+    m_stack.push_undef();
+  }
+
+  void compiler::emit_loop_header(params_t& params) noexcept
+  {
+    auto&& entry = m_context.current_block();
+    auto&& header = m_context.create_block(m_names.make_block_name("loop"sv, "header"sv));
+    emit_jump(eval::value{}, header);
+    m_context.enter_block(header);
+    m_context.set_loop_header(header);
+
+    // Parameters start with the arguments of the call
+    // Self tail calls add their own arguments later
+    auto&& builder = m_cfg->get_builder();
+    for (auto param : params)
+    {
+      auto&& sym = param->symbol();
+      auto initial = m_context.locate(sym);
+      UTILS_ASSERT(initial);
+
+      auto&& phi = builder.add_instruction(header, ir::op_code::Phi, m_context.func_end());
+      auto&& target = make_variable_register(sym.name());
+      phi.add(&target).add(&builder.make_loose(entry, header, initial));
+      update_func_start(phi);
+      m_context.store(sym, target);
+      m_context.add_param(target);
+    }
+  }
+
   void compiler::emit_bind(ir::operand closure, size_type argCount) noexcept
   {
     const auto size = argCount;
@@ -1475,6 +1635,11 @@ namespace tnac
 
   bool compiler::has_ret_jump(ir::basic_block& block) noexcept
   {
+    // Tail calls never fall through either
+    // The loop header is only reachable from the entry and through them
+    if (auto header = m_context.loop_header(); header && block.is_connected_to(*header))
+      return true;
+
     auto retBlock = m_context.return_block();
     if (!retBlock)
       return false;
@@ -1482,6 +1647,77 @@ namespace tnac
     return block.is_connected_to(*retBlock);
   }
 
+  void compiler::mark_tail(ast::node& node, bool inBranch) noexcept
+  {
+    if (auto target = tail_target(node, inBranch))
+      m_context.mark_tail(*target);
+  }
+
+  ast::node* compiler::tail_target(ast::node& node, bool inBranch) noexcept
+  {
+    auto target = &node;
+    for (;;)
+    {
+      if (auto sc = utils::try_cast<ast::scope>(target))
+      {
+        auto&& children = sc->children();
+        if (children.empty())
+          return {};
+
+        target = children.back();
+      }
+      else if (auto paren = utils::try_cast<ast::paren_expr>(target))
+        target = &paren->internal_expr();
+      else if (auto ret = utils::try_cast<ast::ret_expr>(target); ret && inBranch)
+        target = &ret->returned_value();
+      else
+        break;
+    }
+
+    if (!inBranch && target->is(ast::node_kind::Call))
+      return {};
+
+    return target;
+  }
+
+  bool compiler::has_self_tail_call(ast::node& node, bool inBranch) noexcept
+  {
+    auto target = tail_target(node, inBranch);
+    if (!target)
+      return false;
+
+    if (auto call = utils::try_cast<ast::call_expr>(target))
+    {
+      auto id = utils::try_cast<ast::id_expr>(&call->callable());
+      if (!id)
+        return false;
+
+      auto sym = &id->symbol();
+      if (auto ref = utils::try_cast<semantics::scope_ref>(sym))
+        sym = ref->referenced().to_callable();
+
+      return sym && m_cfg->find_entity(sym) == &m_context.current_function();
+    }
+
+    if (auto cond = utils::try_cast<ast::cond_short>(target))
+    {
+      return (cond->has_true() && has_self_tail_call(cond->on_true(), true))
+          || (cond->has_false() && has_self_tail_call(cond->on_false(), true));
+    }
+
+    if (auto cond = utils::try_cast<ast::cond_expr>(target))
+    {
+      for (auto child : cond->patterns().children())
+      {
+        auto&& pattern = utils::cast<ast::pattern>(*child);
+        if (has_self_tail_call(pattern.body(), true))
+          return true;
+      }
+    }
+
+    return false;
+  }
+
   bool compiler::check_post_jmp() noexcept
   {
     auto&& block = m_context.current_block();
@@ -1503,14 +1739,29 @@ namespace tnac
 
   bool compiler::delete_block_tree(ir::basic_block& root) noexcept
   {
-    auto retBlock = m_context.return_block();
-    if (retBlock && root.is_connected_to(*retBlock))
+    if (has_ret_jump(root))
       return false;
 
     m_context.current_function().delete_block_tree(root);
     return true;
   }
 
+  void compiler::optimise(ir::function& fn) noexcept
+  {
+    if (!m_optimise)
+      return;
+
+    m_optStats.m_inlined += m_inliner(fn);
+    m_optStats.m_promoted += ir::mem2reg{ m_cfg->get_builder() }(fn);
+    auto consts = ir::sccp{}(fn);
+    m_optStats.m_folded += consts.m_folded;
+    m_optStats.m_pruned += consts.m_pruned;
+    m_optStats.m_deduplicated += ir::gvn{}(fn);
+    auto dead = ir::cleanup{ m_cfg->get_builder() }(fn);
+    m_optStats.m_erased += dead.m_erased;
+    m_optStats.m_merged += dead.m_merged;
+  }
+
   ir::operand compiler::extract() noexcept
   {
     if (!m_stack.empty())
@@ -1715,6 +1966,7 @@ namespace tnac
     }
     else
     {
+      if (m_context.is_tail(pattern)) mark_tail(pattern.body(), true);
       compile(pattern.body());
       emit_jump(extract(), *term);
       m_context.enter_block(*term);
@@ -1742,6 +1994,7 @@ namespace tnac
 
     emit_cond_jump(checkRes, condThen, condElse);
     m_context.enter_block(condThen);
+    if (m_context.is_tail(pattern)) mark_tail(pattern.body(), true);
     compile(pattern.body());
     emit_jump(extract(), *term);
     m_context.enter_block(condElse);
@@ -1771,6 +2024,13 @@ namespace tnac
         emit_ge(*elem, &loadRes, idx);
       }
     }
+    else if (curFn.owner_func() && !body.empty() && has_self_tail_call(*body.back(), false))
+    {
+      emit_loop_header(params);
+    }
+
+    if (!body.empty())
+      mark_tail(*body.back(), false);
 
     compile(body);
     init_last_closure();
@@ -2028,36 +2288,52 @@ namespace tnac
     }
   }
 
-  void compiler::intern_array(const ir::operand& op) noexcept
+  void compiler::intern_array(ir::operand& op) noexcept
   {
-    if (!op.is_value())
+    if (!op.is_value() || op.get_value().id() != eval::type_id::Array)
       return;
 
-    intern_array(op.get_value());
+    op = intern_array(op.get_value());
   }
 
-  void compiler::intern_array(const ir::instruction& instr) noexcept
+  void compiler::intern_array(ir::instruction& instr) noexcept
   {
     using sz = ir::instruction::size_type;
     for (auto count = sz{}; count < instr.operand_count(); ++count)
-      intern_array(instr[count]);
+    {
+      auto&& op = instr[count];
+      if (!op.is_value() || op.get_value().id() != eval::type_id::Array)
+        continue;
+
+      instr.replace(count, intern_array(op.get_value()));
+    }
   }
 
-  void compiler::intern_array(eval::value val) noexcept
+  eval::value compiler::intern_array(eval::value val) noexcept
   {
     auto arrPtr = val.try_get<eval::array_type>();
     if (!arrPtr)
-      return;
+      return val;
 
+    auto&& builder = m_cfg->get_builder();
     auto arr = *arrPtr;
-    for (auto it = arr->begin(); it != arr->end(); ++it)
+    if (auto existing = builder.find_same(arr))
+      return existing->value();
+
+    // Packed arrays and ranges can't contain other arrays
+    auto&& aw = arr.wrapper();
+    if (aw.data().is_boxed())
     {
-      intern_array(*it);
+      auto&& data = aw.data();
+      for (auto idx = eval::array_wrapper::size_type{}; idx < aw.size(); ++idx)
+      {
+        const auto at = aw.index_of(idx);
+        data.write_at(intern_array(data.read_at(at)), at);
+      }
     }
 
-    auto&& builder = m_cfg->get_builder();
     auto&& reg = builder.make_global_register(m_names.array_name());
-    builder.intern(reg, std::move(arr));
+    return builder.intern(reg, std::move(arr)).value();
   }
 
   void compiler::error(string_t msg) noexcept
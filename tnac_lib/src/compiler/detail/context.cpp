@@ -37,9 +37,12 @@ namespace tnac::detail // func data
     ir::basic_block* m_return{};
     ir::vreg* m_retVal{};
     ir::basic_block* m_terminal{};
+    ir::basic_block* m_loopHeader{};
     ir::vreg* m_importedRec{};
     reg_idx m_regIdx{};
     symbol* m_lastStore{};
+    param_list m_params;
+    tail_set m_tails;
     var_store m_vars;
     closure_store m_closures;
     known_var_names m_varNames;
@@ -95,6 +98,16 @@ namespace tnac::detail
     return vd ? vd->m_reg : nullptr;
   }
 
+  void context::add_param(ir::vreg& reg) noexcept
+  {
+    cur_data().m_params.push_back(&reg);
+  }
+
+  const context::param_list& context::params() noexcept
+  {
+    return cur_data().m_params;
+  }
+
   void context::wipe() noexcept
   {
     m_funcs.clear();
@@ -176,10 +189,53 @@ namespace tnac::detail
     return cur_data().m_return;
   }
 
+  void context::set_loop_header(ir::basic_block& header) noexcept
+  {
+    cur_data().m_loopHeader = &header;
+  }
+
+  ir::basic_block* context::loop_header() noexcept
+  {
+    return cur_data().m_loopHeader;
+  }
+
+  ir::basic_block& context::body_block() noexcept
+  {
+    auto&& fd = cur_data();
+    return fd.m_loopHeader ? *fd.m_loopHeader : current_function().entry();
+  }
+
+  context::instr_iter context::body_start() noexcept
+  {
+    auto&& fd = cur_data();
+    if (!fd.m_loopHeader)
+      return funct_start();
+
+    // The entry ends with the jump into the header, which follows it,
+    // so, while the header is empty, it starts where the entry ends
+    auto&& header = *fd.m_loopHeader;
+    if (!header.begin())
+    {
+      auto&& entry = current_function().entry();
+      UTILS_ASSERT(entry.is_connected_to(header));
+      UTILS_ASSERT(entry.last() && entry.last()->opcode() == ir::op_code::Jump);
+      return entry.end();
+    }
+
+    // Parameter phis stay in front of everything else
+    auto instrIt = header.begin();
+    for (auto endIt = header.end(); instrIt != endIt; ++instrIt)
+    {
+      if (instrIt->opcode() != ir::op_code::Phi)
+        break;
+    }
+    return instrIt;
+  }
+
   ir::basic_block& context::terminal_or_entry() noexcept
   {
     auto&& fd = cur_data();
-    return fd.m_terminal ? *fd.m_terminal : current_function().entry();
+    return fd.m_terminal ? *fd.m_terminal : body_block();
   }
 
   void context::terminate_at(ir::basic_block& term) noexcept
@@ -266,6 +322,16 @@ namespace tnac::detail
     return fd.m_funcScope == fd.m_curScope;
   }
 
+  void context::mark_tail(const ast::node& node) noexcept
+  {
+    cur_data().m_tails.insert(&node);
+  }
+
+  bool context::is_tail(const ast::node& node) const noexcept
+  {
+    return cur_data().m_tails.contains(&node);
+  }
+
   void context::add_closure(ir::function& fn, ast::func_decl& fd) noexcept
   {
     auto&& data = cur_data();
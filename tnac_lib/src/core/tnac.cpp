@@ -79,6 +79,7 @@ namespace tnac
   void core::compile(ast::node& node) noexcept
   {
     m_compiler(node);
+    m_irEval.drop_code();
   }
 
   void core::compile() noexcept
@@ -126,6 +127,11 @@ namespace tnac
     return m_compiler;
   }
 
+  eval::store& core::get_store() noexcept
+  {
+    return m_valStore;
+  }
+
   void core::process_cmd(ast::command cmd) noexcept
   {
     m_cmdInterpreter.on_command(std::move(cmd));
@@ -0,0 +1,46 @@
+#include "eval/bind_cache.hpp"
+#include "cfg/ir/ir_function.hpp"
+
+namespace tnac::eval
+{
+  // Special members
+
+  bind_cache::~bind_cache() noexcept = default;
+
+  bind_cache::bind_cache() noexcept = default;
+
+
+  // Public members
+
+  ir::function* bind_cache::lookup(ir::function& receiver, string_t name, stats& st) noexcept
+  {
+    for (auto idx = size_type{}; idx < m_size; ++idx)
+    {
+      auto&& cached = m_entries[idx];
+      if (cached.m_receiver != &receiver)
+        continue;
+
+      ++st.m_hits;
+      return cached.m_member;
+    }
+
+    ++st.m_misses;
+    auto res = receiver.lookup(name);
+
+    // Failed lookups aren't cached since the receiver might get the member later
+    if (res && !is_megamorphic())
+      m_entries[m_size++] = { &receiver, res };
+
+    return res;
+  }
+
+  bind_cache::size_type bind_cache::size() const noexcept
+  {
+    return m_size;
+  }
+
+  bool bind_cache::is_megamorphic() const noexcept
+  {
+    return m_size == capacity;
+  }
+}
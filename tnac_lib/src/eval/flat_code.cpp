@@ -0,0 +1,396 @@
+#include "eval/flat_code.hpp"
+
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    //
+    // Checks whether the instruction is a binary operation
+    // which is applied to arrays element by element
+    //
+    bool is_elementwise(const ir::instruction& instr) noexcept
+    {
+      using enum ir::op_code;
+      return utils::eq_any(instr.opcode(), Add, Sub, Mul, Div, Mod, Pow, Root, And, Or, Xor);
+    }
+
+    //
+    // Checks whether the instruction writes nothing but its own result
+    // Such instructions can sit between fused operations
+    //
+    bool keeps_operands(const ir::instruction& instr) noexcept
+    {
+      using enum ir::op_code;
+      const auto oc = instr.opcode();
+      if (oc == Load)
+        return !instr[1].is_record();
+
+      return is_elementwise(instr) || utils::eq_any(oc, Alloc,
+        CmpE, CmpL, CmpLE, CmpNE, CmpG, CmpGE,
+        Abs, Plus, Head, Tail, Neg, BNeg, CmpNot, CmpIs);
+    }
+
+    //
+    // Calls the given function for each register referenced by the instruction
+    //
+    template <typename F>
+    void for_each_reg(const ir::instruction& instr, F&& func) noexcept
+    {
+      for (auto idx = ir::instruction::size_type{}; idx < instr.operand_count(); ++idx)
+      {
+        auto&& op = instr[idx];
+        auto&& src = op.is_edge() ? op.get_edge().value() : op;
+        if (src.is_register())
+          func(src.get_reg());
+      }
+    }
+  }
+}
+
+namespace tnac::eval // flat code
+{
+  // Special members
+
+  flat_code::~flat_code() noexcept = default;
+
+  flat_code::flat_code() noexcept = default;
+
+
+  // Public members
+
+  const flat_instr* flat_code::entry() const noexcept
+  {
+    UTILS_ASSERT(!m_instrs.empty());
+    return m_instrs.data();
+  }
+
+  flat_code::size_type flat_code::size() const noexcept
+  {
+    return m_instrs.size();
+  }
+}
+
+
+namespace tnac::eval // code store
+{
+  // Special members
+
+  code_store::~code_store() noexcept = default;
+
+  code_store::code_store(decorator dec) noexcept :
+    m_decorator{ dec }
+  {
+    UTILS_ASSERT(m_decorator);
+  }
+
+
+  // Public members
+
+  const flat_code& code_store::code_for(const ir::function& fn) noexcept
+  {
+    auto [item, isNew] = m_code.try_emplace(&fn);
+    if (isNew)
+    {
+      lower(fn, item->second);
+      ++m_stats.m_functions;
+    }
+
+    return item->second;
+  }
+
+  const value& code_store::constant(const_idx idx) const noexcept
+  {
+    UTILS_ASSERT(idx < m_consts.size());
+    return m_consts[idx];
+  }
+
+  void code_store::clear() noexcept
+  {
+    m_code.clear();
+    m_consts.clear();
+  }
+
+  const code_store::stats& code_store::counters() const noexcept
+  {
+    return m_stats;
+  }
+
+
+  // Private members
+
+  void code_store::lower(const ir::function& fn, flat_code& code) noexcept
+  {
+    using size_type = flat_code::size_type;
+    using block_map = std::unordered_map<const ir::basic_block*, size_type>;
+    struct pending_jump
+    {
+      size_type m_at{};
+      const ir::basic_block* m_to{};
+      const ir::basic_block* m_alt{};
+    };
+    struct pending_phi
+    {
+      size_type m_at{};
+      size_type m_first{};
+    };
+    using pending_links = pending_phi;
+
+    std::vector<const ir::basic_block*> order;
+    auto&& entry = fn.entry();
+    order.push_back(&entry);
+    for (auto&& block : fn.blocks())
+    {
+      if (&block != &entry)
+        order.push_back(&block);
+    }
+
+    const auto chains = find_chains(fn);
+    chain_map chainPrev;
+    for (auto [from, to] : chains)
+      chainPrev.emplace(to, from);
+
+    block_map starts;
+    std::vector<pending_jump> jumps;
+    std::vector<pending_phi> phis;
+    std::vector<pending_links> links;
+    auto&& instrs = code.m_instrs;
+    for (auto block : order)
+    {
+      starts.try_emplace(block, instrs.size());
+      [[maybe_unused]] const ir::instruction* last{};
+      for (auto&& instr : *block)
+      {
+        last = &instr;
+
+        // Chained operations are evaluated by the last one in the chain
+        if (chains.contains(&instr))
+          continue;
+
+        const auto at = instrs.size();
+        const auto incomingAt = code.m_incoming.size();
+        const auto linksAt = code.m_links.size();
+        if (chainPrev.contains(&instr))
+        {
+          auto first = &instr;
+          for (auto prev = chainPrev.find(first); prev != chainPrev.end(); prev = chainPrev.find(first))
+            first = prev->second;
+
+          lower_chain(*first, chains, code);
+          links.emplace_back(at, linksAt);
+          continue;
+        }
+
+        lower(instr, code);
+        if (instrs.size() == at)
+          continue;
+
+        using enum ir::op_code;
+        if (const auto oc = instr.opcode(); oc == Jump)
+        {
+          const auto isCond = instr.operand_count() > 1;
+          auto&& to = instr[isCond ? 1 : 0].get_block();
+          auto alt = isCond ? &instr[2].get_block() : nullptr;
+          jumps.emplace_back(at, &to, alt);
+        }
+        else if (oc == Phi)
+        {
+          phis.emplace_back(at, incomingAt);
+        }
+      }
+
+      // Blocks of compiled functions always end with a jump or a return
+      UTILS_ASSERT(last && utils::eq_any(last->opcode(), ir::op_code::Jump, ir::op_code::Ret));
+    }
+
+    // The list is final at this point, so pointers into it are stable
+    auto resolve = [&](const ir::basic_block* block) noexcept -> const flat_instr*
+      {
+        if (!block)
+          return {};
+
+        auto found = starts.find(block);
+        UTILS_ASSERT(found != starts.end());
+        return &instrs[found->second];
+      };
+
+    for (auto&& jmp : jumps)
+    {
+      auto&& fi = instrs[jmp.m_at];
+      fi.m_target = resolve(jmp.m_to);
+      fi.m_altTarget = resolve(jmp.m_alt);
+    }
+
+    for (auto&& phi : phis)
+    {
+      auto&& fi = instrs[phi.m_at];
+      fi.m_incoming = &code.m_incoming[phi.m_first];
+    }
+
+    for (auto&& link : links)
+    {
+      auto&& fi = instrs[link.m_at];
+      fi.m_links = &code.m_links[link.m_first];
+    }
+  }
+
+  void code_store::lower(const ir::instruction& instr, flat_code& code) noexcept
+  {
+    flat_instr fi{};
+    fi.m_src = &instr;
+    if (!m_decorator(instr, fi))
+      return;
+
+    using enum ir::op_code;
+    const auto oc = instr.opcode();
+    const auto opCount = instr.operand_count();
+    auto opIdx = ir::instruction::size_type{};
+
+    if (oc == Store)
+    {
+      // Store's target goes second
+      fi.m_res = to_flat(instr[1]).m_idx;
+      fi.m_ops[0] = to_flat(instr[0]);
+    }
+    else if (oc == Jump)
+    {
+      if (opCount > 1)
+        fi.m_ops[0] = to_flat(instr[0]);
+    }
+    else if (oc == Ret)
+    {
+      fi.m_ops[0] = to_flat(instr[0]);
+    }
+    else if (oc == DynBind)
+    {
+      // Each bind site gets its own inline cache
+      fi.m_bindCache = &code.m_bindCaches.emplace_front();
+    }
+    else
+    {
+      if (opCount && instr[0].is_register())
+      {
+        fi.m_res = to_flat(instr[0]).m_idx;
+        ++opIdx;
+      }
+
+      if (oc == Phi)
+      {
+        for (; opIdx < opCount; ++opIdx)
+        {
+          auto&& edge = instr[opIdx].get_edge();
+          code.m_incoming.emplace_back(&edge.incoming(), to_flat(edge.value()));
+        }
+        fi.m_incomingCount = static_cast<std::uint32_t>(opCount - 1);
+      }
+
+      for (auto flatIdx = 0u; opIdx < opCount && flatIdx < flat_instr::maxOps; ++opIdx, ++flatIdx)
+      {
+        fi.m_ops[flatIdx] = to_flat(instr[opIdx]);
+      }
+    }
+
+    code.m_instrs.push_back(fi);
+  }
+
+  void code_store::lower_chain(const ir::instruction& first, const chain_map& chains, flat_code& code) noexcept
+  {
+    flat_instr fi{};
+    [[maybe_unused]] const auto decorated = m_decorator(first, fi);
+    UTILS_ASSERT(decorated);
+    fi.m_ops[0] = to_flat(first[1]);
+    fi.m_ops[1] = to_flat(first[2]);
+
+    auto last = &first;
+    for (auto next = chains.find(last); next != chains.end(); next = chains.find(last))
+    {
+      last = next->second;
+      flat_instr linkFi{};
+      m_decorator(*last, linkFi);
+      code.m_links.emplace_back(to_flat((*last)[2]), linkFi.m_valOp);
+      ++fi.m_linkCount;
+    }
+
+    fi.m_src = last;
+    fi.m_res = to_flat((*last)[0]).m_idx;
+    code.m_instrs.push_back(fi);
+
+    ++m_stats.m_chains;
+    m_stats.m_fused += fi.m_linkCount + 1;
+  }
+
+  code_store::chain_map code_store::find_chains(const ir::function& fn) noexcept
+  {
+    // Each register is written once and read once if it is a temporary
+    // between two operations
+    std::unordered_map<const ir::vreg*, std::size_t> refs;
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+        detail::for_each_reg(instr, [&](const ir::vreg& reg) noexcept { ++refs[&reg]; });
+    }
+
+    chain_map res;
+    for (auto&& block : fn.blocks())
+    {
+      for (auto it = block.begin(); it != block.end(); ++it)
+      {
+        auto&& instr = *it;
+        if (!detail::is_elementwise(instr) || !instr[0].is_register())
+          continue;
+
+        auto&& reg = instr[0].get_reg();
+        if (reg.is_global() || refs[&reg] != 2)
+          continue;
+
+        // The user must be the next operation in the same block,
+        // and nothing in between may overwrite the operands
+        for (auto next = std::next(it); next != block.end(); ++next)
+        {
+          auto&& user = *next;
+          auto usesReg = false;
+          detail::for_each_reg(user, [&](const ir::vreg& r) noexcept { usesReg = usesReg || &r == &reg; });
+          if (!usesReg)
+          {
+            if (detail::keeps_operands(user))
+              continue;
+
+            break;
+          }
+
+          const auto isReg = [&reg](const ir::operand& op) noexcept
+            {
+              return op.is_register() && &op.get_reg() == &reg;
+            };
+
+          if (detail::is_elementwise(user) && isReg(user[1]) && !isReg(user[2]))
+            res.emplace(&instr, &user);
+
+          break;
+        }
+      }
+    }
+
+    return res;
+  }
+
+  flat_operand code_store::to_flat(const ir::operand& op) noexcept
+  {
+    flat_operand res{};
+    if (op.is_value())
+    {
+      res.m_src = flat_src::Const;
+      res.m_idx = static_cast<const_idx>(m_consts.size());
+      m_consts.push_back(op.get_value());
+    }
+    else if (op.is_register())
+    {
+      if (auto&& reg = op.get_reg(); reg.has_slot())
+      {
+        res.m_src = flat_src::Slot;
+        res.m_idx = reg.slot();
+      }
+    }
+
+    return res;
+  }
+}
@@ -2,6 +2,7 @@
 #include "common/feedback.hpp"
 #include "eval/value/type_impl.hpp"
 #include "eval/value/traits.hpp"
+#include "eval/value/intrinsics.hpp"
 
 namespace tnac::detail
 {
@@ -12,6 +13,11 @@ namespace tnac::detail
       return reinterpret_cast<const ir::instruction*>(*id);
     }
 
+    auto to_flat_addr(entity_id id) noexcept
+    {
+      return reinterpret_cast<const eval::flat_instr*>(*id);
+    }
+
     constexpr auto is_unary(ir::op_code oc) noexcept
     {
       using enum ir::op_code;
@@ -96,28 +102,39 @@ namespace tnac
 {
   // Special members
 
-  ir_eval::~ir_eval() noexcept = default;
+  ir_eval::~ir_eval() noexcept
+  {
+    if (m_valStore->par() == &m_parElems)
+      m_valStore->attach_par(nullptr);
+  }
 
   ir_eval::ir_eval(ir::cfg& cfg, eval::store& vals, feedback* fb) noexcept :
     m_cfg{ &cfg },
     m_valStore{ &vals },
+    m_code{ &ir_eval::decorate },
     m_feedback{ fb }
-  { }
+  {
+    m_valStore->attach_par(&m_parElems);
+  }
 
 
   // Public members
 
   void ir_eval::try_load(const ir::vreg& reg) noexcept
   {
-    auto regId = m_env.find_reg(m_curFrame, &reg);
-    if (!regId)
+    if (!m_curFrame || !reg.has_slot())
       return;
 
-    m_result = m_curFrame->value_for(*regId);
+    m_result = m_curFrame->value_for(reg.slot());
+    m_resFrame = {};
   }
 
   eval::value ir_eval::result() const noexcept
   {
+    // The last stored value stays in its frame until the frame is left
+    if (m_resFrame)
+      return m_resFrame->value_for(m_resReg);
+
     return m_result;
   }
 
@@ -126,11 +143,22 @@ namespace tnac
     m_env.clear();
   }
 
+  void ir_eval::drop_code() noexcept
+  {
+    // Dropping the code from under a running function would leave m_pc dangling
+    UTILS_ASSERT(!m_flatRoot);
+    m_code.clear();
+  }
+
   void ir_eval::enter(eval::function_type func) noexcept
   {
     auto jmpBack = m_instrPtr ? m_instrPtr->next() : nullptr;
-    const auto paramCnt = func->param_count();
-    m_curFrame = &m_stack.make_frame(std::move(func), paramCnt, jmpBack);
+    if (!func->has_slots())
+      func->assign_slots();
+
+    m_jit.on_enter(*func);
+    const auto slotCnt = func->slot_count();
+    m_curFrame = &m_stack.make_frame(std::move(func), slotCnt, jmpBack);
     auto&& entry = func->entry();
     m_branching.push({ nullptr, &entry });
     init_instr_ptr(*entry.begin());
@@ -155,13 +183,12 @@ namespace tnac
     }
 
     m_instrPtr = detail::to_addr(m_curFrame->jump_back());
-    m_env.remove_frame(m_curFrame);
-    m_curFrame = m_stack.pop_frame();
-    m_branching.pop();
+    pop_frame();
   }
 
   void ir_eval::evaluate_current() noexcept
   {
+    run_flat();
     while (step())
     {
     }
@@ -182,6 +209,53 @@ namespace tnac
       m_curFrame->add_arg(std::move(arg));
   }
 
+  const ir_eval::bind_stats& ir_eval::dyn_bind_stats() const noexcept
+  {
+    return m_bindStats;
+  }
+
+  const ir_eval::flat_stats& ir_eval::flat_code_stats() const noexcept
+  {
+    return m_code.counters();
+  }
+
+  const eval::memo_cache& ir_eval::memo() const noexcept
+  {
+    return m_memo;
+  }
+  eval::memo_cache& ir_eval::memo() noexcept
+  {
+    return FROM_CONST(memo);
+  }
+
+  const eval::native_jit& ir_eval::jit() const noexcept
+  {
+    return m_jit;
+  }
+  eval::native_jit& ir_eval::jit() noexcept
+  {
+    return FROM_CONST(jit);
+  }
+
+  const eval::par_calls& ir_eval::par() const noexcept
+  {
+    return m_par;
+  }
+  eval::par_calls& ir_eval::par() noexcept
+  {
+    return FROM_CONST(par);
+  }
+
+  const eval::par_elems& ir_eval::par_elems() const noexcept
+  {
+    return m_parElems;
+  }
+
+  eval::par_elems& ir_eval::par_elems() noexcept
+  {
+    return FROM_CONST(par_elems);
+  }
+
 
   // Private members
 
@@ -212,6 +286,30 @@ namespace tnac
     return res;
   }
 
+  const eval::value& ir_eval::borrow_value(const ir::operand& op) const noexcept
+  {
+    return borrow_value(*m_curFrame, op);
+  }
+
+  const eval::value& ir_eval::borrow_value(const eval::stack_frame& frame, const ir::operand& op) const noexcept
+  {
+    if (op.is_value())
+      return op.get_value();
+
+    if (op.is_register())
+      return frame.value_ref(get_reg(&frame, op.get_reg()));
+
+    return eval::value::invalid();
+  }
+
+  eval::value ir_eval::take_value(eval::stack_frame& frame, const ir::operand& op) noexcept
+  {
+    if (op.is_register())
+      return frame.take(get_reg(&frame, op.get_reg()));
+
+    return borrow_value(frame, op);
+  }
+
   ir_eval::val_opt ir_eval::get_callee_owner(const eval::stack_frame& frame, const ir::operand& op) const noexcept
   {
     val_opt res{};
@@ -236,11 +334,10 @@ namespace tnac
     return get_reg(m_curFrame, reg);
   }
 
-  entity_id ir_eval::get_reg(const eval::stack_frame* frame, const ir::vreg& reg) const noexcept
+  entity_id ir_eval::get_reg(const eval::stack_frame*, const ir::vreg& reg) const noexcept
   {
-    const auto regId = m_env.find_reg(frame, &reg);
-    UTILS_ASSERT(regId);
-    return regId.value_or(entity_id{});
+    UTILS_ASSERT(reg.has_slot());
+    return reg.has_slot() ? entity_id{ reg.slot() } : entity_id{};
   }
 
   void ir_eval::store_value(entity_id reg, const ir::operand& from) noexcept
@@ -250,9 +347,8 @@ namespace tnac
 
   void ir_eval::store_value(eval::stack_frame& frame, entity_id reg, const ir::operand& from) noexcept
   {
-    auto fromVal = get_value(frame, from);
-    UTILS_ASSERT(fromVal);
-    store_value(frame, reg, std::move(*fromVal));
+    UTILS_ASSERT(from.is_value() || from.is_register());
+    store_value(frame, reg, eval::value{ borrow_value(frame, from) });
   }
 
   void ir_eval::store_value(entity_id reg, eval::value val) noexcept
@@ -262,8 +358,10 @@ namespace tnac
 
   void ir_eval::store_value(eval::stack_frame& frame, entity_id reg, eval::value val) noexcept
   {
-    frame.store(reg, val);
-    m_result = std::move(val);
+    // The result is read from the frame on demand instead of being copied on every store
+    frame.store(reg, std::move(val));
+    m_resFrame = &frame;
+    m_resReg = reg;
   }
 
   entity_id ir_eval::alloc_new(entity_id op) noexcept
@@ -280,7 +378,14 @@ namespace tnac
   {
     UTILS_ASSERT(op.is_register());
     auto&& target = op.get_reg();
-    return alloc_new(entity_id{ &target });
+    if (target.has_slot())
+      return target.slot();
+
+    // Instructions added after the frame was entered (e.g., in the REPL)
+    // get their slots past everything the frame currently holds
+    auto curFn = m_curFrame->function();
+    const auto lowerBound = static_cast<ir::function::slot_type>(m_curFrame->size());
+    return curFn->slot_of(target, lowerBound);
   }
 
   void ir_eval::jump_to(const ir::operand& op) noexcept
@@ -342,6 +447,8 @@ namespace tnac
       select();
     else if (opcode == Arr)
       alloc_array();
+    else if (opcode == Range)
+      alloc_range();
     else if (opcode == StructAlloc)
       alloc_record();
     else if (opcode == Append)
@@ -385,6 +492,14 @@ namespace tnac
     store_value(regId, eval::value::array(wrapper));
   }
 
+  void ir_eval::alloc_range() noexcept
+  {
+    auto&& instr = cur();
+    const auto regId = alloc_new(instr[0]);
+    auto range = eval::value::range(*m_valStore, borrow_value(instr[1]), borrow_value(instr[2]), borrow_value(instr[3]));
+    store_value(regId, std::move(range));
+  }
+
   void ir_eval::alloc_record(eval::function_type& func, ir::record& rec) noexcept
   {
     auto&& arrData = m_valStore->allocate_array(rec.size());
@@ -466,10 +581,9 @@ namespace tnac
 
     if (from.is_param())
     {
+      // Parameter registers are pre-assigned to the argument slots
       UTILS_ASSERT(to.is_register());
-      auto&& target = to.get_reg();
-      auto par = from.get_param();
-      m_env.map(m_curFrame, &target, *par);
+      UTILS_ASSERT(to.get_reg().slot() == *from.get_param());
       return;
     }
 
@@ -539,10 +653,7 @@ namespace tnac
     auto&& ifTrue = instr[1];
     auto&& ifFalse = instr[2];
 
-    auto condVal = get_value(cond);
-    UTILS_ASSERT(condVal);
-
-    if (eval::to_bool(*condVal))
+    if (eval::to_bool(borrow_value(cond)))
       jump_to(ifTrue);
     else
       jump_to(ifFalse);
@@ -550,28 +661,45 @@ namespace tnac
 
   void ir_eval::phi() noexcept
   {
-    auto&& instr = cur();
-    auto&& to = instr[0];
-
-    const auto regId = alloc_new(to);
-
     UTILS_ASSERT(!m_branching.empty());
     auto&& br = m_branching.top();
 
-    for (auto idx = op_count{ 1 }; idx < instr.operand_count(); ++idx)
+    // Along a back edge, a phi can read the previous value of another one,
+    // so nothing is stored until every phi in the block has its value
+    m_phiVals.clear();
+    auto first = m_instrPtr;
+    for (auto instr = first; instr && instr->opcode() == ir::op_code::Phi; instr = instr->next())
     {
-      auto&& op = instr[idx];
-      UTILS_ASSERT(op.is_edge());
-      auto&& edge = op.get_edge();
-      if (&edge.incoming() != br.m_from)
-        continue;
+      m_instrPtr = instr;
+      auto&& val = m_phiVals.emplace_back();
+      for (auto idx = op_count{ 1 }; idx < instr->operand_count(); ++idx)
+      {
+        auto&& op = (*instr)[idx];
+        UTILS_ASSERT(op.is_edge());
+        auto&& edge = op.get_edge();
+        if (&edge.incoming() != br.m_from)
+          continue;
+
+        val = borrow_value(edge.value());
+        break;
+      }
+    }
 
-      store_value(regId, edge.value());
-      return;
+    auto instr = first;
+    for (auto&& val : m_phiVals)
+    {
+      const auto regId = alloc_new((*instr)[0]);
+      store_value(regId, std::move(val));
+      instr = instr->next();
     }
   }
 
   void ir_eval::dyn_bind() noexcept
+  {
+    dyn_bind(m_bindCaches[&cur()]);
+  }
+
+  void ir_eval::dyn_bind(eval::bind_cache& cache) noexcept
   {
     auto&& instr = cur();
     auto&& res = instr[0];
@@ -579,9 +707,7 @@ namespace tnac
     auto&& name = instr[2];
 
     const auto regId = alloc_new(res);
-    auto srcVal = get_value(src);
-    UTILS_ASSERT(srcVal);
-    auto func = eval::cast_value<eval::function_type>(*srcVal);
+    auto func = eval::cast_value<eval::function_type>(borrow_value(src));
     if(!func)
     {
       // todo: error & abort
@@ -592,7 +718,7 @@ namespace tnac
     auto memName = name.get_name();
 
     auto&& callable = *func;
-    auto result = callable->lookup(memName);
+    auto result = cache.lookup(*callable, memName, m_bindStats);
     if(!result)
     {
       // todo: error & abort
@@ -610,9 +736,7 @@ namespace tnac
     auto&& callee = instr[2];
 
     const auto regId = alloc_new(res);
-    auto srcVal = get_value(src);
-    UTILS_ASSERT(srcVal);
-    auto func = eval::cast_value<eval::function_type>(*srcVal);
+    auto func = eval::cast_value<eval::function_type>(borrow_value(src));
     if (!func)
     {
       // todo: error & abort
@@ -632,9 +756,7 @@ namespace tnac
     auto&& onFalse = instr[3];
 
     const auto regId = alloc_new(res);
-    auto condVal = get_value(cond);
-    UTILS_ASSERT(condVal);
-    const auto testRes = eval::to_bool(*condVal);
+    const auto testRes = eval::to_bool(borrow_value(cond));
     auto&& result = testRes ? onTrue : onFalse;
     store_value(regId, result);
   }
@@ -648,9 +770,8 @@ namespace tnac
     const auto regId = alloc_new(res);
     const auto opId = detail::to_unary_op(oc);
 
-    auto opVal = get_value(operand);
-    UTILS_ASSERT(opVal);
-    store_value(regId, opVal->unary(opId));
+    auto&& opVal = borrow_value(operand);
+    store_value(regId, opVal.unary(opId));
   }
 
   void ir_eval::binary(ir::op_code oc) noexcept
@@ -663,11 +784,9 @@ namespace tnac
     const auto regId = alloc_new(res);
     const auto opId = detail::to_binary_op(oc);
 
-    auto lv = get_value(lhs);
-    auto rv = get_value(rhs);
-    UTILS_ASSERT(lv);
-    UTILS_ASSERT(rv);
-    store_value(regId, lv->binary(opId, *rv));
+    auto&& lv = borrow_value(lhs);
+    auto&& rv = borrow_value(rhs);
+    store_value(regId, lv.binary(opId, rv));
   }
 
   void ir_eval::test_type() noexcept
@@ -681,10 +800,7 @@ namespace tnac
     const auto regId = alloc_new(res);
 
     const auto typeId = type.get_typeid();
-    auto opVal = get_value(val);
-    
-    UTILS_ASSERT(opVal);
-    store_value(regId, eval::value{ opVal->id() == typeId });
+    store_value(regId, eval::value{ borrow_value(val).id() == typeId });
   }
 
   void ir_eval::type(ir::op_code oc) noexcept
@@ -709,7 +825,7 @@ namespace tnac
     store_value(regId, instance.value_or(eval::value{}));
   }
 
-  bool ir_eval::call(entity_id regId, eval::value f, const ir::instruction& instr) noexcept
+  bool ir_eval::call(entity_id regId, const eval::value& f, const ir::instruction& instr) noexcept
   {
     const auto argCount = instr.operand_count() - 2;
     auto callable = eval::extract_function(f);
@@ -719,7 +835,7 @@ namespace tnac
     }
 
     auto func = std::move(*callable);
-    if (func->param_count() != argCount)
+    if (func->param_count() != argCount || func->is_intrinsic())
     {
       return false;
     }
@@ -762,7 +878,7 @@ namespace tnac
       auto res = m_curFrame->value_for(regId);
       auto resArr = eval::extract_array(res);
       auto&& resData = resArr->data();
-      for (auto&& elem : resData)
+      for (auto&& elem : resData.elements())
       {
         auto elemId = m_env.find_reg(m_curFrame, &elem);
         UTILS_ASSERT(elemId);
@@ -787,12 +903,21 @@ namespace tnac
         UTILS_ASSERT(resArr);
         auto&& underlying = resArr->data();
         underlying.add(eval::value{});
-        return entity_id{ &(*underlying.rbegin()) };
+        return entity_id{ &underlying.elements().back() };
       };
 
-    for (auto it = std::next(arr.begin(), arrIdx); it != arr.end(); ++it)
+    for (auto it = arr.begin() + static_cast<std::ptrdiff_t>(arrIdx); it != arr.end(); ++it)
     {
-      if (auto subarr = eval::extract_array(*it))
+      auto subarr = eval::extract_array(*it);
+
+      // Packed arrays and ranges have no functions to call
+      if (subarr && !subarr->data().is_boxed())
+      {
+        ++arrIdx;
+        continue;
+      }
+
+      if (subarr)
       {
         auto existing = m_arrCalls.find(subarr);
         entity_id subReg{};
@@ -811,6 +936,13 @@ namespace tnac
       }
 
       ++arrIdx;
+      if (auto builtinRes = call_intrinsic(*it, instr))
+      {
+        const auto elemAddr = allocElem(*m_curFrame);
+        store_value(alloc_new(elemAddr), std::move(*builtinRes));
+        continue;
+      }
+
       auto prevFrame = m_curFrame;
       if (!call(regId, *it, instr))
         continue;
@@ -834,24 +966,247 @@ namespace tnac
     auto&& to = instr[0];
     auto&& f = instr[1];
     const auto regId = alloc_new(to);
-    auto callable = get_value(f);
-    UTILS_ASSERT(callable);
-    if (auto arr = eval::extract_array(callable.value_or(eval::value{})))
+    auto&& callable = borrow_value(f);
+    if (auto arr = eval::extract_array(callable))
     {
+      // Packed arrays and ranges have no functions, iterating them would box every element
+      if (!arr->data().is_boxed())
+      {
+        store_value(regId, eval::value::array(m_valStore->alloc_wrapped({})));
+        m_instrPtr = m_instrPtr->next();
+        return;
+      }
+
+      if (auto parRes = call_par(*arr, instr))
+      {
+        store_value(regId, std::move(*parRes));
+        m_instrPtr = m_instrPtr->next();
+        return;
+      }
+
       call(regId, *arr, instr);
       return;
     }
 
-    if (!call(regId, *callable, instr))
+    if (reduce(regId, callable, instr))
+      return;
+
+    if (auto builtinRes = call_intrinsic(callable, instr))
+    {
+      store_value(regId, std::move(*builtinRes));
+      m_instrPtr = m_instrPtr->next();
+      return;
+    }
+
+    auto memoKey = make_memo_key(callable, instr);
+    if (memoKey)
+    {
+      if (auto cached = m_memo.find(*memoKey))
+      {
+        store_value(regId, *cached);
+        m_instrPtr = m_instrPtr->next();
+        return;
+      }
+    }
+
+    if (auto nativeRes = call_native(callable, instr))
+    {
+      store_value(regId, std::move(*nativeRes));
+      m_instrPtr = m_instrPtr->next();
+      return;
+    }
+
+    if (!call(regId, callable, instr))
     {
       store_value(regId, eval::value{});
       m_instrPtr = m_instrPtr->next();
       return;
     }
+
+    if (memoKey)
+      memo_enter(std::move(*memoKey));
+  }
+
+  ir_eval::val_opt ir_eval::call_par(eval::array_wrapper& arr, const ir::instruction& instr) noexcept
+  {
+    // Nested array calls are already being evaluated sequentially
+    if (!m_par.is_enabled() || !m_arrCalls.empty())
+      return {};
+
+    const auto argCount = instr.operand_count() - 2;
+    std::vector<eval::value> args;
+    args.reserve(argCount);
+    for (auto idx = op_count{}; idx < argCount; ++idx)
+    {
+      auto arg = get_value(instr[idx + 2]);
+      UTILS_ASSERT(arg);
+      args.emplace_back(std::move(*arg));
+    }
+
+    return m_par.call(*m_cfg, *m_valStore, arr, args);
+  }
+
+  ir_eval::val_opt ir_eval::call_native(const eval::value& f, const ir::instruction& instr) noexcept
+  {
+    auto callable = eval::extract_function(f);
+    if (!callable || !m_jit.is_native(**callable))
+      return {};
+
+    using eval::native_jit;
+    const auto argCount = instr.operand_count() - 2;
+    if ((*callable)->param_count() != argCount || argCount > native_jit::maxParams)
+      return {};
+
+    // Native code is specialised for int arguments
+    std::array<eval::int_type, native_jit::maxParams> args{};
+    for (auto idx = op_count{}; idx < argCount; ++idx)
+    {
+      auto intArg = borrow_value(instr[idx + 2]).try_get<eval::int_type>();
+      if (!intArg)
+        return {};
+
+      args[idx] = *intArg;
+    }
+
+    return m_jit.call(**callable, native_jit::arg_list{ args.data(), argCount });
+  }
+
+  ir_eval::val_opt ir_eval::call_intrinsic(const eval::value& f, const ir::instruction& instr) noexcept
+  {
+    auto callable = eval::extract_function(f);
+    if (!callable || !(*callable)->is_intrinsic())
+      return {};
+
+    const auto id = (*callable)->intrinsic_id();
+    if (id == eval::intrinsic::Reduce)
+      return {};
+
+    const auto argCount = instr.operand_count() - 2;
+    std::vector<eval::value> args;
+    args.reserve(argCount);
+    for (auto idx = op_count{}; idx < argCount; ++idx)
+      args.emplace_back(borrow_value(instr[idx + 2]));
+
+    return eval::call_intrinsic(*m_valStore, id, args);
+  }
+
+  bool ir_eval::reduce(entity_id regId, const eval::value& f, const ir::instruction& instr) noexcept
+  {
+    auto callable = eval::extract_function(f);
+    if (!callable || (*callable)->intrinsic_id() != eval::intrinsic::Reduce)
+      return false;
+
+    auto state = m_reductions.find(m_curFrame);
+    if (state == m_reductions.end())
+    {
+      const auto argCount = instr.operand_count() - 2;
+      if ((*callable)->param_count() != argCount)
+      {
+        store_value(regId, eval::value{});
+        m_instrPtr = instr.next();
+        return true;
+      }
+
+      auto arr = get_value(instr[2]);
+      auto fn  = get_value(instr[3]);
+      UTILS_ASSERT(arr && fn);
+
+      // Non-arrays are reduced to themselves, and empty arrays have nothing to start with
+      auto aw = eval::extract_array(*arr);
+      if (!aw || !aw->size())
+      {
+        store_value(regId, aw ? eval::value{} : std::move(*arr));
+        m_instrPtr = instr.next();
+        return true;
+      }
+
+      store_value(regId, aw->data().read_at(aw->index_of(0)));
+      state = m_reductions.try_emplace(m_curFrame, std::move(*arr), std::move(*fn), 1u).first;
+    }
+
+    auto&& red = state->second;
+    auto aw = eval::extract_array(red.m_arr);
+    UTILS_ASSERT(aw);
+    while (red.m_idx < aw->size())
+    {
+      auto acc  = m_curFrame->value_for(regId);
+      auto elem = aw->data().read_at(aw->index_of(red.m_idx++));
+      auto fn   = eval::extract_function(red.m_fn);
+      if (!fn || (*fn)->param_count() != 2)
+      {
+        store_value(regId, eval::value{});
+        break;
+      }
+
+      // Built-in folds need no frames
+      if ((*fn)->is_intrinsic())
+      {
+        std::array args{ std::move(acc), std::move(elem) };
+        store_value(regId, eval::call_intrinsic(*m_valStore, (*fn)->intrinsic_id(), args));
+        continue;
+      }
+
+      enter(std::move(*fn));
+      m_curFrame->attach_ret_val(regId);
+      m_curFrame->add_arg(std::move(acc));
+      m_curFrame->add_arg(std::move(elem));
+      m_curFrame->redirrect(&instr);
+      return true;
+    }
+
+    m_reductions.erase(state);
+    m_instrPtr = instr.next();
+    return true;
+  }
+
+  ir_eval::memo_key ir_eval::make_memo_key(const eval::value& f, const ir::instruction& instr) noexcept
+  {
+    auto callable = eval::extract_function(f);
+    if (!callable)
+      return {};
+
+    auto&& func = **callable;
+    const auto argCount = instr.operand_count() - 2;
+    if (func.param_count() != argCount || !m_memo.wants(func))
+      return {};
+
+    if (get_callee_owner(*m_curFrame, instr[1]))
+      return {};
+
+    eval::memo_cache::arg_list args;
+    args.reserve(argCount);
+    for (auto idx = op_count{ 2 }; idx < instr.operand_count(); ++idx)
+    {
+      auto arg = get_value(instr[idx]);
+      UTILS_ASSERT(arg);
+      args.emplace_back(std::move(*arg));
+    }
+
+    return eval::memo_cache::make_key(func, std::move(args));
+  }
+
+  void ir_eval::memo_enter(eval::memo_cache::key k) noexcept
+  {
+    m_memoCalls.push({ m_curFrame, std::move(k), m_effects });
+  }
+
+  void ir_eval::memo_leave(const eval::value& res) noexcept
+  {
+    if (m_memoCalls.empty() || m_memoCalls.top().m_frame != m_curFrame)
+      return;
+
+    auto&& mc = m_memoCalls.top();
+    if (mc.m_effects == m_effects)
+      m_memo.insert(std::move(mc.m_key), res);
+    else
+      m_memo.forbid(*mc.m_key.m_func);
+
+    m_memoCalls.pop();
   }
 
   void ir_eval::bind() noexcept
   {
+    ++m_effects;
     auto&& instr = cur();
     auto&& to = instr[0];
     auto&& f = instr[1];
@@ -887,6 +1242,7 @@ namespace tnac
 
   void ir_eval::stream_read() noexcept
   {
+    ++m_effects;
     auto&& instr = cur();
     auto&& to = instr[0];
     auto regId = alloc_new(to);
@@ -897,6 +1253,7 @@ namespace tnac
   
   void ir_eval::stream_write() noexcept
   {
+    ++m_effects;
     auto&& instr = cur();
     auto&& to = instr[0];
     auto&& from = instr[1];
@@ -915,20 +1272,287 @@ namespace tnac
     auto&& op = instr[0];
     const auto retAddr = m_curFrame->ret_val();
 
-    auto retVal = get_value(op);
-    UTILS_ASSERT(retVal);
+    // The frame is about to go away, so its value can be moved out
+    auto retVal = take_value(*m_curFrame, op);
 
     auto retFrame = m_curFrame->prev();
+    memo_leave(retVal);
 
     // Root
     if (!retFrame)
     {
-      m_result = std::move(*retVal);
+      m_result = std::move(retVal);
+      m_resFrame = {};
       leave();
       return;
     }
 
-    store_value(*retFrame, retAddr, std::move(*retVal));
+    store_value(*retFrame, retAddr, std::move(retVal));
     leave();
   }
-}
\ No newline at end of file
+
+  void ir_eval::pop_frame() noexcept
+  {
+    // Frames left without returning don't produce a result
+    if (!m_memoCalls.empty() && m_memoCalls.top().m_frame == m_curFrame)
+      m_memoCalls.pop();
+
+    if (m_resFrame == m_curFrame)
+    {
+      m_result = m_curFrame->take(m_resReg);
+      m_resFrame = {};
+    }
+
+    m_reductions.erase(m_curFrame);
+    m_env.remove_frame(m_curFrame);
+    m_curFrame = m_stack.pop_frame();
+    m_branching.pop();
+  }
+}
+
+namespace tnac // flat code
+{
+  // Private members
+
+  bool ir_eval::decorate(const ir::instruction& instr, eval::flat_instr& fi) noexcept
+  {
+    using enum ir::op_code;
+    const auto oc = instr.opcode();
+
+    // Slots are assigned ahead of time, so allocations and parameter loads are no-ops
+    if (oc == Alloc || (oc == Load && instr[1].is_param()))
+      return false;
+
+    if (oc == Jump)
+      fi.m_handler = &ir_eval::flat_jump;
+    else if (oc == Call)
+      fi.m_handler = &ir_eval::flat_call;
+    else if (oc == Ret)
+      fi.m_handler = &ir_eval::flat_ret;
+    else if (oc == Phi)
+      fi.m_handler = &ir_eval::flat_phi;
+    else if (oc == Select)
+      fi.m_handler = &ir_eval::flat_select;
+    else if (oc == DynBind)
+      fi.m_handler = &ir_eval::flat_dyn_bind;
+    else if (oc == Store || (oc == Load && !instr[1].is_record()))
+      fi.m_handler = &ir_eval::flat_copy;
+    else if (detail::is_unary(oc))
+    {
+      fi.m_handler = &ir_eval::flat_unary;
+      fi.m_valOp = detail::to_unary_op(oc);
+    }
+    else if (detail::is_binary(oc))
+    {
+      fi.m_handler = &ir_eval::flat_binary;
+      fi.m_valOp = detail::to_binary_op(oc);
+    }
+    else
+      fi.m_handler = &ir_eval::flat_generic;
+
+    return true;
+  }
+
+  void ir_eval::run_flat() noexcept
+  {
+    if (!m_curFrame || !m_instrPtr)
+      return;
+
+    auto func = m_curFrame->function();
+    if (m_instrPtr != &(*func->entry().begin()))
+      return;
+
+    m_flatRoot = m_curFrame;
+    m_pc = m_code.code_for(*func).entry();
+    while (m_pc)
+    {
+      auto&& instr = *m_pc;
+      (this->*instr.m_handler)(instr);
+    }
+    m_flatRoot = {};
+  }
+
+  const eval::value& ir_eval::flat_value(const eval::flat_operand& op) const noexcept
+  {
+    using enum eval::flat_src;
+    switch (op.m_src)
+    {
+    case Slot:  return m_curFrame->value_ref(op.m_idx);
+    case Const: return m_code.constant(op.m_idx);
+    case None:  break;
+    }
+
+    return eval::value::invalid();
+  }
+
+  eval::value ir_eval::flat_take(const eval::flat_operand& op) noexcept
+  {
+    if (op.m_src == eval::flat_src::Slot)
+      return m_curFrame->take(op.m_idx);
+
+    return flat_value(op);
+  }
+
+  void ir_eval::flat_jump_to(const eval::flat_instr& target) noexcept
+  {
+    UTILS_ASSERT(!m_branching.empty());
+    auto&& br = m_branching.top();
+    br.m_from = br.m_to;
+    br.m_to = &target.m_src->owner_block();
+    m_pc = &target;
+  }
+
+  void ir_eval::flat_jump(const eval::flat_instr& fi) noexcept
+  {
+    auto target = fi.m_target;
+    if (fi.m_altTarget && !eval::to_bool(flat_value(fi.m_ops[0])))
+      target = fi.m_altTarget;
+
+    UTILS_ASSERT(target);
+    flat_jump_to(*target);
+  }
+
+  void ir_eval::flat_call(const eval::flat_instr& fi) noexcept
+  {
+    auto prevFrame = m_curFrame;
+    m_instrPtr = fi.m_src;
+    call();
+
+    if (m_curFrame == prevFrame)
+    {
+      // Array calls keep coming back to the same instruction until exhausted
+      m_pc = (m_instrPtr == fi.m_src) ? &fi : &fi + 1;
+      return;
+    }
+
+    // The frame was created with an IR return address
+    // Array calls return to the call itself, everything else goes to the next instruction
+    const auto retTo = (detail::to_addr(m_curFrame->jump_back()) == fi.m_src) ? &fi : &fi + 1;
+    m_curFrame->redirrect(retTo);
+    auto callee = m_curFrame->function();
+    m_pc = m_code.code_for(*callee).entry();
+  }
+
+  void ir_eval::flat_ret(const eval::flat_instr& fi) noexcept
+  {
+    if (m_curFrame == m_flatRoot)
+    {
+      m_instrPtr = fi.m_src;
+      ret();
+      m_pc = {};
+      return;
+    }
+
+    auto retFrame = m_curFrame->prev();
+    UTILS_ASSERT(retFrame);
+    auto retVal = flat_take(fi.m_ops[0]);
+    memo_leave(retVal);
+    store_value(*retFrame, m_curFrame->ret_val(), std::move(retVal));
+    m_pc = detail::to_flat_addr(m_curFrame->jump_back());
+    pop_frame();
+  }
+
+  void ir_eval::flat_phi(const eval::flat_instr& fi) noexcept
+  {
+    UTILS_ASSERT(!m_branching.empty());
+    auto&& br = m_branching.top();
+
+    // Same as with regular phis, values are read first and stored afterwards
+    m_phiVals.clear();
+    auto last = &fi;
+    for (; last->m_handler == &ir_eval::flat_phi; ++last)
+    {
+      auto&& val = m_phiVals.emplace_back();
+      for (auto it = last->m_incoming, end = it + last->m_incomingCount; it != end; ++it)
+      {
+        if (it->m_from != br.m_from)
+          continue;
+
+        val = flat_value(it->m_val);
+        break;
+      }
+    }
+
+    for (auto phi = &fi; auto&& val : m_phiVals)
+    {
+      store_value(phi->m_res, std::move(val));
+      ++phi;
+    }
+    m_pc = last;
+  }
+
+  void ir_eval::flat_select(const eval::flat_instr& fi) noexcept
+  {
+    const auto testRes = eval::to_bool(flat_value(fi.m_ops[0]));
+    store_value(fi.m_res, eval::value{ flat_value(fi.m_ops[testRes ? 1 : 2]) });
+    ++m_pc;
+  }
+
+  void ir_eval::flat_copy(const eval::flat_instr& fi) noexcept
+  {
+    store_value(fi.m_res, eval::value{ flat_value(fi.m_ops[0]) });
+    ++m_pc;
+  }
+
+  void ir_eval::flat_unary(const eval::flat_instr& fi) noexcept
+  {
+    auto&& opVal = flat_value(fi.m_ops[0]);
+    store_value(fi.m_res, opVal.unary(fi.m_valOp));
+    ++m_pc;
+  }
+
+  void ir_eval::flat_binary(const eval::flat_instr& fi) noexcept
+  {
+    auto&& lv = flat_value(fi.m_ops[0]);
+    auto&& rv = flat_value(fi.m_ops[1]);
+    if (fi.m_linkCount)
+      store_value(fi.m_res, flat_chain(fi, lv, rv));
+    else
+      store_value(fi.m_res, lv.binary(fi.m_valOp, rv));
+
+    ++m_pc;
+  }
+
+  eval::value ir_eval::flat_chain(const eval::flat_instr& fi, const eval::value& lhs, const eval::value& rhs) const noexcept
+  {
+    using enum eval::type_id;
+    const auto links = std::span{ fi.m_links, fi.m_linkCount };
+    const auto hasArrays = lhs.id() == Array || rhs.id() == Array ||
+      std::ranges::any_of(links, [this](const eval::flat_link& link) noexcept
+        {
+          return flat_value(link.m_val).id() == Array;
+        });
+
+    // Scalars have no intermediate arrays to avoid
+    if (!hasArrays)
+    {
+      auto res = lhs.binary(fi.m_valOp, rhs);
+      for (auto&& link : links)
+        res = res.binary(link.m_op, flat_value(link.m_val));
+
+      return res;
+    }
+
+    std::vector<eval::chain_link> chain;
+    chain.reserve(links.size());
+    for (auto&& link : links)
+      chain.emplace_back(&flat_value(link.m_val), link.m_op);
+
+    return lhs.binary_chain(fi.m_valOp, rhs, chain);
+  }
+
+  void ir_eval::flat_dyn_bind(const eval::flat_instr& fi) noexcept
+  {
+    UTILS_ASSERT(fi.m_bindCache);
+    m_instrPtr = fi.m_src;
+    dyn_bind(*fi.m_bindCache);
+    ++m_pc;
+  }
+
+  void ir_eval::flat_generic(const eval::flat_instr& fi) noexcept
+  {
+    m_instrPtr = fi.m_src;
+    dispatch();
+    ++m_pc;
+  }
+}
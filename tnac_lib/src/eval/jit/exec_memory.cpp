@@ -0,0 +1,82 @@
+#include "eval/jit/exec_memory.hpp"
+
+#if TNAC_LINUX_X64
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace tnac::eval
+{
+  // Special members
+
+  exec_memory::~exec_memory() noexcept
+  {
+    release();
+  }
+
+  exec_memory::exec_memory() noexcept = default;
+
+  exec_memory::operator bool() const noexcept
+  {
+    return static_cast<bool>(m_data);
+  }
+
+
+  // Public members
+
+#if TNAC_LINUX_X64
+
+  bool exec_memory::assign(code_view code) noexcept
+  {
+    release();
+    if (code.empty())
+      return false;
+
+    const auto pageSz = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+    const auto size = (code.size() + pageSz - 1) / pageSz * pageSz;
+    auto data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
+      return false;
+
+    std::memcpy(data, code.data(), code.size());
+    if (::mprotect(data, size, PROT_READ | PROT_EXEC) != 0)
+    {
+      ::munmap(data, size);
+      return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    return true;
+  }
+
+  void exec_memory::release() noexcept
+  {
+    if (!m_data)
+      return;
+
+    ::munmap(m_data, m_size);
+    m_data = {};
+    m_size = {};
+  }
+
+#else
+
+  bool exec_memory::assign(code_view) noexcept
+  {
+    return false;
+  }
+
+  void exec_memory::release() noexcept
+  {
+    m_data = {};
+    m_size = {};
+  }
+
+#endif
+
+  const void* exec_memory::entry() const noexcept
+  {
+    return m_data;
+  }
+}
@@ -0,0 +1,110 @@
+#include "eval/jit/native_jit.hpp"
+
+namespace tnac::eval
+{
+  // Special members
+
+  native_jit::~native_jit() noexcept = default;
+
+  native_jit::native_jit() noexcept = default;
+
+
+  // Public members
+
+  void native_jit::enable(bool on) noexcept
+  {
+    m_enabled = on && is_supported();
+  }
+
+  bool native_jit::is_enabled() const noexcept
+  {
+    return m_enabled;
+  }
+
+  void native_jit::set_threshold(counter threshold) noexcept
+  {
+    m_threshold = threshold;
+  }
+
+  native_jit::counter native_jit::threshold() const noexcept
+  {
+    return m_threshold;
+  }
+
+  void native_jit::on_enter(const ir::function& fn) noexcept
+  {
+    if (!m_enabled)
+      return;
+
+    auto&& state = m_states[&fn];
+    if (state.m_tier != tier::Counting || ++state.m_entries < m_threshold)
+      return;
+
+    compile(fn, state);
+  }
+
+  bool native_jit::is_native(const ir::function& fn) const noexcept
+  {
+    if (!m_enabled)
+      return false;
+
+    auto found = m_states.find(&fn);
+    return found != m_states.end() && found->second.m_tier == tier::Native;
+  }
+
+  native_jit::result native_jit::call(const ir::function& fn, arg_list args) noexcept
+  {
+    auto found = m_states.find(&fn);
+    UTILS_ASSERT(found != m_states.end());
+    auto&& state = found->second;
+    UTILS_ASSERT(state.m_tier == tier::Native);
+    UTILS_ASSERT(args.size() == fn.param_count());
+
+    auto entry = reinterpret_cast<entry_point>(const_cast<void*>(state.m_code.entry()));
+    int_type res{};
+    if (!entry(args.data(), &res, maxDepth))
+    {
+      ++m_stats.m_fallbacks;
+      if (++state.m_fallbacks >= maxFallbacks)
+      {
+        state.m_code.release();
+        state.m_tier = tier::Interpreted;
+      }
+      return {};
+    }
+
+    ++m_stats.m_calls;
+    if (state.m_ret == native_type::Bool)
+      return value{ res != int_type{} };
+
+    return value{ res };
+  }
+
+  void native_jit::clear() noexcept
+  {
+    m_states.clear();
+  }
+
+  const native_jit::stats& native_jit::counters() const noexcept
+  {
+    return m_stats;
+  }
+
+
+  // Private members
+
+  void native_jit::compile(const ir::function& fn, fn_state& state) noexcept
+  {
+    x64_translator translator;
+    if (translator.translate(fn) && state.m_code.assign(translator.code()))
+    {
+      state.m_tier = tier::Native;
+      state.m_ret = translator.ret_type();
+      ++m_stats.m_compiled;
+      return;
+    }
+
+    state.m_tier = tier::Interpreted;
+    ++m_stats.m_rejected;
+  }
+}
@@ -0,0 +1,291 @@
+#include "eval/jit/x64_emitter.hpp"
+
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    constexpr auto enc(x64_reg reg) noexcept
+    {
+      return static_cast<std::uint8_t>(reg);
+    }
+
+    constexpr auto low(x64_reg reg) noexcept
+    {
+      return static_cast<std::uint8_t>(enc(reg) & 0x7);
+    }
+
+    constexpr auto is_ext(x64_reg reg) noexcept
+    {
+      return (enc(reg) & 0x8) != 0;
+    }
+
+    //
+    // Registers used as opcode extensions in ModRM.reg
+    //
+    constexpr auto ext(std::uint8_t digit) noexcept
+    {
+      return static_cast<x64_reg>(digit);
+    }
+  }
+}
+
+namespace tnac::eval
+{
+  // Special members
+
+  x64_emitter::~x64_emitter() noexcept = default;
+
+  x64_emitter::x64_emitter() noexcept = default;
+
+
+  // Public members
+
+  x64_emitter::label x64_emitter::make_label() noexcept
+  {
+    const auto res = static_cast<label>(m_labels.size());
+    m_labels.push_back(unbound);
+    return res;
+  }
+
+  void x64_emitter::bind(label l) noexcept
+  {
+    UTILS_ASSERT(l < m_labels.size());
+    UTILS_ASSERT(m_labels[l] == unbound);
+    m_labels[l] = m_code.size();
+  }
+
+  bool x64_emitter::finalise() noexcept
+  {
+    for (auto&& fix : m_fixups)
+    {
+      const auto target = m_labels[fix.m_to];
+      if (target == unbound)
+        return false;
+
+      // Relative to the end of the rel32 field
+      const auto rel = static_cast<std::int64_t>(target) - static_cast<std::int64_t>(fix.m_at + 4);
+      const auto val = static_cast<std::uint32_t>(static_cast<std::int32_t>(rel));
+      for (auto idx = size_type{}; idx < 4; ++idx)
+        m_code[fix.m_at + idx] = static_cast<byte>(val >> (8 * idx));
+    }
+
+    m_fixups.clear();
+    return true;
+  }
+
+  const x64_emitter::buffer& x64_emitter::code() const noexcept
+  {
+    return m_code;
+  }
+
+  void x64_emitter::clear() noexcept
+  {
+    m_code.clear();
+    m_labels.clear();
+    m_fixups.clear();
+  }
+
+  void x64_emitter::push(x64_reg reg) noexcept
+  {
+    if (detail::is_ext(reg))
+      emit(0x41);
+    emit(0x50 | detail::low(reg));
+  }
+
+  void x64_emitter::pop(x64_reg reg) noexcept
+  {
+    if (detail::is_ext(reg))
+      emit(0x41);
+    emit(0x58 | detail::low(reg));
+  }
+
+  void x64_emitter::ret() noexcept
+  {
+    emit(0xC3);
+  }
+
+  void x64_emitter::mov(x64_reg dst, x64_reg src) noexcept
+  {
+    reg_op(0x89, dst, src);
+  }
+
+  void x64_emitter::mov(x64_reg dst, imm_type imm) noexcept
+  {
+    using lim = std::numeric_limits<std::int32_t>;
+    if (imm >= lim::min() && imm <= lim::max())
+    {
+      // Sign-extended imm32
+      rex(true, detail::ext(0), dst);
+      emit(0xC7);
+      modrm(detail::ext(0), dst);
+      emit32(static_cast<std::uint32_t>(imm));
+      return;
+    }
+
+    rex(true, detail::ext(0), dst);
+    emit(0xB8 | detail::low(dst));
+    const auto val = static_cast<std::uint64_t>(imm);
+    emit32(static_cast<std::uint32_t>(val));
+    emit32(static_cast<std::uint32_t>(val >> 32));
+  }
+
+  void x64_emitter::load(x64_reg dst, x64_reg base, disp_type disp) noexcept
+  {
+    rex(true, dst, base);
+    emit(0x8B);
+    modrm(dst, base, disp);
+  }
+
+  void x64_emitter::store(x64_reg base, disp_type disp, x64_reg src) noexcept
+  {
+    rex(true, src, base);
+    emit(0x89);
+    modrm(src, base, disp);
+  }
+
+  void x64_emitter::lea(x64_reg dst, x64_reg base, disp_type disp) noexcept
+  {
+    rex(true, dst, base);
+    emit(0x8D);
+    modrm(dst, base, disp);
+  }
+
+  void x64_emitter::add(x64_reg dst, x64_reg src) noexcept
+  {
+    reg_op(0x01, dst, src);
+  }
+
+  void x64_emitter::sub(x64_reg dst, x64_reg src) noexcept
+  {
+    reg_op(0x29, dst, src);
+  }
+
+  void x64_emitter::sub(x64_reg dst, disp_type imm) noexcept
+  {
+    rex(true, detail::ext(5), dst);
+    emit(0x81);
+    modrm(detail::ext(5), dst);
+    emit32(static_cast<std::uint32_t>(imm));
+  }
+
+  void x64_emitter::imul(x64_reg dst, x64_reg src) noexcept
+  {
+    rex(true, dst, src);
+    emit(0x0F);
+    emit(0xAF);
+    modrm(dst, src);
+  }
+
+  void x64_emitter::neg(x64_reg reg) noexcept
+  {
+    rex(true, detail::ext(3), reg);
+    emit(0xF7);
+    modrm(detail::ext(3), reg);
+  }
+
+  void x64_emitter::cmp(x64_reg lhs, x64_reg rhs) noexcept
+  {
+    reg_op(0x39, lhs, rhs);
+  }
+
+  void x64_emitter::test(x64_reg lhs, x64_reg rhs) noexcept
+  {
+    reg_op(0x85, lhs, rhs);
+  }
+
+  void x64_emitter::setcc(x64_cond cc, x64_reg dst) noexcept
+  {
+    // Without a REX prefix, encodings 4-7 refer to ah, ch, dh, and bh
+    rex(false, detail::ext(0), dst, detail::enc(dst) >= 4);
+    emit(0x0F);
+    emit(0x90 | static_cast<byte>(cc));
+    modrm(detail::ext(0), dst);
+
+    rex(true, dst, dst);
+    emit(0x0F);
+    emit(0xB6);
+    modrm(dst, dst);
+  }
+
+  void x64_emitter::cmov(x64_cond cc, x64_reg dst, x64_reg src) noexcept
+  {
+    rex(true, dst, src);
+    emit(0x0F);
+    emit(0x40 | static_cast<byte>(cc));
+    modrm(dst, src);
+  }
+
+  void x64_emitter::jmp(label l) noexcept
+  {
+    emit(0xE9);
+    rel32(l);
+  }
+
+  void x64_emitter::jcc(x64_cond cc, label l) noexcept
+  {
+    emit(0x0F);
+    emit(0x80 | static_cast<byte>(cc));
+    rel32(l);
+  }
+
+  void x64_emitter::call(label l) noexcept
+  {
+    emit(0xE8);
+    rel32(l);
+  }
+
+
+  // Private members
+
+  void x64_emitter::emit(byte b) noexcept
+  {
+    m_code.push_back(b);
+  }
+
+  void x64_emitter::emit32(std::uint32_t val) noexcept
+  {
+    for (auto idx = 0u; idx < 4u; ++idx)
+      emit(static_cast<byte>(val >> (8 * idx)));
+  }
+
+  void x64_emitter::rex(bool wide, x64_reg reg, x64_reg rm, bool force) noexcept
+  {
+    auto prefix = byte{ 0x40 };
+    if (wide)              prefix |= 0x8;
+    if (detail::is_ext(reg)) prefix |= 0x4;
+    if (detail::is_ext(rm))  prefix |= 0x1;
+
+    if (force || prefix != 0x40)
+      emit(prefix);
+  }
+
+  void x64_emitter::modrm(x64_reg reg, x64_reg rm) noexcept
+  {
+    emit(0xC0 | (detail::low(reg) << 3) | detail::low(rm));
+  }
+
+  void x64_emitter::modrm(x64_reg reg, x64_reg base, disp_type disp) noexcept
+  {
+    emit(0x80 | (detail::low(reg) << 3) | detail::low(base));
+
+    // rsp and r12 as a base require a SIB byte
+    if (detail::low(base) == detail::low(x64_reg::Rsp))
+      emit(0x24);
+
+    emit32(static_cast<std::uint32_t>(disp));
+  }
+
+  void x64_emitter::reg_op(byte opcode, x64_reg rm, x64_reg reg) noexcept
+  {
+    rex(true, reg, rm);
+    emit(opcode);
+    modrm(reg, rm);
+  }
+
+  void x64_emitter::rel32(label l) noexcept
+  {
+    UTILS_ASSERT(l < m_labels.size());
+    m_fixups.emplace_back(m_code.size(), l);
+    emit32({});
+  }
+}
@@ -0,0 +1,571 @@
+#include "eval/jit/x64_translator.hpp"
+#include "eval/value/traits.hpp"
+
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    //
+    // r12 and r13 are saved right below the frame base
+    //
+    constexpr auto savedRegsSize = x64_emitter::disp_type{ 16 };
+    constexpr auto slotSize = x64_emitter::disp_type{ 8 };
+
+    constexpr auto is_arithmetic(ir::op_code oc) noexcept
+    {
+      using enum ir::op_code;
+      return utils::eq_any(oc, Add, Sub, Mul);
+    }
+
+    constexpr auto is_comparison(ir::op_code oc) noexcept
+    {
+      using enum ir::op_code;
+      return utils::eq_any(oc, CmpE, CmpL, CmpLE, CmpNE, CmpG, CmpGE);
+    }
+
+    constexpr auto to_cond(ir::op_code oc) noexcept
+    {
+      using enum ir::op_code;
+      switch (oc)
+      {
+      case CmpL:  return x64_cond::L;
+      case CmpLE: return x64_cond::LE;
+      case CmpNE: return x64_cond::NE;
+      case CmpG:  return x64_cond::G;
+      case CmpGE: return x64_cond::GE;
+      default:    return x64_cond::E;
+      }
+    }
+
+    //
+    // Merges a type into the accumulated one
+    // Returns false on a conflict
+    //
+    bool join(native_type& acc, native_type type) noexcept
+    {
+      if (type == native_type::Unknown)
+        return true;
+
+      if (acc != native_type::Unknown && acc != type)
+        return false;
+
+      acc = type;
+      return true;
+    }
+  }
+}
+
+namespace tnac::eval
+{
+  // Special members
+
+  x64_translator::~x64_translator() noexcept = default;
+
+  x64_translator::x64_translator() noexcept = default;
+
+
+  // Public members
+
+  bool x64_translator::translate(const ir::function& fn) noexcept
+  {
+    if (fn.is_closure() || !fn.has_slots() || fn.param_count() > maxParams)
+      return false;
+
+    m_func = &fn;
+    m_order.clear();
+    auto&& entry = fn.entry();
+    m_order.push_back(&entry);
+    for (auto&& block : fn.blocks())
+    {
+      if (&block != &entry)
+        m_order.push_back(&block);
+    }
+
+    using enum native_type;
+    for (auto retType : { Int, Bool })
+    {
+      if (infer(retType))
+        return emit();
+    }
+
+    return false;
+  }
+
+  x64_translator::code_view x64_translator::code() const noexcept
+  {
+    return m_emitter.code();
+  }
+
+  native_type x64_translator::ret_type() const noexcept
+  {
+    return m_ret;
+  }
+
+
+  // Private members
+
+  bool x64_translator::infer(native_type retType) noexcept
+  {
+    m_ret = retType;
+    m_types.clear();
+
+    // Types only get added, so this terminates
+    for (auto changed = true; changed; )
+    {
+      changed = false;
+      for (auto block : m_order)
+      {
+        for (auto&& instr : *block)
+        {
+          if (!infer(instr, changed))
+            return false;
+        }
+      }
+    }
+
+    for (auto block : m_order)
+    {
+      for (auto&& instr : *block)
+      {
+        if (!validate(instr))
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool x64_translator::infer(const ir::instruction& instr, bool& changed) noexcept
+  {
+    using enum ir::op_code;
+    using enum native_type;
+    const auto oc = instr.opcode();
+
+    if (detail::is_arithmetic(oc) || utils::eq_any(oc, Neg, Plus))
+      return assign(instr[0], Int, changed);
+
+    if (detail::is_comparison(oc) || utils::eq_any(oc, CmpNot, CmpIs))
+      return assign(instr[0], Bool, changed);
+
+    switch (oc)
+    {
+    case Load:
+      if (instr[1].is_param())
+        return assign(instr[0], Int, changed);
+
+      return instr[1].is_register() && assign(instr[0], type_of(instr[1]), changed);
+
+    case Store:
+      return assign(instr[1], type_of(instr[0]), changed);
+
+    case Alloc:
+      return instr[0].is_register();
+
+    case Select:
+    {
+      auto res = Unknown;
+      return detail::join(res, type_of(instr[2])) &&
+             detail::join(res, type_of(instr[3])) &&
+             assign(instr[0], res, changed);
+    }
+
+    case Phi:
+    {
+      auto res = Unknown;
+      for (auto idx = ir::instruction::size_type{ 1 }; idx < instr.operand_count(); ++idx)
+      {
+        if (!detail::join(res, type_of(instr[idx].get_edge().value())))
+          return false;
+      }
+      return assign(instr[0], res, changed);
+    }
+
+    case Call:
+      return is_self_call(instr) && assign(instr[0], m_ret, changed);
+
+    case Jump:
+    case Ret:
+      return true;
+
+    default:
+      return false;
+    }
+  }
+
+  bool x64_translator::validate(const ir::instruction& instr) const noexcept
+  {
+    using enum ir::op_code;
+    using enum native_type;
+    const auto oc = instr.opcode();
+    if (oc == Alloc)
+      return true;
+
+    auto usable = [this](const ir::operand& op) noexcept
+      {
+        if (op.is_register())
+        {
+          auto&& reg = op.get_reg();
+          return !reg.is_global() && reg.has_slot() && m_types.contains(&reg);
+        }
+
+        return type_of(op) != Unknown;
+      };
+
+    for (auto idx = ir::instruction::size_type{}; idx < instr.operand_count(); ++idx)
+    {
+      auto&& op = instr[idx];
+      if (op.is_block() || op.is_param() || (oc == Call && idx == 1))
+        continue;
+
+      if (op.is_edge())
+      {
+        if (!usable(op.get_edge().value()))
+          return false;
+
+        continue;
+      }
+
+      if (!usable(op))
+        return false;
+
+      // Arguments must match the int assumption made for parameters
+      if (oc == Call && idx > 1 && type_of(op) != Int)
+        return false;
+    }
+
+    if (oc == Ret)
+      return type_of(instr[0]) == m_ret;
+
+    return true;
+  }
+
+  native_type x64_translator::type_of(const ir::operand& op) const noexcept
+  {
+    using enum native_type;
+    if (op.is_value())
+    {
+      auto&& val = op.get_value();
+      if (val.try_get<int_type>())
+        return Int;
+      if (val.try_get<bool_type>())
+        return Bool;
+      return Unknown;
+    }
+
+    if (!op.is_register())
+      return Unknown;
+
+    auto found = m_types.find(&op.get_reg());
+    return found != m_types.end() ? found->second : Unknown;
+  }
+
+  bool x64_translator::assign(const ir::operand& op, native_type type, bool& changed) noexcept
+  {
+    if (!op.is_register())
+      return false;
+
+    if (type == native_type::Unknown)
+      return true;
+
+    auto [item, isNew] = m_types.try_emplace(&op.get_reg(), type);
+    if (isNew)
+    {
+      changed = true;
+      return true;
+    }
+
+    return item->second == type;
+  }
+
+  bool x64_translator::is_self_call(const ir::instruction& instr) const noexcept
+  {
+    auto&& callee = instr[1];
+    if (!callee.is_value())
+      return false;
+
+    auto func = extract_function(callee.get_value());
+    return func && &(**func) == m_func &&
+           instr.operand_count() - 2 == m_func->param_count();
+  }
+
+  x64_translator::label x64_translator::label_of(const ir::basic_block& block) const noexcept
+  {
+    auto found = m_labels.find(&block);
+    UTILS_ASSERT(found != m_labels.end());
+    return found->second;
+  }
+
+  x64_translator::disp_type x64_translator::slot_disp(slot_type slot) const noexcept
+  {
+    return -(detail::savedRegsSize + detail::slotSize * (static_cast<disp_type>(slot) + 1));
+  }
+
+  bool x64_translator::emit() noexcept
+  {
+    m_emitter.clear();
+    m_labels.clear();
+    m_start = m_emitter.make_label();
+    m_fail  = m_emitter.make_label();
+    m_exit  = m_emitter.make_label();
+    for (auto block : m_order)
+      m_labels.emplace(block, m_emitter.make_label());
+
+    // Slots, and then outgoing arguments of self calls
+    // After the prologue pushes, rsp is 16-aligned, and so must be the frame
+    const auto slotCount = size_type{ m_func->slot_count() } + m_func->param_count();
+    const auto frameSize = (slotCount * sizeof(int_type) + 15) / 16 * 16;
+    using lim = std::numeric_limits<disp_type>;
+    if (frameSize > static_cast<size_type>(lim::max()))
+      return false;
+
+    m_emitter.bind(m_start);
+    emit_prologue(frameSize);
+    for (auto block : m_order)
+    {
+      m_emitter.bind(label_of(*block));
+      for (auto&& instr : *block)
+        emit(instr);
+    }
+
+    using enum x64_reg;
+    m_emitter.bind(m_fail);
+    m_emitter.mov(Rax, x64_emitter::imm_type{});
+    m_emitter.bind(m_exit);
+    emit_epilogue();
+    return m_emitter.finalise();
+  }
+
+  void x64_translator::emit(const ir::instruction& instr) noexcept
+  {
+    using enum ir::op_code;
+    using enum x64_reg;
+    const auto oc = instr.opcode();
+
+    if (detail::is_arithmetic(oc))
+    {
+      load(Rax, instr[1]);
+      load(Rcx, instr[2]);
+      if (oc == Add)
+        m_emitter.add(Rax, Rcx);
+      else if (oc == Sub)
+        m_emitter.sub(Rax, Rcx);
+      else
+        m_emitter.imul(Rax, Rcx);
+      store(instr[0], Rax);
+      return;
+    }
+
+    if (detail::is_comparison(oc))
+    {
+      load(Rax, instr[1]);
+      load(Rcx, instr[2]);
+      m_emitter.cmp(Rax, Rcx);
+      m_emitter.setcc(detail::to_cond(oc), Rax);
+      store(instr[0], Rax);
+      return;
+    }
+
+    switch (oc)
+    {
+    case Load:
+      // Parameters are copied into their slots by the prologue
+      if (!instr[1].is_param())
+      {
+        load(Rax, instr[1]);
+        store(instr[0], Rax);
+      }
+      break;
+
+    case Store:
+      load(Rax, instr[0]);
+      store(instr[1], Rax);
+      break;
+
+    case Neg:
+      load(Rax, instr[1]);
+      m_emitter.neg(Rax);
+      store(instr[0], Rax);
+      break;
+
+    case Plus:
+      load(Rax, instr[1]);
+      store(instr[0], Rax);
+      break;
+
+    case CmpNot:
+    case CmpIs:
+      load(Rax, instr[1]);
+      m_emitter.test(Rax, Rax);
+      m_emitter.setcc(oc == CmpNot ? x64_cond::E : x64_cond::NE, Rax);
+      store(instr[0], Rax);
+      break;
+
+    case Select:
+      load(Rax, instr[1]);
+      load(Rcx, instr[2]);
+      load(Rdx, instr[3]);
+      m_emitter.test(Rax, Rax);
+      m_emitter.cmov(x64_cond::E, Rcx, Rdx);
+      store(instr[0], Rcx);
+      break;
+
+    case Call:
+      emit_call(instr);
+      break;
+
+    case Jump:
+      emit_jump(instr);
+      break;
+
+    case Ret:
+      load(Rax, instr[0]);
+      m_emitter.store(R12, {}, Rax);
+      m_emitter.mov(Rax, x64_emitter::imm_type{ 1 });
+      m_emitter.jmp(m_exit);
+      break;
+
+    default:
+      // Alloc needs no code, phis are resolved on edges
+      break;
+    }
+  }
+
+  void x64_translator::emit_prologue(size_type frameSize) noexcept
+  {
+    using enum x64_reg;
+    m_emitter.push(Rbp);
+    m_emitter.mov(Rbp, Rsp);
+    m_emitter.push(R12);
+    m_emitter.push(R13);
+    m_emitter.sub(Rsp, static_cast<disp_type>(frameSize));
+
+    // r12 points to the result, r13 holds the remaining depth
+    m_emitter.mov(R12, Rsi);
+    m_emitter.mov(R13, Rdx);
+    m_emitter.test(R13, R13);
+    m_emitter.jcc(x64_cond::E, m_fail);
+
+    // Parameter registers are pre-assigned to the first slots
+    const auto paramCount = m_func->param_count();
+    for (auto idx = size_type{}; idx < paramCount; ++idx)
+    {
+      m_emitter.load(Rax, Rdi, static_cast<disp_type>(idx) * detail::slotSize);
+      m_emitter.store(Rbp, slot_disp(static_cast<slot_type>(idx)), Rax);
+    }
+  }
+
+  void x64_translator::emit_epilogue() noexcept
+  {
+    using enum x64_reg;
+    m_emitter.lea(Rsp, Rbp, -detail::savedRegsSize);
+    m_emitter.pop(R13);
+    m_emitter.pop(R12);
+    m_emitter.pop(Rbp);
+    m_emitter.ret();
+  }
+
+  void x64_translator::emit_jump(const ir::instruction& instr) noexcept
+  {
+    auto&& from = instr.owner_block();
+    if (instr.operand_count() == 1)
+    {
+      auto&& to = instr[0].get_block();
+      emit_edge(from, to);
+      m_emitter.jmp(label_of(to));
+      return;
+    }
+
+    using enum x64_reg;
+    auto&& onTrue = instr[1].get_block();
+    auto&& onFalse = instr[2].get_block();
+    const auto falseEdge = m_emitter.make_label();
+
+    load(Rax, instr[0]);
+    m_emitter.test(Rax, Rax);
+    m_emitter.jcc(x64_cond::E, falseEdge);
+    emit_edge(from, onTrue);
+    m_emitter.jmp(label_of(onTrue));
+
+    m_emitter.bind(falseEdge);
+    emit_edge(from, onFalse);
+    m_emitter.jmp(label_of(onFalse));
+  }
+
+  void x64_translator::emit_edge(const ir::basic_block& from, const ir::basic_block& to) noexcept
+  {
+    // Phis of a loop header can read each other along the back edge,
+    // so all values go to the stack before any of them is stored
+    std::vector<const ir::instruction*> targets;
+    for (auto&& instr : to)
+    {
+      if (instr.opcode() != ir::op_code::Phi)
+        continue;
+
+      for (auto idx = ir::instruction::size_type{ 1 }; idx < instr.operand_count(); ++idx)
+      {
+        auto&& edge = instr[idx].get_edge();
+        if (&edge.incoming() != &from)
+          continue;
+
+        load(x64_reg::Rax, edge.value());
+        m_emitter.push(x64_reg::Rax);
+        targets.push_back(&instr);
+        break;
+      }
+    }
+
+    for (auto instr : targets | std::views::reverse)
+    {
+      m_emitter.pop(x64_reg::Rax);
+      store((*instr)[0], x64_reg::Rax);
+    }
+  }
+
+  void x64_translator::emit_call(const ir::instruction& instr) noexcept
+  {
+    using enum x64_reg;
+    const auto argCount = instr.operand_count() - 2;
+    for (auto idx = size_type{}; idx < argCount; ++idx)
+    {
+      load(Rax, instr[idx + 2]);
+      m_emitter.store(Rsp, static_cast<disp_type>(idx) * detail::slotSize, Rax);
+    }
+
+    // The callee writes its result directly into the result slot
+    m_emitter.mov(Rdi, Rsp);
+    m_emitter.lea(Rsi, Rbp, slot_disp(instr[0].get_reg().slot()));
+    m_emitter.lea(Rdx, R13, -1);
+    m_emitter.call(m_start);
+
+    // Failures propagate all the way up
+    m_emitter.test(Rax, Rax);
+    m_emitter.jcc(x64_cond::E, m_fail);
+  }
+
+  void x64_translator::load(x64_reg dst, const ir::operand& op) noexcept
+  {
+    if (op.is_register())
+    {
+      m_emitter.load(dst, x64_reg::Rbp, slot_disp(op.get_reg().slot()));
+      return;
+    }
+
+    UTILS_ASSERT(op.is_value());
+    auto&& val = op.get_value();
+    if (auto boolVal = val.try_get<bool_type>())
+    {
+      m_emitter.mov(dst, x64_emitter::imm_type{ *boolVal });
+      return;
+    }
+
+    auto intVal = val.try_get<int_type>();
+    UTILS_ASSERT(intVal);
+    m_emitter.mov(dst, static_cast<x64_emitter::imm_type>(*intVal));
+  }
+
+  void x64_translator::store(const ir::operand& op, x64_reg src) noexcept
+  {
+    UTILS_ASSERT(op.is_register());
+    m_emitter.store(x64_reg::Rbp, slot_disp(op.get_reg().slot()), src);
+  }
+}
@@ -0,0 +1,229 @@
+#include "eval/memo_cache.hpp"
+#include "eval/value/traits.hpp"
+#include "eval/value/type_impl.hpp"
+#include "cfg/ir/ir.hpp"
+
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    using hash_type = memo_cache::hash_type;
+    using hash_opt  = std::optional<hash_type>;
+
+    constexpr auto combine(hash_type seed, hash_type h) noexcept
+    {
+      return seed ^ (h + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+    }
+
+    template <typename T>
+    auto hash_of(const T& val) noexcept
+    {
+      return std::hash<T>{}(val);
+    }
+
+    //
+    // Hashes a scalar value
+    // Functions and arrays have no stable identity as arguments and are rejected
+    //
+    hash_opt hash_value(const value& val) noexcept
+    {
+      const auto seed = static_cast<hash_type>(val.id());
+      return on_value(val, utils::visitor
+        {
+          [seed](bool_type v) noexcept -> hash_opt { return combine(seed, hash_of(v)); },
+          [seed](int_type v) noexcept -> hash_opt { return combine(seed, hash_of(v)); },
+          [seed](float_type v) noexcept -> hash_opt { return combine(seed, hash_of(v)); },
+          [seed](const complex_type& v) noexcept -> hash_opt
+          {
+            return combine(combine(seed, hash_of(v.real())), hash_of(v.imag()));
+          },
+          [seed](const fraction_type& v) noexcept -> hash_opt
+          {
+            auto res = combine(seed, hash_of(v.num()));
+            res = combine(res, hash_of(v.denom()));
+            return combine(res, hash_of(v.sign()));
+          },
+          [](const auto&) noexcept -> hash_opt { return {}; }
+        });
+    }
+  }
+}
+
+namespace tnac::eval
+{
+  // Special members
+
+  memo_cache::~memo_cache() noexcept = default;
+
+  memo_cache::memo_cache() noexcept = default;
+
+
+  // Public members
+
+  void memo_cache::set_mode(memo_mode mode) noexcept
+  {
+    m_mode = mode;
+    if (m_mode == memo_mode::Off)
+      clear();
+  }
+
+  memo_mode memo_cache::mode() const noexcept
+  {
+    return m_mode;
+  }
+
+  void memo_cache::mark(const ir::function& fn) noexcept
+  {
+    m_marked.insert(&fn);
+  }
+
+  void memo_cache::forbid(const ir::function& fn) noexcept
+  {
+    m_purity.insert_or_assign(&fn, purity::Impure);
+  }
+
+  bool memo_cache::wants(const ir::function& fn) noexcept
+  {
+    using enum memo_mode;
+    if (m_mode == Off || (m_mode == Marked && !m_marked.contains(&fn)))
+      return false;
+
+    auto [item, isNew] = m_purity.try_emplace(&fn, purity::Pure);
+    if (isNew)
+      item->second = classify(fn);
+
+    return item->second == purity::Pure;
+  }
+
+  std::optional<memo_cache::key> memo_cache::make_key(const ir::function& fn, arg_list args) noexcept
+  {
+    auto res = detail::combine(hash_type{}, detail::hash_of(&fn));
+    for (auto&& arg : args)
+    {
+      auto argHash = detail::hash_value(arg);
+      if (!argHash)
+        return {};
+
+      res = detail::combine(res, *argHash);
+    }
+
+    return key{ &fn, std::move(args), res };
+  }
+
+  const value* memo_cache::find(const key& k) noexcept
+  {
+    auto found = m_entries.find(k);
+    if (found == m_entries.end())
+    {
+      ++m_stats.m_misses;
+      return {};
+    }
+
+    ++m_stats.m_hits;
+    return &found->second;
+  }
+
+  void memo_cache::insert(key k, value res) noexcept
+  {
+    if (!m_capacity || !detail::hash_value(res))
+      return;
+
+    if (m_entries.contains(k))
+      return;
+
+    if (m_ring.size() == m_capacity)
+      evict();
+
+    auto [item, _] = m_entries.try_emplace(std::move(k), std::move(res));
+    if (m_ring.size() < m_capacity)
+    {
+      m_ring.push_back(&item->first);
+      return;
+    }
+
+    // The evicted slot is reused by the newcomer, which makes it the youngest entry
+    m_ring[m_oldest] = &item->first;
+    m_oldest = (m_oldest + 1) % m_capacity;
+  }
+
+  void memo_cache::clear() noexcept
+  {
+    m_entries.clear();
+    m_ring.clear();
+    m_oldest = {};
+  }
+
+  void memo_cache::set_capacity(size_type cap) noexcept
+  {
+    m_capacity = cap;
+    clear();
+  }
+
+  memo_cache::size_type memo_cache::capacity() const noexcept
+  {
+    return m_capacity;
+  }
+
+  memo_cache::size_type memo_cache::size() const noexcept
+  {
+    return m_entries.size();
+  }
+
+  const memo_cache::stats& memo_cache::counters() const noexcept
+  {
+    return m_stats;
+  }
+
+
+  // Private members
+
+  memo_cache::purity memo_cache::classify(const ir::function& fn) noexcept
+  {
+    // Closures depend on their captured data, which can change between calls
+    if (fn.is_closure())
+      return purity::Impure;
+
+    using enum ir::op_code;
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        if (utils::eq_any(instr.opcode(), StreamRead, StreamWrite, Bind))
+          return purity::Impure;
+      }
+    }
+
+    return purity::Pure;
+  }
+
+  void memo_cache::evict() noexcept
+  {
+    UTILS_ASSERT(m_oldest < m_ring.size());
+    auto found = m_entries.find(*m_ring[m_oldest]);
+    UTILS_ASSERT(found != m_entries.end());
+    m_entries.erase(found);
+    ++m_stats.m_evictions;
+  }
+}
+
+namespace tnac::eval // hashing
+{
+  memo_cache::hash_type memo_cache::key_hash::operator()(const key& k) const noexcept
+  {
+    return k.m_hash;
+  }
+
+  bool memo_cache::key_eq::operator()(const key& l, const key& r) const noexcept
+  {
+    if (l.m_func != r.m_func || l.m_hash != r.m_hash || l.m_args.size() != r.m_args.size())
+      return false;
+
+    for (auto li = l.m_args.begin(), ri = r.m_args.begin(); li != l.m_args.end(); ++li, ++ri)
+    {
+      if (li->id() != ri->id() || !to_bool(li->binary(val_ops::Equal, *ri)))
+        return false;
+    }
+
+    return true;
+  }
+}
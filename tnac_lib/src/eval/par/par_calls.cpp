@@ -0,0 +1,266 @@
+#include "eval/par/par_calls.hpp"
+#include "eval/ir_evaluator.hpp"
+#include "eval/value/type_impl.hpp"
+#include "cfg/ir/ir.hpp"
+
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    auto worker_count() noexcept
+    {
+      constexpr auto fallback = std::size_t{ 2 };
+      const auto hw = std::size_t{ std::thread::hardware_concurrency() };
+      return hw ? hw : fallback;
+    }
+
+    //
+    // Checks whether an instruction touches state shared between evaluators
+    //
+    bool has_side_effects(const ir::instruction& instr) noexcept
+    {
+      using enum ir::op_code;
+      return utils::eq_any(instr.opcode(),
+        StreamRead, StreamWrite,
+        Bind, DynBind, StBind,
+        StructAlloc, StoreElem, GetElem);
+    }
+  }
+}
+
+namespace tnac::eval
+{
+  // Special members
+
+  par_calls::~par_calls() noexcept = default;
+
+  par_calls::par_calls() noexcept = default;
+
+
+  // Public members
+
+  void par_calls::enable(bool on) noexcept
+  {
+    m_enabled = on;
+  }
+
+  bool par_calls::is_enabled() const noexcept
+  {
+    return m_enabled;
+  }
+
+  par_calls::result par_calls::call(ir::cfg& cfg, store& vals, array_wrapper& arr, arg_list args) noexcept
+  {
+    if (!m_enabled)
+      return {};
+
+    for (auto&& arg : args)
+    {
+      if (!is_transferable(arg))
+        return {};
+    }
+
+    plan p;
+    task_list tasks;
+    if (!make_plan(arr, args.size(), p, tasks))
+      return {};
+
+    const auto taskCount = tasks.size();
+    if (taskCount < minTasks)
+      return {};
+
+    init_workers(cfg);
+    result_list results(taskCount);
+    m_pool->run(taskCount, [&](size_type workerIdx, size_type taskIdx) noexcept
+      {
+        auto&& ev = *m_workers[workerIdx].m_eval;
+        ev.enter(function_type{ *tasks[taskIdx] });
+        for (auto&& arg : args)
+          ev.add_arg(arg);
+
+        ev.evaluate_current();
+        results[taskIdx] = ev.result();
+        ev.clear_env();
+        m_workers[workerIdx].m_store->maybe_collect();
+      });
+
+    ++m_stats.m_batches;
+    m_stats.m_tasks += taskCount;
+
+    // Results referring to worker stores can't leave the worker.
+    // Callees are pure, so running the call again sequentially is safe
+    for (auto&& res : results)
+    {
+      if (!is_transferable(res))
+      {
+        ++m_stats.m_fallbacks;
+        return {};
+      }
+    }
+
+    return assemble(vals, p, results);
+  }
+
+  void par_calls::clear() noexcept
+  {
+    m_purity.clear();
+  }
+
+  const par_calls::stats& par_calls::counters() const noexcept
+  {
+    return m_stats;
+  }
+
+
+  // Private members
+
+  bool par_calls::make_plan(array_wrapper& arr, size_type argCount, plan& p, task_list& tasks) noexcept
+  {
+    for (auto&& elem : arr)
+    {
+      if (auto subarr = extract_array(elem))
+      {
+        // Numbers only, nothing to call
+        if (!subarr->data().is_boxed())
+          continue;
+
+        plan_item item;
+        if (!make_plan(*subarr, argCount, item.m_nested, tasks))
+          return false;
+
+        p.emplace_back(std::move(item));
+        continue;
+      }
+
+      auto fn = extract_function(elem);
+      if (!fn || (*fn)->param_count() != argCount)
+        continue;
+
+      // Built-ins have no code for workers to enter
+      if (fn->is_closure() || (*fn)->is_intrinsic() || !is_pure(**fn))
+        return false;
+
+      plan_item item;
+      item.m_task = tasks.size();
+      item.m_isCall = true;
+      p.emplace_back(std::move(item));
+      tasks.push_back(&(**fn));
+    }
+
+    return true;
+  }
+
+  bool par_calls::is_transferable(const value& val) noexcept
+  {
+    if (extract_array(val))
+      return false;
+
+    if (auto fn = extract_function(val))
+      return !fn->is_closure() && is_pure(**fn);
+
+    return true;
+  }
+
+  bool par_calls::is_pure(ir::function& fn) noexcept
+  {
+    if (auto known = m_purity.find(&fn); known != m_purity.end())
+      return known->second;
+
+    fn_set visited;
+    const auto res = scan(fn, visited);
+    m_purity.emplace(&fn, res);
+    return res;
+  }
+
+  bool par_calls::scan(ir::function& fn, fn_set& visited) noexcept
+  {
+    if (!visited.emplace(&fn).second)
+      return true;
+
+    if (auto known = m_purity.find(&fn); known != m_purity.end())
+      return known->second;
+
+    if (fn.is_closure())
+    {
+      m_purity.emplace(&fn, false);
+      return false;
+    }
+
+    // Workers must not race to assign slots on their first entry
+    if (!fn.has_slots())
+      fn.assign_slots();
+
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        if (detail::has_side_effects(instr))
+        {
+          m_purity.emplace(&fn, false);
+          return false;
+        }
+
+        for (auto idx = ir::instruction::size_type{}; idx < instr.operand_count(); ++idx)
+        {
+          auto&& op = instr[idx];
+          if (op.is_record())
+            return false;
+
+          if (op.is_register() && op.get_reg().is_global())
+            return false;
+
+          if (!op.is_value())
+            continue;
+
+          // Interned arrays are shared, and their reference counters aren't atomic
+          auto&& val = op.get_value();
+          if (extract_array(val))
+            return false;
+
+          if (auto callee = extract_function(val); callee && !scan(**callee, visited))
+            return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  void par_calls::init_workers(ir::cfg& cfg) noexcept
+  {
+    if (m_pool)
+      return;
+
+    const auto count = detail::worker_count();
+    m_workers.resize(count);
+    for (auto&& w : m_workers)
+    {
+      w.m_store = std::make_unique<store>();
+      w.m_eval  = std::make_unique<ir_eval>(cfg, *w.m_store, nullptr);
+    }
+
+    m_pool = std::make_unique<worker_pool>(count);
+  }
+
+  value par_calls::assemble(store& vals, const plan& p, result_list& results) noexcept
+  {
+    auto&& data = vals.allocate_array(p.size());
+    for (auto&& item : p)
+    {
+      if (item.m_isCall)
+      {
+        data.add(std::move(results[item.m_task]));
+        continue;
+      }
+
+      // Nested arrays without calls are dropped, same as sequential calls do
+      auto nested = assemble(vals, item.m_nested, results);
+      if (auto nestedArr = extract_array(nested); nestedArr && !nestedArr->size())
+        continue;
+
+      data.add(std::move(nested));
+    }
+
+    return value::array(vals.wrap(data));
+  }
+}
@@ -0,0 +1,57 @@
+#include "eval/par/par_elems.hpp"
+
+namespace tnac::eval
+{
+  // Special members
+
+  par_elems::~par_elems() noexcept = default;
+
+  par_elems::par_elems() noexcept = default;
+
+
+  // Public members
+
+  void par_elems::configure(const config& cfg) noexcept
+  {
+    const auto restart = cfg.m_threads != m_cfg.m_threads;
+    m_cfg = cfg;
+    if (!m_cfg.m_grain)
+      m_cfg.m_grain = defaultGrain;
+
+    if (restart)
+      m_pool.reset();
+  }
+
+  const par_elems::config& par_elems::settings() const noexcept
+  {
+    return m_cfg;
+  }
+
+  bool par_elems::wants(size_type count) const noexcept
+  {
+    // A single chunk has nothing to run alongside
+    return m_cfg.m_threads > 1 && count >= m_cfg.m_minSize && count > m_cfg.m_grain;
+  }
+
+  void par_elems::run(size_type count, range_job job) noexcept
+  {
+    if (!m_pool)
+      m_pool = std::make_unique<worker_pool>(m_cfg.m_threads);
+
+    const auto grain = m_cfg.m_grain;
+    const auto taskCount = (count + grain - 1) / grain;
+    m_pool->run(taskCount, [&](size_type, size_type task) noexcept
+      {
+        const auto from = task * grain;
+        job(from, std::min(from + grain, count));
+      });
+
+    ++m_stats.m_batches;
+    m_stats.m_tasks += taskCount;
+  }
+
+  const par_elems::stats& par_elems::counters() const noexcept
+  {
+    return m_stats;
+  }
+}
@@ -0,0 +1,71 @@
+#include "eval/par/worker_pool.hpp"
+
+namespace tnac::eval
+{
+  // Special members
+
+  worker_pool::~worker_pool() noexcept
+  {
+    {
+      std::scoped_lock lock{ m_lock };
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    m_threads.clear();
+  }
+
+  worker_pool::worker_pool(size_type workerCount) noexcept
+  {
+    UTILS_ASSERT(workerCount);
+    m_threads.reserve(workerCount);
+    for (auto idx = size_type{}; idx < workerCount; ++idx)
+      m_threads.emplace_back([this, idx] { work(idx); });
+  }
+
+
+  // Public members
+
+  worker_pool::size_type worker_pool::size() const noexcept
+  {
+    return m_threads.size();
+  }
+
+  void worker_pool::run(size_type taskCount, job j) noexcept
+  {
+    if (!taskCount)
+      return;
+
+    std::unique_lock lock{ m_lock };
+    m_job = std::move(j);
+    m_next = {};
+    m_taskCount = taskCount;
+    m_pending = taskCount;
+    m_wake.notify_all();
+
+    m_done.wait(lock, [this] { return !m_pending; });
+    m_job = {};
+    m_taskCount = {};
+  }
+
+
+  // Private members
+
+  void worker_pool::work(size_type worker) noexcept
+  {
+    std::unique_lock lock{ m_lock };
+    for (;;)
+    {
+      m_wake.wait(lock, [this] { return m_stop || m_next < m_taskCount; });
+      if (m_stop)
+        return;
+
+      const auto task = m_next++;
+      lock.unlock();
+      m_job(worker, task);
+      lock.lock();
+
+      if (!--m_pending)
+        m_done.notify_one();
+    }
+  }
+}
@@ -4,25 +4,79 @@ namespace tnac::eval
 {
   // Special members
 
-  call_stack::~call_stack() noexcept = default;
+  call_stack::~call_stack() noexcept
+  {
+    // Frames release their slots, so they must go before the segments
+    while (pop_frame());
+    m_frames.clear();
+  }
 
   call_stack::call_stack() noexcept = default;
 
 
   // Public members
 
-  stack_frame& call_stack::make_frame(eval::function_type func, param_count argSz, entity_id jmp) noexcept
+  stack_frame& call_stack::make_frame(eval::function_type func, slot_count slotSz, entity_id jmp) noexcept
   {
-    return m_frames.emplace_back(std::move(func), argSz, jmp);
+    auto prev = m_depth ? &**m_frames[m_depth - 1] : nullptr;
+    m_marks.push_back(m_top);
+    auto slots = reserve(slotSz);
+
+    if (m_depth == m_frames.size())
+      m_frames.push_back(std::make_unique<frame_slot>());
+
+    auto&& frame = *m_frames[m_depth++];
+    return frame.emplace(std::move(func), slots, prev, jmp);
   }
 
   stack_frame* call_stack::pop_frame() noexcept
   {
-    if (m_frames.empty())
+    if (!m_depth)
       return {};
 
-    auto res = m_frames.back().prev();
-    m_frames.pop_back();
+    auto&& frame = *m_frames[--m_depth];
+    auto res = frame->prev();
+    frame.reset();
+
+    UTILS_ASSERT(!m_marks.empty());
+    m_top = m_marks.back();
+    m_marks.pop_back();
+    return res;
+  }
+
+  call_stack::size_type call_stack::depth() const noexcept
+  {
+    return m_depth;
+  }
+
+
+  // Private members
+
+  stack_frame::slot_span call_stack::reserve(slot_count count) noexcept
+  {
+    const auto fits = !m_segments.empty() &&
+      m_top.m_offset + count <= m_segments[m_top.m_segment].m_size;
+
+    if (!fits)
+    {
+      // Segments past the current one hold no live frames, so they are reused,
+      // or replaced if too small
+      const auto next = m_segments.empty() ? size_type{} : m_top.m_segment + 1;
+      if (next == m_segments.size())
+        m_segments.emplace_back();
+
+      if (auto&& seg = m_segments[next]; !seg.m_data || seg.m_size < count)
+      {
+        seg.m_size = std::max(segmentSize, size_type{ count });
+        seg.m_data = std::make_unique<value[]>(seg.m_size);
+      }
+
+      m_top = { next, size_type{} };
+    }
+
+    auto&& seg = m_segments[m_top.m_segment];
+    stack_frame::slot_span res{ seg.m_data.get() + m_top.m_offset, count };
+    m_top.m_offset += count;
     return res;
   }
-}
\ No newline at end of file
+}
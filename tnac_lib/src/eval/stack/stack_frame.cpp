@@ -5,18 +5,27 @@ namespace tnac::eval
 {
   // Special members
 
-  stack_frame::~stack_frame() noexcept = default;
+  stack_frame::~stack_frame() noexcept
+  {
+    // The slot region gets reused by subsequent calls, so we release its values here
+    std::ranges::fill(m_slots, value{});
+  }
 
-  stack_frame::stack_frame(eval::function_type func, param_count argSz, entity_id jmpBack) noexcept :
+  stack_frame::stack_frame(eval::function_type func, slot_span slots, stack_frame* prev, entity_id jmpBack) noexcept :
+    m_slots{ slots },
+    m_prev{ prev },
     m_func{ std::move(func) },
     m_jmp{ jmpBack }
-  {
-    m_mem.reserve(argSz);
-  }
+  { }
 
 
   // Public members
 
+  stack_frame* stack_frame::prev() const noexcept
+  {
+    return m_prev;
+  }
+
   stack_frame::name_type stack_frame::name() const noexcept
   {
     return m_func->name();
@@ -29,33 +38,63 @@ namespace tnac::eval
 
   entity_id stack_frame::add_arg(value argVal) noexcept
   {
-    auto res = entity_id{ m_mem.size() };
-    m_mem.emplace_back(std::move(argVal));
+    const auto res = entity_id{ m_argCount++ };
+    store(res, std::move(argVal));
     return res;
   }
 
   void stack_frame::store(entity_id id, value val) noexcept
   {
-    UTILS_ASSERT(*id < m_mem.size());
-    m_mem[*id] = std::move(val);
+    const auto idx = *id;
+    UTILS_ASSERT(id != entity_id{});
+    if (idx < m_slots.size())
+    {
+      m_slots[idx] = std::move(val);
+      return;
+    }
+
+    const auto spillIdx = idx - m_slots.size();
+    if (spillIdx >= m_spill.size())
+      m_spill.resize(spillIdx + 1);
+
+    m_spill[spillIdx] = std::move(val);
   }
 
   entity_id stack_frame::allocate() noexcept
   {
-    const auto idx = m_mem.size();
-    m_mem.emplace_back();
+    const auto idx = size();
+    m_spill.emplace_back();
     return idx;
   }
 
+  stack_frame::size_type stack_frame::size() const noexcept
+  {
+    return m_slots.size() + m_spill.size();
+  }
+
   value stack_frame::value_for(entity_id id) const noexcept
   {
-    const auto idx = *id;
-    return (idx < m_mem.size()) ? m_mem[idx] : value{};
+    return value_ref(id);
+  }
+
+  const value& stack_frame::value_ref(entity_id id) const noexcept
+  {
+    auto res = try_get(id);
+    return res ? *res : value::invalid();
+  }
+
+  value stack_frame::take(entity_id id) noexcept
+  {
+    auto res = try_get(id);
+    if (!res)
+      return {};
+
+    return std::move(*res);
   }
 
   value stack_frame::value_for_this() const noexcept
   {
-    return m_this != entity_id{} ? m_mem[*m_this] : value{};
+    return m_this;
   }
 
   void stack_frame::redirrect(entity_id jmp) noexcept
@@ -80,6 +119,23 @@ namespace tnac::eval
 
   void stack_frame::init_this_reg(value val) noexcept
   {
-    m_this = add_arg(std::move(val));
+    m_this = std::move(val);
+  }
+
+
+  // Private members
+
+  const value* stack_frame::try_get(entity_id id) const noexcept
+  {
+    const auto idx = *id;
+    if (idx < m_slots.size())
+      return &m_slots[idx];
+
+    const auto spillIdx = idx - m_slots.size();
+    return spillIdx < m_spill.size() ? &m_spill[spillIdx] : nullptr;
+  }
+  value* stack_frame::try_get(entity_id id) noexcept
+  {
+    return FROM_CONST(try_get, id);
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,350 @@
+#include "eval/value/intrinsics.hpp"
+#include "eval/value/traits.hpp"
+#include "eval/value/type_impl.hpp"
+#include "eval/value/value_store.hpp"
+#include "eval/value/simd.hpp"
+
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    using size_type = array_wrapper::size_type;
+    template <typename T> using elem_buf = array_data::packed_buf<T>;
+
+    constexpr std::array arrParams{ string_t{ "arr" } };
+    constexpr std::array dotParams{ string_t{ "lhs" }, string_t{ "rhs" } };
+    constexpr std::array reduceParams{ string_t{ "arr" }, string_t{ "fn" } };
+    constexpr std::array sliceParams{ string_t{ "arr" }, string_t{ "from" }, string_t{ "count" }, string_t{ "step" } };
+
+    constexpr std::array intrinsicTable
+    {
+      intrinsic_info{ intrinsic::Sum,       "sum",        arrParams },
+      intrinsic_info{ intrinsic::Product,   "product",    arrParams },
+      intrinsic_info{ intrinsic::Min,       "min",        arrParams },
+      intrinsic_info{ intrinsic::Max,       "max",        arrParams },
+      intrinsic_info{ intrinsic::Sort,      "sort",       arrParams },
+      intrinsic_info{ intrinsic::Reverse,   "reverse",    arrParams },
+      intrinsic_info{ intrinsic::Slice,     "slice",      sliceParams },
+      intrinsic_info{ intrinsic::Dot,       "dot",        dotParams },
+      intrinsic_info{ intrinsic::PrefixSum, "prefix_sum", arrParams },
+      intrinsic_info{ intrinsic::Reduce,    "reduce",     reduceParams },
+    };
+
+    const intrinsic_info* info_of(intrinsic id) noexcept
+    {
+      for (auto&& info : intrinsicTable)
+      {
+        if (info.m_id == id)
+          return &info;
+      }
+
+      return nullptr;
+    }
+
+    //
+    // Returns the array passed as an argument
+    // Anything else is wrapped into a single element array, which the holder keeps alive
+    //
+    array_wrapper& as_array(store& vs, const value& arg, value& holder) noexcept
+    {
+      if (auto aw = extract_array(arg))
+        return *aw;
+
+      auto&& data = vs.allocate_array(1);
+      data.add(arg);
+      auto&& res = vs.wrap(data);
+      holder = value::array(res);
+      return res;
+    }
+
+    //
+    // Reads an element without boxing the underlying data
+    //
+    value elem_at(const array_wrapper& aw, size_type idx) noexcept
+    {
+      return aw.data().read_at(aw.index_of(idx));
+    }
+
+    //
+    // Returns the elements of the given type
+    // The result is empty if the array doesn't hold them
+    //
+    template <packable T>
+    std::span<const T> elems_of(const array_wrapper& aw, elem_buf<T>& tmp) noexcept
+    {
+      if constexpr (rangeable<T>)
+      {
+        if (auto all = aw.data().range<T>())
+        {
+          tmp.resize(aw.size());
+          for (auto idx = size_type{}; idx < tmp.size(); ++idx)
+            tmp[idx] = all->at(aw.index_of(idx));
+
+          return tmp;
+        }
+      }
+
+      return aw.packed<T>(tmp);
+    }
+
+    //
+    // Calls the function with the elements as a typed buffer
+    // Returns an empty result for boxed arrays, and the ones the function rejects
+    //
+    template <typename F>
+    val_opt on_typed(const array_wrapper& aw, F&& func) noexcept
+    {
+      elem_buf<int_type> ints;
+      if (auto src = elems_of(aw, ints); !src.empty())
+        return func(src);
+
+      elem_buf<float_type> floats;
+      if (auto src = elems_of(aw, floats); !src.empty())
+        return func(src);
+
+      elem_buf<complex_type> complexes;
+      if (auto src = elems_of(aw, complexes); !src.empty())
+        return func(src);
+
+      return {};
+    }
+
+    template <packable T>
+    value packed_result(store& vs, size_type count, auto&& filler) noexcept
+    {
+      auto&& data = vs.allocate_array(count);
+      filler(data.template make_packed<T>(count));
+      return value::array(vs.wrap(data));
+    }
+
+    value fold(const array_wrapper& aw, val_ops op) noexcept
+    {
+      auto acc = elem_at(aw, 0);
+      for (auto idx = size_type{ 1 }; idx < aw.size(); ++idx)
+        acc = acc.binary(op, elem_at(aw, idx));
+
+      return acc;
+    }
+
+    //
+    // Picks the min or max element using the less operator
+    // Incomparable elements are skipped
+    //
+    value pick(const array_wrapper& aw, bool wantMax) noexcept
+    {
+      auto acc = elem_at(aw, 0);
+      for (auto idx = size_type{ 1 }; idx < aw.size(); ++idx)
+      {
+        auto elem = elem_at(aw, idx);
+        auto less = wantMax ? acc.binary(val_ops::RelLess, elem) : elem.binary(val_ops::RelLess, acc);
+        if (less && to_bool(less))
+          acc = std::move(elem);
+      }
+
+      return acc;
+    }
+
+    value sum(const array_wrapper& aw) noexcept
+    {
+      if (!aw.size())
+        return value{ int_type{} };
+
+      // Ints in a range add up to a closed form
+      if (auto r = aw.range<int_type>())
+      {
+        const auto count = static_cast<int_type>(r->m_count);
+        return value{ r->m_start * count + r->m_step * (count * (count - 1) / 2) };
+      }
+
+      auto res = on_typed(aw, [](auto src) noexcept -> val_opt
+        {
+          return value{ simd::sum(src) };
+        });
+
+      return res ? std::move(*res) : fold(aw, val_ops::Addition);
+    }
+
+    value product(const array_wrapper& aw) noexcept
+    {
+      if (!aw.size())
+        return value{ int_type{ 1 } };
+
+      auto res = on_typed(aw, [](auto src) noexcept -> val_opt
+        {
+          return value{ simd::product(src) };
+        });
+
+      return res ? std::move(*res) : fold(aw, val_ops::Multiplication);
+    }
+
+    value min_max(const array_wrapper& aw, bool wantMax) noexcept
+    {
+      if (!aw.size())
+        return {};
+
+      auto res = on_typed(aw, [wantMax](auto src) noexcept -> val_opt
+        {
+          using elem_t = typename decltype(src)::value_type;
+          if constexpr (rangeable<elem_t>)
+            return value{ wantMax ? simd::max(src) : simd::min(src) };
+          else
+            return {};
+        });
+
+      return res ? std::move(*res) : pick(aw, wantMax);
+    }
+
+    value sort(store& vs, array_wrapper& aw) noexcept
+    {
+      const auto size = aw.size();
+      auto res = on_typed(aw, [&vs, size](auto src) noexcept -> val_opt
+        {
+          using elem_t = typename decltype(src)::value_type;
+          if constexpr (rangeable<elem_t>)
+          {
+            return packed_result<elem_t>(vs, size, [src](auto out) noexcept
+              {
+                std::ranges::copy(src, out.begin());
+                std::ranges::sort(out, [](elem_t l, elem_t r) noexcept { return std::strong_order(l, r) < 0; });
+              });
+          }
+          else
+            return {};
+        });
+
+      if (res)
+        return std::move(*res);
+
+      std::vector<value> elems;
+      elems.reserve(size);
+      for (auto idx = size_type{}; idx < size; ++idx)
+        elems.emplace_back(elem_at(aw, idx));
+
+      std::ranges::stable_sort(elems, [](const value& l, const value& r) noexcept
+        {
+          auto less = l.binary(val_ops::RelLess, r);
+          return less && to_bool(less);
+        });
+
+      auto&& data = vs.allocate_array(size);
+      for (auto&& elem : elems)
+        data.add(std::move(elem));
+
+      return value::array(vs.wrap(data));
+    }
+
+    value dot(const array_wrapper& lhs, const array_wrapper& rhs) noexcept
+    {
+      const auto size = lhs.size();
+      if (size != rhs.size())
+        return {};
+
+      if (!size)
+        return value{ int_type{} };
+
+      elem_buf<int_type> lInts, rInts;
+      if (auto l = elems_of(lhs, lInts), r = elems_of(rhs, rInts); !l.empty() && !r.empty())
+        return value{ simd::dot(l, r) };
+
+      elem_buf<float_type> lFloats, rFloats;
+      if (auto l = elems_of(lhs, lFloats), r = elems_of(rhs, rFloats); !l.empty() && !r.empty())
+        return value{ simd::dot(l, r) };
+
+      auto acc = elem_at(lhs, 0).binary(val_ops::Multiplication, elem_at(rhs, 0));
+      for (auto idx = size_type{ 1 }; idx < size; ++idx)
+        acc = acc.binary(val_ops::Addition, elem_at(lhs, idx).binary(val_ops::Multiplication, elem_at(rhs, idx)));
+
+      return acc;
+    }
+
+    value prefix_sum(store& vs, array_wrapper& aw) noexcept
+    {
+      const auto size = aw.size();
+      if (!size)
+        return value::array(aw);
+
+      auto res = on_typed(aw, [&vs, size](auto src) noexcept -> val_opt
+        {
+          using elem_t = typename decltype(src)::value_type;
+          return packed_result<elem_t>(vs, size, [src](auto out) noexcept
+            {
+              simd::prefix_sum(src, out);
+            });
+        });
+
+      if (res)
+        return std::move(*res);
+
+      auto&& data = vs.allocate_array(size);
+      auto acc = elem_at(aw, 0);
+      data.add(acc);
+      for (auto idx = size_type{ 1 }; idx < size; ++idx)
+      {
+        acc = acc.binary(val_ops::Addition, elem_at(aw, idx));
+        data.add(acc);
+      }
+
+      return value::array(vs.wrap(data));
+    }
+  }
+}
+
+namespace tnac::eval
+{
+  std::span<const intrinsic_info> intrinsics() noexcept
+  {
+    return detail::intrinsicTable;
+  }
+
+  intrinsic find_intrinsic(string_t name) noexcept
+  {
+    for (auto&& info : detail::intrinsicTable)
+    {
+      if (info.m_name == name)
+        return info.m_id;
+    }
+
+    return intrinsic::None;
+  }
+
+  value call_intrinsic(store& vs, intrinsic id, std::span<const value> args) noexcept
+  {
+    auto info = detail::info_of(id);
+    if (!info || args.size() != info->m_params.size())
+      return {};
+
+    value holder;
+    auto&& arr = detail::as_array(vs, args[0], holder);
+
+    using enum intrinsic;
+    switch (id)
+    {
+    case Sum:       return detail::sum(arr);
+    case Product:   return detail::product(arr);
+    case Min:       return detail::min_max(arr, false);
+    case Max:       return detail::min_max(arr, true);
+    case Sort:      return detail::sort(vs, arr);
+    case Reverse:   return reverse(array_type{ arr });
+    case PrefixSum: return detail::prefix_sum(vs, arr);
+
+    case Slice:
+    {
+      auto from  = args[1].try_get<int_type>();
+      auto count = args[2].try_get<int_type>();
+      auto step  = args[3].try_get<int_type>();
+      if (!from || !count || !step)
+        return {};
+
+      return slice(array_type{ arr }, *from, *count, *step);
+    }
+
+    case Dot:
+    {
+      value rhsHolder;
+      return detail::dot(arr, detail::as_array(vs, args[1], rhsHolder));
+    }
+
+    default: return {};
+    }
+  }
+}
@@ -0,0 +1,233 @@
+#include "eval/value/nan_box.hpp"
+#include "eval/value/type_impl.hpp"
+
+#if TNAC_NAN_BOXING
+
+namespace tnac::eval
+{
+  struct nan_box::cell
+  {
+    using ref_counter = std::atomic<std::uint32_t>;
+
+    static constexpr auto storageSize = std::max({ sizeof(int_type), sizeof(complex_type),
+                                                   sizeof(fraction_type), sizeof(function_type) });
+
+    static constexpr auto storageAlign = std::max({ alignof(int_type), alignof(complex_type),
+                                                    alignof(fraction_type), alignof(function_type) });
+
+    template <typename T>
+    const T& as() const noexcept
+    {
+      return *std::launder(reinterpret_cast<const T*>(m_storage));
+    }
+
+    template <typename T>
+    T& as() noexcept
+    {
+      return *std::launder(reinterpret_cast<T*>(m_storage));
+    }
+
+    // Cells are shared between copies, and copies can be passed to workers
+    ref_counter m_refs{};
+    type_id m_id{};
+    alignas(storageAlign) std::byte m_storage[storageSize];
+  };
+}
+
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    using cell = nan_box::cell;
+    using bits_type = nan_box::bits_type;
+
+    //
+    // Per-thread free list of spill cells
+    //
+    class cell_pool final
+    {
+    public:
+      static constexpr auto maxCells = std::size_t{ 256 };
+
+    public:
+      CLASS_SPECIALS_NONE(cell_pool);
+
+      ~cell_pool() noexcept
+      {
+        for (auto c : m_free)
+          delete c;
+      }
+
+      cell_pool() noexcept = default;
+
+    public:
+      cell* take() noexcept
+      {
+        if (m_free.empty())
+          return new cell{};
+
+        auto res = m_free.back();
+        m_free.pop_back();
+        return res;
+      }
+
+      void put(cell* c) noexcept
+      {
+        if (m_free.size() < maxCells)
+        {
+          m_free.push_back(c);
+          return;
+        }
+
+        delete c;
+      }
+
+    private:
+      std::vector<cell*> m_free;
+    };
+
+    cell_pool& pool() noexcept
+    {
+      thread_local cell_pool cells;
+      return cells;
+    }
+
+    template <typename T>
+    cell* make_cell(type_id ti, T val) noexcept
+    {
+      static_assert(sizeof(T) <= cell::storageSize);
+      auto res = pool().take();
+      res->m_refs.store(1, std::memory_order_relaxed);
+      res->m_id = ti;
+      new (res->m_storage) T{ std::move(val) };
+      return res;
+    }
+
+    void free_cell(cell* c) noexcept
+    {
+      if (c->m_id == type_id::Function)
+        c->as<function_type>().~function_type();
+
+      pool().put(c);
+    }
+
+    template <typename T>
+    bits_type to_payload(T* ptr) noexcept
+    {
+      // User space addresses fit into 48 bits
+      const auto res = std::bit_cast<bits_type>(ptr);
+      UTILS_ASSERT(!(res >> 48));
+      return res;
+    }
+
+    template <typename T>
+    T* from_payload(bits_type payload) noexcept
+    {
+      return std::bit_cast<T*>(payload);
+    }
+  }
+}
+
+namespace tnac::eval
+{
+  // Special members
+
+  nan_box::nan_box(complex_type val) noexcept :
+    m_bits{ box(tag::Spill, detail::to_payload(detail::make_cell(type_id::Complex, val))) }
+  {
+  }
+
+  nan_box::nan_box(fraction_type val) noexcept :
+    m_bits{ box(tag::Spill, detail::to_payload(detail::make_cell(type_id::Fraction, val))) }
+  {
+  }
+
+  nan_box::nan_box(function_type val) noexcept
+  {
+    if (val.is_closure())
+    {
+      m_bits = box(tag::Spill, detail::to_payload(detail::make_cell(type_id::Function, std::move(val))));
+      return;
+    }
+
+    m_bits = box(tag::Function, detail::to_payload(&(*val)));
+  }
+
+  nan_box::nan_box(array_type val) noexcept
+  {
+    auto&& aw = val.wrapper();
+    aw.addref();
+    m_bits = box(tag::Array, detail::to_payload(&aw));
+  }
+
+
+  // Private members
+
+  nan_box::bits_type nan_box::spill(int_type val) noexcept
+  {
+    return box(tag::Spill, detail::to_payload(detail::make_cell(type_id::Int, val)));
+  }
+
+  void nan_box::ref_slow() const noexcept
+  {
+    if (get_tag() == tag::Array)
+    {
+      detail::from_payload<array_wrapper>(payload())->addref();
+      return;
+    }
+
+    detail::from_payload<cell>(payload())->m_refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void nan_box::unref_slow() noexcept
+  {
+    if (get_tag() == tag::Array)
+    {
+      auto aw = detail::from_payload<array_wrapper>(payload());
+      aw->release();
+      if (!aw->hasref())
+        aw->remove();
+
+      return;
+    }
+
+    auto c = detail::from_payload<cell>(payload());
+    if (c->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      detail::free_cell(c);
+  }
+
+  type_id nan_box::spilled_id() const noexcept
+  {
+    return detail::from_payload<cell>(payload())->m_id;
+  }
+
+  int_type nan_box::spilled_int() const noexcept
+  {
+    return detail::from_payload<cell>(payload())->as<int_type>();
+  }
+
+  complex_type nan_box::get_complex() const noexcept
+  {
+    return detail::from_payload<cell>(payload())->as<complex_type>();
+  }
+
+  fraction_type nan_box::get_fraction() const noexcept
+  {
+    return detail::from_payload<cell>(payload())->as<fraction_type>();
+  }
+
+  function_type nan_box::get_function() const noexcept
+  {
+    if (get_tag() == tag::Function)
+      return function_type{ *detail::from_payload<ir::function>(payload()) };
+
+    return detail::from_payload<cell>(payload())->as<function_type>();
+  }
+
+  array_type nan_box::get_array() const noexcept
+  {
+    return array_type{ *detail::from_payload<array_wrapper>(payload()) };
+  }
+}
+
+#endif
@@ -0,0 +1,768 @@
+#include "eval/value/simd.hpp"
+#include "eval/value/traits.hpp"
+
+#if TNAC_X64
+  #include <immintrin.h>
+  #if TNAC_WINDOWS
+    #include <intrin.h>
+  #endif
+#endif
+
+#if TNAC_X64 && defined(__GNUC__)
+  #define TNAC_AVX2 __attribute__((target("avx2")))
+#else
+  #define TNAC_AVX2
+#endif
+
+namespace tnac::eval::simd::detail
+{
+  namespace
+  {
+    isa detect() noexcept
+    {
+#if TNAC_X64
+  #if defined(__GNUC__)
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+        return isa::Avx2;
+  #elif TNAC_WINDOWS
+      int info[4]{};
+      __cpuid(info, 1);
+      const auto osSaves = (info[2] & (1 << 27)) != 0;
+      __cpuidex(info, 7, 0);
+      const auto hasAvx2 = (info[1] & (1 << 5)) != 0;
+      if (osSaves && hasAvx2 && (_xgetbv(0) & 6u) == 6u)
+        return isa::Avx2;
+  #endif
+      return isa::Sse2;
+#else
+      return isa::Scalar;
+#endif
+    }
+
+    //
+    // Ints wrap around on overflow instead of invoking UB
+    //
+    template <typename F>
+    int_type wrapping(int_type l, int_type r, F&& f) noexcept
+    {
+      using uint = std::make_unsigned_t<int_type>;
+      return static_cast<int_type>(f(static_cast<uint>(l), static_cast<uint>(r)));
+    }
+
+
+    // Lanes
+
+    template <typename T>
+    struct sse2_lane
+    {
+      static constexpr auto enabled = false;
+    };
+    template <typename T>
+    struct avx2_lane
+    {
+      static constexpr auto enabled = false;
+    };
+
+#if TNAC_X64
+    template <>
+    struct sse2_lane<int_type>
+    {
+      using vec = __m128i;
+      static constexpr auto enabled = true;
+      static constexpr auto width = size_type{ 2 };
+
+      static vec load(const int_type* src) noexcept { return _mm_loadu_si128(reinterpret_cast<const vec*>(src)); }
+      static void store(int_type* dest, vec v) noexcept { _mm_storeu_si128(reinterpret_cast<vec*>(dest), v); }
+      static vec splat(int_type v) noexcept { return _mm_set1_epi64x(v); }
+    };
+    template <>
+    struct sse2_lane<float_type>
+    {
+      using vec = __m128d;
+      static constexpr auto enabled = true;
+      static constexpr auto width = size_type{ 2 };
+
+      static vec load(const float_type* src) noexcept { return _mm_loadu_pd(src); }
+      static void store(float_type* dest, vec v) noexcept { _mm_storeu_pd(dest, v); }
+      static vec splat(float_type v) noexcept { return _mm_set1_pd(v); }
+    };
+
+    template <>
+    struct avx2_lane<int_type>
+    {
+      using vec = __m256i;
+      static constexpr auto enabled = true;
+      static constexpr auto width = size_type{ 4 };
+
+      TNAC_AVX2 static vec load(const int_type* src) noexcept { return _mm256_loadu_si256(reinterpret_cast<const vec*>(src)); }
+      TNAC_AVX2 static void store(int_type* dest, vec v) noexcept { _mm256_storeu_si256(reinterpret_cast<vec*>(dest), v); }
+      TNAC_AVX2 static vec splat(int_type v) noexcept { return _mm256_set1_epi64x(v); }
+    };
+    template <>
+    struct avx2_lane<float_type>
+    {
+      using vec = __m256d;
+      static constexpr auto enabled = true;
+      static constexpr auto width = size_type{ 4 };
+
+      TNAC_AVX2 static vec load(const float_type* src) noexcept { return _mm256_loadu_pd(src); }
+      TNAC_AVX2 static void store(float_type* dest, vec v) noexcept { _mm256_storeu_pd(dest, v); }
+      TNAC_AVX2 static vec splat(float_type v) noexcept { return _mm256_set1_pd(v); }
+    };
+#endif
+
+
+    // Binary operations
+
+    struct add_op
+    {
+      static int_type apply(int_type l, int_type r) noexcept
+      {
+        return wrapping(l, r, [](auto a, auto b) noexcept { return a + b; });
+      }
+      static auto apply(const auto& l, const auto& r) noexcept { return l + r; }
+#if TNAC_X64
+      static __m128i sse2(__m128i l, __m128i r) noexcept { return _mm_add_epi64(l, r); }
+      static __m128d sse2(__m128d l, __m128d r) noexcept { return _mm_add_pd(l, r); }
+      TNAC_AVX2 static __m256i avx2(__m256i l, __m256i r) noexcept { return _mm256_add_epi64(l, r); }
+      TNAC_AVX2 static __m256d avx2(__m256d l, __m256d r) noexcept { return _mm256_add_pd(l, r); }
+#endif
+    };
+
+    struct sub_op
+    {
+      static int_type apply(int_type l, int_type r) noexcept
+      {
+        return wrapping(l, r, [](auto a, auto b) noexcept { return a - b; });
+      }
+      static auto apply(const auto& l, const auto& r) noexcept { return l - r; }
+#if TNAC_X64
+      static __m128i sse2(__m128i l, __m128i r) noexcept { return _mm_sub_epi64(l, r); }
+      static __m128d sse2(__m128d l, __m128d r) noexcept { return _mm_sub_pd(l, r); }
+      TNAC_AVX2 static __m256i avx2(__m256i l, __m256i r) noexcept { return _mm256_sub_epi64(l, r); }
+      TNAC_AVX2 static __m256d avx2(__m256d l, __m256d r) noexcept { return _mm256_sub_pd(l, r); }
+#endif
+    };
+
+    //
+    // There is no packed 64-bit int multiplication below AVX-512,
+    // so ints are multiplied one by one
+    //
+    struct mul_op
+    {
+      static int_type apply(int_type l, int_type r) noexcept
+      {
+        return wrapping(l, r, [](auto a, auto b) noexcept { return a * b; });
+      }
+      static auto apply(const auto& l, const auto& r) noexcept { return l * r; }
+#if TNAC_X64
+      static __m128d sse2(__m128d l, __m128d r) noexcept { return _mm_mul_pd(l, r); }
+      TNAC_AVX2 static __m256d avx2(__m256d l, __m256d r) noexcept { return _mm256_mul_pd(l, r); }
+#endif
+    };
+
+    struct div_op
+    {
+      static auto apply(const auto& l, const auto& r) noexcept { return l / r; }
+#if TNAC_X64
+      static __m128d sse2(__m128d l, __m128d r) noexcept { return _mm_div_pd(l, r); }
+      TNAC_AVX2 static __m256d avx2(__m256d l, __m256d r) noexcept { return _mm256_div_pd(l, r); }
+#endif
+    };
+
+    struct and_op
+    {
+      static int_type apply(int_type l, int_type r) noexcept { return l & r; }
+#if TNAC_X64
+      static __m128i sse2(__m128i l, __m128i r) noexcept { return _mm_and_si128(l, r); }
+      TNAC_AVX2 static __m256i avx2(__m256i l, __m256i r) noexcept { return _mm256_and_si256(l, r); }
+#endif
+    };
+
+    struct xor_op
+    {
+      static int_type apply(int_type l, int_type r) noexcept { return l ^ r; }
+#if TNAC_X64
+      static __m128i sse2(__m128i l, __m128i r) noexcept { return _mm_xor_si128(l, r); }
+      TNAC_AVX2 static __m256i avx2(__m256i l, __m256i r) noexcept { return _mm256_xor_si256(l, r); }
+#endif
+    };
+
+    struct or_op
+    {
+      static int_type apply(int_type l, int_type r) noexcept { return l | r; }
+#if TNAC_X64
+      static __m128i sse2(__m128i l, __m128i r) noexcept { return _mm_or_si128(l, r); }
+      TNAC_AVX2 static __m256i avx2(__m256i l, __m256i r) noexcept { return _mm256_or_si256(l, r); }
+#endif
+    };
+
+
+    struct min_op
+    {
+      static auto apply(const auto& l, const auto& r) noexcept { return r < l ? r : l; }
+#if TNAC_X64
+      static __m128d sse2(__m128d l, __m128d r) noexcept { return _mm_min_pd(l, r); }
+      TNAC_AVX2 static __m256i avx2(__m256i l, __m256i r) noexcept { return _mm256_blendv_epi8(l, r, _mm256_cmpgt_epi64(l, r)); }
+      TNAC_AVX2 static __m256d avx2(__m256d l, __m256d r) noexcept { return _mm256_min_pd(l, r); }
+#endif
+    };
+
+    struct max_op
+    {
+      static auto apply(const auto& l, const auto& r) noexcept { return l < r ? r : l; }
+#if TNAC_X64
+      static __m128d sse2(__m128d l, __m128d r) noexcept { return _mm_max_pd(l, r); }
+      TNAC_AVX2 static __m256i avx2(__m256i l, __m256i r) noexcept { return _mm256_blendv_epi8(l, r, _mm256_cmpgt_epi64(r, l)); }
+      TNAC_AVX2 static __m256d avx2(__m256d l, __m256d r) noexcept { return _mm256_max_pd(l, r); }
+#endif
+    };
+
+
+    // Unary operations
+
+    struct neg_op
+    {
+      static int_type apply(int_type v) noexcept
+      {
+        return wrapping(int_type{}, v, [](auto a, auto b) noexcept { return a - b; });
+      }
+      static auto apply(const auto& v) noexcept { return -v; }
+#if TNAC_X64
+      static __m128i sse2(__m128i v) noexcept { return _mm_sub_epi64(_mm_setzero_si128(), v); }
+      static __m128d sse2(__m128d v) noexcept { return _mm_xor_pd(v, _mm_set1_pd(-0.0)); }
+      TNAC_AVX2 static __m256i avx2(__m256i v) noexcept { return _mm256_sub_epi64(_mm256_setzero_si256(), v); }
+      TNAC_AVX2 static __m256d avx2(__m256d v) noexcept { return _mm256_xor_pd(v, _mm256_set1_pd(-0.0)); }
+#endif
+    };
+
+    struct plus_op
+    {
+      static auto apply(const auto& v) noexcept { return +v; }
+    };
+
+    struct not_op
+    {
+      static int_type apply(int_type v) noexcept { return ~v; }
+#if TNAC_X64
+      static __m128i sse2(__m128i v) noexcept { return _mm_xor_si128(v, _mm_set1_epi32(-1)); }
+      TNAC_AVX2 static __m256i avx2(__m256i v) noexcept { return _mm256_xor_si256(v, _mm256_set1_epi32(-1)); }
+#endif
+    };
+
+    //
+    // Kept scalar to match the sign handling of the generic path exactly
+    //
+    struct abs_op
+    {
+      static auto apply(const auto& v) noexcept { return eval::abs(v); }
+    };
+
+
+    // Loops
+
+    template <typename Op, typename T>
+    void row_scalar(T lhs, in_buf<T> rhs, out_buf<T> out, size_type from) noexcept
+    {
+      for (auto idx = from; idx < rhs.size(); ++idx)
+        out[idx] = Op::apply(lhs, rhs[idx]);
+    }
+
+    template <typename Op, typename T>
+    void map_scalar(in_buf<T> src, out_buf<T> out, size_type from) noexcept
+    {
+      for (auto idx = from; idx < src.size(); ++idx)
+        out[idx] = Op::apply(src[idx]);
+    }
+
+    template <typename Op, typename T>
+    T fold_scalar(in_buf<T> src, T acc, size_type from) noexcept
+    {
+      for (auto idx = from; idx < src.size(); ++idx)
+        acc = Op::apply(acc, src[idx]);
+
+      return acc;
+    }
+
+    template <typename T>
+    T dot_scalar(in_buf<T> lhs, in_buf<T> rhs, T acc, size_type from) noexcept
+    {
+      for (auto idx = from; idx < lhs.size(); ++idx)
+        acc = add_op::apply(acc, mul_op::apply(lhs[idx], rhs[idx]));
+
+      return acc;
+    }
+
+#if TNAC_X64
+    template <typename Op, typename T>
+    void row_sse2(T lhs, in_buf<T> rhs, out_buf<T> out) noexcept
+    {
+      using lane = sse2_lane<T>;
+      const auto l = lane::splat(lhs);
+      auto idx = size_type{};
+      for (; idx + lane::width <= rhs.size(); idx += lane::width)
+        lane::store(out.data() + idx, Op::sse2(l, lane::load(rhs.data() + idx)));
+
+      row_scalar<Op>(lhs, rhs, out, idx);
+    }
+
+    template <typename Op, typename T>
+    TNAC_AVX2 void row_avx2(T lhs, in_buf<T> rhs, out_buf<T> out) noexcept
+    {
+      using lane = avx2_lane<T>;
+      const auto l = lane::splat(lhs);
+      auto idx = size_type{};
+      for (; idx + lane::width <= rhs.size(); idx += lane::width)
+        lane::store(out.data() + idx, Op::avx2(l, lane::load(rhs.data() + idx)));
+
+      row_scalar<Op>(lhs, rhs, out, idx);
+    }
+
+    template <typename Op, typename T>
+    void map_sse2(in_buf<T> src, out_buf<T> out) noexcept
+    {
+      using lane = sse2_lane<T>;
+      auto idx = size_type{};
+      for (; idx + lane::width <= src.size(); idx += lane::width)
+        lane::store(out.data() + idx, Op::sse2(lane::load(src.data() + idx)));
+
+      map_scalar<Op>(src, out, idx);
+    }
+
+    template <typename Op, typename T>
+    TNAC_AVX2 void map_avx2(in_buf<T> src, out_buf<T> out) noexcept
+    {
+      using lane = avx2_lane<T>;
+      auto idx = size_type{};
+      for (; idx + lane::width <= src.size(); idx += lane::width)
+        lane::store(out.data() + idx, Op::avx2(lane::load(src.data() + idx)));
+
+      map_scalar<Op>(src, out, idx);
+    }
+
+    //
+    // Each lane is folded separately, and the lanes are combined at the end
+    //
+    template <typename Op, typename T>
+    T fold_sse2(in_buf<T> src) noexcept
+    {
+      using lane = sse2_lane<T>;
+      auto acc = lane::load(src.data());
+      auto idx = lane::width;
+      for (; idx + lane::width <= src.size(); idx += lane::width)
+        acc = Op::sse2(acc, lane::load(src.data() + idx));
+
+      T parts[lane::width]{};
+      lane::store(parts, acc);
+      auto res = fold_scalar<Op>(in_buf<T>{ parts }, parts[0], size_type{ 1 });
+      return fold_scalar<Op>(src, res, idx);
+    }
+
+    template <typename Op, typename T>
+    TNAC_AVX2 T fold_avx2(in_buf<T> src) noexcept
+    {
+      using lane = avx2_lane<T>;
+      auto acc = lane::load(src.data());
+      auto idx = lane::width;
+      for (; idx + lane::width <= src.size(); idx += lane::width)
+        acc = Op::avx2(acc, lane::load(src.data() + idx));
+
+      T parts[lane::width]{};
+      lane::store(parts, acc);
+      auto res = fold_scalar<Op>(in_buf<T>{ parts }, parts[0], size_type{ 1 });
+      return fold_scalar<Op>(src, res, idx);
+    }
+
+    float_type dot_sse2(in_buf<float_type> lhs, in_buf<float_type> rhs) noexcept
+    {
+      using lane = sse2_lane<float_type>;
+      auto acc = _mm_setzero_pd();
+      auto idx = size_type{};
+      for (; idx + lane::width <= lhs.size(); idx += lane::width)
+        acc = add_op::sse2(acc, mul_op::sse2(lane::load(lhs.data() + idx), lane::load(rhs.data() + idx)));
+
+      float_type parts[lane::width]{};
+      lane::store(parts, acc);
+      return dot_scalar(lhs, rhs, parts[0] + parts[1], idx);
+    }
+
+    TNAC_AVX2 float_type dot_avx2(in_buf<float_type> lhs, in_buf<float_type> rhs) noexcept
+    {
+      using lane = avx2_lane<float_type>;
+      auto acc = _mm256_setzero_pd();
+      auto idx = size_type{};
+      for (; idx + lane::width <= lhs.size(); idx += lane::width)
+        acc = add_op::avx2(acc, mul_op::avx2(lane::load(lhs.data() + idx), lane::load(rhs.data() + idx)));
+
+      float_type parts[lane::width]{};
+      lane::store(parts, acc);
+      return dot_scalar(lhs, rhs, (parts[0] + parts[1]) + (parts[2] + parts[3]), idx);
+    }
+
+    size_type mismatch_sse2(in_buf<int_type> lhs, in_buf<int_type> rhs, size_type count) noexcept
+    {
+      using lane = sse2_lane<int_type>;
+      auto idx = size_type{};
+      for (; idx + lane::width <= count; idx += lane::width)
+      {
+        // SSE2 can only compare 32-bit halves, both of them must match
+        const auto halves = _mm_cmpeq_epi32(lane::load(lhs.data() + idx), lane::load(rhs.data() + idx));
+        const auto both = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+        const auto mask = static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(both)));
+        if (mask != 0b11u)
+          return idx + std::countr_one(mask);
+      }
+
+      for (; idx < count && lhs[idx] == rhs[idx]; ++idx);
+      return idx;
+    }
+
+    TNAC_AVX2 size_type mismatch_avx2(in_buf<int_type> lhs, in_buf<int_type> rhs, size_type count) noexcept
+    {
+      using lane = avx2_lane<int_type>;
+      auto idx = size_type{};
+      for (; idx + lane::width <= count; idx += lane::width)
+      {
+        const auto eq = _mm256_cmpeq_epi64(lane::load(lhs.data() + idx), lane::load(rhs.data() + idx));
+        const auto mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(eq)));
+        if (mask != 0b1111u)
+          return idx + std::countr_one(mask);
+      }
+
+      for (; idx < count && lhs[idx] == rhs[idx]; ++idx);
+      return idx;
+    }
+#endif
+
+    template <typename Op, typename T>
+    void row(T lhs, in_buf<T> rhs, out_buf<T> out) noexcept
+    {
+      UTILS_ASSERT(out.size() >= rhs.size());
+#if TNAC_X64
+      const auto cur = active();
+      if constexpr (avx2_lane<T>::enabled)
+      {
+        using vec = avx2_lane<T>::vec;
+        if constexpr (requires(vec v) { Op::avx2(v, v); })
+        {
+          if (cur == isa::Avx2)
+            return row_avx2<Op>(lhs, rhs, out);
+        }
+      }
+      if constexpr (sse2_lane<T>::enabled)
+      {
+        using vec = sse2_lane<T>::vec;
+        if constexpr (requires(vec v) { Op::sse2(v, v); })
+        {
+          if (cur != isa::Scalar)
+            return row_sse2<Op>(lhs, rhs, out);
+        }
+      }
+#endif
+      row_scalar<Op>(lhs, rhs, out, size_type{});
+    }
+
+    template <typename Op, typename T>
+    void map(in_buf<T> src, out_buf<T> out) noexcept
+    {
+      UTILS_ASSERT(out.size() >= src.size());
+#if TNAC_X64
+      const auto cur = active();
+      if constexpr (avx2_lane<T>::enabled)
+      {
+        using vec = avx2_lane<T>::vec;
+        if constexpr (requires(vec v) { Op::avx2(v); })
+        {
+          if (cur == isa::Avx2)
+            return map_avx2<Op>(src, out);
+        }
+      }
+      if constexpr (sse2_lane<T>::enabled)
+      {
+        using vec = sse2_lane<T>::vec;
+        if constexpr (requires(vec v) { Op::sse2(v); })
+        {
+          if (cur != isa::Scalar)
+            return map_sse2<Op>(src, out);
+        }
+      }
+#endif
+      map_scalar<Op>(src, out, size_type{});
+    }
+
+    //
+    // Folds a non-empty buffer starting with its first element
+    //
+    template <typename Op, typename T>
+    T fold(in_buf<T> src) noexcept
+    {
+      UTILS_ASSERT(!src.empty());
+#if TNAC_X64
+      [[maybe_unused]] const auto cur = active();
+      if constexpr (avx2_lane<T>::enabled)
+      {
+        using vec = avx2_lane<T>::vec;
+        if constexpr (requires(vec v) { Op::avx2(v, v); })
+        {
+          if (cur == isa::Avx2 && src.size() >= avx2_lane<T>::width)
+            return fold_avx2<Op>(src);
+        }
+      }
+      if constexpr (sse2_lane<T>::enabled)
+      {
+        using vec = sse2_lane<T>::vec;
+        if constexpr (requires(vec v) { Op::sse2(v, v); })
+        {
+          if (cur != isa::Scalar && src.size() >= sse2_lane<T>::width)
+            return fold_sse2<Op>(src);
+        }
+      }
+#endif
+      return fold_scalar<Op>(src, src.front(), size_type{ 1 });
+    }
+
+    template <typename T>
+    void running_sum(in_buf<T> src, out_buf<T> out) noexcept
+    {
+      // Every element depends on the previous one
+      UTILS_ASSERT(out.size() >= src.size());
+      auto acc = T{};
+      for (auto idx = size_type{}; idx < src.size(); ++idx)
+      {
+        acc = add_op::apply(acc, src[idx]);
+        out[idx] = acc;
+      }
+    }
+  }
+}
+
+namespace tnac::eval::simd
+{
+  isa active() noexcept
+  {
+    static const auto cur = detail::detect();
+    return cur;
+  }
+
+  bool has_binary(val_ops op, type_id ti) noexcept
+  {
+    using enum val_ops;
+    switch (ti)
+    {
+    case type_id::Int:
+      return utils::eq_any(op, Addition, Subtraction, Multiplication, BitwiseAnd, BitwiseXor, BitwiseOr);
+
+    case type_id::Float:
+    case type_id::Complex:
+      return utils::eq_any(op, Addition, Subtraction, Multiplication, Division);
+
+    default:
+      return false;
+    }
+  }
+
+  bool has_unary(val_ops op, type_id ti) noexcept
+  {
+    using enum val_ops;
+    switch (ti)
+    {
+    case type_id::Int:     return utils::eq_any(op, UnaryNegation, UnaryPlus, UnaryBitwiseNot, AbsoluteValue);
+    case type_id::Float:   return utils::eq_any(op, UnaryNegation, UnaryPlus, AbsoluteValue);
+    case type_id::Complex: return utils::eq_any(op, UnaryNegation, UnaryPlus);
+    default:               return false;
+    }
+  }
+
+  void binary_row(val_ops op, int_type lhs, in_buf<int_type> rhs, out_buf<int_type> out) noexcept
+  {
+    using enum val_ops;
+    using namespace detail;
+    switch (op)
+    {
+    case Addition:       row<add_op>(lhs, rhs, out); break;
+    case Subtraction:    row<sub_op>(lhs, rhs, out); break;
+    case Multiplication: row<mul_op>(lhs, rhs, out); break;
+    case BitwiseAnd:     row<and_op>(lhs, rhs, out); break;
+    case BitwiseXor:     row<xor_op>(lhs, rhs, out); break;
+    case BitwiseOr:      row<or_op>(lhs, rhs, out);  break;
+    default: UTILS_ASSERT(false); break;
+    }
+  }
+
+  void binary_row(val_ops op, float_type lhs, in_buf<float_type> rhs, out_buf<float_type> out) noexcept
+  {
+    using enum val_ops;
+    using namespace detail;
+    switch (op)
+    {
+    case Addition:       row<add_op>(lhs, rhs, out); break;
+    case Subtraction:    row<sub_op>(lhs, rhs, out); break;
+    case Multiplication: row<mul_op>(lhs, rhs, out); break;
+    case Division:       row<div_op>(lhs, rhs, out); break;
+    default: UTILS_ASSERT(false); break;
+    }
+  }
+
+  void binary_row(val_ops op, complex_type lhs, in_buf<complex_type> rhs, out_buf<complex_type> out) noexcept
+  {
+    using enum val_ops;
+    using namespace detail;
+    switch (op)
+    {
+    case Addition:       row<add_op>(lhs, rhs, out); break;
+    case Subtraction:    row<sub_op>(lhs, rhs, out); break;
+    case Multiplication: row<mul_op>(lhs, rhs, out); break;
+    case Division:       row<div_op>(lhs, rhs, out); break;
+    default: UTILS_ASSERT(false); break;
+    }
+  }
+
+  void unary(val_ops op, in_buf<int_type> src, out_buf<int_type> out) noexcept
+  {
+    using enum val_ops;
+    using namespace detail;
+    switch (op)
+    {
+    case UnaryNegation:   map<neg_op>(src, out);  break;
+    case UnaryPlus:       map<plus_op>(src, out); break;
+    case UnaryBitwiseNot: map<not_op>(src, out);  break;
+    case AbsoluteValue:   map<abs_op>(src, out);  break;
+    default: UTILS_ASSERT(false); break;
+    }
+  }
+
+  void unary(val_ops op, in_buf<float_type> src, out_buf<float_type> out) noexcept
+  {
+    using enum val_ops;
+    using namespace detail;
+    switch (op)
+    {
+    case UnaryNegation: map<neg_op>(src, out);  break;
+    case UnaryPlus:     map<plus_op>(src, out); break;
+    case AbsoluteValue: map<abs_op>(src, out);  break;
+    default: UTILS_ASSERT(false); break;
+    }
+  }
+
+  void unary(val_ops op, in_buf<complex_type> src, out_buf<complex_type> out) noexcept
+  {
+    using enum val_ops;
+    using namespace detail;
+    switch (op)
+    {
+    case UnaryNegation: map<neg_op>(src, out);  break;
+    case UnaryPlus:     map<plus_op>(src, out); break;
+    default: UTILS_ASSERT(false); break;
+    }
+  }
+
+  size_type mismatch(in_buf<int_type> lhs, in_buf<int_type> rhs) noexcept
+  {
+    const auto count = std::min(lhs.size(), rhs.size());
+#if TNAC_X64
+    if (active() == isa::Avx2)
+      return detail::mismatch_avx2(lhs, rhs, count);
+
+    return detail::mismatch_sse2(lhs, rhs, count);
+#else
+    auto idx = size_type{};
+    for (; idx < count && lhs[idx] == rhs[idx]; ++idx);
+    return idx;
+#endif
+  }
+
+  void widen(in_buf<int_type> src, out_buf<float_type> out) noexcept
+  {
+    // No packed int64 to double conversion below AVX-512
+    UTILS_ASSERT(out.size() >= src.size());
+    for (auto idx = size_type{}; idx < src.size(); ++idx)
+      out[idx] = static_cast<float_type>(src[idx]);
+  }
+
+  int_type sum(in_buf<int_type> src) noexcept
+  {
+    return src.empty() ? int_type{} : detail::fold<detail::add_op>(src);
+  }
+
+  float_type sum(in_buf<float_type> src) noexcept
+  {
+    return src.empty() ? float_type{} : detail::fold<detail::add_op>(src);
+  }
+
+  complex_type sum(in_buf<complex_type> src) noexcept
+  {
+    return src.empty() ? complex_type{} : detail::fold<detail::add_op>(src);
+  }
+
+  int_type product(in_buf<int_type> src) noexcept
+  {
+    return src.empty() ? int_type{ 1 } : detail::fold<detail::mul_op>(src);
+  }
+
+  float_type product(in_buf<float_type> src) noexcept
+  {
+    return src.empty() ? float_type{ 1 } : detail::fold<detail::mul_op>(src);
+  }
+
+  complex_type product(in_buf<complex_type> src) noexcept
+  {
+    return src.empty() ? complex_type{ 1 } : detail::fold<detail::mul_op>(src);
+  }
+
+  int_type min(in_buf<int_type> src) noexcept
+  {
+    return detail::fold<detail::min_op>(src);
+  }
+
+  float_type min(in_buf<float_type> src) noexcept
+  {
+    return detail::fold<detail::min_op>(src);
+  }
+
+  int_type max(in_buf<int_type> src) noexcept
+  {
+    return detail::fold<detail::max_op>(src);
+  }
+
+  float_type max(in_buf<float_type> src) noexcept
+  {
+    return detail::fold<detail::max_op>(src);
+  }
+
+  int_type dot(in_buf<int_type> lhs, in_buf<int_type> rhs) noexcept
+  {
+    // No packed 64-bit int multiplication, same as in binary rows
+    UTILS_ASSERT(lhs.size() == rhs.size());
+    return detail::dot_scalar(lhs, rhs, int_type{}, size_type{});
+  }
+
+  float_type dot(in_buf<float_type> lhs, in_buf<float_type> rhs) noexcept
+  {
+    UTILS_ASSERT(lhs.size() == rhs.size());
+#if TNAC_X64
+    const auto cur = active();
+    if (cur == isa::Avx2)
+      return detail::dot_avx2(lhs, rhs);
+
+    if (cur == isa::Sse2)
+      return detail::dot_sse2(lhs, rhs);
+#endif
+    return detail::dot_scalar(lhs, rhs, float_type{}, size_type{});
+  }
+
+  void prefix_sum(in_buf<int_type> src, out_buf<int_type> out) noexcept
+  {
+    detail::running_sum(src, out);
+  }
+
+  void prefix_sum(in_buf<float_type> src, out_buf<float_type> out) noexcept
+  {
+    detail::running_sum(src, out);
+  }
+
+  void prefix_sum(in_buf<complex_type> src, out_buf<complex_type> out) noexcept
+  {
+    detail::running_sum(src, out);
+  }
+}
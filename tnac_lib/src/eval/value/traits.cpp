@@ -20,10 +20,12 @@ namespace tnac::eval
 {
   value head(const array_type& arr) noexcept
   {
-    if (arr->begin() == arr->end())
+    // Reading by index keeps packed arrays and ranges as they are
+    auto&& wrapper = arr.wrapper();
+    if (!wrapper.size())
       return value{};
 
-    return *arr->begin();
+    return wrapper.data().read_at(wrapper.offset());
   }
 
   value tail(const array_type& op) noexcept
@@ -36,14 +38,48 @@ namespace tnac::eval
     if (size < threshold)
       return value{};
     else if (size == threshold)
-      return *std::next(wrapper.begin());
+      return wrapper.data().read_at(wrapper.index_of(sz{ 1 }));
 
-    auto&& data = arr->data();
     auto&& vs = arr->val_store();
-    auto&& res = vs.wrap(data, wrapper.offset() + 1, size - 1u);
+    auto&& res = vs.view(wrapper, sz{ 1 }, size - 1u, 1);
     return value{ array_type{ res } };
   }
 
+  value slice(const array_type& op, int_type from, int_type count, int_type step) noexcept
+  {
+    auto arr = op;
+    auto&& wrapper = arr.wrapper();
+    const auto size = static_cast<int_type>(wrapper.size());
+    if (!step || from < 0 || count < 0)
+      return value{};
+
+    if (count)
+    {
+      if (from >= size)
+        return value{};
+
+      // Computing the last index directly can overflow with large steps,
+      // so the steps are compared to how many fit between from and the edge
+      const auto room = step > 0 ? (size - 1 - from) / step : -(from / step);
+      if (count - 1 > room)
+        return value{};
+    }
+
+    using sz = array_data::size_type;
+    auto&& vs = arr->val_store();
+    auto&& res = vs.view(wrapper, static_cast<sz>(from), static_cast<sz>(count), step);
+    return value{ array_type{ res } };
+  }
+
+  value reverse(const array_type& arr) noexcept
+  {
+    const auto size = static_cast<int_type>(arr->size());
+    if (!size)
+      return value{ arr };
+
+    return slice(arr, size - 1, size, -1);
+  }
+
   template <eval::expr_result Obj, typename Int, Int... Seq>
   inline val_opt instantiate(eval::cval_array<sizeof...(Seq)>& args, utils::idx_seq<Int, Seq...>) noexcept
   {
@@ -5,12 +5,15 @@ namespace tnac::eval
 {
   // Special members
 
-  array_data::~array_data() noexcept = default;
+  array_data::~array_data() noexcept
+  {
+    clear();
+  }
 
   array_data::array_data(store& valStore, size_type prealloc) noexcept :
-    m_store{ &valStore }
+    m_store{ &valStore },
+    m_prealloc{ prealloc }
   {
-    m_data.reserve(prealloc);
   }
 
 
@@ -18,12 +21,32 @@ namespace tnac::eval
 
   array_data::size_type array_data::size() const noexcept
   {
-    return m_data.size();
+    if (m_boxed)
+      return m_data.size();
+
+    if (is_range())
+    {
+      return std::visit(utils::visitor
+        {
+          [](const std::monostate&) noexcept { return size_type{}; },
+          [](const auto& r) noexcept { return r.m_count; }
+        }, m_range);
+    }
+
+    return std::visit(utils::visitor
+      {
+        [](const std::monostate&) noexcept { return size_type{}; },
+        [](const auto& buf) noexcept { return buf.size(); }
+      }, m_packed);
   }
 
   void array_data::add(value item) noexcept
   {
-    m_data.push_back(std::move(item));
+    unroll();
+    if (!m_boxed && try_pack(item))
+      return;
+
+    boxed().push_back(std::move(item));
   }
 
   store& array_data::val_store() const noexcept
@@ -33,8 +56,9 @@ namespace tnac::eval
 
   void array_data::erase(eraser_t eraser) noexcept
   {
-    auto it = std::remove_if(m_data.begin(), m_data.end(), std::move(eraser));
-    m_data.erase(it, m_data.end());
+    auto&& data = boxed();
+    auto it = std::remove_if(data.begin(), data.end(), std::move(eraser));
+    data.erase(it, data.end());
   }
 
   void array_data::remove() noexcept
@@ -45,13 +69,162 @@ namespace tnac::eval
   void array_data::write_at(value val, size_type idx) noexcept
   {
     UTILS_ASSERT(idx < size());
-    m_data[idx] = std::move(val);
+    unroll();
+    if (!m_boxed)
+    {
+      const auto written = std::visit(utils::visitor
+        {
+          [](std::monostate&) noexcept { return false; },
+          [&](auto& buf) noexcept
+          {
+            using elem_t = typename std::remove_cvref_t<decltype(buf)>::value_type;
+            auto elem = val.try_get<elem_t>();
+            if (elem)
+              buf[idx] = *elem;
+
+            return static_cast<bool>(elem);
+          }
+        }, m_packed);
+
+      if (written)
+        return;
+    }
+
+    boxed()[idx] = std::move(val);
   }
 
   value array_data::read_at(size_type idx) const noexcept
   {
     UTILS_ASSERT(idx < size());
-    return m_data[idx];
+    if (m_boxed)
+      return m_data[idx];
+
+    if (is_range())
+    {
+      return std::visit(utils::visitor
+        {
+          [](const std::monostate&) noexcept { return value{}; },
+          [idx](const auto& r) noexcept { return value{ r.at(idx) }; }
+        }, m_range);
+    }
+
+    return std::visit(utils::visitor
+      {
+        [](const std::monostate&) noexcept { return value{}; },
+        [idx](const auto& buf) noexcept { return value{ buf[idx] }; }
+      }, m_packed);
+  }
+
+  bool array_data::is_boxed() const noexcept
+  {
+    return m_boxed;
+  }
+
+  bool array_data::is_range() const noexcept
+  {
+    return !std::holds_alternative<std::monostate>(m_range);
+  }
+
+  void array_data::clear() noexcept
+  {
+    // Elements can reference other arrays which get removed along the way,
+    // so the buffers are detached before anything is destroyed
+    auto data = std::exchange(m_data, {});
+    auto packed = std::exchange(m_packed, {});
+    m_range = {};
+    m_store->recycle(std::move(data));
+    std::visit(utils::visitor
+      {
+        [](std::monostate&) noexcept {},
+        [this](auto& buf) noexcept { m_store->recycle(std::move(buf)); }
+      }, packed);
+  }
+
+  array_data::data_type& array_data::elements() noexcept
+  {
+    return boxed();
+  }
+
+
+  // Private members
+
+  array_data::data_type& array_data::boxed() const noexcept
+  {
+    if (m_boxed)
+      return m_data;
+
+    unroll();
+    m_boxed = true;
+    std::visit(utils::visitor
+      {
+        [this](std::monostate&) noexcept
+        {
+          m_data = m_store->take_buffer<value>(m_prealloc);
+        },
+        [this](auto& buf) noexcept
+        {
+          m_data = m_store->take_buffer<value>(std::max(m_prealloc, buf.size()));
+          for (auto&& elem : buf)
+            m_data.emplace_back(elem);
+
+          m_store->recycle(std::move(buf));
+        }
+      }, m_packed);
+
+    m_packed = {};
+    return m_data;
+  }
+
+  void array_data::unroll() const noexcept
+  {
+    if (!is_range())
+      return;
+
+    auto lazy = std::exchange(m_range, {});
+    std::visit(utils::visitor
+      {
+        [](std::monostate&) noexcept {},
+        [this](auto& r) noexcept
+        {
+          using elem_t = decltype(r.at(size_type{}));
+          auto&& buf = m_packed.emplace<packed_buf<elem_t>>(m_store->take_buffer<elem_t>(r.m_count));
+          buf.resize(r.m_count);
+          for (auto idx = size_type{}; idx < r.m_count; ++idx)
+            buf[idx] = r.at(idx);
+        }
+      }, lazy);
+  }
+
+  bool array_data::try_pack(const value& item) noexcept
+  {
+    return std::visit(utils::visitor
+      {
+        [&](std::monostate&) noexcept
+        {
+          auto start = [&](auto elem) noexcept
+            {
+              using elem_t = decltype(elem);
+              auto&& buf = m_packed.emplace<packed_buf<elem_t>>(m_store->take_buffer<elem_t>(m_prealloc));
+              buf.push_back(elem);
+              return true;
+            };
+
+          if (auto i = item.try_get<int_type>())     return start(*i);
+          if (auto f = item.try_get<float_type>())   return start(*f);
+          if (auto c = item.try_get<complex_type>()) return start(*c);
+          return false;
+        },
+        [&](auto& buf) noexcept
+        {
+          using elem_t = typename std::remove_cvref_t<decltype(buf)>::value_type;
+          auto elem = item.try_get<elem_t>();
+          if (!elem)
+            return false;
+
+          buf.push_back(*elem);
+          return true;
+        }
+      }, m_packed);
   }
 }
 
@@ -63,10 +236,17 @@ namespace tnac::eval
 
   array_wrapper::~array_wrapper() noexcept = default;
 
-  array_wrapper::array_wrapper(array_data& arr, size_type offset, size_type count) noexcept :
+  array_wrapper::array_wrapper(array_data& arr, size_type offset, size_type count, stride_type stride) noexcept :
     wrapper_base{ arr },
     m_offset{ offset },
-    m_count{ count }
+    m_count{ count },
+    m_stride{ stride }
+  {
+    UTILS_ASSERT(stride);
+  }
+
+  array_wrapper::array_wrapper(array_data& arr, size_type offset, size_type count) noexcept :
+    array_wrapper{ arr, offset, count, stride_type{ 1 } }
   {
   }
 
@@ -84,6 +264,10 @@ namespace tnac::eval
 
   // Public members
 
+  array_wrapper::wrapper_base::const_reference array_wrapper::data() const noexcept
+  {
+    return *operator->();
+  }
   array_wrapper::wrapper_base::reference array_wrapper::data() noexcept
   {
     return FROM_CONST(data);
@@ -99,6 +283,23 @@ namespace tnac::eval
     return m_count;
   }
 
+  array_wrapper::stride_type array_wrapper::stride() const noexcept
+  {
+    return m_stride;
+  }
+
+  array_wrapper::size_type array_wrapper::index_of(size_type idx) const noexcept
+  {
+    const auto res = static_cast<stride_type>(m_offset) + static_cast<stride_type>(idx) * m_stride;
+    UTILS_ASSERT(res >= 0);
+    return static_cast<size_type>(res);
+  }
+
+  bool array_wrapper::is_contiguous() const noexcept
+  {
+    return m_stride == 1;
+  }
+
   entity_id array_wrapper::id() const noexcept
   {
     return this;
@@ -117,28 +318,11 @@ namespace tnac::eval
 
   // Private members
 
-  array_wrapper::wrapper_base::const_reference array_wrapper::data() const noexcept
-  {
-    return *operator->();
-  }
-
-  array_wrapper::size_type array_wrapper::calc_begin() const noexcept
-  {
-    UTILS_ASSERT(m_offset <= data().size());
-    return m_offset;
-  }
-  array_wrapper::size_type array_wrapper::calc_end() const noexcept
-  {
-    const auto res = m_offset + m_count;
-    UTILS_ASSERT(res <= data().size());
-    return res;
-  }
-  array_wrapper::size_type array_wrapper::calc_rbegin() const noexcept
-  {
-    return data().size() - calc_end();
-  }
-  array_wrapper::size_type array_wrapper::calc_rend() const noexcept
+  array_wrapper::iterator array_wrapper::make_iter(size_type idx) const noexcept
   {
-    return data().size() - calc_begin();
+    auto&& arr = data();
+    UTILS_ASSERT(!m_count || index_of(m_count - 1) < arr.size());
+    const auto pos = static_cast<stride_type>(m_offset) + static_cast<stride_type>(idx) * m_stride;
+    return iterator{ arr, pos, m_stride };
   }
 }
\ No newline at end of file
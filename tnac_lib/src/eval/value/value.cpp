@@ -2,6 +2,8 @@
 #include "eval/value/traits.hpp"
 #include "eval/value/type_impl.hpp"
 #include "eval/value/value_store.hpp"
+#include "eval/value/simd.hpp"
+#include "eval/par/par_elems.hpp"
 
 namespace tnac::eval::detail
 {
@@ -41,6 +43,638 @@ namespace tnac::eval
   };
 }
 
+// Packed arrays
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    using size_type = array_data::size_type;
+    using float_buf = array_data::packed_buf<float_type>;
+
+    //
+    // Returns the element type of a packed array
+    // Boxed and empty arrays yield Invalid
+    //
+    type_id packed_id(const array_wrapper& aw) noexcept
+    {
+      if (!aw.size())
+        return type_id::Invalid;
+
+      // Views share the element type of the underlying array
+      auto&& data = aw.data();
+      if (!data.packed<int_type>().empty())     return type_id::Int;
+      if (!data.packed<float_type>().empty())   return type_id::Float;
+      if (!data.packed<complex_type>().empty()) return type_id::Complex;
+      return type_id::Invalid;
+    }
+
+    //
+    // Converts a packed int array to floats
+    //
+    std::span<const float_type> as_floats(const array_wrapper& aw, float_buf& tmp) noexcept
+    {
+      if (auto floats = aw.packed<float_type>(tmp); !floats.empty())
+        return floats;
+
+      array_data::packed_buf<int_type> intTmp;
+      auto ints = aw.packed<int_type>(intTmp);
+      tmp.resize(ints.size());
+      simd::widen(ints, tmp);
+      return tmp;
+    }
+
+    //
+    // Returns the parallel runner if an operation over the given number
+    // of elements is large enough to be split
+    //
+    par_elems* par_for(const store& vs, size_type count) noexcept
+    {
+      auto par = vs.par();
+      return par && par->wants(count) ? par : nullptr;
+    }
+
+    //
+    // Computes elements [from, to) of the outer product of packed arrays
+    //
+    template <packable T>
+    void packed_rows(val_ops op, std::span<const T> lhs, std::span<const T> rhs, std::span<T> res, size_type from, size_type to) noexcept
+    {
+      const auto rowSz = rhs.size();
+      while (from < to)
+      {
+        const auto col = from % rowSz;
+        const auto len = std::min(rowSz - col, to - from);
+        simd::binary_row(op, lhs[from / rowSz], rhs.subspan(col, len), res.subspan(from, len));
+        from += len;
+      }
+    }
+
+    template <packable T>
+    value packed_binary(store& vs, val_ops op, std::span<const T> lhs, std::span<const T> rhs) noexcept
+    {
+      const auto total = lhs.size() * rhs.size();
+      auto&& resArr = vs.allocate_array(total);
+      auto res = resArr.make_packed<T>(total);
+      if (auto par = par_for(vs, total))
+      {
+        par->run(total, [&](size_type from, size_type to) noexcept
+          {
+            packed_rows(op, lhs, rhs, res, from, to);
+          });
+      }
+      else
+        packed_rows(op, lhs, rhs, res, size_type{}, total);
+
+      return value{ array_type{ vs.wrap(resArr) } };
+    }
+
+    //
+    // Strided views are gathered into temporary buffers first
+    //
+    template <packable T>
+    value packed_binary_as(store& vs, val_ops op, const array_wrapper& lhs, const array_wrapper& rhs) noexcept
+    {
+      array_data::packed_buf<T> lTmp;
+      array_data::packed_buf<T> rTmp;
+      return packed_binary(vs, op, lhs.packed<T>(lTmp), rhs.packed<T>(rTmp));
+    }
+
+    //
+    // Applies a binary operation to every pair of elements of packed arrays
+    // Mixed ints and floats, as well as int division, are computed with floats
+    //
+    val_opt packed_binary(store& vs, val_ops op, const array_wrapper& lhs, const array_wrapper& rhs) noexcept
+    {
+      using enum type_id;
+      const auto lid = packed_id(lhs);
+      const auto rid = packed_id(rhs);
+      if (lid == Invalid || rid == Invalid)
+        return {};
+
+      if (lid == rid && simd::has_binary(op, lid) && !(lid == Int && op == val_ops::Division))
+      {
+        switch (lid)
+        {
+        case Int:     return packed_binary_as<int_type>(vs, op, lhs, rhs);
+        case Float:   return packed_binary_as<float_type>(vs, op, lhs, rhs);
+        case Complex: return packed_binary_as<complex_type>(vs, op, lhs, rhs);
+        default:      return {};
+        }
+      }
+
+      if (!utils::eq_any(lid, Int, Float) || !utils::eq_any(rid, Int, Float) || !simd::has_binary(op, Float))
+        return {};
+
+      float_buf lTmp;
+      float_buf rTmp;
+      return packed_binary(vs, op, as_floats(lhs, lTmp), as_floats(rhs, rTmp));
+    }
+
+    template <packable T>
+    value packed_unary(store& vs, val_ops op, std::span<const T> src) noexcept
+    {
+      const auto total = src.size();
+      auto&& resArr = vs.allocate_array(total);
+      auto res = resArr.make_packed<T>(total);
+      if (auto par = par_for(vs, total))
+      {
+        par->run(total, [&](size_type from, size_type to) noexcept
+          {
+            simd::unary(op, src.subspan(from, to - from), res.subspan(from, to - from));
+          });
+      }
+      else
+        simd::unary(op, src, res);
+
+      return value{ array_type{ vs.wrap(resArr) } };
+    }
+
+    template <packable T>
+    value packed_unary_as(store& vs, val_ops op, const array_wrapper& aw) noexcept
+    {
+      array_data::packed_buf<T> tmp;
+      return packed_unary(vs, op, aw.packed<T>(tmp));
+    }
+
+    //
+    // Applies a unary operation to every element of a packed array
+    //
+    val_opt packed_unary(store& vs, val_ops op, const array_wrapper& aw) noexcept
+    {
+      using enum type_id;
+      const auto id = packed_id(aw);
+      if (!simd::has_unary(op, id))
+        return {};
+
+      switch (id)
+      {
+      case Int:     return packed_unary_as<int_type>(vs, op, aw);
+      case Float:   return packed_unary_as<float_type>(vs, op, aw);
+      case Complex: return packed_unary_as<complex_type>(vs, op, aw);
+      default:      return {};
+      }
+    }
+
+    //
+    // Checks whether every element of an array can be computed on a worker
+    // Arrays and functions refer to the value store, which isn't thread safe
+    //
+    bool has_plain_elems(const array_wrapper& aw) noexcept
+    {
+      for (auto&& elem : aw)
+      {
+        if (utils::eq_any(elem.id(), type_id::Array, type_id::Function))
+          return false;
+      }
+
+      return true;
+    }
+
+    //
+    // Computes elements on workers, and stores them in order on the calling thread
+    //
+    template <typename F>
+    value collect_elems(store& vs, par_elems& par, size_type total, F&& compute) noexcept
+    {
+      std::vector<value> results(total);
+      par.run(total, [&](size_type from, size_type to) noexcept
+        {
+          for (auto idx = from; idx < to; ++idx)
+            results[idx] = compute(idx);
+        });
+
+      auto&& resArr = vs.allocate_array(total);
+      for (auto&& res : results)
+        resArr.add(std::move(res));
+
+      return value{ array_type{ vs.wrap(resArr) } };
+    }
+
+    //
+    // Applies a unary operation to a large array of scalars in parallel
+    //
+    val_opt par_unary(store& vs, val_ops op, const array_wrapper& aw) noexcept
+    {
+      const auto total = aw.size();
+      auto par = par_for(vs, total);
+      if (!par || !has_plain_elems(aw))
+        return {};
+
+      const auto elems = aw.begin();
+      return collect_elems(vs, *par, total, [&](size_type idx) noexcept
+        {
+          return elems[idx].unary(op);
+        });
+    }
+
+    //
+    // Applies a binary operation to every pair of elements
+    // of large arrays of scalars in parallel
+    //
+    val_opt par_binary(store& vs, val_ops op, const array_wrapper& lhs, const array_wrapper& rhs) noexcept
+    {
+      const auto rowSz = rhs.size();
+      const auto total = lhs.size() * rowSz;
+      auto par = par_for(vs, total);
+      if (!par || !has_plain_elems(lhs) || !has_plain_elems(rhs))
+        return {};
+
+      const auto lElems = lhs.begin();
+      const auto rElems = rhs.begin();
+      return collect_elems(vs, *par, total, [&](size_type idx) noexcept
+        {
+          return lElems[idx / rowSz].binary(op, rElems[idx % rowSz]);
+        });
+    }
+
+    //
+    // Compares packed arrays up to the length of the shorter one
+    // Returns an empty result if they have to be compared element by element
+    //
+    std::optional<cmp> packed_compare(const array_wrapper& lhs, const array_wrapper& rhs) noexcept
+    {
+      array_data::packed_buf<int_type> lIntTmp;
+      array_data::packed_buf<int_type> rIntTmp;
+      auto lInts = lhs.packed<int_type>(lIntTmp);
+      auto rInts = rhs.packed<int_type>(rIntTmp);
+      if (!lInts.empty() && !rInts.empty())
+      {
+        const auto at = simd::mismatch(lInts, rInts);
+        if (at == std::min(lInts.size(), rInts.size()))
+          return cmp::Equal;
+
+        return lInts[at] < rInts[at] ? cmp::Less : cmp::Greater;
+      }
+
+      // Floats are compared with a tolerance, which doesn't vectorise
+      float_buf lFloatTmp;
+      float_buf rFloatTmp;
+      auto lFloats = lhs.packed<float_type>(lFloatTmp);
+      auto rFloats = rhs.packed<float_type>(rFloatTmp);
+      if (lFloats.empty() || rFloats.empty())
+        return {};
+
+      const auto count = std::min(lFloats.size(), rFloats.size());
+      for (auto idx = size_type{}; idx < count; ++idx)
+      {
+        const auto le = lFloats[idx];
+        const auto re = rFloats[idx];
+        if (eval::eq(le, re))
+          continue;
+
+        return eval::less(le, re) ? cmp::Less : cmp::Greater;
+      }
+
+      return cmp::Equal;
+    }
+  }
+}
+
+// Ranges
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    template <rangeable T>
+    using range_of = array_data::range_desc<T>;
+
+    template <rangeable T>
+    value make_range(store& vs, const range_of<T>& r) noexcept
+    {
+      auto&& arr = vs.allocate_array(size_type{});
+      arr.make_range(r.m_start, r.m_step, r.m_count);
+      return value{ array_type{ vs.wrap(arr) } };
+    }
+
+    //
+    // Converts a range bound to a float
+    //
+    std::optional<float_type> range_float(const value& val) noexcept
+    {
+      if (auto i = val.try_get<int_type>())
+        return static_cast<float_type>(*i);
+
+      if (auto f = val.try_get<float_type>())
+        return *f;
+
+      return {};
+    }
+
+    //
+    // Returns the elements visible through a wrapper as a packed buffer
+    // Ranges are generated into the temporary one
+    //
+    template <rangeable T>
+    std::span<const T> packed_view(const array_wrapper& aw, std::vector<T>& tmp) noexcept
+    {
+      auto r = aw.range<T>();
+      if (!r)
+      {
+        // Strided views of float ranges are generated element by element
+        if (auto all = aw.data().range<T>())
+        {
+          tmp.resize(aw.size());
+          for (auto idx = size_type{}; idx < tmp.size(); ++idx)
+            tmp[idx] = all->at(aw.index_of(idx));
+
+          return tmp;
+        }
+
+        return aw.packed<T>(tmp);
+      }
+
+      tmp.resize(r->m_count);
+      for (auto idx = size_type{}; idx < r->m_count; ++idx)
+        tmp[idx] = r->at(idx);
+
+      return tmp;
+    }
+
+    template <rangeable T>
+    val_opt range_unary(store& vs, val_ops op, const array_wrapper& aw, const range_of<T>& r) noexcept
+    {
+      if (op == val_ops::UnaryPlus)
+        return make_range(vs, r);
+
+      if (op == val_ops::UnaryNegation)
+        return make_range(vs, range_of<T>{ -r.m_start, -r.m_step, r.m_count });
+
+      if (!simd::has_unary(op, utils::type_to_id_v<T>))
+        return {};
+
+      std::vector<T> tmp;
+      return packed_unary(vs, op, packed_view<T>(aw, tmp));
+    }
+
+    //
+    // Applies a unary operation to a range
+    // Negation and unary plus produce another range,
+    // other operations are computed over the generated elements
+    //
+    val_opt range_unary(store& vs, val_ops op, const array_wrapper& aw) noexcept
+    {
+      if (auto r = aw.range<int_type>())
+        return range_unary(vs, op, aw, *r);
+
+      if (auto r = aw.range<float_type>())
+        return range_unary(vs, op, aw, *r);
+
+      return {};
+    }
+
+    //
+    // Adds an int to an int range, subtracts one from another,
+    // or multiplies them, producing another range
+    //
+    val_opt affine_range(store& vs, val_ops op, const range_of<int_type>& r, int_type scalar, bool rangeFirst) noexcept
+    {
+      using enum val_ops;
+      using int_range = range_of<int_type>;
+      switch (op)
+      {
+      case Addition:
+        return make_range(vs, int_range{ r.m_start + scalar, r.m_step, r.m_count });
+
+      case Subtraction:
+        if (rangeFirst)
+          return make_range(vs, int_range{ r.m_start - scalar, r.m_step, r.m_count });
+
+        return make_range(vs, int_range{ scalar - r.m_start, -r.m_step, r.m_count });
+
+      case Multiplication:
+        return make_range(vs, int_range{ r.m_start * scalar, r.m_step * scalar, r.m_count });
+
+      default:
+        return {};
+      }
+    }
+
+    //
+    // Returns the only element of an array if it is an int
+    //
+    std::optional<int_type> single_int(const array_wrapper& aw) noexcept
+    {
+      if (aw.size() != 1)
+        return {};
+
+      const auto elem = aw.data().read_at(aw.offset());
+      auto i = elem.try_get<int_type>();
+      if (!i)
+        return {};
+
+      return *i;
+    }
+
+    template <rangeable T>
+    val_opt range_packed(store& vs, val_ops op, const array_wrapper& lhs, const array_wrapper& rhs) noexcept
+    {
+      constexpr auto ti = utils::type_to_id_v<T>;
+      if (!simd::has_binary(op, ti) || (ti == type_id::Int && op == val_ops::Division))
+        return {};
+
+      std::vector<T> lTmp;
+      std::vector<T> rTmp;
+      auto l = packed_view<T>(lhs, lTmp);
+      auto r = packed_view<T>(rhs, rTmp);
+      if (l.empty() || r.empty())
+        return {};
+
+      return packed_binary(vs, op, l, r);
+    }
+
+    //
+    // Applies a binary operation to arrays at least one of which is a range
+    // Int ranges combined with an int by addition, subtraction, or multiplication
+    // stay lazy. Float ones don't, since the result would be rounded differently.
+    // Everything else is computed by the packed kernels over the generated elements
+    //
+    val_opt range_binary(store& vs, val_ops op, const array_wrapper& lhs, const array_wrapper& rhs) noexcept
+    {
+      if (!lhs.data().is_range() && !rhs.data().is_range())
+        return {};
+
+      if (auto r = lhs.range<int_type>())
+      {
+        if (auto scalar = single_int(rhs))
+        {
+          if (auto res = affine_range(vs, op, *r, *scalar, true))
+            return res;
+        }
+      }
+
+      if (auto r = rhs.range<int_type>())
+      {
+        if (auto scalar = single_int(lhs))
+        {
+          if (auto res = affine_range(vs, op, *r, *scalar, false))
+            return res;
+        }
+      }
+
+      if (auto res = range_packed<int_type>(vs, op, lhs, rhs))
+        return res;
+
+      return range_packed<float_type>(vs, op, lhs, rhs);
+    }
+  }
+}
+
+// Fused chains
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    //
+    // Operands and operations of a chain of binary operations
+    // Operation N combines the result so far with operand N + 1
+    //
+    struct chain
+    {
+      std::vector<const value*> m_vals;
+      std::vector<val_ops> m_ops;
+    };
+
+    template <packable T>
+    using packed_list = std::span<const T>;
+
+    using elem_list = std::ranges::subrange<array_wrapper::iterator>;
+
+    //
+    // Elements of a chain operand
+    // Non-arrays act as single element arrays, same as in regular array operations
+    //
+    elem_list chain_elems(const value& val) noexcept
+    {
+      auto arr = val.try_get<array_type>();
+      if (!arr)
+        return { strided_iter{ &val, 0, 1 }, strided_iter{ &val, 1, 1 } };
+
+      auto&& aw = (*arr).wrapper();
+      return { aw.begin(), aw.end() };
+    }
+
+    template <packable T>
+    void packed_level(const chain& ch, std::span<const packed_list<T>> lists, size_type level, T acc, std::span<T>& out) noexcept
+    {
+      auto&& list = lists[level];
+      const auto op = ch.m_ops[level - 1];
+      if (level + 1 == lists.size())
+      {
+        simd::binary_row(op, acc, list, out.first(list.size()));
+        out = out.subspan(list.size());
+        return;
+      }
+
+      for (auto elem : list)
+      {
+        T next{};
+        simd::binary_row(op, acc, packed_list<T>{ &elem, 1 }, std::span<T>{ &next, 1 });
+        packed_level<T>(ch, lists, level + 1, next, out);
+      }
+    }
+
+    template <packable T>
+    val_opt packed_chain(store& vs, const chain& ch, size_type total) noexcept
+    {
+      constexpr auto ti = utils::type_to_id_v<T>;
+      for (auto op : ch.m_ops)
+      {
+        if (!simd::has_binary(op, ti) || (ti == type_id::Int && op == val_ops::Division))
+          return {};
+      }
+
+      // Scalars and strided views are stored aside so that every operand can be viewed as a span
+      const auto count = ch.m_vals.size();
+      std::vector<T> scalars(count);
+      std::vector<array_data::packed_buf<T>> gathered(count);
+      std::vector<packed_list<T>> lists;
+      lists.reserve(count);
+      for (auto idx = size_type{}; idx < count; ++idx)
+      {
+        auto&& val = *ch.m_vals[idx];
+        if (auto arr = val.try_get<array_type>())
+        {
+          auto elems = (*arr).wrapper().packed<T>(gathered[idx]);
+          if (elems.empty())
+            return {};
+
+          lists.push_back(elems);
+          continue;
+        }
+
+        auto scalar = val.try_get<T>();
+        if (!scalar)
+          return {};
+
+        scalars[idx] = *scalar;
+        lists.emplace_back(&scalars[idx], 1);
+      }
+
+      auto&& resArr = vs.allocate_array(total);
+      auto out = resArr.make_packed<T>(total);
+      for (auto elem : lists.front())
+        packed_level<T>(ch, lists, 1, elem, out);
+
+      return value{ array_type{ vs.wrap(resArr) } };
+    }
+
+    //
+    // Computes a chain over packed arrays of the same type
+    //
+    val_opt packed_chain(store& vs, const chain& ch, size_type total) noexcept
+    {
+      auto ti = type_id::Invalid;
+      for (auto val : ch.m_vals)
+      {
+        if (auto arr = val->try_get<array_type>())
+        {
+          ti = packed_id((*arr).wrapper());
+          break;
+        }
+      }
+
+      using enum type_id;
+      switch (ti)
+      {
+      case Int:     return packed_chain<int_type>(vs, ch, total);
+      case Float:   return packed_chain<float_type>(vs, ch, total);
+      case Complex: return packed_chain<complex_type>(vs, ch, total);
+      default:      return {};
+      }
+    }
+
+    void chain_level(const chain& ch, std::span<const elem_list> lists, size_type level, const value& acc, array_data& out) noexcept
+    {
+      const auto op = ch.m_ops[level - 1];
+      const auto isLast = level + 1 == lists.size();
+      for (auto&& elem : lists[level])
+      {
+        if (isLast)
+          out.add(acc.binary(op, elem));
+        else
+          chain_level(ch, lists, level + 1, acc.binary(op, elem), out);
+      }
+    }
+
+    //
+    // Computes a chain element by element
+    //
+    value generic_chain(store& vs, const chain& ch, size_type total) noexcept
+    {
+      std::vector<elem_list> lists;
+      lists.reserve(ch.m_vals.size());
+      for (auto val : ch.m_vals)
+        lists.push_back(chain_elems(*val));
+
+      auto&& resArr = vs.allocate_array(total);
+      for (auto&& elem : lists.front())
+        chain_level(ch, lists, 1, elem, resArr);
+
+      return value{ array_type{ vs.wrap(resArr) } };
+    }
+  }
+}
+
 namespace tnac::eval
 {
   // Special members
@@ -60,7 +694,7 @@ namespace tnac::eval
 
   value::operator bool() const noexcept
   {
-    return !std::holds_alternative<invalid_val_t>(m_raw);
+    return id() != Invalid;
   }
 
 
@@ -68,7 +702,11 @@ namespace tnac::eval
 
   type_id value::id() const noexcept
   {
+#if TNAC_NAN_BOXING
+    return m_raw.id();
+#else
     return static_cast<type_id>(m_raw.index());
+#endif
   }
 
   string_t value::id_str(type_id id) noexcept
@@ -167,6 +805,12 @@ namespace tnac::eval
     return value{ false };
   }
 
+  const value& value::invalid() noexcept
+  {
+    static const value inv{};
+    return inv;
+  }
+
   value value::function(ir::function& func) noexcept
   {
     return value{ function_type{ func } };
@@ -177,6 +821,26 @@ namespace tnac::eval
     return value{ array_type{ aw } };
   }
 
+  value value::range(store& vs, const value& count, const value& start, const value& step) noexcept
+  {
+    auto cnt = count.try_get<int_type>();
+    if (!cnt || *cnt < 0)
+      return {};
+
+    const auto size = static_cast<detail::size_type>(*cnt);
+    auto intStart = start.try_get<int_type>();
+    auto intStep = step.try_get<int_type>();
+    if (intStart && intStep)
+      return detail::make_range(vs, detail::range_of<int_type>{ *intStart, *intStep, size });
+
+    auto fltStart = detail::range_float(start);
+    auto fltStep = detail::range_float(step);
+    if (!fltStart || !fltStep)
+      return {};
+
+    return detail::make_range(vs, detail::range_of<float_type>{ *fltStart, *fltStep, size });
+  }
+
 
   // Unary ops
   namespace
@@ -243,11 +907,107 @@ namespace tnac::eval
     {
       return eval::tail(arr);
     }
+
+    template <val_ops Op, expr_result T>
+    value unary_op(const T& val) noexcept
+    {
+      using enum val_ops;
+      if constexpr (Op == UnaryNegation)        return unary_neg(val);
+      else if constexpr (Op == UnaryPlus)       return unary_plus(val);
+      else if constexpr (Op == UnaryBitwiseNot) return bitwise_not(val);
+      else if constexpr (Op == LogicalNot)      return logical_not(val);
+      else if constexpr (Op == LogicalIs)       return logical_is(val);
+      else if constexpr (Op == AbsoluteValue)   return absolute(val);
+      else if constexpr (Op == UnaryHead)       return unary_head(val);
+      else if constexpr (Op == PostTail)        return unary_tail(val);
+      else                                      return value{};
+    }
+
+    template <expr_result T>
+    value unary_op(val_ops op, const T& val) noexcept
+    {
+      using enum val_ops;
+      switch (op)
+      {
+      case UnaryNegation:   return unary_op<UnaryNegation>(val);
+      case UnaryPlus:       return unary_op<UnaryPlus>(val);
+      case UnaryBitwiseNot: return unary_op<UnaryBitwiseNot>(val);
+      case LogicalNot:      return unary_op<LogicalNot>(val);
+      case LogicalIs:       return unary_op<LogicalIs>(val);
+      case AbsoluteValue:   return unary_op<AbsoluteValue>(val);
+      case UnaryHead:       return unary_op<UnaryHead>(val);
+      case PostTail:        return unary_op<PostTail>(val);
+
+      default: return value{};
+      }
+    }
+  }
+
+  // Unary dispatch
+  namespace detail
+  {
+    namespace
+    {
+      using unary_kernel = value(*)(const value&, val_ops) noexcept;
+
+      constexpr auto typeCount = static_cast<std::size_t>(type_id::Array) + 1;
+      constexpr auto opCount   = static_cast<std::size_t>(val_ops::AbsoluteValue) + 1;
+
+      //
+      // Types which get specialised kernels
+      // Everything else goes through the generic path
+      //
+      template <type_id TI>
+      constexpr auto has_kernel() noexcept
+      {
+        using enum type_id;
+        return TI == Bool || TI == Int || TI == Float;
+      }
+
+      value generic_unary(const value& val, val_ops op) noexcept
+      {
+        return val.unary_generic(op);
+      }
+
+      template <type_id TI, val_ops Op>
+      value kernel_unary(const value& val, val_ops) noexcept
+      {
+        using arg_t = utils::id_to_type_t<TI>;
+        using op_type = common_type_t<arg_t, arg_t>;
+        return unary_op<Op>(static_cast<op_type>(val.get<TI>()));
+      }
+
+      template <std::size_t Idx>
+      constexpr unary_kernel make_unary_kernel() noexcept
+      {
+        constexpr auto ti = static_cast<type_id>(Idx / opCount);
+        constexpr auto op = static_cast<val_ops>(Idx % opCount);
+        if constexpr (has_kernel<ti>() && is_unary(op))
+          return &kernel_unary<ti, op>;
+        else
+          return &generic_unary;
+      }
+
+      template <std::size_t... Idx>
+      constexpr auto make_unary_table(utils::idx_seq<std::size_t, Idx...>) noexcept
+      {
+        return std::array<unary_kernel, sizeof...(Idx)>{ make_unary_kernel<Idx>()... };
+      }
+
+      constexpr auto unaryTable = make_unary_table(utils::idx_gen<typeCount * opCount>{});
+
+      auto unary_kernel_for(type_id ti, val_ops op) noexcept
+      {
+        const auto idx = static_cast<std::size_t>(ti) * opCount + static_cast<std::size_t>(op);
+        UTILS_ASSERT(idx < unaryTable.size());
+        return unaryTable[idx];
+      }
+    }
   }
 
   value value::unary_as_array(val_ops op) const noexcept
   {
-    auto arr = std::get<array_type>(m_raw);
+    auto arr = get<array_type>();
     if (utils::eq_any(op, val_ops::LogicalIs, val_ops::LogicalNot))
     {
       auto toBool = get_caster<bool_type>()(std::move(arr));
@@ -261,6 +1021,15 @@ namespace tnac::eval
       return unary_tail(arr);
 
     auto&& store = arr->val_store();
+    if (auto lazy = detail::range_unary(store, op, arr.wrapper()))
+      return *lazy;
+
+    if (auto packed = detail::packed_unary(store, op, arr.wrapper()))
+      return *packed;
+
+    if (auto par = detail::par_unary(store, op, arr.wrapper()))
+      return *par;
+
     auto&& resData = store.allocate_array(arr->size());
     for (auto&& it : arr.wrapper())
     {
@@ -272,6 +1041,11 @@ namespace tnac::eval
   }
 
   value value::unary(val_ops op) const noexcept
+  {
+    return detail::unary_kernel_for(id(), op)(*this, op);
+  }
+
+  value value::unary_generic(val_ops op) const noexcept
   {
     if (is_array())
       return unary_as_array(op);
@@ -279,7 +1053,7 @@ namespace tnac::eval
     value res{};
     if (detail::is_unary(op))
     {
-      res = std::visit([op](const auto& v) noexcept
+      res = on_value(*this, [op](const auto& v) noexcept
         {
           using arg_t = std::remove_cvref_t<decltype(v)>;
           using op_type = common_type_t<arg_t, arg_t>;
@@ -287,22 +1061,8 @@ namespace tnac::eval
           if (!val)
             return value{};
 
-          using enum val_ops;
-          switch (op)
-          {
-          case UnaryNegation:   return unary_neg(*val);
-          case UnaryPlus:       return unary_plus(*val);
-          case UnaryBitwiseNot: return bitwise_not(*val);
-          case LogicalNot:      return logical_not(*val);
-          case LogicalIs:       return logical_is(*val);
-          case AbsoluteValue:   return absolute(*val);
-          case UnaryHead:       return unary_head(*val);
-          case PostTail:        return unary_tail(*val);
-
-          default: return value{};
-          }
-        },
-        m_raw);
+          return unary_op(op, *val);
+        });
     }
 
     return res;
@@ -387,19 +1147,30 @@ namespace tnac::eval
       }
 
       auto res = cmp::Equal;
-      for (auto&& [le, re] : utils::make_iterators(lhs.wrapper(), rhs.wrapper()))
+      if (auto packed = detail::packed_compare(lhs.wrapper(), rhs.wrapper()))
       {
-        if (to_bool(le.binary(val_ops::Equal, re)))
-          continue;
-
-        if (to_bool(le.binary(val_ops::RelLess, re)))
+        res = *packed;
+      }
+      else
+      {
+        auto li = lhs.wrapper().begin();
+        auto ri = rhs.wrapper().begin();
+        for (auto count = std::min(lsz, rsz); count; --count, ++li, ++ri)
         {
-          res = cmp::Less;
+          const auto le = *li;
+          const auto re = *ri;
+          if (to_bool(le.binary(val_ops::Equal, re)))
+            continue;
+
+          if (to_bool(le.binary(val_ops::RelLess, re)))
+          {
+            res = cmp::Less;
+            break;
+          }
+
+          res = cmp::Greater;
           break;
         }
-
-        res = cmp::Greater;
-        break;
       }
 
       if (res != cmp::Equal)
@@ -613,6 +1384,108 @@ namespace tnac::eval
     {
       return value{};
     }
+
+    template <val_ops Op, expr_result T>
+    value binary_op(const T& lhs, const T& rhs) noexcept
+    {
+      using enum val_ops;
+      if constexpr (Op == Addition)            return add(lhs, rhs);
+      else if constexpr (Op == Subtraction)    return sub(lhs, rhs);
+      else if constexpr (Op == Multiplication) return mul(lhs, rhs);
+      else if constexpr (Op == Division)       return div(lhs, rhs);
+      else if constexpr (Op == Modulo)         return mod(lhs, rhs);
+      else if constexpr (Op == RelLess)        return lt(lhs, rhs);
+      else if constexpr (Op == RelLessEq)      return lte(lhs, rhs);
+      else if constexpr (Op == RelGr)          return gt(lhs, rhs);
+      else if constexpr (Op == RelGrEq)        return gte(lhs, rhs);
+      else if constexpr (Op == Equal)          return eq(lhs, rhs, true);
+      else if constexpr (Op == NEqual)         return eq(lhs, rhs, false);
+      else if constexpr (Op == BitwiseAnd)     return bit_and(lhs, rhs);
+      else if constexpr (Op == BitwiseXor)     return bit_xor(lhs, rhs);
+      else if constexpr (Op == BitwiseOr)      return bit_or(lhs, rhs);
+      else if constexpr (Op == BinaryPow)      return power(lhs, rhs);
+      else if constexpr (Op == BinaryRoot)     return root(lhs, rhs);
+      else                                     return value{};
+    }
+
+    template <expr_result T>
+    value binary_op(val_ops op, const T& lhs, const T& rhs) noexcept
+    {
+      using enum val_ops;
+      switch (op)
+      {
+      case Addition:       return binary_op<Addition>(lhs, rhs);
+      case Subtraction:    return binary_op<Subtraction>(lhs, rhs);
+      case Multiplication: return binary_op<Multiplication>(lhs, rhs);
+      case Division:       return binary_op<Division>(lhs, rhs);
+      case Modulo:         return binary_op<Modulo>(lhs, rhs);
+
+      case RelLess:        return binary_op<RelLess>(lhs, rhs);
+      case RelLessEq:      return binary_op<RelLessEq>(lhs, rhs);
+      case RelGr:          return binary_op<RelGr>(lhs, rhs);
+      case RelGrEq:        return binary_op<RelGrEq>(lhs, rhs);
+      case Equal:          return binary_op<Equal>(lhs, rhs);
+      case NEqual:         return binary_op<NEqual>(lhs, rhs);
+
+      case BitwiseAnd:     return binary_op<BitwiseAnd>(lhs, rhs);
+      case BitwiseXor:     return binary_op<BitwiseXor>(lhs, rhs);
+      case BitwiseOr:      return binary_op<BitwiseOr>(lhs, rhs);
+
+      case BinaryPow:      return binary_op<BinaryPow>(lhs, rhs);
+      case BinaryRoot:     return binary_op<BinaryRoot>(lhs, rhs);
+
+      default: return value{};
+      }
+    }
+  }
+
+  // Binary dispatch
+  namespace detail
+  {
+    namespace
+    {
+      using binary_kernel = value(*)(const value&, const value&, val_ops) noexcept;
+
+      value generic_binary(const value& lhs, const value& rhs, val_ops op) noexcept
+      {
+        return lhs.binary_generic(op, rhs);
+      }
+
+      template <type_id L, type_id R, val_ops Op>
+      value kernel_binary(const value& lhs, const value& rhs, val_ops) noexcept
+      {
+        using common_t = common_type_t<utils::id_to_type_t<L>, utils::id_to_type_t<R>>;
+        return binary_op<Op>(static_cast<common_t>(lhs.get<L>()), static_cast<common_t>(rhs.get<R>()));
+      }
+
+      template <std::size_t Idx>
+      constexpr binary_kernel make_binary_kernel() noexcept
+      {
+        constexpr auto op = static_cast<val_ops>(Idx % opCount);
+        constexpr auto r  = static_cast<type_id>(Idx / opCount % typeCount);
+        constexpr auto l  = static_cast<type_id>(Idx / opCount / typeCount);
+        if constexpr (has_kernel<l>() && has_kernel<r>() && is_binary(op))
+          return &kernel_binary<l, r, op>;
+        else
+          return &generic_binary;
+      }
+
+      template <std::size_t... Idx>
+      constexpr auto make_binary_table(utils::idx_seq<std::size_t, Idx...>) noexcept
+      {
+        return std::array<binary_kernel, sizeof...(Idx)>{ make_binary_kernel<Idx>()... };
+      }
+
+      constexpr auto binaryTable = make_binary_table(utils::idx_gen<typeCount * typeCount * opCount>{});
+
+      auto binary_kernel_for(type_id l, type_id r, val_ops op) noexcept
+      {
+        const auto idx = (static_cast<std::size_t>(l) * typeCount + static_cast<std::size_t>(r)) * opCount
+                       + static_cast<std::size_t>(op);
+        UTILS_ASSERT(idx < binaryTable.size());
+        return binaryTable[idx];
+      }
+    }
   }
 
   value value::binary_as_array(val_ops op, const value& r) const noexcept
@@ -649,6 +1522,15 @@ namespace tnac::eval
       return {};
 
     UTILS_ASSERT(vs);
+    if (auto lazy = detail::range_binary(*vs, op, larr.wrapper(), rarr.wrapper()))
+      return *lazy;
+
+    if (auto packed = detail::packed_binary(*vs, op, larr.wrapper(), rarr.wrapper()))
+      return *packed;
+
+    if (auto par = detail::par_binary(*vs, op, larr.wrapper(), rarr.wrapper()))
+      return *par;
+
     auto&& resArr = vs->allocate_array(lsz * rsz);
     for (auto&& li : larr.wrapper())
     {
@@ -662,6 +1544,11 @@ namespace tnac::eval
   }
 
   value value::binary(val_ops op, const value& rhs) const noexcept
+  {
+    return detail::binary_kernel_for(id(), rhs.id(), op)(*this, rhs, op);
+  }
+
+  value value::binary_generic(val_ops op, const value& rhs) const noexcept
   {
     if (is_array() || rhs.is_array())
       return binary_as_array(op, rhs);
@@ -669,52 +1556,83 @@ namespace tnac::eval
     value res{};
     if (detail::is_binary(op))
     {
-      res = std::visit([op](const auto& l, const auto& r) noexcept
+      res = on_value(*this, [op, &rhs](const auto& l) noexcept
         {
-          using lhs_t = std::remove_cvref_t<decltype(l)>;
-          using rhs_t = std::remove_cvref_t<decltype(r)>;
-          using common_t = common_type_t<lhs_t, rhs_t>;
-          auto caster = get_caster<common_t>();
-          auto lhs = caster(l);
-          auto rhs = caster(r);
-          if (!lhs || !rhs)
-          {
-            return value{};
-          }
-
-          using enum val_ops;
-          switch (op)
+          return on_value(rhs, [op, &l](const auto& r) noexcept
           {
-          case Addition:       return add(*lhs, *rhs);
-          case Subtraction:    return sub(*lhs, *rhs);
-          case Multiplication: return mul(*lhs, *rhs);
-          case Division:       return div(*lhs, *rhs);
-          case Modulo:         return mod(*lhs, *rhs);
-
-          case RelLess:        return lt(*lhs, *rhs);
-          case RelLessEq:      return lte(*lhs, *rhs);
-          case RelGr:          return gt(*lhs, *rhs);
-          case RelGrEq:        return gte(*lhs, *rhs);
-          case Equal:          return eq(*lhs, *rhs, true);
-          case NEqual:         return eq(*lhs, *rhs, false);
-
-          case BitwiseAnd:     return bit_and(*lhs, *rhs);
-          case BitwiseXor:     return bit_xor(*lhs, *rhs);
-          case BitwiseOr:      return bit_or(*lhs, *rhs);
-
-          case BinaryPow:      return power(*lhs, *rhs);
-          case BinaryRoot:     return root(*lhs, *rhs);
-
-          default: return value{};
-          }
-        },
-        m_raw, rhs.m_raw);
+            using lhs_t = std::remove_cvref_t<decltype(l)>;
+            using rhs_t = std::remove_cvref_t<decltype(r)>;
+            using common_t = common_type_t<lhs_t, rhs_t>;
+            auto caster = get_caster<common_t>();
+            auto lhs = caster(l);
+            auto rhs = caster(r);
+            if (!lhs || !rhs)
+            {
+              return value{};
+            }
+
+            return binary_op(op, *lhs, *rhs);
+          });
+        });
     }
 
     return res;
   }
 
 
+  value value::binary_chain(val_ops op, const value& rhs, chain_links links) const noexcept
+  {
+    detail::chain ch;
+    ch.m_vals.reserve(links.size() + 2);
+    ch.m_ops.reserve(links.size() + 1);
+    ch.m_vals.push_back(this);
+    ch.m_vals.push_back(&rhs);
+    ch.m_ops.push_back(op);
+    for (auto&& link : links)
+    {
+      ch.m_vals.push_back(link.m_val);
+      ch.m_ops.push_back(link.m_op);
+    }
+
+    // Each array operation over arrays is an outer product of their elements,
+    // so the whole chain is a single loop nest over all operands
+    store* vs{};
+    auto total = size_type{ 1 };
+    auto hasRange = false;
+    for (auto val : ch.m_vals)
+    {
+      auto arr = val->try_get<array_type>();
+      if (!arr)
+        continue;
+
+      vs = &(*arr)->val_store();
+      total *= (*arr)->size();
+      hasRange = hasRange || (*arr)->data().is_range();
+    }
+
+    // Comparisons and empty arrays don't produce arrays, so they are left as is.
+    // Ranges are kept lazy by the regular operations
+    const auto fusable = std::ranges::none_of(ch.m_ops, [](val_ops o) noexcept
+      {
+        return !detail::is_binary(o) || detail::is_comparison(o);
+      });
+
+    if (!vs || !total || !fusable || hasRange)
+    {
+      auto res = binary(op, rhs);
+      for (auto&& link : links)
+        res = res.binary(link.m_op, *link.m_val);
+
+      return res;
+    }
+
+    if (auto packed = detail::packed_chain(*vs, ch, total))
+      return *packed;
+
+    return detail::generic_chain(*vs, ch, total);
+  }
+
+
   // Private members
 
   bool value::is_array() const noexcept
@@ -2,6 +2,35 @@
 #include "eval/value/value.hpp"
 #include "eval/value/type_impl.hpp"
 
+namespace tnac::eval::detail
+{
+  namespace
+  {
+    using data_refs = std::unordered_map<const array_data*, std::size_t>;
+    using wrap_refs = std::unordered_map<const array_wrapper*, std::size_t>;
+    using data_set  = std::unordered_set<const array_data*>;
+
+    //
+    // Calls the given functions for each array and closure referenced by the array elements
+    // Packed arrays only hold numbers, so there's nothing to visit
+    //
+    template <typename WF, typename DF>
+    void for_each_ref(const array_data& arr, WF&& onWrapper, DF&& onData) noexcept
+    {
+      if (!arr.is_boxed())
+        return;
+
+      for (auto&& elem : arr)
+      {
+        if (auto subarr = elem.try_get<array_type>())
+          onWrapper(subarr->wrapper());
+        else if (auto fn = elem.try_get<function_type>(); fn && fn->is_closure())
+          onData(fn->closure_data());
+      }
+    }
+  }
+}
+
 namespace tnac::eval
 {
   // Special members
@@ -15,6 +44,7 @@ namespace tnac::eval
 
   array_data& store::allocate_array(size_type size) noexcept
   {
+    ++m_allocs;
     return m_arrData.emplace_back(*this, size);
   }
 
@@ -48,4 +78,115 @@ namespace tnac::eval
 
     return wrap(aw.data(), offset, size);
   }
-}
\ No newline at end of file
+
+  array_wrapper& store::view(array_wrapper& aw, size_type from, size_type count, std::ptrdiff_t step) noexcept
+  {
+    UTILS_ASSERT(step);
+    UTILS_ASSERT(!count || (from < aw.size() && from + (count - 1) * step < aw.size()));
+    if (!from && count == aw.size() && step == 1)
+      return aw;
+
+    const auto offset = count ? aw.index_of(from) : aw.offset();
+    return m_arrWrappers.emplace_back(aw.data(), offset, count, aw.stride() * step);
+  }
+
+  void store::collect() noexcept
+  {
+    ++m_stats.m_collections;
+    m_allocs = {};
+
+    // Count references coming from within the store.
+    // Anything referenced more than that is held from outside, and is a root
+    detail::data_refs dataRefs;
+    detail::wrap_refs wrapRefs;
+    for (auto&& aw : m_arrWrappers)
+      ++dataRefs[&aw.data()];
+
+    for (auto&& arr : m_arrData)
+    {
+      detail::for_each_ref(arr,
+        [&](const array_wrapper& aw) noexcept { ++wrapRefs[&aw]; },
+        [&](const array_data& ad) noexcept { ++dataRefs[&ad]; });
+    }
+
+    std::vector<const array_data*> pending;
+    for (auto&& arr : m_arrData)
+    {
+      if (arr.refs() > dataRefs[&arr])
+        pending.push_back(&arr);
+    }
+    for (auto&& aw : m_arrWrappers)
+    {
+      if (aw.refs() > wrapRefs[&aw])
+        pending.push_back(&aw.data());
+    }
+
+    detail::data_set live;
+    while (!pending.empty())
+    {
+      auto arr = pending.back();
+      pending.pop_back();
+      if (!live.emplace(arr).second)
+        continue;
+
+      detail::for_each_ref(*arr,
+        [&](array_wrapper& aw) noexcept { pending.push_back(&aw.data()); },
+        [&](array_data& ad) noexcept { pending.push_back(&ad); });
+    }
+
+    // Keep dead arrays alive while their elements are dropped.
+    // This breaks cycles, and wrappers go away along with the references to them
+    std::vector<rc_wrapper<array_data>> dead;
+    for (auto&& arr : m_arrData)
+    {
+      if (!live.contains(&arr))
+        dead.emplace_back(arr);
+    }
+
+    m_stats.m_reclaimed += dead.size();
+    for (auto&& arr : dead)
+      arr->clear();
+
+    // Wrappers nobody has ever referenced don't remove themselves
+    std::vector<array_wrapper*> unused;
+    for (auto&& aw : m_arrWrappers)
+    {
+      if (!aw.hasref())
+        unused.push_back(&aw);
+    }
+    for (auto aw : unused)
+      aw->remove();
+
+    dead.clear();
+  }
+
+  void store::maybe_collect() noexcept
+  {
+    if (m_allocs >= collectThreshold)
+      collect();
+  }
+
+  void store::attach_par(par_elems* pe) noexcept
+  {
+    m_par = pe;
+  }
+
+  par_elems* store::par() const noexcept
+  {
+    return m_par;
+  }
+
+  store::size_type store::array_count() const noexcept
+  {
+    auto res = size_type{};
+    for ([[maybe_unused]] auto&& arr : m_arrData)
+      ++res;
+
+    return res;
+  }
+
+  const store::stats& store::counters() const noexcept
+  {
+    return m_stats;
+  }
+}
@@ -201,6 +201,7 @@ namespace tnac
           { "flt",    tok_kind::KwFloat },
           { "bool",   tok_kind::KwBool },
           { "array",  tok_kind::KwArray },
+          { "range",  tok_kind::KwRange },
           { "undef",  tok_kind::KwUndef },
           { "ret",    tok_kind::KwRet },
           { "true",   tok_kind::KwTrue },
@@ -212,7 +213,8 @@ namespace tnac
           { "import", tok_kind::KwImport },
           { "as",     tok_kind::KwAs },
           { "io",     tok_kind::KwIO },
-          { "this",   tok_kind::KwThis }
+          { "this",   tok_kind::KwThis },
+          { "lib",    tok_kind::KwLib }
         };
 
         constexpr auto err = tok_kind::Error;
@@ -201,7 +201,7 @@ namespace tnac::detail
     auto is_type_keyword(const token& tok) noexcept
     {
       using enum tok_kind;
-      return tok.is_any(KwComplex, KwFraction, KwInt, KwFloat, KwBool, KwArray);
+      return tok.is_any(KwComplex, KwFraction, KwInt, KwFloat, KwBool, KwArray, KwRange);
     }
 
     auto is_entry(const token& tok) noexcept
@@ -1259,6 +1259,10 @@ namespace tnac
         return error_expr(id, diag::scope_ref_nodot(), err_pos::Last);
     }
 
+    // Built-ins can only be called through their module
+    if (id.is(token::KwLib) && !detail::is_dot(peek_next()))
+      return error_expr(id, diag::scope_ref_nodot(), err_pos::Last);
+
     return m_builder.make_id(id, *sym);
   }
 
@@ -1,5 +1,6 @@
 #include "sema/sema.hpp"
 #include "parser/ast/ast.hpp"
+#include "eval/value/intrinsics.hpp"
 
 namespace tnac
 {
@@ -90,6 +91,9 @@ namespace tnac
 
   sema::sym_ptr sema::find(const token& tok, lookup_type type) noexcept
   {
+    if (tok.is(token::KwLib))
+      return &intrinsics();
+
     if (tok.is(token::KwThis))
     {
       auto enclosing = m_curScope->encl_skip_internal();
@@ -246,6 +250,47 @@ namespace tnac
     return { *this, found };
   }
 
+  semantics::module_sym& sema::intrinsics() noexcept
+  {
+    if (m_intrinsics)
+      return *m_intrinsics;
+
+    // Built-ins live next to user modules, but aren't visible without the module name
+    auto global = m_curScope;
+    while (global->enclosing())
+      global = global->enclosing();
+
+    auto loc = src::location::dummy().record();
+    auto&& libScope = m_symTab.add_scope(global, semantics::scope::Module);
+    m_intrinsics = &m_symTab.add_module("_lib"sv, global, loc, libScope);
+    libScope.attach_symbol(*m_intrinsics);
+
+    for (auto&& info : eval::intrinsics())
+    {
+      auto&& fnScope = m_symTab.add_scope(&libScope, semantics::scope::Function);
+      symbol_params params;
+      params.reserve(info.m_params.size());
+      for (auto paramName : info.m_params)
+        params.emplace_back(&m_symTab.add_parameter(paramName, &fnScope, loc));
+
+      auto&& fn = m_symTab.add_function(info.m_name, &libScope, std::move(params), loc, fnScope);
+      fnScope.attach_symbol(fn);
+    }
+
+    return *m_intrinsics;
+  }
+
+  bool sema::is_intrinsic(const semantics::symbol& sym) const noexcept
+  {
+    if (!m_intrinsics)
+      return false;
+
+    if (&sym == m_intrinsics)
+      return true;
+
+    return sym.is(semantics::sym_kind::Function) && &sym.owner_scope() == &m_intrinsics->own_scope();
+  }
+
   string_t sema::contrive_name() noexcept
   {
     return m_generatedNames.next_indexed("`__anon_entity__"sv);
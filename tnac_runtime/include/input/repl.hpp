@@ -132,6 +132,11 @@ namespace tnac::rt
     //
     void print_ir(ast::command cmd) noexcept;
 
+    //
+    // #cgen <'path'>
+    //
+    void emit_c(ast::command cmd) noexcept;
+
     //
     // #vars <'path'>
     //
@@ -152,6 +157,37 @@ namespace tnac::rt
     //
     void print_all(ast::command cmd) noexcept;
 
+    //
+    // #stats <'path'>
+    //
+    void print_stats(ast::command cmd) noexcept;
+
+    //
+    // #memo <all | off | function name>
+    //
+    void set_memo(ast::command cmd) noexcept;
+
+    //
+    // #jit <on | off>
+    //
+    void set_jit(ast::command cmd) noexcept;
+
+    //
+    // #par <on | off>
+    //
+    void set_par(ast::command cmd) noexcept;
+
+    //
+    // #inline <on | off>
+    //
+    void set_inline(ast::command cmd) noexcept;
+
+    //
+    // #threads <count> <grain>
+    // Zero or one thread turns parallel elementwise operations off
+    //
+    void set_threads(ast::command cmd) noexcept;
+
   private:
     inline static const source_manager::path_t m_fake{ "REPL" };
     
@@ -0,0 +1,122 @@
+//
+// C emitter
+//
+
+#pragma once
+#include "output/common.hpp"
+
+namespace tnac::rt::out
+{
+  //
+  // Translates IR into portable C source
+  // Each function becomes a C function operating on a tagged union
+  // defined by the runtime prelude, which makes the output self-contained
+  // The generated main calls the last module with numeric arguments
+  // from the command line and prints its result. Function descriptors
+  // have external linkage, so the output can also be built as a shared object
+  //
+  // Arrays, closures and dynamic binds have no C counterpart yet.
+  // Instructions using them compile to a runtime failure and are counted
+  //
+  class c_emitter : public ir::const_walker<c_emitter>
+  {
+  public:
+    using base      = ir::const_walker<c_emitter>;
+    using size_type = std::size_t;
+    using fn_map    = std::unordered_map<const ir::function*, size_type>;
+    using block_map = std::unordered_map<const ir::basic_block*, size_type>;
+    using reg_map   = std::unordered_map<const ir::vreg*, size_type>;
+    using param_map = std::unordered_map<const ir::vreg*, size_type>;
+
+  public:
+    CLASS_SPECIALS_NONE_CUSTOM(c_emitter);
+
+    ~c_emitter() noexcept;
+
+    c_emitter() noexcept;
+
+  public:
+    void operator()(const ir::cfg& gr, out_stream& os) noexcept;
+
+    void operator()(const ir::cfg& gr) noexcept;
+
+    //
+    // Returns the number of instructions which couldn't be translated
+    // during the last run
+    //
+    size_type unsupported_count() const noexcept;
+
+  public:
+    bool preview(const ir::function& fn) noexcept;
+
+    bool preview(const ir::basic_block& bb) noexcept;
+
+    void visit(const ir::function& fn) noexcept;
+
+    void visit(const ir::basic_block& bb) noexcept;
+
+    void visit(const ir::instruction& instr) noexcept;
+
+  private:
+    void emit_binary(const ir::instruction& bin) noexcept;
+
+    void emit_unary(const ir::instruction& un) noexcept;
+
+    void emit_type(const ir::instruction& inst) noexcept;
+
+    void emit_test(const ir::instruction& test) noexcept;
+
+    void emit_select(const ir::instruction& sel) noexcept;
+
+    void emit_load(const ir::instruction& load) noexcept;
+
+    void emit_store(const ir::instruction& store) noexcept;
+
+    void emit_call(const ir::instruction& call) noexcept;
+
+    void emit_jump(const ir::instruction& jmp) noexcept;
+
+    void emit_ret(const ir::instruction& ret) noexcept;
+
+    void emit_unsupported(const ir::instruction& instr) noexcept;
+
+    //
+    // Assigns phi nodes of the target block and jumps to it
+    //
+    void emit_edge(const ir::basic_block& from, const ir::basic_block& to) noexcept;
+
+  private:
+    out_stream& out() noexcept;
+
+    void endl() noexcept;
+
+    void plain(string_t str) noexcept;
+
+    void operand(const ir::operand& op) noexcept;
+
+    void value(const eval::value& val) noexcept;
+
+    void assign(const ir::operand& op) noexcept;
+
+    void label(const ir::basic_block& block) noexcept;
+
+    void func_name(const ir::function& fn) noexcept;
+
+    void func_descr(const ir::function& fn) noexcept;
+
+    void declare_funcs() noexcept;
+
+    void emit_main() noexcept;
+
+  private:
+    const ir::cfg* m_cfg{};
+    const ir::function* m_entry{};
+    const ir::basic_block* m_curBlock{};
+    out_stream* m_out{ &std::cout };
+    fn_map m_funcs;
+    block_map m_blocks;
+    reg_map m_regs;
+    param_map m_params;
+    size_type m_unsupported{};
+  };
+}
@@ -0,0 +1,600 @@
+//
+// C runtime for the C backend
+//
+
+#pragma once
+#include "output/common.hpp"
+
+namespace tnac::rt::out
+{
+  //
+  // Prelude written at the top of every generated C file
+  // Implements the value type and its operations in portable C11
+  // Mirrors the semantics of eval::value for the scalar types
+  //
+  inline constexpr string_t cRuntime = R"tnac(
+#include <complex.h>
+#include <inttypes.h>
+#include <math.h>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum
+{
+  TNAC_UNDEF,
+  TNAC_BOOL,
+  TNAC_INT,
+  TNAC_FLOAT,
+  TNAC_CPLX,
+  TNAC_FRAC,
+  TNAC_FN
+} tnac_type;
+
+typedef struct tnac_value tnac_value;
+
+typedef struct
+{
+  tnac_value (*body)(const tnac_value* args);
+  unsigned arity;
+  const char* name;
+} tnac_fn;
+
+typedef struct
+{
+  int64_t num;
+  int64_t den;
+  int sign;
+} tnac_frac_t;
+
+struct tnac_value
+{
+  tnac_type type;
+  union
+  {
+    int b;
+    int64_t i;
+    double f;
+    double _Complex c;
+    tnac_frac_t q;
+    const tnac_fn* fn;
+  } as;
+};
+
+typedef enum
+{
+  TNAC_ADD, TNAC_SUB, TNAC_MUL, TNAC_DIV, TNAC_MOD,
+  TNAC_LT, TNAC_LE, TNAC_GT, TNAC_GE, TNAC_EQ, TNAC_NE,
+  TNAC_AND, TNAC_XOR, TNAC_OR, TNAC_POW, TNAC_ROOT
+} tnac_binop;
+
+typedef enum
+{
+  TNAC_NEG, TNAC_PLUS, TNAC_BNEG, TNAC_NOT, TNAC_IS, TNAC_HEAD, TNAC_TAIL, TNAC_ABS
+} tnac_unop;
+
+/* Construction */
+
+static inline tnac_value tnac_undef(void) { tnac_value v; memset(&v, 0, sizeof v); return v; }
+static inline tnac_value tnac_bool(int b) { tnac_value v = tnac_undef(); v.type = TNAC_BOOL; v.as.b = !!b; return v; }
+static inline tnac_value tnac_int(int64_t i) { tnac_value v = tnac_undef(); v.type = TNAC_INT; v.as.i = i; return v; }
+static inline tnac_value tnac_float(double f) { tnac_value v = tnac_undef(); v.type = TNAC_FLOAT; v.as.f = f; return v; }
+static inline tnac_value tnac_fnval(const tnac_fn* fn) { tnac_value v = tnac_undef(); v.type = TNAC_FN; v.as.fn = fn; return v; }
+
+static inline tnac_value tnac_cplx(double re, double im)
+{
+  tnac_value v = tnac_undef();
+  v.type = TNAC_CPLX;
+  v.as.c = CMPLX(re, im);
+  return v;
+}
+
+static inline tnac_value tnac_cval(double _Complex c) { return tnac_cplx(creal(c), cimag(c)); }
+
+static inline int64_t tnac_gcd(int64_t a, int64_t b)
+{
+  while (b) { int64_t t = a % b; a = b; b = t; }
+  return a;
+}
+
+static inline tnac_frac_t tnac_qnorm(int64_t num, int64_t den)
+{
+  tnac_frac_t q;
+  q.sign = ((num < 0) != (den < 0)) ? -1 : 1;
+  q.num = num < 0 ? -num : num;
+  q.den = den < 0 ? -den : den;
+  if (!q.den)
+  {
+    q.num = 1;
+    return q;
+  }
+
+  int64_t g = tnac_gcd(q.num, q.den);
+  if (g > 1) { q.num /= g; q.den /= g; }
+  if (!q.num) q.sign = 1;
+  return q;
+}
+
+static inline tnac_value tnac_frac(int64_t num, int64_t den)
+{
+  tnac_value v = tnac_undef();
+  v.type = TNAC_FRAC;
+  v.as.q = tnac_qnorm(num, den);
+  return v;
+}
+
+static inline tnac_value tnac_qval(tnac_frac_t q) { return tnac_frac(q.sign * q.num, q.den); }
+
+static inline tnac_value tnac_unsupported(const char* what)
+{
+  fprintf(stderr, "tnac: '%s' is not supported by the C backend\n", what);
+  exit(EXIT_FAILURE);
+}
+
+/* Casts */
+
+static inline int tnac_feq(double l, double r)
+{
+  if (isinf(l) && isinf(r)) return 1;
+  if (isnan(l) && isnan(r)) return 1;
+  return fabs(l - r) <= DBL_EPSILON;
+}
+
+static inline double tnac_qf(tnac_frac_t q) { return (double)(q.sign * q.num) / (double)q.den; }
+
+static inline int tnac_to_int(tnac_value v, int64_t* out)
+{
+  double f = 0.0;
+  switch (v.type)
+  {
+  case TNAC_UNDEF: *out = 0; return 1;
+  case TNAC_BOOL:  *out = v.as.b; return 1;
+  case TNAC_INT:   *out = v.as.i; return 1;
+  case TNAC_FLOAT: f = v.as.f; break;
+  case TNAC_FRAC:  f = tnac_qf(v.as.q); break;
+  case TNAC_CPLX:
+    if (!tnac_feq(cimag(v.as.c), 0.0)) return 0;
+    f = creal(v.as.c);
+    break;
+  default: return 0;
+  }
+
+  *out = (int64_t)f;
+  return tnac_feq((double)*out, f);
+}
+
+static inline int tnac_to_float(tnac_value v, double* out)
+{
+  switch (v.type)
+  {
+  case TNAC_UNDEF: *out = 0.0; return 1;
+  case TNAC_BOOL:  *out = v.as.b ? 1.0 : 0.0; return 1;
+  case TNAC_INT:   *out = (double)v.as.i; return 1;
+  case TNAC_FLOAT: *out = v.as.f; return 1;
+  case TNAC_FRAC:  *out = tnac_qf(v.as.q); return 1;
+  case TNAC_CPLX:
+    if (!tnac_feq(cimag(v.as.c), 0.0)) return 0;
+    *out = creal(v.as.c);
+    return 1;
+  default: return 0;
+  }
+}
+
+static inline int tnac_to_cplx(tnac_value v, double _Complex* out)
+{
+  double f = 0.0;
+  if (v.type == TNAC_CPLX) { *out = v.as.c; return 1; }
+  if (!tnac_to_float(v, &f)) return 0;
+  *out = CMPLX(f, 0.0);
+  return 1;
+}
+
+static inline int tnac_to_frac(tnac_value v, tnac_frac_t* out)
+{
+  double f = 0.0;
+  switch (v.type)
+  {
+  case TNAC_UNDEF: *out = tnac_qnorm(0, 1); return 1;
+  case TNAC_BOOL:  *out = tnac_qnorm(v.as.b, 1); return 1;
+  case TNAC_INT:   *out = tnac_qnorm(v.as.i, 1); return 1;
+  case TNAC_FRAC:  *out = v.as.q; return 1;
+  case TNAC_FLOAT: f = v.as.f; break;
+  case TNAC_CPLX:
+    if (!tnac_feq(cimag(v.as.c), 0.0)) return 0;
+    f = creal(v.as.c);
+    break;
+  default: return 0;
+  }
+
+  if (isnan(f) || isinf(f))
+  {
+    out->num = 1;
+    out->den = 0;
+    out->sign = f < 0 ? -1 : 1;
+    return 1;
+  }
+
+  *out = tnac_qnorm((int64_t)f, 1);
+  return 1;
+}
+
+static inline int tnac_truthy(tnac_value v)
+{
+  switch (v.type)
+  {
+  case TNAC_BOOL:  return v.as.b;
+  case TNAC_INT:   return v.as.i != 0;
+  case TNAC_FLOAT: return !tnac_feq(v.as.f, 0.0);
+  case TNAC_CPLX:  return !tnac_feq(creal(v.as.c), 0.0) || !tnac_feq(cimag(v.as.c), 0.0);
+  case TNAC_FRAC:  return v.as.q.num != 0;
+  case TNAC_FN:    return 1;
+  default:         return 0;
+  }
+}
+
+static inline tnac_type tnac_common(tnac_type l, tnac_type r)
+{
+  if (l == TNAC_UNDEF || r == TNAC_UNDEF) return TNAC_UNDEF;
+  if (l == TNAC_FN || r == TNAC_FN)       return TNAC_FN;
+  if (l == TNAC_CPLX || r == TNAC_CPLX)   return TNAC_CPLX;
+  if (l == TNAC_FLOAT || r == TNAC_FLOAT) return TNAC_FLOAT;
+  if (l == TNAC_FRAC || r == TNAC_FRAC)   return TNAC_FRAC;
+  return TNAC_INT;
+}
+
+/* Fractions */
+
+static inline tnac_frac_t tnac_qadd(tnac_frac_t l, tnac_frac_t r)
+{
+  return tnac_qnorm(l.sign * l.num * r.den + r.sign * r.num * l.den, l.den * r.den);
+}
+
+static inline tnac_frac_t tnac_qmul(tnac_frac_t l, tnac_frac_t r)
+{
+  return tnac_qnorm(l.sign * r.sign * l.num * r.num, l.den * r.den);
+}
+
+static inline tnac_frac_t tnac_qinv(tnac_frac_t q)
+{
+  return tnac_qnorm(q.sign * q.den, q.num);
+}
+
+static inline int tnac_qeq(tnac_frac_t l, tnac_frac_t r)
+{
+  return l.sign == r.sign && l.num == r.num && l.den == r.den;
+}
+
+static inline int tnac_qless(tnac_frac_t l, tnac_frac_t r)
+{
+  return l.sign * l.num * r.den < r.sign * r.num * l.den;
+}
+
+/* Powers */
+
+static inline tnac_value tnac_power(double base, double exp)
+{
+  if (base < 0.0 && !tnac_feq(base, 0.0))
+  {
+    const double root = 1.0 / exp;
+    if (tnac_feq(fmod(root, 2.0), 0.0))
+    {
+      const double rem = 1.0 / (root / 2.0);
+      const double _Complex res = CMPLX(0.0, pow(fabs(base), 0.5));
+      const double _Complex intrm = tnac_feq(fabs(rem), 1.0) ? res : cpow(res, rem);
+      return tnac_cval(rem > 0.0 ? intrm : 1.0 / intrm);
+    }
+
+    return tnac_float(-pow(fabs(base), exp));
+  }
+
+  return tnac_float(pow(base, exp));
+}
+
+static inline tnac_value tnac_cmp_result(tnac_binop op, int eq, int less)
+{
+  switch (op)
+  {
+  case TNAC_LT: return tnac_bool(less);
+  case TNAC_LE: return tnac_bool(eq || less);
+  case TNAC_GT: return tnac_bool(!eq && !less);
+  case TNAC_GE: return tnac_bool(!less);
+  case TNAC_EQ: return tnac_bool(eq);
+  case TNAC_NE: return tnac_bool(!eq);
+  default:      return tnac_undef();
+  }
+}
+
+static inline tnac_value tnac_bitwise(tnac_binop op, tnac_value l, tnac_value r)
+{
+  int64_t li = 0, ri = 0;
+  if (!tnac_to_int(l, &li) || !tnac_to_int(r, &ri))
+    return tnac_undef();
+
+  switch (op)
+  {
+  case TNAC_AND: return tnac_int(li & ri);
+  case TNAC_XOR: return tnac_int(li ^ ri);
+  default:       return tnac_int(li | ri);
+  }
+}
+
+/* Binary operations on a common type */
+
+static inline tnac_value tnac_binary_int(tnac_binop op, int64_t l, int64_t r)
+{
+  switch (op)
+  {
+  case TNAC_ADD:  return tnac_int((int64_t)((uint64_t)l + (uint64_t)r));
+  case TNAC_SUB:  return tnac_int((int64_t)((uint64_t)l - (uint64_t)r));
+  case TNAC_MUL:  return tnac_int((int64_t)((uint64_t)l * (uint64_t)r));
+  case TNAC_DIV:  return tnac_float((double)l / (double)r);
+  case TNAC_MOD:  return tnac_float(fmod((double)l, (double)r));
+  case TNAC_POW:  return tnac_power((double)l, (double)r);
+  case TNAC_ROOT: return tnac_power((double)l, 1.0 / (double)r);
+  default:        return tnac_cmp_result(op, l == r, l < r);
+  }
+}
+
+static inline tnac_value tnac_binary_float(tnac_binop op, double l, double r)
+{
+  switch (op)
+  {
+  case TNAC_ADD:  return tnac_float(l + r);
+  case TNAC_SUB:  return tnac_float(l - r);
+  case TNAC_MUL:  return tnac_float(l * r);
+  case TNAC_DIV:  return tnac_float(l / r);
+  case TNAC_MOD:  return tnac_float(fmod(l, r));
+  case TNAC_POW:  return tnac_power(l, r);
+  case TNAC_ROOT: return tnac_power(l, 1.0 / r);
+  default:        return tnac_cmp_result(op, tnac_feq(l, r), l < r);
+  }
+}
+
+static inline tnac_value tnac_binary_frac(tnac_binop op, tnac_frac_t l, tnac_frac_t r)
+{
+  switch (op)
+  {
+  case TNAC_ADD: return tnac_qval(tnac_qadd(l, r));
+  case TNAC_SUB: r.sign = -r.sign; return tnac_qval(tnac_qadd(l, r));
+  case TNAC_MUL: return tnac_qval(tnac_qmul(l, r));
+  case TNAC_DIV: return tnac_qval(tnac_qmul(l, tnac_qinv(r)));
+  case TNAC_MOD: return tnac_float(fmod(tnac_qf(l), tnac_qf(r)));
+  case TNAC_POW: return tnac_power(tnac_qf(l), tnac_qf(r));
+  case TNAC_ROOT: return tnac_power(tnac_qf(l), tnac_qf(tnac_qinv(r)));
+  default:       return tnac_cmp_result(op, tnac_qeq(l, r), tnac_qless(l, r));
+  }
+}
+
+static inline tnac_value tnac_binary_cplx(tnac_binop op, double _Complex l, double _Complex r)
+{
+  const int eq = tnac_feq(creal(l), creal(r)) && tnac_feq(cimag(l), cimag(r));
+  switch (op)
+  {
+  case TNAC_ADD:  return tnac_cval(l + r);
+  case TNAC_SUB:  return tnac_cval(l - r);
+  case TNAC_MUL:  return tnac_cval(l * r);
+  case TNAC_DIV:  return tnac_cval(l / r);
+  case TNAC_POW:  return tnac_cval(cpow(l, r));
+  case TNAC_ROOT: return tnac_cval(cpow(l, 1.0 / r));
+  case TNAC_MOD:
+  {
+    const double _Complex q = l / r;
+    return tnac_cval(l - CMPLX(round(creal(q)), round(cimag(q))) * r);
+  }
+  default: return tnac_cmp_result(op, eq, cabs(l) < cabs(r));
+  }
+}
+
+static inline tnac_value tnac_binary(tnac_binop op, tnac_value l, tnac_value r)
+{
+  const tnac_type ct = tnac_common(l.type, r.type);
+  if (op == TNAC_AND || op == TNAC_XOR || op == TNAC_OR)
+    return ct == TNAC_FN ? tnac_undef() : tnac_bitwise(op, l, r);
+
+  switch (ct)
+  {
+  case TNAC_INT:
+  {
+    int64_t li = 0, ri = 0;
+    tnac_to_int(l, &li);
+    tnac_to_int(r, &ri);
+    return tnac_binary_int(op, li, ri);
+  }
+  case TNAC_FLOAT:
+  {
+    double lf = 0.0, rf = 0.0;
+    tnac_to_float(l, &lf);
+    tnac_to_float(r, &rf);
+    return tnac_binary_float(op, lf, rf);
+  }
+  case TNAC_FRAC:
+  {
+    tnac_frac_t lq, rq;
+    tnac_to_frac(l, &lq);
+    tnac_to_frac(r, &rq);
+    return tnac_binary_frac(op, lq, rq);
+  }
+  case TNAC_CPLX:
+  {
+    double _Complex lc = 0.0, rc = 0.0;
+    tnac_to_cplx(l, &lc);
+    tnac_to_cplx(r, &rc);
+    return tnac_binary_cplx(op, lc, rc);
+  }
+  case TNAC_FN:
+    if (l.type != TNAC_FN || r.type != TNAC_FN || (op != TNAC_EQ && op != TNAC_NE))
+      return tnac_undef();
+    return tnac_bool((l.as.fn == r.as.fn) == (op == TNAC_EQ));
+  default:
+    return tnac_undef();
+  }
+}
+
+/* Unary operations */
+
+static inline tnac_value tnac_unary(tnac_unop op, tnac_value v)
+{
+  if (op == TNAC_NOT) return tnac_bool(!tnac_truthy(v));
+  if (op == TNAC_IS)  return tnac_bool(tnac_truthy(v));
+  if (op == TNAC_BNEG)
+  {
+    int64_t i = 0;
+    return tnac_to_int(v, &i) ? tnac_int(~i) : tnac_undef();
+  }
+
+  if (v.type == TNAC_BOOL)
+    v = tnac_int(v.as.b);
+
+  switch (v.type)
+  {
+  case TNAC_INT:
+    switch (op)
+    {
+    case TNAC_NEG:  return tnac_int((int64_t)(0 - (uint64_t)v.as.i));
+    case TNAC_ABS:  return tnac_int(v.as.i < 0 ? (int64_t)(0 - (uint64_t)v.as.i) : v.as.i);
+    case TNAC_TAIL: return tnac_undef();
+    default:        return v;
+    }
+  case TNAC_FLOAT:
+    switch (op)
+    {
+    case TNAC_NEG:  return tnac_float(-v.as.f);
+    case TNAC_ABS:  return tnac_float(fabs(v.as.f));
+    case TNAC_TAIL: return tnac_undef();
+    default:        return v;
+    }
+  case TNAC_FRAC:
+    switch (op)
+    {
+    case TNAC_NEG:  if (v.as.q.num) v.as.q.sign = -v.as.q.sign; return v;
+    case TNAC_ABS:  v.as.q.sign = 1; return v;
+    case TNAC_TAIL: return tnac_undef();
+    default:        return v;
+    }
+  case TNAC_CPLX:
+    switch (op)
+    {
+    case TNAC_NEG:  return tnac_cval(-v.as.c);
+    case TNAC_ABS:  return tnac_float(cabs(v.as.c));
+    case TNAC_HEAD: return tnac_float(creal(v.as.c));
+    case TNAC_TAIL: return tnac_float(cimag(v.as.c));
+    default:        return v;
+    }
+  case TNAC_FN:
+    return (op == TNAC_HEAD || op == TNAC_ABS) ? v : tnac_undef();
+  default:
+    return tnac_undef();
+  }
+}
+
+/* Types */
+
+static inline tnac_value tnac_test(tnac_type type, tnac_value v)
+{
+  return tnac_bool(v.type == type);
+}
+
+static inline tnac_value tnac_make_bool(tnac_value v) { return tnac_bool(tnac_truthy(v)); }
+
+static inline tnac_value tnac_make_int(tnac_value v)
+{
+  int64_t i = 0;
+  return tnac_to_int(v, &i) ? tnac_int(i) : tnac_undef();
+}
+
+static inline tnac_value tnac_make_float(tnac_value v)
+{
+  double f = 0.0;
+  return tnac_to_float(v, &f) ? tnac_float(f) : tnac_undef();
+}
+
+static inline tnac_value tnac_make_cplx(tnac_value re, tnac_value im)
+{
+  double r = 0.0, i = 0.0;
+  return (tnac_to_float(re, &r) && tnac_to_float(im, &i)) ? tnac_cplx(r, i) : tnac_undef();
+}
+
+static inline tnac_value tnac_make_frac(tnac_value num, tnac_value den)
+{
+  int64_t n = 0, d = 0;
+  return (tnac_to_int(num, &n) && tnac_to_int(den, &d)) ? tnac_frac(n, d) : tnac_undef();
+}
+
+/* Calls */
+
+static inline tnac_value tnac_call(tnac_value callee, unsigned argc, const tnac_value* args)
+{
+  if (callee.type != TNAC_FN || callee.as.fn->arity != argc)
+    return tnac_undef();
+
+  return callee.as.fn->body(args);
+}
+
+/* IO */
+
+static inline void tnac_write(FILE* out, tnac_value v, int boolAsStr)
+{
+  switch (v.type)
+  {
+  case TNAC_BOOL:
+    if (boolAsStr) fputs(v.as.b ? "true" : "false", out);
+    else           fprintf(out, "%d", v.as.b);
+    break;
+  case TNAC_INT:   fprintf(out, "%" PRId64, v.as.i); break;
+  case TNAC_FLOAT: fprintf(out, "%g", v.as.f); break;
+  case TNAC_FRAC:
+    if (v.as.q.sign < 0) fputc('-', out);
+    fprintf(out, "%" PRId64 "/%" PRId64, v.as.q.num, v.as.q.den);
+    break;
+  case TNAC_CPLX:
+    fprintf(out, "%g %c %gi", creal(v.as.c), cimag(v.as.c) >= 0.0 ? '+' : '-', fabs(cimag(v.as.c)));
+    break;
+  case TNAC_FN:
+    fprintf(out, "%s(%u)", v.as.fn->name, v.as.fn->arity);
+    break;
+  default:
+    fputs("<undef>", out);
+    break;
+  }
+}
+
+static inline tnac_value tnac_stream_write(tnac_value v)
+{
+  tnac_write(stdout, v, 0);
+  return v;
+}
+
+static inline tnac_value tnac_stream_read(void)
+{
+  char buf[128];
+  if (!fgets(buf, sizeof buf, stdin))
+    return tnac_undef();
+
+  char* end = NULL;
+  const long long i = strtoll(buf, &end, 0);
+  if (end != buf && (*end == '\n' || *end == '\0'))
+    return tnac_int((int64_t)i);
+
+  const double f = strtod(buf, &end);
+  if (end != buf && (*end == '\n' || *end == '\0'))
+    return tnac_float(f);
+
+  return tnac_undef();
+}
+
+static inline tnac_value tnac_parse_arg(const char* arg)
+{
+  char* end = NULL;
+  const long long i = strtoll(arg, &end, 0);
+  if (end != arg && !*end)
+    return tnac_int((int64_t)i);
+
+  const double f = strtod(arg, &end);
+  if (end != arg && !*end)
+    return tnac_float(f);
+
+  return tnac_undef();
+}
+)tnac"sv;
+}
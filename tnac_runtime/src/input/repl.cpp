@@ -3,6 +3,7 @@
 #include "output/sym_printer.hpp"
 #include "output/lister.hpp"
 #include "output/ir_printer.hpp"
+#include "output/c_emitter.hpp"
 #include "common/feedback.hpp"
 #include "common/diag.hpp"
 #include "sema/sym/symbols.hpp"
@@ -39,6 +40,16 @@ namespace tnac::rt::detail
 
       return var;
     }
+
+    std::optional<std::size_t> to_count(string_t str) noexcept
+    {
+      auto res = std::size_t{};
+      auto convRes = std::from_chars(str.data(), str.data() + str.size(), res);
+      if (convRes.ec != std::errc{} || convRes.ptr != str.data() + str.size())
+        return {};
+
+      return res;
+    }
   }
 }
 
@@ -182,6 +193,7 @@ namespace tnac::rt
       if (!hasNew)
       {
         print_result();
+        core.get_store().maybe_collect();
         continue;
       }
 
@@ -217,6 +229,7 @@ namespace tnac::rt
       }
 
       print_value(ev.result());
+      core.get_store().maybe_collect();
     }
   }
 
@@ -243,6 +256,9 @@ namespace tnac::rt
     core.declare_cmd("ir"sv, params{ String }, size_type{},
          [this](auto c) noexcept { print_ir(std::move(c)); });
 
+    core.declare_cmd("cgen"sv, params{ String }, size_type{},
+         [this](auto c) noexcept { emit_c(std::move(c)); });
+
     core.declare_cmd("vars"sv, params{ String }, size_type{},
          [this](auto c) noexcept { print_vars(std::move(c)); });
 
@@ -255,6 +271,24 @@ namespace tnac::rt
     core.declare_cmd("env"sv, params{ String }, size_type{},
          [this](auto c) noexcept { print_all(std::move(c)); });
 
+    core.declare_cmd("stats"sv, params{ String }, size_type{},
+         [this](auto c) noexcept { print_stats(std::move(c)); });
+
+    core.declare_cmd("memo"sv, params{ Identifier }, size_type{ 1 },
+         [this](auto c) noexcept { set_memo(std::move(c)); });
+
+    core.declare_cmd("jit"sv, params{ Identifier }, size_type{ 1 },
+         [this](auto c) noexcept { set_jit(std::move(c)); });
+
+    core.declare_cmd("par"sv, params{ Identifier }, size_type{ 1 },
+         [this](auto c) noexcept { set_par(std::move(c)); });
+
+    core.declare_cmd("inline"sv, params{ Identifier }, size_type{ 1 },
+         [this](auto c) noexcept { set_inline(std::move(c)); });
+
+    core.declare_cmd("threads"sv, params{ IntDec, IntDec }, size_type{ 1 },
+         [this](auto c) noexcept { set_threads(std::move(c)); });
+
     core.declare_cmd("bin"sv, [this](auto) noexcept { m_state->set_base(2); });
     core.declare_cmd("oct"sv, [this](auto) noexcept { m_state->set_base(8); });
     core.declare_cmd("dec"sv, [this](auto) noexcept { m_state->set_base(10); });
@@ -486,6 +520,21 @@ namespace tnac::rt
       });
   }
 
+  void repl::emit_c(ast::command cmd) noexcept
+  {
+    out::c_emitter ce;
+    print_cmd(cmd, [this, &ce]
+      {
+        ce(m_state->tnac_core().get_cfg(), m_state->out());
+      });
+
+    if (const auto unsupported = ce.unsupported_count())
+    {
+      fmt::print(m_state->err(), fmt::clr::Yellow, "Instructions not supported by the C backend: "sv);
+      m_state->err() << unsupported << '\n';
+    }
+  }
+
   template <semantics::sem_symbol S>
   void repl::print_symbols(semantics::sym_container<S> collection) noexcept
   {
@@ -586,4 +635,186 @@ namespace tnac::rt
     if (!hasOut) m_state->out() << "==========  IR   ==========\n";
     on_command({ cTok("ir"sv), std::move(aIr) });
   }
-}
\ No newline at end of file
+
+  void repl::print_stats(ast::command cmd) noexcept
+  {
+    print_cmd(cmd, [this]
+      {
+        auto&& os = m_state->out();
+        auto&& binds = m_state->tnac_core().ir_evaluator().dyn_bind_stats();
+        fmt::println(os, fmt::clr::Yellow, "Dynamic bind caches:"sv);
+        os << "  hits:   " << binds.m_hits << '\n';
+        os << "  misses: " << binds.m_misses << '\n';
+
+        auto&& flat = m_state->tnac_core().ir_evaluator().flat_code_stats();
+        fmt::println(os, fmt::clr::Yellow, "Flat code:"sv);
+        os << "  functions: " << flat.m_functions << '\n';
+        os << "  chains:    " << flat.m_chains << '\n';
+        os << "  fused:     " << flat.m_fused << '\n';
+
+        auto&& memo = m_state->tnac_core().ir_evaluator().memo();
+        auto&& memoStats = memo.counters();
+        const auto lookups = memoStats.m_hits + memoStats.m_misses;
+        const auto hitRate = lookups ? 100.0 * memoStats.m_hits / lookups : 0.0;
+        fmt::println(os, fmt::clr::Yellow, "Memoised calls:"sv);
+        os << "  hits:      " << memoStats.m_hits << " (" << hitRate << "%)\n";
+        os << "  misses:    " << memoStats.m_misses << '\n';
+        os << "  evictions: " << memoStats.m_evictions << '\n';
+        os << "  entries:   " << memo.size() << '/' << memo.capacity() << '\n';
+
+        auto&& jit = m_state->tnac_core().ir_evaluator().jit();
+        auto&& jitStats = jit.counters();
+        fmt::println(os, fmt::clr::Yellow, "Native code:"sv);
+        os << "  enabled:   " << (jit.is_enabled() ? "yes" : "no") << '\n';
+        os << "  compiled:  " << jitStats.m_compiled << '\n';
+        os << "  rejected:  " << jitStats.m_rejected << '\n';
+        os << "  calls:     " << jitStats.m_calls << '\n';
+        os << "  fallbacks: " << jitStats.m_fallbacks << '\n';
+
+        auto&& par = m_state->tnac_core().ir_evaluator().par();
+        auto&& parStats = par.counters();
+        fmt::println(os, fmt::clr::Yellow, "Parallel calls:"sv);
+        os << "  enabled:   " << (par.is_enabled() ? "yes" : "no") << '\n';
+        os << "  batches:   " << parStats.m_batches << '\n';
+        os << "  tasks:     " << parStats.m_tasks << '\n';
+        os << "  fallbacks: " << parStats.m_fallbacks << '\n';
+
+        auto&& elems = m_state->tnac_core().ir_evaluator().par_elems();
+        auto&& elemSettings = elems.settings();
+        auto&& elemStats = elems.counters();
+        fmt::println(os, fmt::clr::Yellow, "Parallel elementwise:"sv);
+        os << "  threads:   " << elemSettings.m_threads << '\n';
+        os << "  grain:     " << elemSettings.m_grain << '\n';
+        os << "  batches:   " << elemStats.m_batches << '\n';
+        os << "  tasks:     " << elemStats.m_tasks << '\n';
+
+        auto&& opt = m_state->tnac_core().get_compiler().opt_counters();
+        fmt::println(os, fmt::clr::Yellow, "Optimisations:"sv);
+        os << "  promoted:     " << opt.m_promoted << '\n';
+        os << "  folded:       " << opt.m_folded << '\n';
+        os << "  pruned:       " << opt.m_pruned << '\n';
+        os << "  deduplicated: " << opt.m_deduplicated << '\n';
+        os << "  erased:       " << opt.m_erased << '\n';
+        os << "  merged:       " << opt.m_merged << '\n';
+        os << "  inlined:      " << opt.m_inlined << '\n';
+
+        auto&& vals = m_state->tnac_core().get_store();
+        auto&& valStats = vals.counters();
+        fmt::println(os, fmt::clr::Yellow, "Value store:"sv);
+        os << "  arrays:      " << vals.array_count() << '\n';
+        os << "  collections: " << valStats.m_collections << '\n';
+        os << "  reclaimed:   " << valStats.m_reclaimed << '\n';
+        os << "  recycled:    " << valStats.m_recycled << '\n';
+      });
+  }
+
+  void repl::set_memo(ast::command cmd) noexcept
+  {
+    using size_type = ast::command::size_type;
+    using enum eval::memo_mode;
+    auto&& arg = cmd[size_type{}];
+    const auto argName = arg.value();
+    auto&& memo = m_state->tnac_core().ir_evaluator().memo();
+
+    if (argName == "all"sv)
+      memo.set_mode(All);
+    else if (argName == "off"sv)
+      memo.set_mode(Off);
+    else if (auto fn = m_replMod->lookup(argName))
+    {
+      memo.mark(*fn);
+      if (memo.mode() == Off)
+        memo.set_mode(Marked);
+    }
+    else
+      m_feedback->compile_error(arg.at(), diag::wrong_cmd_arg(size_type{}, argName));
+  }
+
+  void repl::set_jit(ast::command cmd) noexcept
+  {
+    using size_type = ast::command::size_type;
+    auto&& arg = cmd[size_type{}];
+    const auto argName = arg.value();
+    auto&& jit = m_state->tnac_core().ir_evaluator().jit();
+
+    if (argName == "on"sv)
+    {
+      if (!jit.is_supported())
+      {
+        fmt::println(m_state->err(), fmt::clr::Red, "Native code is not supported on this platform"sv);
+        return;
+      }
+      jit.enable(true);
+    }
+    else if (argName == "off"sv)
+      jit.enable(false);
+    else
+      m_feedback->compile_error(arg.at(), diag::wrong_cmd_arg(size_type{}, argName));
+  }
+
+  void repl::set_par(ast::command cmd) noexcept
+  {
+    using size_type = ast::command::size_type;
+    auto&& arg = cmd[size_type{}];
+    const auto argName = arg.value();
+    auto&& par = m_state->tnac_core().ir_evaluator().par();
+
+    if (argName == "on"sv)
+      par.enable(true);
+    else if (argName == "off"sv)
+      par.enable(false);
+    else
+      m_feedback->compile_error(arg.at(), diag::wrong_cmd_arg(size_type{}, argName));
+  }
+
+  void repl::set_inline(ast::command cmd) noexcept
+  {
+    using size_type = ast::command::size_type;
+    auto&& arg = cmd[size_type{}];
+    const auto argName = arg.value();
+    auto&& comp = m_state->tnac_core().get_compiler();
+    auto cfg = comp.inlining();
+
+    if (argName == "on"sv)
+      cfg.m_enabled = true;
+    else if (argName == "off"sv)
+      cfg.m_enabled = false;
+    else
+    {
+      m_feedback->compile_error(arg.at(), diag::wrong_cmd_arg(size_type{}, argName));
+      return;
+    }
+
+    comp.configure_inlining(cfg);
+  }
+
+  void repl::set_threads(ast::command cmd) noexcept
+  {
+    using size_type = ast::command::size_type;
+    auto&& elems = m_state->tnac_core().ir_evaluator().par_elems();
+    auto cfg = elems.settings();
+
+    auto&& threads = cmd[size_type{}];
+    auto threadCount = detail::to_count(threads.value());
+    if (!threadCount)
+    {
+      m_feedback->compile_error(threads.at(), diag::wrong_cmd_arg(size_type{}, threads.value()));
+      return;
+    }
+    cfg.m_threads = *threadCount;
+
+    if (cmd.arg_count() > 1)
+    {
+      auto&& grain = cmd[size_type{ 1 }];
+      auto grainSize = detail::to_count(grain.value());
+      if (!grainSize)
+      {
+        m_feedback->compile_error(grain.at(), diag::wrong_cmd_arg(size_type{ 1 }, grain.value()));
+        return;
+      }
+      cfg.m_grain = *grainSize;
+    }
+
+    elems.configure(cfg);
+  }
+}
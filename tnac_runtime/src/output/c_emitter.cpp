@@ -0,0 +1,776 @@
+#include "output/c_emitter.hpp"
+#include "output/c_runtime.hpp"
+#include "eval/value/type_impl.hpp"
+
+namespace tnac::rt::out::detail
+{
+  namespace
+  {
+    string_t binary_op(ir::op_code oc) noexcept
+    {
+      using enum ir::op_code;
+      switch (oc)
+      {
+      case Add:   return "TNAC_ADD"sv;
+      case Sub:   return "TNAC_SUB"sv;
+      case Mul:   return "TNAC_MUL"sv;
+      case Div:   return "TNAC_DIV"sv;
+      case Mod:   return "TNAC_MOD"sv;
+      case Pow:   return "TNAC_POW"sv;
+      case Root:  return "TNAC_ROOT"sv;
+      case And:   return "TNAC_AND"sv;
+      case Or:    return "TNAC_OR"sv;
+      case Xor:   return "TNAC_XOR"sv;
+      case CmpE:  return "TNAC_EQ"sv;
+      case CmpNE: return "TNAC_NE"sv;
+      case CmpL:  return "TNAC_LT"sv;
+      case CmpLE: return "TNAC_LE"sv;
+      case CmpG:  return "TNAC_GT"sv;
+      case CmpGE: return "TNAC_GE"sv;
+
+      default: break;
+      }
+
+      return {};
+    }
+
+    string_t unary_op(ir::op_code oc) noexcept
+    {
+      using enum ir::op_code;
+      switch (oc)
+      {
+      case Abs:    return "TNAC_ABS"sv;
+      case CmpNot: return "TNAC_NOT"sv;
+      case CmpIs:  return "TNAC_IS"sv;
+      case Plus:   return "TNAC_PLUS"sv;
+      case Neg:    return "TNAC_NEG"sv;
+      case BNeg:   return "TNAC_BNEG"sv;
+      case Head:   return "TNAC_HEAD"sv;
+      case Tail:   return "TNAC_TAIL"sv;
+
+      default: break;
+      }
+
+      return {};
+    }
+
+    string_t type_ctor(ir::op_code oc) noexcept
+    {
+      using enum ir::op_code;
+      switch (oc)
+      {
+      case Bool:  return "tnac_make_bool"sv;
+      case Int:   return "tnac_make_int"sv;
+      case Float: return "tnac_make_float"sv;
+      case Frac:  return "tnac_make_frac"sv;
+      case Cplx:  return "tnac_make_cplx"sv;
+
+      default: break;
+      }
+
+      return {};
+    }
+
+    auto ctor_arity(ir::op_code oc) noexcept
+    {
+      using enum ir::op_code;
+      return utils::eq_any(oc, Frac, Cplx) ? 2u : 1u;
+    }
+
+    void write_float(out_stream& os, eval::float_type val) noexcept
+    {
+      if (std::isnan(val))
+      {
+        os << "NAN"sv;
+        return;
+      }
+      if (std::isinf(val))
+      {
+        os << (val < 0 ? "-INFINITY"sv : "INFINITY"sv);
+        return;
+      }
+
+      std::array<char, 64> buf{};
+      auto conv = std::to_chars(buf.data(), buf.data() + buf.size(), val);
+      const auto str = string_t{ buf.data(), conv.ptr };
+      os << str;
+
+      // Keep the literal floating point
+      if (str.find_first_of(".e"sv) == string_t::npos)
+        os << ".0"sv;
+    }
+
+    void write_int(out_stream& os, eval::int_type val) noexcept
+    {
+      if (val == std::numeric_limits<eval::int_type>::min())
+      {
+        os << "INT64_MIN"sv;
+        return;
+      }
+
+      os << "INT64_C(" << val << ')';
+    }
+  }
+}
+
+namespace tnac::rt::out
+{
+  // Special members
+
+  c_emitter::~c_emitter() noexcept = default;
+
+  c_emitter::c_emitter() noexcept = default;
+
+
+  // Public members
+
+  void c_emitter::operator()(const ir::cfg& gr, out_stream& os) noexcept
+  {
+    m_out = &os;
+    m_cfg = &gr;
+    m_entry = {};
+    m_funcs.clear();
+    m_unsupported = {};
+
+    plain(cRuntime);
+    endl();
+    declare_funcs();
+    base::operator()(gr);
+    emit_main();
+  }
+
+  void c_emitter::operator()(const ir::cfg& gr) noexcept
+  {
+    operator()(gr, out());
+  }
+
+  c_emitter::size_type c_emitter::unsupported_count() const noexcept
+  {
+    return m_unsupported;
+  }
+
+  bool c_emitter::preview(const ir::function& fn) noexcept
+  {
+    m_blocks.clear();
+    m_regs.clear();
+    m_params.clear();
+
+    using enum ir::op_code;
+    for (auto&& block : fn.blocks())
+    {
+      for (auto&& instr : block)
+      {
+        const auto oc = instr.opcode();
+        if (oc == Jump)
+        {
+          // Only jump targets get labels
+          for (auto idx = decltype(instr.operand_count()){}; idx < instr.operand_count(); ++idx)
+          {
+            if (instr[idx].is_block())
+              m_blocks.try_emplace(&instr[idx].get_block(), m_blocks.size());
+          }
+          continue;
+        }
+
+        if (!instr.operand_count() || utils::eq_any(oc, Store, StoreElem, Append, Ret))
+          continue;
+
+        auto&& res = instr[0];
+        if (!res.is_register())
+          continue;
+
+        auto&& reg = res.get_reg();
+        m_regs.try_emplace(&reg, m_regs.size());
+        if (oc == Load && instr[1].is_param())
+          m_params.try_emplace(&reg, *instr[1].get_param());
+      }
+    }
+
+    plain("static tnac_value "sv);
+    func_name(fn);
+    plain("(const tnac_value* args)"sv);
+    endl();
+    plain("{"sv);
+    endl();
+
+    std::vector<const ir::vreg*> regs(m_regs.size());
+    for (auto&& [reg, idx] : m_regs)
+      regs[idx] = reg;
+
+    for (auto idx = size_type{}; auto reg : regs)
+    {
+      out() << "  tnac_value r" << idx++ << " = ";
+      if (auto param = m_params.find(reg); param != m_params.end())
+        out() << "args[" << param->second << ']';
+      else
+        plain("tnac_undef()"sv);
+      plain(";"sv);
+      endl();
+    }
+
+    plain("  (void)args;"sv);
+    endl();
+    return true;
+  }
+
+  bool c_emitter::preview(const ir::basic_block& bb) noexcept
+  {
+    m_curBlock = &bb;
+    if (!m_blocks.contains(&bb))
+      return true;
+
+    label(bb);
+    plain(": ;"sv);
+    endl();
+    return true;
+  }
+
+  void c_emitter::visit(const ir::function&) noexcept
+  {
+    plain("}"sv);
+    endl();
+    endl();
+  }
+
+  void c_emitter::visit(const ir::basic_block& bb) noexcept
+  {
+    auto last = bb.last();
+    if (last && utils::eq_any(last->opcode(), ir::op_code::Jump, ir::op_code::Ret))
+      return;
+
+    // Blocks which are still being built return the last computed value
+    plain("  return "sv);
+    if (last && last->operand_count() && last->opcode() != ir::op_code::Store && (*last)[0].is_register())
+      operand((*last)[0]);
+    else
+      plain("tnac_undef()"sv);
+    plain(";"sv);
+    endl();
+  }
+
+  void c_emitter::visit(const ir::instruction& instr) noexcept
+  {
+    using enum ir::op_code;
+    switch (instr.opcode())
+    {
+    case Add:
+    case Sub:
+    case Mul:
+    case Div:
+    case Mod:
+    case Pow:
+    case Root:
+    case And:
+    case Or:
+    case Xor:
+    case CmpE:
+    case CmpL:
+    case CmpLE:
+    case CmpNE:
+    case CmpG:
+    case CmpGE:
+      emit_binary(instr);
+      break;
+
+    case Abs:
+    case CmpNot:
+    case CmpIs:
+    case Plus:
+    case Neg:
+    case BNeg:
+    case Head:
+    case Tail:
+      emit_unary(instr);
+      break;
+
+    case Bool:
+    case Int:
+    case Float:
+    case Frac:
+    case Cplx:
+      emit_type(instr);
+      break;
+
+    case Test:   emit_test(instr);   break;
+    case Select: emit_select(instr); break;
+    case Load:   emit_load(instr);   break;
+    case Store:  emit_store(instr);  break;
+    case Call:   emit_call(instr);   break;
+    case Jump:   emit_jump(instr);   break;
+    case Ret:    emit_ret(instr);    break;
+
+    case Alloc:
+      assign(instr[0]);
+      plain("tnac_undef();"sv);
+      endl();
+      break;
+
+    case StreamRead:
+      assign(instr[0]);
+      plain("tnac_stream_read();"sv);
+      endl();
+      break;
+
+    case StreamWrite:
+      assign(instr[0]);
+      plain("tnac_stream_write("sv);
+      operand(instr[1]);
+      plain(");"sv);
+      endl();
+      break;
+
+    // Resolved on the incoming edges
+    case Phi:
+      break;
+
+    case Arr:
+    case Range:
+    case StructAlloc:
+    case StoreElem:
+    case Append:
+    case GetElem:
+    case Bind:
+    case DynBind:
+    case StBind:
+      emit_unsupported(instr);
+      break;
+    }
+  }
+
+
+  // Private members
+
+  void c_emitter::emit_binary(const ir::instruction& bin) noexcept
+  {
+    assign(bin[0]);
+    plain("tnac_binary("sv);
+    plain(detail::binary_op(bin.opcode()));
+    plain(", "sv);
+    operand(bin[1]);
+    plain(", "sv);
+    operand(bin[2]);
+    plain(");"sv);
+    endl();
+  }
+
+  void c_emitter::emit_unary(const ir::instruction& un) noexcept
+  {
+    assign(un[0]);
+    plain("tnac_unary("sv);
+    plain(detail::unary_op(un.opcode()));
+    plain(", "sv);
+    operand(un[1]);
+    plain(");"sv);
+    endl();
+  }
+
+  void c_emitter::emit_type(const ir::instruction& inst) noexcept
+  {
+    const auto oc = inst.opcode();
+    const auto opCount = inst.operand_count();
+    assign(inst[0]);
+    plain(detail::type_ctor(oc));
+    plain("("sv);
+    for (auto idx = 1u; idx <= detail::ctor_arity(oc); ++idx)
+    {
+      if (idx > 1u)
+        plain(", "sv);
+
+      if (idx < opCount)
+        operand(inst[idx]);
+      else
+        plain("tnac_undef()"sv);
+    }
+    plain(");"sv);
+    endl();
+  }
+
+  void c_emitter::emit_test(const ir::instruction& test) noexcept
+  {
+    assign(test[0]);
+    out() << "tnac_test((tnac_type)" << static_cast<unsigned>(test[1].get_typeid()) << ", ";
+    operand(test[2]);
+    plain(");"sv);
+    endl();
+  }
+
+  void c_emitter::emit_select(const ir::instruction& sel) noexcept
+  {
+    assign(sel[0]);
+    plain("tnac_truthy("sv);
+    operand(sel[1]);
+    plain(") ? "sv);
+    operand(sel[2]);
+    plain(" : "sv);
+    operand(sel[3]);
+    plain(";"sv);
+    endl();
+  }
+
+  void c_emitter::emit_load(const ir::instruction& load) noexcept
+  {
+    auto&& from = load[1];
+
+    // Parameters are copied from the arguments in the prologue
+    if (from.is_param())
+      return;
+
+    if (from.is_record())
+    {
+      emit_unsupported(load);
+      return;
+    }
+
+    assign(load[0]);
+    operand(from);
+    plain(";"sv);
+    endl();
+  }
+
+  void c_emitter::emit_store(const ir::instruction& store) noexcept
+  {
+    assign(store[1]);
+    operand(store[0]);
+    plain(";"sv);
+    endl();
+  }
+
+  void c_emitter::emit_call(const ir::instruction& call) noexcept
+  {
+    using size_type = decltype(call.operand_count());
+    constexpr auto firstArg = size_type{ 2 };
+    const auto opCount = call.operand_count();
+    const auto argCount = opCount - firstArg;
+
+    auto&& callee = call[1];
+    const ir::function* direct{};
+    if (callee.is_value())
+    {
+      if (auto fn = eval::extract_function(callee.get_value()); fn && !fn->is_closure())
+      {
+        if ((*fn)->param_count() == argCount && m_funcs.contains(&**fn))
+          direct = &**fn;
+      }
+    }
+
+    assign(call[0]);
+    if (direct)
+    {
+      func_name(*direct);
+      plain("("sv);
+    }
+    else
+    {
+      plain("tnac_call("sv);
+      operand(callee);
+      out() << ", " << argCount << ", ";
+    }
+
+    if (!argCount)
+    {
+      plain("NULL"sv);
+    }
+    else
+    {
+      plain("(const tnac_value[]){ "sv);
+      for (auto idx = firstArg; idx < opCount; ++idx)
+      {
+        if (idx > firstArg)
+          plain(", "sv);
+        operand(call[idx]);
+      }
+      plain(" }"sv);
+    }
+    plain(");"sv);
+    endl();
+  }
+
+  void c_emitter::emit_jump(const ir::instruction& jmp) noexcept
+  {
+    UTILS_ASSERT(m_curBlock);
+    if (jmp.operand_count() < 3)
+    {
+      emit_edge(*m_curBlock, jmp[0].get_block());
+      return;
+    }
+
+    plain("  if (tnac_truthy("sv);
+    operand(jmp[0]);
+    plain(")) {"sv);
+    endl();
+    emit_edge(*m_curBlock, jmp[1].get_block());
+    plain("  }"sv);
+    endl();
+    emit_edge(*m_curBlock, jmp[2].get_block());
+  }
+
+  void c_emitter::emit_ret(const ir::instruction& ret) noexcept
+  {
+    plain("  return "sv);
+    operand(ret[0]);
+    plain(";"sv);
+    endl();
+  }
+
+  void c_emitter::emit_unsupported(const ir::instruction& instr) noexcept
+  {
+    ++m_unsupported;
+    if (instr.operand_count() && instr[0].is_register() && m_regs.contains(&instr[0].get_reg()))
+      assign(instr[0]);
+    else
+      plain("  "sv);
+
+    out() << "tnac_unsupported(\"" << instr.opcode_str() << "\");";
+    endl();
+  }
+
+  void c_emitter::emit_edge(const ir::basic_block& from, const ir::basic_block& to) noexcept
+  {
+    // Phis of the same block read their inputs before any of them is assigned
+    std::vector<const ir::instruction*> phis;
+    std::vector<ir::operand> vals;
+    for (auto&& instr : to)
+    {
+      if (instr.opcode() != ir::op_code::Phi)
+        break;
+
+      const auto opCount = instr.operand_count();
+      for (auto idx = decltype(opCount){ 1 }; idx < opCount; ++idx)
+      {
+        auto&& edge = instr[idx].get_edge();
+        if (&edge.incoming() != &from)
+          continue;
+
+        phis.push_back(&instr);
+        vals.push_back(edge.value());
+        break;
+      }
+    }
+
+    if (!phis.empty())
+    {
+      plain("  {"sv);
+      endl();
+      for (auto idx = size_type{}; idx < phis.size(); ++idx)
+      {
+        out() << "  const tnac_value t" << idx << " = ";
+        operand(vals[idx]);
+        plain(";"sv);
+        endl();
+      }
+      for (auto idx = size_type{}; idx < phis.size(); ++idx)
+      {
+        assign((*phis[idx])[0]);
+        out() << 't' << idx << ';';
+        endl();
+      }
+      plain("  }"sv);
+      endl();
+    }
+
+    plain("  goto "sv);
+    label(to);
+    plain(";"sv);
+    endl();
+  }
+
+  out_stream& c_emitter::out() noexcept
+  {
+    return *m_out;
+  }
+
+  void c_emitter::endl() noexcept
+  {
+    out() << '\n';
+  }
+
+  void c_emitter::plain(string_t str) noexcept
+  {
+    out() << str;
+  }
+
+  void c_emitter::operand(const ir::operand& op) noexcept
+  {
+    if (op.is_value())
+    {
+      value(op.get_value());
+      return;
+    }
+
+    if (op.is_register())
+    {
+      if (auto reg = m_regs.find(&op.get_reg()); reg != m_regs.end())
+      {
+        out() << 'r' << reg->second;
+        return;
+      }
+    }
+
+    ++m_unsupported;
+    plain("tnac_unsupported(\"operand\")"sv);
+  }
+
+  void c_emitter::value(const eval::value& val) noexcept
+  {
+    auto visitor = utils::visitor
+    {
+      [&](eval::bool_type b) noexcept
+      {
+        out() << "tnac_bool(" << (b ? 1 : 0) << ')';
+      },
+      [&](eval::int_type i) noexcept
+      {
+        plain("tnac_int("sv);
+        detail::write_int(out(), i);
+        plain(")"sv);
+      },
+      [&](eval::float_type f) noexcept
+      {
+        plain("tnac_float("sv);
+        detail::write_float(out(), f);
+        plain(")"sv);
+      },
+      [&](eval::complex_type c) noexcept
+      {
+        plain("tnac_cplx("sv);
+        detail::write_float(out(), c.real());
+        plain(", "sv);
+        detail::write_float(out(), c.imag());
+        plain(")"sv);
+      },
+      [&](eval::fraction_type f) noexcept
+      {
+        plain("tnac_frac("sv);
+        detail::write_int(out(), f.num() * f.sign());
+        plain(", "sv);
+        detail::write_int(out(), f.denom());
+        plain(")"sv);
+      },
+      [&](eval::function_type f) noexcept
+      {
+        if (f.is_closure() || !m_funcs.contains(&*f))
+        {
+          ++m_unsupported;
+          plain("tnac_unsupported(\"closure\")"sv);
+          return;
+        }
+
+        plain("tnac_fnval(&"sv);
+        func_descr(*f);
+        plain(")"sv);
+      },
+      [&](eval::array_type) noexcept
+      {
+        ++m_unsupported;
+        plain("tnac_unsupported(\"array\")"sv);
+      },
+      [&](eval::invalid_val_t) noexcept
+      {
+        plain("tnac_undef()"sv);
+      }
+    };
+
+    eval::on_value(val, visitor);
+  }
+
+  void c_emitter::assign(const ir::operand& op) noexcept
+  {
+    plain("  "sv);
+    operand(op);
+    plain(" = "sv);
+  }
+
+  void c_emitter::label(const ir::basic_block& block) noexcept
+  {
+    auto found = m_blocks.find(&block);
+    UTILS_ASSERT(found != m_blocks.end());
+    out() << 'b' << found->second;
+  }
+
+  void c_emitter::func_name(const ir::function& fn) noexcept
+  {
+    auto found = m_funcs.find(&fn);
+    UTILS_ASSERT(found != m_funcs.end());
+    out() << "tnac_f" << found->second;
+  }
+
+  void c_emitter::func_descr(const ir::function& fn) noexcept
+  {
+    auto found = m_funcs.find(&fn);
+    UTILS_ASSERT(found != m_funcs.end());
+    out() << "tnac_d" << found->second;
+  }
+
+  void c_emitter::declare_funcs() noexcept
+  {
+    std::queue<const ir::function*> fnq;
+    for (auto mod : *m_cfg)
+    {
+      if (mod->is_loose())
+        continue;
+
+      fnq.push(mod);
+      m_entry = mod;
+    }
+
+    while (!fnq.empty())
+    {
+      auto fn = fnq.front();
+      fnq.pop();
+      m_funcs.try_emplace(fn, m_funcs.size());
+
+      plain("static tnac_value "sv);
+      func_name(*fn);
+      plain("(const tnac_value* args);"sv);
+      endl();
+
+      for (auto child : fn->children())
+        fnq.push(child);
+    }
+    endl();
+
+    std::vector<const ir::function*> funcs(m_funcs.size());
+    for (auto&& [fn, idx] : m_funcs)
+      funcs[idx] = fn;
+
+    for (auto fn : funcs)
+    {
+      plain("const tnac_fn "sv);
+      func_descr(*fn);
+      plain(" = { "sv);
+      func_name(*fn);
+      out() << ", " << fn->param_count() << ", \"" << fn->name() << "\" };";
+      endl();
+    }
+    endl();
+  }
+
+  void c_emitter::emit_main() noexcept
+  {
+    if (!m_entry)
+      return;
+
+    const auto paramCount = std::max(size_type{ 1 }, size_type{ m_entry->param_count() });
+    plain("int main(int argc, char** argv)"sv);
+    endl();
+    plain("{"sv);
+    endl();
+    out() << "  tnac_value args[" << paramCount << "];";
+    endl();
+    out() << "  for (int i = 0; i < " << paramCount << "; ++i)";
+    endl();
+    plain("    args[i] = (i + 1 < argc) ? tnac_parse_arg(argv[i + 1]) : tnac_undef();"sv);
+    endl();
+    endl();
+    plain("  tnac_write(stdout, "sv);
+    func_name(*m_entry);
+    plain("(args), 1);"sv);
+    endl();
+    plain("  fputc('\\n', stdout);"sv);
+    endl();
+    plain("  return 0;"sv);
+    endl();
+    plain("}"sv);
+    endl();
+  }
+}
@@ -126,6 +126,7 @@ namespace tnac::rt::out
     case Float:
     case Frac:
     case Cplx:
+    case Range:
       print_inst(instr);
       break;
     }
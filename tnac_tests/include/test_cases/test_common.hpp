@@ -150,9 +150,10 @@ namespace tnac::tests
         return *this;
       }
 
-      for (auto&& [e, s] : utils::make_iterators(expected.wrapper(), stored.wrapper()))
+      auto si = stored.wrapper().begin();
+      for (auto&& e : expected.wrapper())
       {
-        auto vc = value_checker{ s };
+        auto vc = value_checker{ *si++ };
         eval::on_value(e, utils::visitor{
           [&](dummy) noexcept
           {
@@ -265,13 +266,34 @@ namespace tnac::tests
   class source_tester final
   {
   public:
-    using symtab = std::unordered_map<string_t, ir::function*>;
+    using symtab    = std::unordered_map<string_t, ir::function*>;
+    using opt_stats = compiler::opt_stats;
+    using size_type = ir::function::size_type;
+
+    struct settings
+    {
+      compiler::inline_settings m_inline{};
+      bool m_optimise{ true };
+    };
 
   public:
     CLASS_SPECIALS_NONE(source_tester);
 
     explicit source_tester(string_t path) noexcept :
+      source_tester{ path, settings{} }
+    {
+    }
+
+    source_tester(string_t path, const settings& cfg) noexcept :
       m_core{ m_fb }
+    {
+      auto&& comp = m_core.get_compiler();
+      comp.configure_inlining(cfg.m_inline);
+      comp.set_optimising(cfg.m_optimise);
+      load(path);
+    }
+
+    source_tester& load(string_t path) noexcept
     {
       const auto loadRes = m_core.process_file(path);
       EXPECT_TRUE(loadRes);
@@ -282,13 +304,16 @@ namespace tnac::tests
       auto end = cfg.end();
       EXPECT_NE(it, end);
 
+      const auto loaded = m_st.size();
       for (; it != end; ++it)
       {
         auto mod = *it;
         auto modName = mod->raw_name();
-        auto res = m_st.emplace(modName, mod);
-        EXPECT_TRUE(res.second);
+        m_st.try_emplace(modName, mod);
       }
+
+      EXPECT_GT(m_st.size(), loaded);
+      return *this;
     }
 
     template <testable... Args>
@@ -298,17 +323,52 @@ namespace tnac::tests
       auto fn = find_fn(input, sizeof...(args));
       if (!fn) return *this;
 
+      value_checker{ run(*fn, args...) }.verify(expected);
+      return *this;
+    }
+
+    template <testable... Args>
+    value evaluate(string_t input, Args... args) noexcept
+    {
+      utils::unused(args...);
+      auto fn = find_fn(input, sizeof...(args));
+      if (!fn) return {};
+
+      return run(*fn, args...);
+    }
+
+    ir_eval& evaluator() noexcept
+    {
+      return m_core.ir_evaluator();
+    }
+
+    const ir::cfg& cfg() noexcept
+    {
+      return m_core.get_cfg();
+    }
+
+    const opt_stats& opt_counters() noexcept
+    {
+      return m_core.get_compiler().opt_counters();
+    }
+
+    ir::function* func(string_t name, size_type paramCount) noexcept
+    {
+      return find_fn(name, paramCount);
+    }
+
+  private:
+    template <testable... Args>
+    value run(ir::function& fn, Args... args) noexcept
+    {
       auto&& ev = m_core.ir_evaluator();
-      ev.enter(*fn);
+      ev.enter(fn);
       ( ..., ev.add_arg(detail::to_value(args)) );
       ev.evaluate_current();
-
-      value_checker{ ev.result() }.verify(expected);
-      return *this;
+      return ev.result();
     }
 
-  private:
-    ir::function* find_fn(string_t name, ir::function::size_type paramCount) noexcept
+    ir::function* find_fn(string_t name, size_type paramCount) noexcept
     {
       EXPECT_FALSE(name.empty());
       auto nameParts = utils::split(name, "."sv);
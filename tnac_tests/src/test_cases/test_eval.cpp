@@ -239,6 +239,34 @@ namespace tnac::tests
     ;
   }
 
+  TEST(evaluation, t_kernels)
+  {
+    const std::array vals{ value{ true }, value{ eval::int_type{ 7 } }, value{ 3.5 },
+                           value{ eval::int_type{ -3 } }, value{ -0.25 } };
+    const auto opCount = static_cast<std::uint8_t>(val_ops::AbsoluteValue) + 1;
+    for (std::uint8_t opIdx{}; opIdx < opCount; ++opIdx)
+    {
+      const auto op = static_cast<val_ops>(opIdx);
+      for (auto&& l : vals)
+      {
+        auto fastUn = l.unary(op);
+        auto genUn = l.unary_generic(op);
+        EXPECT_EQ(fastUn.id(), genUn.id()) << "Unary op " << +opIdx;
+        if (fastUn && fastUn.id() == genUn.id())
+          EXPECT_TRUE(eval::to_bool(fastUn.binary_generic(val_ops::Equal, genUn))) << "Unary op " << +opIdx;
+
+        for (auto&& r : vals)
+        {
+          auto fast = l.binary(op, r);
+          auto gen = l.binary_generic(op, r);
+          EXPECT_EQ(fast.id(), gen.id()) << "Binary op " << +opIdx;
+          if (fast && fast.id() == gen.id())
+            EXPECT_TRUE(eval::to_bool(fast.binary_generic(val_ops::Equal, gen))) << "Binary op " << +opIdx;
+        }
+      }
+    }
+  }
+
   TEST(evaluation, t_arr_eq)
   {
     array_builder ab;
@@ -1,7 +1,113 @@
 #include "test_cases/test_common.hpp"
+#include "output/c_emitter.hpp"
+#include <cstdlib>
 
 #define TEST_EXAMPLE(N) "tests/example"#N".tnac"sv
 
+namespace tnac::tests
+{
+  namespace
+  {
+    struct ir_size
+    {
+      std::size_t m_blocks{};
+      std::size_t m_instructions{};
+    };
+
+    ir_size measure(const ir::function* fn) noexcept
+    {
+      ir_size res;
+      if (!fn)
+        return res;
+
+      for (auto&& block : fn->blocks())
+      {
+        ++res.m_blocks;
+        for (auto it = block.begin(); it != block.end(); ++it)
+          ++res.m_instructions;
+      }
+
+      return res;
+    }
+
+    std::size_t count_ops(const ir::function* fn, ir::op_code oc) noexcept
+    {
+      std::size_t res{};
+      if (!fn)
+        return res;
+
+      for (auto&& block : fn->blocks())
+      {
+        for (auto&& instr : block)
+        {
+          if (instr.opcode() == oc)
+            ++res;
+        }
+      }
+
+      return res;
+    }
+
+    //
+    // Checks whether there is a C compiler to build the emitted code with
+    //
+    bool has_c_compiler() noexcept
+    {
+#if TNAC_WINDOWS
+      return false;
+#else
+      return !std::system("cc --version > /dev/null 2>&1");
+#endif
+    }
+
+    //
+    // Emits C code for a compiled program and builds it with the system C compiler
+    // Returns the path to the executable, or an empty optional if the build failed
+    //
+    std::optional<std::filesystem::path> build_c(const ir::cfg& gr, string_t name) noexcept
+    {
+      namespace fs = std::filesystem;
+      std::error_code errc;
+      const auto dir = fs::temp_directory_path(errc) / "tnac_c_tests";
+      fs::create_directories(dir, errc);
+
+      const auto exe = dir / name;
+      const auto src = fs::path{ exe }.replace_extension(".c");
+      {
+        std::ofstream os{ src };
+        rt::out::c_emitter ce;
+        ce(gr, os);
+        EXPECT_EQ(ce.unsupported_count(), 0u);
+      }
+
+      std::ostringstream cmd;
+      cmd << "cc -std=c11 -o " << exe << ' ' << src << " -lm";
+      if (std::system(cmd.str().c_str()))
+        return {};
+
+      return exe;
+    }
+
+    //
+    // Runs a program built from emitted C code with the given argument
+    // Returns the first line it printed
+    //
+    std::optional<buf_t> run_c(const std::filesystem::path& exe, string_t arg) noexcept
+    {
+      const auto res = std::filesystem::path{ exe }.replace_extension(".txt");
+      std::ostringstream cmd;
+      cmd << exe << ' ' << arg << " > " << res;
+      if (std::system(cmd.str().c_str()))
+        return {};
+
+      std::ifstream in{ res };
+      buf_t out;
+      std::getline(in, out);
+      return out;
+    }
+  }
+}
+
 namespace tnac::tests
 {
   TEST(program, t_playground)
@@ -61,4 +167,722 @@ namespace tnac::tests
     ;
   }
 
+  TEST(program, t_example_tail)
+  {
+    source_tester st{ TEST_EXAMPLE(_tail) };
+    constexpr auto fn = "example_tail.sum"sv;
+    st
+      .test(fn, 0, 0, 0)
+      .test(fn, 1, 1, 0)
+      .test(fn, 15, 5, 0)
+      .test(fn, 5050, 100, 0)
+      .test(fn, 5000050000, 100000, 0)
+    ;
+  }
+
+  TEST(program, t_example_tail_swap)
+  {
+    source_tester st{ TEST_EXAMPLE(_tail) };
+    constexpr auto fn = "example_tail.swap"sv;
+    st
+      .test(fn, 12, 1, 2, 0)
+      .test(fn, 21, 1, 2, 1)
+      .test(fn, 12, 1, 2, 4)
+      .test(fn, 21, 1, 2, 1001)
+    ;
+  }
+
+  TEST(program, t_example_tail_header)
+  {
+    constexpr auto sum   = "example_tail.sum"sv;
+    constexpr auto plain = "example_tail.plain"sv;
+    constexpr auto depth = "example_tail.depth"sv;
+
+    source_tester raw{ TEST_EXAMPLE(_tail), { .m_optimise = false } };
+    raw.test(plain, 7, 3)
+      .test(depth, 0, -1)
+      .test(depth, 4, 4)
+    ;
+
+    // Only self tail calls get a loop header with parameter phis
+    EXPECT_EQ(count_ops(raw.func(sum, 2), ir::op_code::Phi), 2u);
+    EXPECT_EQ(count_ops(raw.func(plain, 1), ir::op_code::Phi), 0u);
+    EXPECT_EQ(measure(raw.func(plain, 1)).m_blocks, 1u);
+
+    // A self call which isn't in tail position stays a call
+    EXPECT_EQ(count_ops(raw.func(depth, 1), ir::op_code::Call), 1u);
+    EXPECT_EQ(count_ops(raw.func(depth, 1), ir::op_code::Phi), 1u);
+  }
+
+  TEST(program, t_example_mem2reg)
+  {
+    constexpr auto vars = "example_mem2reg.vars"sv;
+    constexpr auto acc  = "example_mem2reg.acc"sv;
+
+    source_tester raw{ TEST_EXAMPLE(_mem2reg), { .m_optimise = false } };
+    source_tester st{ TEST_EXAMPLE(_mem2reg) };
+    for (auto tester : { &raw, &st })
+    {
+      tester->test(vars, 8, 3)
+        .test(vars, 3, -1)
+        .test(acc, 10, 4, 0)
+      ;
+    }
+
+    EXPECT_GT(count_ops(raw.func(vars, 1), ir::op_code::Alloc), 0u);
+    EXPECT_GT(st.opt_counters().m_promoted, 0u);
+    for (auto fn : { st.func(vars, 1), st.func(acc, 2) })
+    {
+      ASSERT_NE(fn, nullptr);
+      EXPECT_EQ(count_ops(fn, ir::op_code::Alloc), 0u);
+      EXPECT_EQ(count_ops(fn, ir::op_code::Store), 0u);
+    }
+
+    EXPECT_LT(measure(st.func(vars, 1)).m_instructions, measure(raw.func(vars, 1)).m_instructions);
+  }
+
+  TEST(program, t_example_gvn)
+  {
+    constexpr auto same = "example_gvn.same"sv;
+    constexpr auto dom  = "example_gvn.dominated"sv;
+
+    source_tester raw{ TEST_EXAMPLE(_gvn), { .m_optimise = false } };
+    source_tester st{ TEST_EXAMPLE(_gvn) };
+    for (auto tester : { &raw, &st })
+    {
+      tester->test(same, 9, 4)
+        .test(dom, 12, 3)
+        .test(dom, 0, -3)
+      ;
+    }
+
+    EXPECT_EQ(count_ops(raw.func(same, 1), ir::op_code::Sub), 2u);
+    EXPECT_EQ(count_ops(raw.func(dom, 1), ir::op_code::Mul), 3u);
+
+    EXPECT_EQ(count_ops(st.func(same, 1), ir::op_code::Sub), 1u);
+    EXPECT_EQ(count_ops(st.func(dom, 1), ir::op_code::Mul), 1u);
+    EXPECT_EQ(st.opt_counters().m_deduplicated, 3u);
+  }
+
+  TEST(program, t_example_sccp)
+  {
+    constexpr auto folded = "example_sccp.folded"sv;
+    constexpr auto across = "example_sccp.across"sv;
+
+    source_tester raw{ TEST_EXAMPLE(_sccp), { .m_optimise = false } };
+    source_tester st{ TEST_EXAMPLE(_sccp) };
+    for (auto tester : { &raw, &st })
+    {
+      tester->test(folded, 7, 1)
+        .test(across, 8, 5)
+        .test(across, 8, -5)
+      ;
+    }
+
+    auto foldedFn = st.func(folded, 1);
+    EXPECT_EQ(count_ops(foldedFn, ir::op_code::Mul), 0u);
+    EXPECT_EQ(count_ops(foldedFn, ir::op_code::CmpG), 0u);
+    EXPECT_EQ(count_ops(foldedFn, ir::op_code::Sub), 0u);
+    EXPECT_LT(measure(foldedFn).m_blocks, measure(raw.func(folded, 1)).m_blocks);
+
+    auto acrossFn = st.func(across, 1);
+    EXPECT_EQ(count_ops(raw.func(across, 1), ir::op_code::Mul), 1u);
+    EXPECT_EQ(count_ops(acrossFn, ir::op_code::Mul), 0u);
+    EXPECT_EQ(count_ops(acrossFn, ir::op_code::Add), 0u);
+
+    auto&& opt = st.opt_counters();
+    EXPECT_GT(opt.m_folded, 0u);
+    EXPECT_GT(opt.m_pruned, 0u);
+  }
+
+  TEST(program, t_example_cleanup)
+  {
+    constexpr auto dead   = "example_cleanup.dead"sv;
+    constexpr auto branch = "example_cleanup.branch"sv;
+
+    source_tester raw{ TEST_EXAMPLE(_cleanup), { .m_optimise = false } };
+    source_tester st{ TEST_EXAMPLE(_cleanup) };
+    for (auto tester : { &raw, &st })
+    {
+      tester->test(dead, 6, 5)
+        .test(dead, 1, -5)
+        .test(branch, 4, 2)
+        .test(branch, -6, -2)
+      ;
+    }
+
+    EXPECT_EQ(count_ops(raw.func(dead, 1), ir::op_code::Mul), 1u);
+    EXPECT_EQ(count_ops(st.func(dead, 1), ir::op_code::Mul), 0u);
+
+    for (auto name : { dead, branch })
+    {
+      const auto before = measure(raw.func(name, 1));
+      const auto after  = measure(st.func(name, 1));
+      EXPECT_LT(after.m_blocks, before.m_blocks);
+      EXPECT_LT(after.m_instructions, before.m_instructions);
+    }
+
+    auto&& opt = st.opt_counters();
+    EXPECT_GT(opt.m_erased, 0u);
+    EXPECT_GT(opt.m_merged, 0u);
+  }
+
+  TEST(program, t_example_inline)
+  {
+    constexpr auto twice = "example_inline.twice"sv;
+    constexpr auto clamp = "example_inline.clamp"sv;
+
+    source_tester st{ TEST_EXAMPLE(_inline) };
+    st.test(twice, 20, 3)
+      .test(clamp, 1, -4)
+      .test(clamp, 5, 4)
+    ;
+
+    EXPECT_EQ(count_ops(st.func(twice, 1), ir::op_code::Call), 0u);
+    EXPECT_EQ(count_ops(st.func(clamp, 1), ir::op_code::Call), 0u);
+    EXPECT_EQ(st.opt_counters().m_inlined, 3u);
+    EXPECT_GT(measure(st.func(clamp, 1)).m_blocks, 1u);
+  }
+
+  TEST(program, t_example_inline_off)
+  {
+    constexpr auto twice = "example_inline.twice"sv;
+    constexpr auto clamp = "example_inline.clamp"sv;
+
+    source_tester st{ TEST_EXAMPLE(_inline), { .m_inline{ .m_enabled = false } } };
+    st.test(twice, 20, 3)
+      .test(clamp, 1, -4)
+      .test(clamp, 5, 4)
+    ;
+
+    EXPECT_EQ(count_ops(st.func(twice, 1), ir::op_code::Call), 2u);
+    EXPECT_EQ(count_ops(st.func(clamp, 1), ir::op_code::Call), 1u);
+    EXPECT_EQ(st.opt_counters().m_inlined, 0u);
+  }
+
+  TEST(program, t_example_c)
+  {
+    if (!has_c_compiler())
+      GTEST_SKIP() << "No C compiler to build the emitted code";
+
+    constexpr auto mod = "example_c"sv;
+    source_tester st{ TEST_EXAMPLE(_c) };
+    st.test(mod, 13, 0)
+      .test(mod, 156, 5)
+      .test(mod, 3628867, 10)
+    ;
+
+    const auto exe = build_c(st.cfg(), mod);
+    ASSERT_TRUE(exe.has_value()) << "Emitted C code doesn't build";
+
+    for (auto arg : { 0, 5, 10 })
+    {
+      const auto expected = st.evaluate(mod, arg);
+      ASSERT_EQ(expected.id(), eval::type_id::Int);
+
+      const auto argStr = std::to_string(arg);
+      const auto actual = run_c(*exe, argStr);
+      ASSERT_TRUE(actual.has_value()) << "Failed to run with argument " << argStr;
+      EXPECT_EQ(*actual, std::to_string(expected.get<eval::int_type>()));
+    }
+  }
+
+  TEST(program, t_example_rebuild)
+  {
+    constexpr auto fn = "example_rebuild.inc"sv;
+    source_tester st{ TEST_EXAMPLE(_rebuild) };
+    st.test(fn, 2, 1);
+
+    // Rewrite the constant the way a rebuild would
+    // Running the function first lowers it into flat code
+    auto func = st.func(fn, 1);
+    ASSERT_NE(func, nullptr);
+    auto replaced = false;
+    for (auto&& block : func->blocks())
+    {
+      for (auto&& instr : block)
+      {
+        if (instr.opcode() != ir::op_code::Add)
+          continue;
+
+        for (auto idx = ir::instruction::size_type{}; idx < instr.operand_count(); ++idx)
+        {
+          if (!instr[idx].is_value())
+            continue;
+
+          instr.replace(idx, eval::value{ eval::int_type{ 10 } });
+          replaced = true;
+        }
+      }
+    }
+    ASSERT_TRUE(replaced);
+
+    // Compiling more code has to drop what was lowered before it
+    auto&& stats = st.evaluator().flat_code_stats();
+    const auto lowered = stats.m_functions;
+    st.load(TEST_EXAMPLE(_rebuild_next))
+      .test(fn, 11, 1)
+      .test(fn, 10, 0)
+      .test("example_rebuild_next.dec"sv, 0, 1)
+    ;
+    EXPECT_GT(stats.m_functions, lowered);
+  }
+
+  TEST(program, t_example_range)
+  {
+    source_tester st{ TEST_EXAMPLE(_range) };
+
+    // Returns the visible part of a lazy range, or nothing if the elements were generated
+    auto lazy = [&st]<typename T>(T, string_t name, eval::int_type n) noexcept
+      -> std::optional<eval::array_data::range_desc<T>>
+      {
+        const auto res = st.evaluate(name, n);
+        auto arr = res.try_get<eval::type_id::Array>();
+        if (!arr)
+          return {};
+
+        return arr->wrapper().template range<T>();
+      };
+    constexpr auto ints = eval::int_type{};
+    constexpr auto floats = eval::float_type{};
+
+    auto seq = lazy(ints, "example_range.seq"sv, 4);
+    ASSERT_TRUE(seq.has_value());
+    EXPECT_EQ(seq->m_start, 1);
+    EXPECT_EQ(seq->m_step, 2);
+    EXPECT_EQ(seq->m_count, 4u);
+    EXPECT_EQ(seq->at(3), 7);
+
+    auto neg = lazy(ints, "example_range.neg"sv, 4);
+    ASSERT_TRUE(neg.has_value());
+    EXPECT_EQ(neg->m_start, -1);
+    EXPECT_EQ(neg->m_step, -2);
+    EXPECT_EQ(neg->m_count, 4u);
+
+    auto shifted = lazy(ints, "example_range.shifted"sv, 4);
+    ASSERT_TRUE(shifted.has_value());
+    EXPECT_EQ(shifted->m_start, 11);
+    EXPECT_EQ(shifted->m_step, 2);
+
+    auto halves = lazy(floats, "example_range.halves"sv, 3);
+    ASSERT_TRUE(halves.has_value());
+    EXPECT_EQ(halves->m_count, 3u);
+    EXPECT_DOUBLE_EQ(halves->at(2), 1.0);
+
+    auto empty = lazy(ints, "example_range.seq"sv, 0);
+    ASSERT_TRUE(empty.has_value());
+    EXPECT_EQ(empty->m_count, 0u);
+
+    // Head and tail read by index, so the tail is still a range
+    constexpr auto first = "example_range.first"sv;
+    constexpr auto rest  = "example_range.rest"sv;
+    st.test(first, 1, 4)
+      .test(rest, 3, 2)
+    ;
+    EXPECT_FALSE(st.evaluate(first, 0));
+    EXPECT_FALSE(st.evaluate(rest, 1));
+
+    auto tail = lazy(ints, rest, 4);
+    ASSERT_TRUE(tail.has_value());
+    EXPECT_EQ(tail->m_start, 3);
+    EXPECT_EQ(tail->m_count, 3u);
+    EXPECT_EQ(tail->at(2), 7);
+
+    // Elements read through the iterators match the generated ones
+    array_builder ab;
+    st.test("example_range.seq"sv, ab.with_new(4).add(1).add(3).add(5).add(7).get(), 4)
+      .test("example_range.halves"sv, ab.with_new(3).add(0.5).add(0.75).add(1.0).get(), 3)
+    ;
+
+    auto scaled = ab.with_new(4).add(2).add(8).add(14).add(20).get();
+    st.test("example_range.scaled"sv, scaled, 4)
+      .test("example_range.folded"sv, scaled)
+    ;
+  }
+
+  TEST(program, t_example_lib)
+  {
+    source_tester st{ TEST_EXAMPLE(_lib) };
+
+    array_builder ab;
+    auto ints   = ab.with_new(3).add(3).add(1).add(2).get();
+    auto floats = ab.with_new(3).add(3.0).add(-1.5).add(2.0).get();
+    auto mixed  = ab.with_new(3).add(3).add(1.5).add(2).get();
+    auto empty  = ab.with_new(0).get();
+
+    // Same-typed numbers go through the packed kernels, anything else is boxed
+    ASSERT_FALSE(ints->data().is_boxed());
+    ASSERT_FALSE(floats->data().is_boxed());
+    ASSERT_TRUE(mixed->data().is_boxed());
+
+    constexpr auto total = "example_lib.total"sv;
+    st.test(total, 6, ints)
+      .test(total, 3.5, floats)
+      .test(total, 6.5, mixed)
+      .test(total, 0, empty)
+    ;
+
+    constexpr auto prod = "example_lib.prod"sv;
+    st.test(prod, 6, ints)
+      .test(prod, -9.0, floats)
+      .test(prod, 9.0, mixed)
+      .test(prod, 1, empty)
+    ;
+
+    constexpr auto lo = "example_lib.lo"sv;
+    constexpr auto hi = "example_lib.hi"sv;
+    st.test(lo, 1, ints)
+      .test(lo, -1.5, floats)
+      .test(lo, 1.5, mixed)
+      .test(hi, 3, ints)
+      .test(hi, 3.0, floats)
+      .test(hi, 3, mixed)
+    ;
+    EXPECT_FALSE(st.evaluate(lo, empty));
+    EXPECT_FALSE(st.evaluate(hi, empty));
+
+    constexpr auto sorted = "example_lib.sorted"sv;
+    st.test(sorted, ab.with_new(3).add(1).add(2).add(3).get(), ints)
+      .test(sorted, ab.with_new(3).add(-1.5).add(2.0).add(3.0).get(), floats)
+      .test(sorted, ab.with_new(3).add(1.5).add(2).add(3).get(), mixed)
+      .test(sorted, ab.with_new(0).get(), empty)
+    ;
+    const auto packedSort = st.evaluate(sorted, ints);
+    auto sortedArr = packedSort.try_get<eval::type_id::Array>();
+    ASSERT_NE(sortedArr, nullptr);
+    EXPECT_FALSE(sortedArr->wrapper().data().is_boxed());
+
+    constexpr auto dotted = "example_lib.dotted"sv;
+    st.test(dotted, 14, ints, ints)
+      .test(dotted, 11.5, ints, floats)
+      .test(dotted, 14.5, mixed, ints)
+      .test(dotted, 0, empty, empty)
+    ;
+    EXPECT_FALSE(st.evaluate(dotted, ints, ab.with_new(2).add(1).add(2).get()));
+
+    constexpr auto prefix = "example_lib.prefix"sv;
+    st.test(prefix, ab.with_new(3).add(3).add(4).add(6).get(), ints)
+      .test(prefix, ab.with_new(3).add(3.0).add(1.5).add(3.5).get(), floats)
+      .test(prefix, ab.with_new(3).add(3).add(4.5).add(6.5).get(), mixed)
+      .test(prefix, ab.with_new(0).get(), empty)
+    ;
+
+    constexpr auto folded = "example_lib.folded"sv;
+    st.test(folded, 6, ints)
+      .test(folded, -9.0, floats)
+      .test(folded, 9.0, mixed)
+    ;
+    EXPECT_FALSE(st.evaluate(folded, empty));
+
+    auto row0 = ab.with_new(2).add(1).add(2).get();
+    auto row1 = ab.with_new(2).add(3).add(4).get();
+    st.test("example_lib.rows"sv, 11, ab.with_new(2).add(row0).add(row1).get());
+
+    // Ranges are summed in closed form and aren't generated
+    st.test("example_lib.range_sum"sv, 10, 5)
+      .test("example_lib.range_sum"sv, 0, 0)
+      .test("example_lib.range_max"sv, 7, 4)
+    ;
+  }
+
+  TEST(program, t_example_slice)
+  {
+    constexpr auto fn = "example_slice.part"sv;
+    source_tester st{ TEST_EXAMPLE(_slice) };
+
+    array_builder ab;
+    st.test(fn, ab.with_new(3).add(2).add(4).add(6).get(), 1, 3, 2)
+      .test(fn, ab.with_new(3).add(6).add(4).add(2).get(), 5, 3, -2)
+      .test(fn, ab.with_new(1).add(4).get(), 3, 1, 100)
+      .test(fn, ab.with_new(0).get(), 0, 0, 1)
+    ;
+
+    // Views that don't fit, including the ones whose last index overflows
+    constexpr auto bigStep = eval::int_type{ 1 } << 62;
+    constexpr auto minStep = std::numeric_limits<eval::int_type>::min();
+    EXPECT_FALSE(st.evaluate(fn, 1, 4, 2));
+    EXPECT_FALSE(st.evaluate(fn, 6, 1, 1));
+    EXPECT_FALSE(st.evaluate(fn, 0, 1, 0));
+    EXPECT_FALSE(st.evaluate(fn, 0, 5, bigStep));
+    EXPECT_FALSE(st.evaluate(fn, 5, 3, minStep));
+  }
+
+  TEST(program, t_example_chain)
+  {
+    constexpr auto fn = "example_chain.mad"sv;
+    source_tester st{ TEST_EXAMPLE(_chain) };
+
+    // The fused chain must give the same result as applying the operations one by one
+    auto check = [&st](auto a, auto b, auto c)
+      {
+        using enum eval::val_ops;
+        const auto fused = st.evaluate(fn, a, b, c);
+        const auto stepped = detail::to_value(a)
+          .binary(Multiplication, detail::to_value(b))
+          .binary(Addition, detail::to_value(c))
+          .binary(Subtraction, detail::to_value(1));
+
+        ASSERT_TRUE(fused);
+        EXPECT_TRUE(eval::to_bool(stepped.binary(Equal, fused)));
+      };
+
+    array_builder ab;
+    auto ints   = ab.with_new(2).add(1).add(2).get();
+    auto more   = ab.with_new(2).add(3).add(4).get();
+    auto offs   = ab.with_new(2).add(1).add(0).get();
+    auto floats = ab.with_new(3).add(0.5).add(2.0).add(-1.5).get();
+    auto inner  = ab.with_new(2).add(2).add(3).get();
+    auto nested = ab.with_new(2).add(1).add(inner).get();
+    auto empty  = ab.with_new(0).get();
+
+    check(ints, more, offs);
+    check(floats, ints, offs);
+    check(2, ints, 3.5);
+    check(ints, 3, offs);
+    check(nested, ints, offs);
+    check(empty, ints, offs);
+    check(ints, empty, 1);
+    st.test(fn, 9, 2, 3, 4);
+
+    // mad is lowered once, and its three operations become one instruction
+    auto&& stats = st.evaluator().flat_code_stats();
+    EXPECT_EQ(stats.m_functions, 1u);
+    EXPECT_EQ(stats.m_chains, 1u);
+    EXPECT_EQ(stats.m_fused, 3u);
+  }
+
+  TEST(program, t_example_intern)
+  {
+    source_tester st{ TEST_EXAMPLE(_intern) };
+    auto wrapper_of = [&st](string_t name) noexcept -> const eval::array_wrapper*
+      {
+        const auto res = st.evaluate(name);
+        auto arr = res.try_get<eval::type_id::Array>();
+        return arr ? &arr->wrapper() : nullptr;
+      };
+
+    auto f = wrapper_of("example_intern.f"sv);
+    auto g = wrapper_of("example_intern.g"sv);
+    auto inner = wrapper_of("example_intern.inner"sv);
+    ASSERT_NE(f, nullptr);
+    ASSERT_NE(inner, nullptr);
+
+    // Equal literals share one array, nested ones included
+    EXPECT_EQ(f, g);
+    auto nested = f->begin()[1].try_get<eval::type_id::Array>();
+    ASSERT_NE(nested, nullptr);
+    EXPECT_EQ(&nested->wrapper(), inner);
+
+    // Matching is exact
+    EXPECT_NE(wrapper_of("example_intern.ints"sv), wrapper_of("example_intern.mixed"sv));
+
+    // No two constants in the pool hold the same content
+    std::vector<const ir::constant*> pool;
+    for (auto&& c : st.cfg().interned())
+      pool.push_back(&c);
+
+    EXPECT_EQ(pool.size(), 4u);
+    for (auto li = pool.begin(); li != pool.end(); ++li)
+    {
+      for (auto ri = std::next(li); ri != pool.end(); ++ri)
+        EXPECT_FALSE((*li)->holds((*ri)->value()));
+    }
+  }
+
+  TEST(program, t_example_par_calls)
+  {
+    constexpr auto fn = "example_par.calls"sv;
+    source_tester serial{ TEST_EXAMPLE(_par) };
+    source_tester st{ TEST_EXAMPLE(_par) };
+    auto&& par = st.evaluator().par();
+    par.enable(true);
+
+    for (auto arg : { 3, -2 })
+    {
+      array_builder ab;
+      auto inner = ab.with_new(2).add(arg + 1).add(arg * arg).get();
+      auto expected = ab.with_new(5).add(arg * arg).add(arg * 2).add(-arg).add(inner).add(arg + 1).get();
+
+      serial.test(fn, expected, arg);
+      st.test(fn, expected, arg);
+
+      const auto serialRes = serial.evaluate(fn, arg);
+      const auto parRes    = st.evaluate(fn, arg);
+      EXPECT_TRUE(eval::to_bool(serialRes.binary(eval::val_ops::Equal, parRes)));
+    }
+
+    auto&& stats = par.counters();
+    EXPECT_EQ(stats.m_batches, 4u);
+    EXPECT_EQ(stats.m_tasks, 24u);
+    EXPECT_EQ(stats.m_fallbacks, 0u);
+    EXPECT_EQ(serial.evaluator().par().counters().m_batches, 0u);
+  }
+
+  TEST(program, t_example_par_elems)
+  {
+    constexpr auto fn = "example_par.elems"sv;
+    constexpr auto count = eval::int_type{ 5000 };
+    constexpr auto total = static_cast<std::size_t>(count * 2);
+    constexpr auto grain = std::size_t{ 256 };
+    constexpr auto minSize = std::size_t{ 1024 };
+
+    // Element i * 2 + j is i * [ 1, -1 ][j]
+    auto check_order = [](const eval::value& res, std::size_t expectedSz)
+      {
+        auto arr = res.try_get<eval::type_id::Array>();
+        ASSERT_TRUE(arr) << "expected an array, got " << res.id_str();
+        ASSERT_EQ((*arr)->size(), expectedSz);
+
+        std::size_t idx{};
+        for (auto&& elem : arr->wrapper())
+        {
+          const auto base = static_cast<eval::int_type>(idx / 2);
+          const auto expected = idx % 2 ? -base : base;
+          ASSERT_EQ(elem.get<eval::int_type>(), expected) << "at index " << idx;
+          ++idx;
+        }
+      };
+
+    source_tester serial{ TEST_EXAMPLE(_par) };
+    source_tester st{ TEST_EXAMPLE(_par) };
+    auto&& par = st.evaluator().par_elems();
+
+    const auto serialRes = serial.evaluate(fn, count);
+    check_order(serialRes, total);
+
+    // Same as '#threads N', the result must not depend on the worker count
+    constexpr std::array<std::size_t, 3> threadCounts{ 4, 2, 3 };
+    for (auto threads : threadCounts)
+    {
+      par.configure({ .m_threads = threads, .m_grain = grain, .m_minSize = minSize });
+      ASSERT_TRUE(par.wants(total));
+
+      const auto parRes = st.evaluate(fn, count);
+      check_order(parRes, total);
+      EXPECT_TRUE(eval::to_bool(serialRes.binary(eval::val_ops::Equal, parRes))) << "with " << threads << " threads";
+    }
+
+    const auto batches = threadCounts.size();
+    const auto tasks   = batches * ((total + grain - 1) / grain);
+    EXPECT_EQ(par.counters().m_batches, batches);
+    EXPECT_EQ(par.counters().m_tasks, tasks);
+
+    // Below the threshold everything stays on the calling thread
+    constexpr auto smallCount = eval::int_type{ 100 };
+    check_order(st.evaluate(fn, smallCount), static_cast<std::size_t>(smallCount * 2));
+    EXPECT_EQ(par.counters().m_batches, batches);
+
+    // '#threads 0' turns it off
+    par.configure({ .m_threads = 0, .m_grain = grain, .m_minSize = minSize });
+    ASSERT_FALSE(par.wants(total));
+    const auto offRes = st.evaluate(fn, count);
+    check_order(offRes, total);
+    EXPECT_TRUE(eval::to_bool(serialRes.binary(eval::val_ops::Equal, offRes)));
+    EXPECT_EQ(par.counters().m_batches, batches);
+    EXPECT_EQ(serial.evaluator().par_elems().counters().m_batches, 0u);
+  }
+
+  TEST(program, t_example_fib_slots)
+  {
+    source_tester st{ TEST_EXAMPLE(_fib) };
+    constexpr auto fn = "example_fib.fib"sv;
+    auto func = st.func(fn, 1);
+    ASSERT_NE(func, nullptr);
+
+    st.test(fn, 6765, 20);
+    ASSERT_TRUE(func->has_slots());
+
+    // Parameters take the first slots, other registers are numbered densely after them
+    using slot_type = ir::function::slot_type;
+    const auto paramCount = slot_type{ func->param_count() };
+    const auto slotCount = func->slot_count();
+    std::unordered_map<const ir::vreg*, slot_type> slots;
+    for (auto&& block : func->blocks())
+    {
+      for (auto&& instr : block)
+      {
+        if (instr.opcode() == ir::op_code::Load && instr[1].is_param())
+          EXPECT_EQ(instr[0].get_reg().slot(), slot_type{ *instr[1].get_param() });
+
+        for (auto idx = ir::instruction::size_type{}; idx < instr.operand_count(); ++idx)
+        {
+          auto&& op = instr[idx];
+          if (!op.is_register() || op.get_reg().is_global())
+            continue;
+
+          auto&& reg = op.get_reg();
+          ASSERT_TRUE(reg.has_slot());
+          ASSERT_LT(reg.slot(), slotCount);
+          slots.emplace(&reg, reg.slot());
+        }
+      }
+    }
+
+    std::vector<std::size_t> owners(slotCount);
+    for (auto&& [reg, slot] : slots)
+      ++owners[slot];
+
+    for (auto slot = paramCount; slot < slotCount; ++slot)
+      EXPECT_EQ(owners[slot], 1u) << "slot " << slot;
+  }
+
+  TEST(program, t_example_dyn_bind)
+  {
+    constexpr auto fn = "example_bind.run"sv;
+    source_tester st{ TEST_EXAMPLE(_bind) };
+    st.test(fn, 15, 3)
+      .test(fn, 0, 0)
+      .test(fn, 8, -4)
+      .test(fn, 120, 10)
+    ;
+
+    // Either receiver is looked up by name once, then comes from the cache
+    auto&& stats = st.evaluator().dyn_bind_stats();
+    EXPECT_EQ(stats.m_misses, 2u);
+    EXPECT_EQ(stats.m_hits, 6u);
+  }
+
+  TEST(program, t_example_fib_memo)
+  {
+    source_tester st{ TEST_EXAMPLE(_fib) };
+    auto&& memo = st.evaluator().memo();
+    memo.set_mode(eval::memo_mode::All);
+
+    constexpr auto fn = "example_fib.fib"sv;
+    st
+      .test(fn, 55, 10)
+      .test(fn, 6765, 20)
+      .test(fn, 832040, 30)
+    ;
+
+    EXPECT_GT(memo.counters().m_hits, 0u);
+    EXPECT_LE(memo.size(), memo.capacity());
+
+    memo.set_capacity(4);
+    st.test(fn, 6765, 20);
+    EXPECT_LE(memo.size(), 4u);
+    EXPECT_GT(memo.counters().m_evictions, 0u);
+  }
+
+  TEST(program, t_example_fib_jit)
+  {
+    source_tester st{ TEST_EXAMPLE(_fib) };
+    auto&& jit = st.evaluator().jit();
+    jit.set_threshold(1);
+    jit.enable(true);
+
+    constexpr auto fn = "example_fib.fib"sv;
+    st
+      .test(fn, 55, 10)
+      .test(fn, 6765, 20)
+      .test(fn, 832040, 30)
+    ;
+
+    if (!jit.is_supported())
+      return;
+
+    EXPECT_GT(jit.counters().m_compiled, 0u);
+    EXPECT_GT(jit.counters().m_calls, 0u);
+  }
+
 }
@@ -23,4 +23,79 @@ namespace tnac::tests
     wrplist.remove(wrap3);
     ASSERT_TRUE(arrlist.empty());
   }
+
+  TEST(refcounted, t_arr_packing)
+  {
+    eval::store store;
+    auto&& arr = store.allocate_array(4ull);
+    for (eval::int_type i = 0; i < 3; ++i)
+      arr.add(eval::value{ i });
+
+    ASSERT_FALSE(arr.is_boxed());
+    ASSERT_EQ(arr.packed<eval::int_type>().size(), 3ull);
+    ASSERT_TRUE(arr.packed<eval::float_type>().empty());
+
+    auto&& part = store.wrap(arr, 1ull, 2ull);
+    ASSERT_EQ(part.packed<eval::int_type>().front(), eval::int_type{ 1 });
+
+    auto total = eval::int_type{};
+    for (auto&& elem : arr)
+      total += elem.get<eval::int_type>();
+    for (auto&& elem : part)
+      total += elem.get<eval::int_type>();
+    ASSERT_EQ(total, eval::int_type{ 6 });
+    ASSERT_EQ(part.rbegin()->get<eval::int_type>(), eval::int_type{ 2 });
+    ASSERT_FALSE(arr.is_boxed());
+
+    arr.add(eval::value{ 1.5 });
+    ASSERT_TRUE(arr.is_boxed());
+    ASSERT_EQ(arr.size(), 4ull);
+    ASSERT_EQ(arr.read_at(2ull).get<eval::int_type>(), eval::int_type{ 2 });
+    ASSERT_EQ(arr.read_at(3ull).get<eval::float_type>(), 1.5);
+  }
+
+  TEST(refcounted, t_arr_views)
+  {
+    eval::store store;
+    auto&& arr = store.allocate_array(6ull);
+    for (eval::int_type i = 0; i < 6; ++i)
+      arr.add(eval::value{ i });
+
+    auto&& whole = store.wrap(arr);
+    auto&& back = store.view(whole, 4ull, 3ull, -2);
+    ASSERT_EQ(back.size(), 3ull);
+    ASSERT_FALSE(back.is_contiguous());
+    ASSERT_TRUE(back.packed<eval::int_type>().empty());
+
+    std::vector<eval::int_type> tmp;
+    auto gathered = back.packed<eval::int_type>(tmp);
+    ASSERT_EQ(gathered.size(), 3ull);
+    ASSERT_EQ(gathered[0], eval::int_type{ 4 });
+    ASSERT_EQ(gathered[2], eval::int_type{ 0 });
+
+    auto&& inner = store.view(back, 1ull, 2ull, -1);
+    ASSERT_EQ(inner.stride(), 2);
+    auto it = inner.begin();
+    ASSERT_EQ(it->get<eval::int_type>(), eval::int_type{ 2 });
+    ASSERT_EQ((++it)->get<eval::int_type>(), eval::int_type{ 4 });
+    ASSERT_TRUE(++it == inner.end());
+  }
+
+  TEST(refcounted, t_arr_collect)
+  {
+    eval::store store;
+    store.allocate_array(4ull);
+
+    auto&& kept = store.allocate_array(2ull);
+    kept.add(eval::value{ eval::int_type{ 1 } });
+    const auto keep = eval::value::array(store.wrap(kept));
+
+    auto&& cyclic = store.allocate_array(1ull);
+    cyclic.add(eval::value::array(store.wrap(cyclic)));
+
+    ASSERT_EQ(store.array_count(), 3ull);
+    store.collect();
+    ASSERT_EQ(store.array_count(), 1ull);
+    ASSERT_EQ(store.counters().m_reclaimed, 2ull);
+  }
 }
\ No newline at end of file